@@ -1,5 +1,7 @@
 #include <immintrin.h>
 
+#include "../common/jumptable.h"
+
 #define FORCE_INLINE inline __attribute__((always_inline))
 
 namespace avx512sort {
@@ -591,4 +593,148 @@ namespace avx512sort {
         }
     }
 
+
+    // The same as sort_inplace, but code for a size is reached with two
+    // jumps through tables (../common/jumptable.h): the number of
+    // registers, then the size within them.  There is neither a chain of
+    // compares nor the bounds checks of switches.  It is not faster, see
+    // README.rst.
+    void sort_inplace_jumptable(uint32_t* array, size_t size) {
+        JUMPTABLE_DEFINE(regs, regs1, regs2, regs3, regs4);
+        JUMPTABLE_DEFINE(sizes1, size1, size2, size3, size4, size5, size6, size7, size8, size9, size10, size11, size12, size13, size14, size15, size16);
+        JUMPTABLE_DEFINE(sizes2, size17, size18, size19, size20, size21, size22, size23, size24, size25, size26, size27, size28, size29, size30, size31, size32);
+        JUMPTABLE_DEFINE(sizes3, size33, size34, size35, size36, size37, size38, size39, size40, size41, size42, size43, size44, size45, size46, size47, size48);
+        JUMPTABLE_DEFINE(sizes4, size49, size50, size51, size52, size53, size54, size55, size56, size57, size58, size59, size60, size61, size62, size63, size64);
+
+        __m512i v1, v2, v3, v4;
+
+        if (size <= 1 || size > 64) {
+            return;
+        }
+
+        JUMPTABLE_GOTO(regs, (size - 1) / 16);
+
+    regs1:
+        v1 = _mm512_loadu_si512(array);
+        JUMPTABLE_GOTO(sizes1, (size - 1) % 16);
+
+    regs2:
+        v1 = _mm512_loadu_si512(array);
+        v2 = _mm512_loadu_si512(array + 16);
+        JUMPTABLE_GOTO(sizes2, (size - 1) % 16);
+
+    regs3:
+        v1 = _mm512_loadu_si512(array);
+        v2 = _mm512_loadu_si512(array + 16);
+        v3 = _mm512_loadu_si512(array + 32);
+        JUMPTABLE_GOTO(sizes3, (size - 1) % 16);
+
+    regs4:
+        v1 = _mm512_loadu_si512(array);
+        v2 = _mm512_loadu_si512(array + 16);
+        v3 = _mm512_loadu_si512(array + 32);
+        v4 = _mm512_loadu_si512(array + 48);
+        JUMPTABLE_GOTO(sizes4, (size - 1) % 16);
+
+    #define TAIL1(n) size##n: v1 = sort1xreg_tail<n>(v1); goto store1;
+    #define TAIL2(n) size##n: sort2xreg_tail<n>(v1, v2); goto store2;
+    #define TAIL3(n) size##n: sort3xreg_tail<n>(v1, v2, v3); goto store3;
+    #define TAIL4(n) size##n: sort4xreg_tail<n>(v1, v2, v3, v4); goto store4;
+
+    size1:
+        return;
+    TAIL1(2)
+    TAIL1(3)
+    TAIL1(4)
+    TAIL1(5)
+    TAIL1(6)
+    TAIL1(7)
+    TAIL1(8)
+    TAIL1(9)
+    TAIL1(10)
+    TAIL1(11)
+    TAIL1(12)
+    TAIL1(13)
+    TAIL1(14)
+    TAIL1(15)
+    size16:
+        v1 = sort1xreg(v1);
+    store1:
+        _mm512_storeu_si512(array, v1);
+        return;
+
+    TAIL2(17)
+    TAIL2(18)
+    TAIL2(19)
+    TAIL2(20)
+    TAIL2(21)
+    TAIL2(22)
+    TAIL2(23)
+    TAIL2(24)
+    TAIL2(25)
+    TAIL2(26)
+    TAIL2(27)
+    TAIL2(28)
+    TAIL2(29)
+    TAIL2(30)
+    TAIL2(31)
+    size32:
+        sort2xreg(v1, v2);
+    store2:
+        _mm512_storeu_si512(array, v1);
+        _mm512_storeu_si512(array + 16, v2);
+        return;
+
+    TAIL3(33)
+    TAIL3(34)
+    TAIL3(35)
+    TAIL3(36)
+    TAIL3(37)
+    TAIL3(38)
+    TAIL3(39)
+    TAIL3(40)
+    TAIL3(41)
+    TAIL3(42)
+    TAIL3(43)
+    TAIL3(44)
+    TAIL3(45)
+    TAIL3(46)
+    TAIL3(47)
+    size48:
+        sort3xreg(v1, v2, v3);
+    store3:
+        _mm512_storeu_si512(array, v1);
+        _mm512_storeu_si512(array + 16, v2);
+        _mm512_storeu_si512(array + 32, v3);
+        return;
+
+    TAIL4(49)
+    TAIL4(50)
+    TAIL4(51)
+    TAIL4(52)
+    TAIL4(53)
+    TAIL4(54)
+    TAIL4(55)
+    TAIL4(56)
+    TAIL4(57)
+    TAIL4(58)
+    TAIL4(59)
+    TAIL4(60)
+    TAIL4(61)
+    TAIL4(62)
+    TAIL4(63)
+    size64:
+        sort4xreg(v1, v2, v3, v4);
+    store4:
+        _mm512_storeu_si512(array, v1);
+        _mm512_storeu_si512(array + 16, v2);
+        _mm512_storeu_si512(array + 32, v3);
+        _mm512_storeu_si512(array + 48, v4);
+
+    #undef TAIL4
+    #undef TAIL3
+    #undef TAIL2
+    #undef TAIL1
+    }
+
 } // namespace avx512sort
@@ -0,0 +1,69 @@
+#include "../common/bench.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+#include "avx512-sort-any.cpp"
+
+// Dispatch on size in sort_inplace: a chain of compares followed by
+// switches vs jumps through tables.  One sample sorts `count` arrays,
+// the sizes are either the same or random (then the dispatch is not
+// predictable); results are given per array.
+
+typedef void (*sort_function)(uint32_t* array, size_t size);
+
+const size_t count = 1024;
+
+uint32_t data[count][64];
+uint8_t  sizes[count];
+
+
+void measure(const char* name, const char* variant, sort_function fun) {
+
+    char label[128];
+    snprintf(label, sizeof(label), "sort_inplace-%s/%s/%lu", name, variant, count);
+
+    bench b;
+    bench_begin(&b, label, 1000, count);
+    while (bench_next(&b)) {
+        for (size_t i=0; i < count; i++) {
+            fun(data[i], sizes[i]);
+        }
+        BENCH_CLOBBER();
+    }
+    bench_report(&b);
+}
+
+
+void measure_all(const char* name) {
+
+    for (size_t i=0; i < count; i++) {
+        for (size_t j=0; j < 64; j++) {
+            data[i][j] = rand();
+        }
+    }
+
+    measure(name, "switch",    avx512sort::sort_inplace);
+    measure(name, "jumptable", avx512sort::sort_inplace_jumptable);
+}
+
+
+int main() {
+
+    const size_t fixed[] = {5, 20, 40, 64};
+    char name[32];
+
+    for (size_t size: fixed) {
+        memset(sizes, size, sizeof(sizes));
+        snprintf(name, sizeof(name), "size%lu", size);
+        measure_all(name);
+    }
+
+    for (size_t i=0; i < count; i++) {
+        sizes[i] = 2 + rand() % 63;
+    }
+
+    measure_all("random");
+}
@@ -10,20 +10,24 @@
 
 class Failed {};
 
+typedef void (*sort_function)(uint32_t* array, size_t size);
+
 
 class Test {
 
 protected:
 
     size_t N;
+    sort_function sort;
 
     uint32_t buf[64];
     uint32_t ref[64];
 
 public:
 
-    Test(size_t n)
-        : N(n) {
+    Test(size_t n, sort_function fun)
+        : N(n)
+        , sort(fun) {
 
         assert(N > 0);
         assert(N <= 64);
@@ -79,7 +83,7 @@ private:
         std::sort(ref, ref + N);
 
         // run an AVX512 procedure
-        avx512sort::sort_inplace(buf, N);
+        sort(buf, N);
 
         // compare
         for (size_t i=1; i < N; i++) {
@@ -106,16 +110,26 @@ private:
 
 int main() {
 
-    for (int i=2; i <= 64; i++) {
-        Test test(i);
-
-        printf("AVX512 sort(%d)... ", i); fflush(stdout);
-        try {
-            test.run();
-            puts("OK");
-        } catch (Failed&) {
-            puts("ERROR");
-            return EXIT_FAILURE;
+    const struct {
+        sort_function fun;
+        const char*   name;
+    } functions[] = {
+        {avx512sort::sort_inplace,           "switch"},
+        {avx512sort::sort_inplace_jumptable, "jumptable"},
+    };
+
+    for (const auto& f: functions) {
+        for (int i=2; i <= 64; i++) {
+            Test test(i, f.fun);
+
+            printf("AVX512 sort(%d) %s... ", i, f.name); fflush(stdout);
+            try {
+                test.run();
+                puts("OK");
+            } catch (Failed&) {
+                puts("ERROR");
+                return EXIT_FAILURE;
+            }
         }
     }
 
@@ -0,0 +1,14 @@
+#!/bin/sh
+# Renders random 640x480 frames with both builds, frames/s are printed on stderr
+
+FRAMES=${FRAMES:-200}
+TMP=$(mktemp)
+trap 'rm -f $TMP' EXIT
+
+head -c $((640*480/8*FRAMES)) /dev/urandom > $TMP
+
+for prog in bmp2ascii bmp2ascii_avx2
+do
+    printf "%-16s" $prog
+    ./$prog -V -w=640 -h=480 -f=$TMP > /dev/null
+done
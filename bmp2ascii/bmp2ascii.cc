@@ -1,12 +1,25 @@
 /*
   bmp2ascii
-  
+
   Wojciech Mua (wojciech_mula@poczta.onet.pl)
-  
+
   29-30.10.2002 -- Linux version
-  
+
   compile:
-  	g++ -O2 -o bmp2ascii bmp2ascii.cc
+  	make
+
+  Fonts come from one of sources (option -F):
+  * builtin  -- 8x16 PSF font embedded in the program (default),
+  * console  -- font of the current console (ioctl GIO_FONT),
+  * filename -- a PSF1 or PSF2 file of width 8.
+
+  A cell of image (8 x font height pixels) and glyphs are 32-byte bitmaps,
+  the best glyph has the smallest popcount(cell xor glyph); with AVX2
+  (make bmp2ascii_avx2) four glyphs are compared at once.
+
+  With -V the input is a sequence of raw 1-bit frames (like ffmpeg's
+  "-f rawvideo -pix_fmt monob"), frames are rendered in parallel
+  threads and the rate in frames/s is printed on stderr.
  */
 
 #include <cstdlib>
@@ -14,6 +27,13 @@
 #include <cerrno>
 #include <cstring>
 #include <cstdint>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -23,11 +43,12 @@
 #include <sys/ioctl.h>
 #include <sys/kd.h>
 
-extern int errno;
+#include <immintrin.h>
 
-// size of character cell (standard 80x25 EGA mode)
+#include "../common/font_builtin.h"
+
+// width of character cell; height is given by font
 #define cellx 8
-#define celly 16
 
 // predefined sets of chars using to build ASCII-image
 const char* set_l = "abcdefghijklmnopqrstuvwxyz";
@@ -36,108 +57,296 @@ const char* set_n = "012345678";
 const char* set_s = "+-|=)([]@#$%^&*_~,.:;\"'`\\/?><";
 
 
-unsigned char font[256][32];  // font data
+// glyph or image cell: up to 32 rows of 8 pixels, unused rows are zero
+struct Cell
+{
+ uint8_t row[32];
+};
+
+struct Font
+{
+ Cell glyph[256];
+ int  height;
+};
+
+Font font;               // font data
 char filename[256] = ""; // filename
+char fontname[256] = "builtin";
 
-int  width  = -1;        // width and 
+int  width  = -1;        // width and
 int  height = -1;        // height of image in pixels
 int  cx, cy;             // in character cells
+int  celly;              // height of character cell
 
-int  negate = 0;         // image will be negate
+int  negate  = 0;        // image will be negate
+int  video   = 0;        // input is a sequence of frames
+int  threads = 0;        // 0 -- number of CPUs
 char set[512] = "";      // set of characters using
 
-unsigned char image_row[celly][2048]; // one image row (using by ASCII)
-char char_row[2048+1];                // the character representation
+// glyphs of chars from `set', padded to multiply of 4
+std::vector<Cell> candidates;
 
 // gets bitmap fonts frome EGA card
-void get_EGA_font(unsigned char font[256][32]);
+void get_EGA_font(Font& font);
+
+// loads PSF font from memory or file
+void load_PSF_font(const unsigned char* data, size_t size, Font& font);
+void load_PSF_file(const char* name, Font& font);
 
 // guess
 void parse_opt(int argc, char* argv[]);
 
-// convert data from `image_row' (pixels) into `char_row' (characters)
-void ASCII();
+// converts frame (height rows of cx bytes) into text, cy lines;
+// like in the original program cells are mirrored
+void ASCII(const uint8_t* frame, int rows, std::string& text);
+
+void render_image();
+void render_video();
 
 int main(int argc, char* argv[])
 {
  parse_opt(argc, argv);
- get_EGA_font(font);
 
+ if (strcmp(fontname, "builtin") == 0)
+	load_PSF_font(font_builtin, sizeof(font_builtin), font);
+ else
+ if (strcmp(fontname, "console") == 0)
+	get_EGA_font(font);
+ else
+	load_PSF_file(fontname, font);
+
+ celly = font.height;
  cx = (width  + cellx-1)/cellx; // size of output image
  cy = (height + celly-1)/celly; // in character cells
 
+ for (const char* s = set; *s; s++)
+	candidates.push_back(font.glyph[uint8_t(*s)]);
+ while (candidates.size() % 4)
+	candidates.push_back(candidates.back());
+
+ if (video)
+	render_video();
+ else
+	render_image();
+
+ return 0;
+}
+
+void render_image()
+{
  errno = 0;
  FILE *file = fopen(filename, "r");
- if (errno)
+ if (file == NULL)
  	{
 	 printf("open: %s\n",strerror(errno));
 	 exit(1);
 	}
 
  struct stat buf;
- stat(filename, &buf);
- if (errno)
+ if (stat(filename, &buf) < 0)
  	{
 	 printf("stat: %s\n", strerror(errno));
 	 exit(1);
 	}
-	
+
  // skip header, in fact input data can be any bin file
- fseek(file, buf.st_size-(width*height)/cellx, SEEK_SET);
- if (errno)
+ if (fseek(file, buf.st_size-(width*height)/cellx, SEEK_SET) < 0)
  	{
 	 printf("seek: %s\n", strerror(errno));
 	 exit(1);
 	}
- 
- char_row[cx] = '\0';
- for (int y=0; y<cy; y++)
+
+ std::vector<uint8_t> frame(size_t(cx)*height);
+ const size_t rows = fread(frame.data(), cx, height, file);
+ fclose(file);
+
+ std::string text;
+ ASCII(frame.data(), rows, text);
+
+ fputs(text.c_str(), stdout);
+}
+
+void render_video()
+{
+ FILE* file = (strcmp(filename, "-") == 0) ? stdin : fopen(filename, "r");
+ if (file == NULL)
  	{
-	 for (int n=0; n<celly; n++)
+	 printf("open: %s\n",strerror(errno));
+	 exit(1);
+	}
+
+ const size_t frame_size = size_t(cx)*height;
+ const unsigned count = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+ const size_t batch = 4*count;
+
+ std::vector<uint8_t> frames(batch*frame_size);
+ std::vector<std::string> texts(batch);
+ const std::string home = isatty(STDOUT_FILENO) ? "\033[H" : "";
+
+ // the pool of count-1 threads, started once; the main thread renders too
+ std::mutex lock;
+ std::condition_variable start, done;
+ size_t   n = 0;           // frames in the batch
+ unsigned generation = 0;  // number of the batch
+ unsigned running = 0;     // workers still rendering the batch
+ bool     quit = false;
+ std::atomic<size_t> next(0);
+
+ auto render = [&]() {
+	for (size_t i = next++; i < n; i = next++)
+		ASCII(&frames[i*frame_size], height, texts[i]);
+ };
+
+ auto worker = [&]() {
+	unsigned seen = 0;
+	std::unique_lock<std::mutex> guard(lock);
+	while (true)
+		{
+		 start.wait(guard, [&]() { return quit || generation != seen; });
+		 if (quit)
+			return;
+
+		 seen = generation;
+		 guard.unlock();
+		 render();
+		 guard.lock();
+		 if (--running == 0)
+			done.notify_one();
+		}
+ };
+
+ std::vector<std::thread> workers;
+ for (unsigned t=1; t < count; t++)
+	workers.emplace_back(worker);
+
+ size_t total = 0;
+ const auto t0 = std::chrono::steady_clock::now();
+ while (true)
+ 	{
+	 const size_t readed = fread(frames.data(), frame_size, batch, file);
+	 if (readed == 0)
+		break;
+
+	 {
+		std::lock_guard<std::mutex> guard(lock);
+		n = readed;
+		next = 0;
+		running = workers.size();
+		generation += 1;
+	 }
+	 start.notify_all();
+	 render();
+	 {
+		std::unique_lock<std::mutex> guard(lock);
+		done.wait(guard, [&]() { return running == 0; });
+	 }
+
+	 for (size_t i=0; i < n; i++)
 	 	{
-		 memset(image_row[n], 0, sizeof(image_row[0]));
-		 if (height--)
- 	    	    fread(image_row[n], cx, 1, file);
+		 fputs(home.c_str(), stdout);
+		 fputs(texts[i].c_str(), stdout);
 		}
 
-	 ASCII();
+	 total += n;
+	}
+ const auto t1 = std::chrono::steady_clock::now();
+
+ {
+	std::lock_guard<std::mutex> guard(lock);
+	quit = true;
+ }
+ start.notify_all();
+ for (auto& w: workers)
+	w.join();
+
+ if (file != stdin)
+	fclose(file);
+
+ const double time = std::chrono::duration<double>(t1 - t0).count();
+ fflush(stdout);
+ fprintf(stderr, "%zu frame(s), %.3f s, %.1f frames/s\n", total, time, total/time);
+}
+
+#ifdef __AVX2__
+// distances between cell and glyphs g[0..3], as 4 x 16-bit fields
+static inline uint64_t distance4(const __m256i cell, const Cell* g)
+{
+ const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+ const __m256i low4 = _mm256_set1_epi8(0x0f);
 
-	 puts(char_row);
+ __m256i sum = _mm256_setzero_si256();
+ for (int k=0; k < 4; k++)
+ 	{
+	 const __m256i x  = _mm256_xor_si256(cell, _mm256_loadu_si256((const __m256i*)g[k].row));
+	 const __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(x, low4));
+	 const __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(x, 4), low4));
+	 // sad: four partial sums (<= 64) in 64-bit lanes, put them in k-th 16-bit field
+	 const __m256i s  = _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+	 sum = _mm256_or_si256(sum, _mm256_sllv_epi64(s, _mm256_set1_epi64x(16*k)));
 	}
- fclose(file);
- 
- return 0;
+
+ const __m128i s = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+ return _mm_cvtsi128_si64(_mm_add_epi64(s, _mm_unpackhi_epi64(s, s)));
 }
+#endif
 
-void ASCII()
+// index of glyph closest to cell, the first one if there are more
+static int best_glyph(const Cell& cell)
 {
- static unsigned int diff[256];
- static unsigned int min;
- 
- uint8_t *s;
- for (int i=0; i<cx; i++)
+ int best = 0;
+ unsigned min = ~0u;
+
+#ifdef __AVX2__
+ const __m256i c = _mm256_loadu_si256((const __m256i*)cell.row);
+ for (size_t i=0; i < candidates.size(); i += 4)
  	{
-	 s = (uint8_t*)set;
-	 while (*s)
+	 uint64_t d = distance4(c, &candidates[i]);
+	 for (int k=0; k < 4; k++, d >>= 16)
+		if ((d & 0xffff) < min)
+			{
+			 min  = d & 0xffff;
+			 best = i + k;
+			}
+	}
+#else
+ uint64_t w[4];
+ memcpy(w, cell.row, sizeof(w));
+ for (size_t i=0; i < candidates.size(); i++)
+ 	{
+	 uint64_t g[4];
+	 memcpy(g, candidates[i].row, sizeof(g));
+	 const unsigned d = __builtin_popcountll(w[0] ^ g[0]) + __builtin_popcountll(w[1] ^ g[1])
+	                  + __builtin_popcountll(w[2] ^ g[2]) + __builtin_popcountll(w[3] ^ g[3]);
+	 if (d < min)
 	 	{
-		 diff[*s] = 0;
-		 for (int j=0; j<celly; j++)
-		 	if (negate)
-				diff[*s] += ~image_row[j][i] ^ font[*s][j];
-			else
-				diff[*s] += image_row[j][i] ^ font[*s][j];
-		 s++;
+		 min  = d;
+		 best = i;
 		}
-		
-	 s   = (uint8_t*)set;
-	 min = diff[uint8_t(char_row[cx-i-1] = *s)];
-	 while (*s)
+	}
+#endif
+
+ return best;
+}
+
+void ASCII(const uint8_t* frame, int rows, std::string& text)
+{
+ text.assign(size_t(cy)*(cx + 1), '\n');
+
+ for (int y=0; y<cy; y++)
+	for (int i=0; i<cx; i++)
 	 	{
-		 if (diff[*s] < min)
-			 min = diff[uint8_t(char_row[cx-i-1] = *s)];
-		 s++;
+		 Cell cell;
+		 memset(&cell, 0, sizeof(cell));
+		 for (int j=0; j<celly; j++)
+		 	{
+			 const int row = y*celly + j;
+			 const uint8_t pixels = (row < rows) ? frame[size_t(row)*cx + i] : 0;
+			 cell.row[j] = negate ? ~pixels : pixels;
+			}
+
+		 text[size_t(y)*(cx + 1) + (cx - 1 - i)] = set[best_glyph(cell)];
 		}
-	}
 }
 
 void print_help()
@@ -152,7 +361,10 @@ void print_help()
       "              * s - symbols\n"
       "              If no option specified all sets will be used.\n"
       "-f=name    -- filename\n"
+      "-F=font    -- builtin (default), console or name of PSF file\n"
       "-n         -- negate image\n"
+      "-V         -- file (- is stdin) contains sequence of frames\n"
+      "-t=threads -- number of threads rendering frames\n"
       "--help     -- this info\n"
       "--version  -- info about bmp2ascii\n"
       "\n"
@@ -181,7 +393,7 @@ void parse_opt(int argc, char* argv[])
 		 print_help();
 		 exit(0);
 		}
-	 else	
+	 else
 	 if (strncmp(argv[i], "-h=", 3) == 0)
 	 	{
 		 height = strtol(&argv[i][3], &err, 10);
@@ -202,9 +414,24 @@ void parse_opt(int argc, char* argv[])
 			}
 		}
 	 else
+	 if (strncmp(argv[i], "-t=", 3) == 0)
+	 	{
+		 threads = strtol(&argv[i][3], &err, 10);
+		 if (*err != '\0' || threads < 0)
+		 	{
+			 puts("bad number of threads");
+			 exit(1);
+			}
+		}
+	 else
 	 if (strncmp(argv[i], "-f=", 3) == 0)
 	 	{
-		 strcpy(filename, &argv[i][3]);
+		 snprintf(filename, sizeof(filename), "%s", &argv[i][3]);
+		}
+	 else
+	 if (strncmp(argv[i], "-F=", 3) == 0)
+	 	{
+		 snprintf(fontname, sizeof(fontname), "%s", &argv[i][3]);
 		}
 	 else
 	 if (strcmp(argv[i], "-n") == 0)
@@ -212,6 +439,11 @@ void parse_opt(int argc, char* argv[])
 		 negate = 1;
 		}
 	 else
+	 if (strcmp(argv[i], "-V") == 0)
+	 	{
+		 video = 1;
+		}
+	 else
 	 if (strncmp(argv[i], "-s=", 3) == 0)
 	 	{
 		 char *c = &argv[i][3];
@@ -235,10 +467,10 @@ void parse_opt(int argc, char* argv[])
 		 print_help();
 		 exit(1);
 		}
-	 
+
 	}
 
- if ((width < 0 || width > 2048) || height < 0)
+ if (width <= 0 || height <= 0)
  	{
  	 puts("bad width or height\n");
 	 print_help();
@@ -255,7 +487,7 @@ void parse_opt(int argc, char* argv[])
 	 char *env = getenv("ASCII_SET");
 
 	 if (env != NULL)
-	 	 strcpy(set, env);
+	 	 snprintf(set, sizeof(set) - 1, "%s", env);
 	 else
 	 	{
 		 strcpy(set, set_l);
@@ -268,21 +500,87 @@ void parse_opt(int argc, char* argv[])
  width = ((width+cellx-1)/cellx)*cellx;
 }
 
-void get_EGA_font(unsigned char font[256][32])
+void get_EGA_font(Font& font)
 // The EGA fonts has got size 8x32 pixels.
 {
+ static unsigned char data[256][32];
+
  errno = 0;
  int tty = open("/dev/tty", O_RDWR);
- if (errno) goto error;
-
- ioctl(tty, GIO_FONT, font);
- if (errno) goto error;
- 
- close(tty);
- if (errno) goto error;
- 
+ if (tty < 0) goto error;
+
+ if (ioctl(tty, GIO_FONT, data) < 0) goto error;
+
+ if (close(tty) < 0) goto error;
+
+ for (int c=0; c < 256; c++)
+	memcpy(font.glyph[c].row, data[c], 32);
+
+ font.height = 16; // standard 80x25 mode
  return;
 error:
  printf("Loading font error: %s\n", strerror(errno));
  exit(1);
 }
+
+void load_PSF_font(const unsigned char* data, size_t size, Font& font)
+{
+ unsigned count, charsize, offset, width;
+
+ if (size >= 4 && data[0] == 0x36 && data[1] == 0x04)
+ 	{
+	 // PSF1: magic, mode, charsize; glyphs are 8 pixels wide
+	 count    = (data[2] & 0x01) ? 512 : 256;
+	 charsize = data[3];
+	 offset   = 4;
+	 width    = 8;
+	 font.height = charsize;
+	}
+ else
+ if (size >= 32 && data[0] == 0x72 && data[1] == 0xb5 && data[2] == 0x4a && data[3] == 0x86)
+ 	{
+	 // PSF2: magic, version, headersize, flags, length, charsize, height, width
+	 uint32_t header[8];
+	 memcpy(header, data, sizeof(header));
+	 offset   = header[2];
+	 count    = header[4];
+	 charsize = header[5];
+	 font.height = header[6];
+	 width    = header[7];
+	}
+ else
+ 	{
+	 puts("Loading font error: not a PSF font");
+	 exit(1);
+	}
+
+ if (width != 8 || font.height <= 0 || font.height > 32 || charsize != unsigned(font.height) ||
+     offset + size_t(std::min(count, 256u))*charsize > size)
+ 	{
+	 puts("Loading font error: only PSF fonts 8 pixels wide and up to 32 pixels high are supported");
+	 exit(1);
+	}
+
+ memset(font.glyph, 0, sizeof(font.glyph));
+ for (unsigned c=0; c < std::min(count, 256u); c++)
+	memcpy(font.glyph[c].row, data + offset + c*charsize, charsize);
+}
+
+void load_PSF_file(const char* name, Font& font)
+{
+ FILE* f = fopen(name, "rb");
+ if (f == NULL)
+ 	{
+	 printf("Loading font error: %s\n", strerror(errno));
+	 exit(1);
+	}
+
+ std::vector<unsigned char> data;
+ unsigned char buf[4096];
+ size_t n;
+ while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+	data.insert(data.end(), buf, buf + n);
+ fclose(f);
+
+ load_PSF_font(data.data(), data.size(), font);
+}
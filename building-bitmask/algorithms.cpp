@@ -1,13 +1,35 @@
+#include <immintrin.h>
+
+#include "../common/cpudispatch.h"
+
 #include "scalar.cpp"
 #include "sse.cpp"
 
-#ifdef HAVE_AVX512_INSTRUCTIONS
-#   ifndef HAVE_AVX2_INSTRUCTIONS
-#       define HAVE_AVX2_INSTRUCTIONS
-#   endif
-#   include "avx512.cpp"
-#endif
+CPU_TARGET_BEGIN("avx2")
+#include "avx2.cpp"
+CPU_TARGET_END
+
+CPU_TARGET_BEGIN("avx512f")
+#include "avx512.cpp"
+CPU_TARGET_END
+
+// the fastest procedure available, selected at the first call
+static const cpu_variant bitmask_variants[] = {
+    CPU_VARIANT(CPU_AVX512F, bitmask_avx512),
+    CPU_VARIANT(CPU_AVX2,    bitmask_avx2),
+    CPU_VARIANT(0,           bitmask_SSE),
+};
+
+typedef void (*bitmask_fun)(const uint32_t*, size_t, uint32_t, uint8_t*);
+
+const char* bitmask_name() {
+    return cpu_select(bitmask_variants)->name;
+}
+
+void bitmask(const uint32_t* array, size_t n, uint32_t key, uint8_t* bitvector) {
+
+    // function-local statics are initialized once, even with threads
+    static const bitmask_fun fun = (bitmask_fun)cpu_select(bitmask_variants)->fun;
 
-#ifdef HAVE_AVX2_INSTRUCTIONS
-#   include "avx2.cpp"
-#endif
+    fun(array, n, key, bitvector);
+}
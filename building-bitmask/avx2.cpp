@@ -1,4 +1,4 @@
-void bitmask_avx2(uint32_t* ptr, size_t n, uint32_t key, uint8_t* out) {
+void bitmask_avx2(const uint32_t* ptr, size_t n, uint32_t key, uint8_t* out) {
 
     uint32_t* output = (uint32_t*)out;
 
@@ -1,4 +1,4 @@
-void bitmask_avx512(uint32_t* ptr, size_t n, uint32_t key, uint8_t* out) {
+void bitmask_avx512(const uint32_t* ptr, size_t n, uint32_t key, uint8_t* out) {
 
     uint16_t* output = (uint16_t*)out;
 
@@ -159,22 +159,29 @@ int main() {
         puts("FAILED");
     }
 
-#ifdef HAVE_AVX2_INSTRUCTIONS
-    printf("bitmask_avx2... "); fflush(stdout);
-    if (test.run_all(bitmask_avx2)) {
-        puts("OK");
-    } else {
-        puts("FAILED");
+    if (cpu_has(CPU_AVX2)) {
+        printf("bitmask_avx2... "); fflush(stdout);
+        if (test.run_all(bitmask_avx2)) {
+            puts("OK");
+        } else {
+            puts("FAILED");
+        }
+    }
+
+    if (cpu_has(CPU_AVX512F)) {
+        printf("bitmask_avx512... "); fflush(stdout);
+        if (test.run_all(bitmask_avx512)) {
+            puts("OK");
+        } else {
+            puts("FAILED");
+        }
     }
-#endif
 
-#ifdef HAVE_AVX512_INSTRUCTIONS
-    printf("bitmask_avx512... "); fflush(stdout);
-    if (test.run_all(bitmask_avx512)) {
+    printf("bitmask (%s)... ", bitmask_name()); fflush(stdout);
+    if (test.run_all(bitmask)) {
         puts("OK");
     } else {
         puts("FAILED");
     }
-#endif
 
 }
@@ -6,6 +6,8 @@
 
 
 */
+#include "../common/bufalloc.h"
+#include "../common/bench.h"
 #include <iso646.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -20,8 +22,8 @@ int main(int argc, char* argv[]) {
 	int n = 0;
 	uint32_t* table   = NULL;
 	uint32_t* indexes = NULL;
-	clock_t ta1, ta2;
-	clock_t tb1, tb2;
+	buf_t table_buf, indexes_buf;
+	bench seq_scan, random_scan;
 	
 	if (argc < 2) {
 		fprintf(stderr, "program table_size\n");
@@ -34,40 +36,36 @@ int main(int argc, char* argv[]) {
 		return EXIT_FAILURE;
 	}
 
-	table   = malloc(sizeof(uint32_t)*n);
-	indexes = malloc(sizeof(uint32_t)*n);
-	if (table == NULL or indexes == NULL) {
-		if (table) free(table);
-		if (indexes) free(table);
-	}
+	table   = buf_alloc_or_die(&table_buf,   sizeof(uint32_t)*n);
+	indexes = buf_alloc_or_die(&indexes_buf, sizeof(uint32_t)*n);
 
 	seq(table, n);
 	seq(indexes, n);
 
-	printf("sequential scan... "); fflush(stdout);
-	ta1 = clock();
-		scanmem(table, indexes, n);
-	ta2 = clock();
-	printf("took %0.2fs\n", (double)(ta2 - ta1)/CLOCKS_PER_SEC);
+	bench_begin(&seq_scan, "sequential scan", 5, n);
+	seq_scan.bytes = 2*sizeof(uint32_t);
+	while (bench_next(&seq_scan))
+		BENCH_KEEP(scanmem(table, indexes, n));
+	bench_report(&seq_scan);
 
 	printf("shuffling indexes... "); fflush(stdout);
 	srand(time(NULL));
 	shuffle(indexes, n);
 	putchar('\n');
 	
-	printf("random scan... "); fflush(stdout);
-	tb1 = clock();
-		scanmem(table, indexes, n);
-	tb2 = clock();
-	printf("took %0.2fs\n", (double)(tb2 - tb1)/CLOCKS_PER_SEC);
-
-	if (tb2 - tb1 != 0) {
-		printf("slower %0.3f times\n", (double)(tb2 - tb1)/(ta2 - ta1));
+	bench_begin(&random_scan, "random scan", 5, n);
+	random_scan.bytes = 2*sizeof(uint32_t);
+	while (bench_next(&random_scan))
+		BENCH_KEEP(scanmem(table, indexes, n));
+	bench_report(&random_scan);
+
+	if (seq_scan.result.median_ns > 0) {
+		printf("slower %0.3f times\n", random_scan.result.median_ns/seq_scan.result.median_ns);
 	}
 
 
-	free(table);
-	free(indexes);
+	buf_free(&table_buf);
+	buf_free(&indexes_buf);
 	return EXIT_SUCCESS;
 }
 /*------------------------------------------------------------------------*/
@@ -0,0 +1,483 @@
+/*
+
+	Memory hierarchy characterization
+
+	Tests:
+
+	* latency   --- pointer chase over working sets from 4 KB up to
+	                the given maximum, with configurable stride;
+	* bandwidth --- streaming read, write and copy, per thread and
+	                aggregated over 1 .. T threads (from the earliest
+	                start to the latest end of a run); threads are
+	                pinned to CPUs allowed for the process;
+	* tlb       --- random chase with one access per 4 KB, the same
+	                memory backed by 4 KB pages and 2 MB huge pages;
+	* prefetch  --- sequential vs random chase for strides 64 B .. 4 KB,
+	                shows when hardware prefetchers stop helping.
+
+	Results are printed as CSV:
+
+		test,pattern,pages,threads,size,stride,metric,value
+
+*/
+#include "../common/bufalloc.h"
+#include <iso646.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#define KB (1024ul)
+#define MB (1024ul*KB)
+#define GB (1024ul*MB)
+
+/* options */
+static size_t    min_size    = 4*KB;
+static size_t    max_size    = 256*MB;
+static size_t    stride      = 64;
+static size_t    accesses    = 1ul << 22;
+static size_t    bw_size     = 64*MB;
+static int       max_threads = 0;
+static buf_pages pages       = BUF_PAGES_4K;
+
+/*------------------------------------------------------------------------*/
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+
+static uint64_t rng(void) {
+	/* xorshift64* */
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545f4914f6cdd1dull;
+}
+
+/*------------------------------------------------------------------------*/
+
+/*
+	Buffers come from ../common/bufalloc.h: pre-faulted, page kind as
+	requested (explicit 2 MB pages if reserved, THP otherwise).
+*/
+static int buffer_alloc(buf_t* b, size_t size, buf_pages kind) {
+	buf_options opt = buf_default_options();
+	opt.pages = kind;
+	opt.align = 2*MB;
+
+	return buf_alloc_opt(b, size, &opt);
+}
+
+/*------------------------------------------------------------------------*/
+
+/*
+	Builds a single cycle of pointers: n nodes placed every `stride`
+	bytes; nodes are visited in order (sequential) or in random order
+	(Sattolo's algorithm guarantees one cycle covering all nodes).
+*/
+static void** build_chain(char* mem, size_t n, size_t stride, int random) {
+	size_t* order = malloc(n * sizeof(size_t));
+	size_t i;
+
+	for (i=0; i < n; i++)
+		order[i] = i;
+
+	if (random) {
+		for (i=n - 1; i > 0; i--) {
+			const size_t j = rng() % i;
+			const size_t t = order[i];
+			order[i] = order[j];
+			order[j] = t;
+		}
+	}
+
+	for (i=0; i < n; i++) {
+		void** node = (void**)(mem + order[i]*stride);
+		*node = mem + order[(i + 1) % n]*stride;
+	}
+
+	void** start = (void**)(mem + order[0]*stride);
+	free(order);
+	return start;
+}
+
+static void* volatile sink;
+
+/* returns ns per access, the best of three runs */
+static double chase(void** start, size_t count) {
+	double best = 1e100;
+	int run;
+
+	for (run=0; run < 3; run++) {
+		void** p = start;
+		size_t i;
+
+		const double t1 = now();
+		for (i=0; i < count; i += 8) {
+			p = (void**)*p; p = (void**)*p; p = (void**)*p; p = (void**)*p;
+			p = (void**)*p; p = (void**)*p; p = (void**)*p; p = (void**)*p;
+		}
+		const double t2 = now();
+
+		sink = p;
+		if (t2 - t1 < best)
+			best = t2 - t1;
+	}
+
+	return best * 1e9 / count;
+}
+
+static void print_row(const char* test, const char* pattern, const char* kind,
+                      int threads, size_t size, size_t stride,
+                      const char* metric, double value) {
+	printf("%s,%s,%s,%d,%zu,%zu,%s,%0.3f\n",
+	       test, pattern, kind, threads, size, stride, metric, value);
+	fflush(stdout);
+}
+
+/*------------------------------------------------------------------------*/
+
+static void chase_row(const char* test, size_t size, size_t stride, int random, buf_pages kind) {
+	buf_t b;
+	if (buffer_alloc(&b, size, kind) < 0) {
+		fprintf(stderr, "can't allocate %zu bytes\n", size);
+		return;
+	}
+
+	const size_t n = size / stride;
+	if (n >= 2) {
+		void** start = build_chain(b.ptr, n, stride, random);
+		const double ns = chase(start, accesses);
+
+		print_row(test, random ? "random" : "sequential", buf_pages_name(b.pages),
+		          1, size, stride, "ns_per_access", ns);
+	}
+
+	buf_free(&b);
+}
+
+static void test_latency(void) {
+	size_t size;
+
+	for (size=min_size; size <= max_size; size *= 2) {
+		chase_row("latency", size, stride, 1, pages);
+	}
+}
+
+static void test_tlb(void) {
+	size_t size;
+
+	for (size=64*KB; size <= max_size; size *= 2) {
+		chase_row("tlb", size, 4*KB, 1, BUF_PAGES_4K);
+		chase_row("tlb", size, 4*KB, 1, BUF_PAGES_2M);
+	}
+}
+
+static void test_prefetch(void) {
+	/* large enough to not fit in any cache */
+	const size_t size = (max_size < 256*MB) ? max_size : 256*MB;
+	size_t s;
+
+	for (s=64; s <= 4*KB; s *= 2) {
+		chase_row("prefetch", size, s, 0, pages);
+		chase_row("prefetch", size, s, 1, pages);
+	}
+}
+
+/*------------------------------------------------------------------------*/
+
+typedef enum {
+	BW_READ,
+	BW_WRITE,
+	BW_COPY
+} bw_kind;
+
+#define BW_RUNS 3
+
+typedef struct {
+	pthread_t         thread;
+	int               cpu;		/* -1: not pinned */
+	bw_kind           kind;
+	size_t            size;
+	buf_pages         pages;
+	buf_pages         used;		/* pages actually obtained */
+	pthread_barrier_t* barrier;
+	double            seconds;	/* the best run of this thread */
+	double            start[BW_RUNS];	/* of each run, to get the time of all threads */
+	double            end[BW_RUNS];
+	uint64_t          result;
+	int               failed;	/* buffers couldn't be allocated */
+} bw_thread;
+
+static uint64_t bw_read(const uint64_t* p, size_t n) {
+	uint64_t a = 0, b = 0, c = 0, d = 0;
+	size_t i;
+	for (i=0; i < n; i += 4) {
+		a += p[i + 0];
+		b += p[i + 1];
+		c += p[i + 2];
+		d += p[i + 3];
+	}
+	return a + b + c + d;
+}
+
+static void bw_write(uint64_t* p, size_t n, uint64_t v) {
+	size_t i;
+	for (i=0; i < n; i++)
+		p[i] = v;
+}
+
+static void* bw_worker(void* arg) {
+	bw_thread* t = arg;
+	buf_t src, dst;
+	int run;
+
+	if (t->cpu >= 0) {
+		cpu_set_t set;
+		int err;
+		CPU_ZERO(&set);
+		CPU_SET(t->cpu, &set);
+		err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+		if (err != 0)
+			fprintf(stderr, "can't pin thread to CPU %d: %s\n", t->cpu, strerror(err));
+	}
+
+	/* first touch happens in the worker thread, thus memory is local on NUMA */
+	memset(&dst, 0, sizeof(dst));
+	if (buffer_alloc(&src, t->size, t->pages) < 0 or buffer_alloc(&dst, t->size, t->pages) < 0) {
+		fprintf(stderr, "can't allocate 2 x %zu bytes\n", t->size);
+		t->failed = 1;
+	}
+	t->used = src.pages;
+
+	const size_t n = t->size / sizeof(uint64_t);
+
+	t->seconds = 1e100;
+	for (run=0; run < BW_RUNS; run++) {
+		pthread_barrier_wait(t->barrier);
+		/* still at barriers, other threads wait there */
+		if (t->failed)
+			continue;
+
+		const double t1 = now();
+		switch (t->kind) {
+			case BW_READ:
+				t->result += bw_read(src.ptr, n);
+				break;
+			case BW_WRITE:
+				bw_write(dst.ptr, n, run);
+				break;
+			case BW_COPY:
+				memcpy(dst.ptr, src.ptr, t->size);
+				break;
+		}
+		const double t2 = now();
+
+		t->start[run] = t1;
+		t->end[run]   = t2;
+		if (t2 - t1 < t->seconds)
+			t->seconds = t2 - t1;
+	}
+
+	buf_free(&src);
+	buf_free(&dst);
+	return NULL;
+}
+
+static void bandwidth_row(bw_kind kind, int threads) {
+	static const char* names[] = {"read", "write", "copy"};
+	/* threads are pinned to distinct CPUs the process may run on */
+	int cpus[CPU_SETSIZE];
+	int ncpus = 0;
+	cpu_set_t allowed;
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+		int cpu;
+		for (cpu=0; cpu < CPU_SETSIZE; cpu++)
+			if (CPU_ISSET(cpu, &allowed))
+				cpus[ncpus++] = cpu;
+	} else
+		perror("sched_getaffinity");
+
+	bw_thread* t = calloc(threads, sizeof(bw_thread));
+	pthread_barrier_t barrier;
+	pthread_barrier_init(&barrier, NULL, threads);
+
+	int i, run;
+	for (i=0; i < threads; i++) {
+		t[i].cpu     = (threads <= ncpus) ? cpus[i] : -1;
+		t[i].kind    = kind;
+		t[i].size    = bw_size;
+		t[i].pages   = pages;
+		t[i].barrier = &barrier;
+		pthread_create(&t[i].thread, NULL, bw_worker, &t[i]);
+	}
+
+	double per_thread = 0.0;
+	int failed = 0;
+	for (i=0; i < threads; i++) {
+		pthread_join(t[i].thread, NULL);
+		failed |= t[i].failed;
+		per_thread += bw_size / t[i].seconds;
+	}
+
+	/* the total comes from the time all threads took together in a run:
+	   from the earliest start to the latest end; the best run is kept */
+	double best = 1e100;
+	for (run=0; run < BW_RUNS; run++) {
+		double start = t[0].start[run];
+		double end   = t[0].end[run];
+		for (i=1; i < threads; i++) {
+			if (t[i].start[run] < start)
+				start = t[i].start[run];
+			if (t[i].end[run] > end)
+				end = t[i].end[run];
+		}
+
+		if (end - start < best)
+			best = end - start;
+	}
+
+	/* copy reads and writes each byte */
+	const double factor = (kind == BW_COPY) ? 2.0 : 1.0;
+	if (not failed) {
+		print_row("bandwidth", names[kind], buf_pages_name(t[0].used), threads, bw_size, 0,
+		          "GBps_per_thread", factor * per_thread / threads / 1e9);
+		print_row("bandwidth", names[kind], buf_pages_name(t[0].used), threads, bw_size, 0,
+		          "GBps_total", factor * threads * bw_size / best / 1e9);
+	}
+
+	pthread_barrier_destroy(&barrier);
+	free(t);
+}
+
+/* 1, 2, 4, ... below max_threads, then max_threads */
+static void test_bandwidth(void) {
+	int counts[8*sizeof(int) + 1];
+	int n = 0;
+	int threads, i;
+
+	for (threads=1; threads < max_threads; threads *= 2)
+		counts[n++] = threads;
+	counts[n++] = max_threads;
+
+	for (i=0; i < n; i++) {
+		bandwidth_row(BW_READ,  counts[i]);
+		bandwidth_row(BW_WRITE, counts[i]);
+		bandwidth_row(BW_COPY,  counts[i]);
+	}
+}
+
+/*------------------------------------------------------------------------*/
+
+static size_t parse_size(const char* s) {
+	char* end;
+	size_t v = strtoull(s, &end, 0);
+	switch (*end) {
+		case 'k': case 'K': v *= KB; break;
+		case 'm': case 'M': v *= MB; break;
+		case 'g': case 'G': v *= GB; break;
+	}
+	return v;
+}
+
+static void usage(const char* prog) {
+	fprintf(stderr,
+		"usage: %s [options] [latency|bandwidth|tlb|prefetch|all]...\n"
+		"\n"
+		"  -m size     minimal working set (default 4K)\n"
+		"  -M size     maximal working set (default 256M, up to 4G makes sense)\n"
+		"  -s bytes    stride of pointer chase (default 64)\n"
+		"  -n count    number of accesses in a chase (default 4194304)\n"
+		"  -b size     bandwidth buffer per thread (default 64M)\n"
+		"  -t threads  max number of threads for bandwidth (default: all CPUs)\n"
+		"  -p 4k|thp|2m|1g  pages used by latency, bandwidth and prefetch tests\n"
+		"              (default: BUFALLOC_PAGES or 4k)\n"
+		"\n"
+		"sizes accept suffixes K, M and G\n", prog);
+}
+
+int main(int argc, char* argv[]) {
+	int opt;
+
+	max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	pages       = buf_default_options().pages;
+
+	while ((opt = getopt(argc, argv, "m:M:s:n:b:t:p:h")) != -1) {
+		switch (opt) {
+			case 'm': min_size    = parse_size(optarg); break;
+			case 'M': max_size    = parse_size(optarg); break;
+			case 's': stride      = parse_size(optarg); break;
+			case 'n': accesses    = parse_size(optarg); break;
+			case 'b': bw_size     = parse_size(optarg); break;
+			case 't': max_threads = atoi(optarg); break;
+			case 'p':
+				if (strcasecmp(optarg, "4k") == 0)
+					pages = BUF_PAGES_4K;
+				else if (strcasecmp(optarg, "thp") == 0)
+					pages = BUF_PAGES_THP;
+				else if (strcasecmp(optarg, "2m") == 0)
+					pages = BUF_PAGES_2M;
+				else if (strcasecmp(optarg, "1g") == 0)
+					pages = BUF_PAGES_1G;
+				else {
+					fprintf(stderr, "unknown kind of pages '%s'\n", optarg);
+					usage(argv[0]);
+					return EXIT_FAILURE;
+				}
+				break;
+			default:
+				usage(argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	if (stride < sizeof(void*) or min_size < stride or max_threads < 1) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	accesses = (accesses + 7) / 8 * 8;
+
+	int all = (optind == argc);
+	int i;
+	for (i=optind; i < argc; i++)
+		if (strcmp(argv[i], "all") == 0)
+			all = 1;
+
+	puts("test,pattern,pages,threads,size,stride,metric,value");
+
+	if (all) {
+		test_latency();
+		test_bandwidth();
+		test_tlb();
+		test_prefetch();
+		return EXIT_SUCCESS;
+	}
+
+	for (i=optind; i < argc; i++) {
+		if (strcmp(argv[i], "latency") == 0)
+			test_latency();
+		else if (strcmp(argv[i], "bandwidth") == 0)
+			test_bandwidth();
+		else if (strcmp(argv[i], "tlb") == 0)
+			test_tlb();
+		else if (strcmp(argv[i], "prefetch") == 0)
+			test_prefetch();
+		else {
+			fprintf(stderr, "unknown test '%s'\n", argv[i]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,67 @@
+// ASCII case conversion and fold_hash64 with the procedures selected at
+// runtime, the program is compiled with -DCHANGECASE_DISPATCH and without
+// -mavx2/-mavx512bw.  UTF-8 procedures are not dispatched, their vector
+// code is a template over ISA-specific structures.
+#include "foldhash.cpp"
+
+#ifndef CHANGECASE_DISPATCH
+#   error "compile with -DCHANGECASE_DISPATCH"
+#endif
+
+namespace dispatch {
+
+    typedef void (*inplace_fun)(char*, size_t);
+    typedef uint64_t (*hash_fun)(const char*, size_t);
+
+    const cpu_variant to_lower_variants[] = {
+        CPU_VARIANT(CPU_AVX512BW, avx512::to_lower_inplace),
+        CPU_VARIANT(CPU_AVX2,     avx2::to_lower_inplace),
+        CPU_VARIANT(0,            swar::to_lower_inplace),
+    };
+
+    const cpu_variant to_upper_variants[] = {
+        CPU_VARIANT(CPU_AVX512BW, avx512::to_upper_inplace),
+        CPU_VARIANT(CPU_AVX2,     avx2::to_upper_inplace),
+        CPU_VARIANT(0,            swar::to_upper_inplace),
+    };
+
+    const cpu_variant hash64_variants[] = {
+        CPU_VARIANT(CPU_AVX512BW, hash64_avx512),
+        CPU_VARIANT(CPU_AVX2,     hash64_avx2),
+        CPU_VARIANT(0,            hash64_scalar),
+    };
+
+    const cpu_variant fold_hash64_variants[] = {
+        CPU_VARIANT(CPU_AVX512BW, fold_hash64_avx512),
+        CPU_VARIANT(CPU_AVX2,     fold_hash64_avx2),
+        CPU_VARIANT(0,            fold_hash64_scalar),
+    };
+
+    // function-local statics are initialized at the first call
+    template <typename FUN, size_t N>
+    FUN resolve(const cpu_variant (&variants)[N]) {
+        return (FUN)cpu_select_n(variants, N)->fun;
+    }
+
+} // namespace dispatch
+
+
+void to_lower_inplace(char* s, size_t n) {
+    static const auto fun = dispatch::resolve<dispatch::inplace_fun>(dispatch::to_lower_variants);
+    fun(s, n);
+}
+
+void to_upper_inplace(char* s, size_t n) {
+    static const auto fun = dispatch::resolve<dispatch::inplace_fun>(dispatch::to_upper_variants);
+    fun(s, n);
+}
+
+uint64_t hash64(const char* s, size_t n) {
+    static const auto fun = dispatch::resolve<dispatch::hash_fun>(dispatch::hash64_variants);
+    return fun(s, n);
+}
+
+uint64_t fold_hash64(const char* s, size_t n) {
+    static const auto fun = dispatch::resolve<dispatch::hash_fun>(dispatch::fold_hash64_variants);
+    return fun(s, n);
+}
@@ -0,0 +1,227 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "tolower.cpp"
+
+#ifndef FORCE_INLINE
+#   define FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+// Case-insensitive hashing: ASCII letters are lowercased on the fly, the
+// lowercased string is never stored.
+//
+// The hash is designed for SIMD, unlike byte-serial FNV: input is split
+// into 64-byte stripes, each is eight little-endian 64-bit words; the word
+// w[i] goes to accumulator i:
+//
+//     d      = w[i] ^ key[i]
+//     acc[i] = acc[i] + lo32(d) * hi32(d) + w[i]
+//
+// That's a single vpmuludq per four (AVX2) or eight (AVX-512) words.  The
+// last, partial stripe is padded with zeros; then the length and all
+// accumulators are mixed into the 64-bit result (see finalize).  All implementations give
+// the same values, thus fold_hash64_xxx(s) == hash64_scalar(to_lower(s)).
+
+namespace foldhash {
+
+    const uint64_t keys[8] = {
+        0x243f6a8885a308d3u, 0x13198a2e03707344u, 0xa4093822299f31d0u, 0x082efa98ec4e6c89u,
+        0x452821e638d01377u, 0xbe5466cf34e90c6cu, 0xc0ac29b7c97c50ddu, 0x3f84d5b5b5470917u,
+    };
+
+    const uint64_t prime = 0x9e3779b185ebca87u;
+
+    // murmur3 finalizer
+    uint64_t mix(uint64_t h) {
+
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdu;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53u;
+        h ^= h >> 33;
+
+        return h;
+    }
+
+    __extension__ typedef unsigned __int128 uint128_t;
+
+    // 64 x 64 -> 128-bit product, halves xored
+    uint64_t mul_fold(uint64_t a, uint64_t b) {
+
+        const uint128_t p = uint128_t(a) * b;
+
+        return uint64_t(p) ^ uint64_t(p >> 64);
+    }
+
+    // pairs of accumulators are multiplied, four independent products
+    // cost less than mixing accumulators one by one -- it matters for
+    // short keys
+    uint64_t finalize(const uint64_t acc[8], size_t n) {
+
+        uint64_t h = n * prime;
+        for (int i=0; i < 8; i += 2) {
+            h += mul_fold(acc[i] ^ keys[i + 1], acc[i + 1] ^ keys[i]);
+        }
+
+        return mix(h);
+    }
+
+
+    // swar::to_lower_ascii for any bytes: MSBs are cleared before additions,
+    // thus there are no carries, and non-ASCII bytes are excluded
+    uint64_t fold_word(uint64_t chars) {
+
+        const uint64_t low = chars & packed_byte(0x7f);
+        const uint64_t A = low + packed_byte(128 - 'A');
+        const uint64_t Z = low + packed_byte(128 - 'Z' - 1);
+
+        return chars ^ (((A ^ Z) & ~chars & packed_byte(0x80)) >> 2);
+    }
+
+
+    template <bool fold>
+    FORCE_INLINE void accumulate(uint64_t& acc, uint64_t w, uint64_t key) {
+
+        if (fold) {
+            w = fold_word(w);
+        }
+
+        const uint64_t d = w ^ key;
+        acc += (d & 0xffffffff) * (d >> 32) + w;
+    }
+
+    // the last, partial stripe of n < 64 bytes, read word by word
+    template <bool fold>
+    void accumulate_tail(uint64_t acc[8], const char* s, size_t n) {
+
+        for (size_t i=0; i < 8; i++) {
+            uint64_t w = 0;
+            if (8*i < n) {
+                memcpy(&w, s + 8*i, std::min(n - 8*i, size_t(8)));
+            }
+
+            accumulate<fold>(acc[i], w, keys[i]);
+        }
+    }
+
+    template <bool fold>
+    uint64_t hash_scalar(const char* s, size_t n) {
+
+        uint64_t acc[8];
+        memcpy(acc, keys, sizeof(acc));
+
+        size_t i;
+        for (i=0; i + 64 <= n; i += 64) {
+            for (int k=0; k < 8; k++) {
+                uint64_t w;
+                memcpy(&w, s + i + 8*k, 8);
+                accumulate<fold>(acc[k], w, keys[k]);
+            }
+        }
+
+        if (i < n) {
+            accumulate_tail<fold>(acc, s + i, n - i);
+        }
+
+        return finalize(acc, n);
+    }
+
+
+#ifdef HAVE_AVX2_INSTRUCTIONS
+CHANGECASE_TARGET_BEGIN("avx2")
+    template <bool fold>
+    uint64_t hash_avx2(const char* s, size_t n) {
+
+        const __m256i key0 = _mm256_loadu_si256((const __m256i*)(keys + 0));
+        const __m256i key1 = _mm256_loadu_si256((const __m256i*)(keys + 4));
+        __m256i acc0 = key0;
+        __m256i acc1 = key1;
+
+        size_t i;
+        for (i=0; i + 64 <= n; i += 64) {
+            __m256i w0 = _mm256_loadu_si256((const __m256i*)(s + i));
+            __m256i w1 = _mm256_loadu_si256((const __m256i*)(s + i + 32));
+            if (fold) {
+                w0 = avx2::to_lower_ascii(w0);
+                w1 = avx2::to_lower_ascii(w1);
+            }
+
+            const __m256i d0 = _mm256_xor_si256(w0, key0);
+            const __m256i d1 = _mm256_xor_si256(w1, key1);
+            acc0 = _mm256_add_epi64(acc0, _mm256_add_epi64(_mm256_mul_epu32(d0, _mm256_srli_epi64(d0, 32)), w0));
+            acc1 = _mm256_add_epi64(acc1, _mm256_add_epi64(_mm256_mul_epu32(d1, _mm256_srli_epi64(d1, 32)), w1));
+        }
+
+        uint64_t acc[8];
+        _mm256_storeu_si256((__m256i*)(acc + 0), acc0);
+        _mm256_storeu_si256((__m256i*)(acc + 4), acc1);
+
+        if (i < n) {
+            accumulate_tail<fold>(acc, s + i, n - i);
+        }
+
+        return finalize(acc, n);
+    }
+CHANGECASE_TARGET_END
+#endif
+
+
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+CHANGECASE_TARGET_BEGIN("avx512bw")
+    template <bool fold>
+    uint64_t hash_avx512(const char* s, size_t n) {
+
+        const __m512i key = _mm512_loadu_si512((const __m512i*)keys);
+        __m512i acc = key;
+
+        size_t i;
+        for (i=0; i + 64 <= n; i += 64) {
+            __m512i w = _mm512_loadu_si512((const __m512i*)(s + i));
+            if (fold) {
+                w = avx512::to_lower_ascii(w);
+            }
+
+            const __m512i d = _mm512_xor_si512(w, key);
+            acc = _mm512_add_epi64(acc, _mm512_add_epi64(_mm512_mul_epu32(d, _mm512_srli_epi64(d, 32)), w));
+        }
+
+        // a masked load pads the tail with zeros
+        if (i < n) {
+            __m512i w = _mm512_maskz_loadu_epi8((uint64_t(1) << (n - i)) - 1, s + i);
+            if (fold) {
+                w = avx512::to_lower_ascii(w);
+            }
+
+            const __m512i d = _mm512_xor_si512(w, key);
+            acc = _mm512_add_epi64(acc, _mm512_add_epi64(_mm512_mul_epu32(d, _mm512_srli_epi64(d, 32)), w));
+        }
+
+        uint64_t result[8];
+        _mm512_storeu_si512((__m512i*)result, acc);
+
+        return finalize(result, n);
+    }
+CHANGECASE_TARGET_END
+#endif
+
+} // namespace foldhash
+
+
+uint64_t hash64_scalar(const char* s, size_t n)      { return foldhash::hash_scalar<false>(s, n); }
+uint64_t fold_hash64_scalar(const char* s, size_t n) { return foldhash::hash_scalar<true>(s, n); }
+
+#ifdef HAVE_AVX2_INSTRUCTIONS
+CHANGECASE_TARGET_BEGIN("avx2")
+uint64_t hash64_avx2(const char* s, size_t n)        { return foldhash::hash_avx2<false>(s, n); }
+uint64_t fold_hash64_avx2(const char* s, size_t n)   { return foldhash::hash_avx2<true>(s, n); }
+CHANGECASE_TARGET_END
+#endif
+
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+CHANGECASE_TARGET_BEGIN("avx512bw")
+uint64_t hash64_avx512(const char* s, size_t n)      { return foldhash::hash_avx512<false>(s, n); }
+uint64_t fold_hash64_avx512(const char* s, size_t n) { return foldhash::hash_avx512<true>(s, n); }
+CHANGECASE_TARGET_END
+#endif
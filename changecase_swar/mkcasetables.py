@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+
+"""
+Generates casetables.h, the Unicode simple case mappings used by utf8case.cpp.
+
+Python's str methods implement the full mappings (SpecialCasing.txt), the
+simple ones (UnicodeData.txt, CaseFolding.txt status C+S) are recovered:
+
+* lower -- the first character of lower(), only U+0130 has a longer one;
+* upper -- upper() if it's a single character, otherwise title() (Greek
+  letters with ypogegrammeni), otherwise no mapping (like U+00DF);
+* fold  -- casefold() if it's a single character, otherwise lower().
+"""
+
+import sys
+import unicodedata
+
+
+def simple_lower(c):
+    return ord(chr(c).lower()[0])
+
+
+def simple_upper(c):
+    s = chr(c).upper()
+    if len(s) > 1:
+        s = chr(c).title()
+
+    return ord(s) if len(s) == 1 else c
+
+
+def simple_fold(c):
+    s = chr(c).casefold()
+    if len(s) > 1:
+        s = chr(c).lower()
+
+    return ord(s) if len(s) == 1 else c
+
+
+def mappings(function):
+    result = {}
+    for c in range(0x110000):
+        if 0xd800 <= c <= 0xdfff:
+            continue
+
+        m = function(c)
+        if m != c:
+            result[c] = m
+
+    return result
+
+
+def get_runs(mapping):
+    """
+    Groups code points into runs (first, last, delta, step): each step-th
+    code point from range [first, last] maps to code point + delta.
+    Alternating upper/lower pairs give runs with step 2.
+    """
+
+    runs = []
+    for c in sorted(mapping):
+        delta = mapping[c] - c
+        if runs:
+            first, last, d, step = runs[-1]
+            if d == delta:
+                if first == last and c - last in (1, 2):
+                    runs[-1] = (first, c, d, c - last)
+                    continue
+
+                if c - last == step:
+                    runs[-1] = (first, c, d, step)
+                    continue
+
+        runs.append((c, c, delta, 1))
+
+    return runs
+
+
+def get_blocks(mapping):
+    """
+    Tables for two-byte sequences (U+0080..U+07FF), indexed by code point >> 4:
+
+    * delta -- the code point difference, packed as ((delta >> 6) & 3) << 6 | (delta & 63),
+      thus range is -128..127;
+    * apply -- 16-bit mask, code points in the block that map to code point + delta;
+    * except -- 16-bit mask, code points having other mappings (the slow path).
+    """
+
+    delta  = [0] * 128
+    apply  = [0] * 128
+    except_ = [0] * 128
+
+    for block in range(8, 128):
+        counts = {}
+        for c in range(block * 16, block * 16 + 16):
+            m = mapping.get(c, c)
+            d = m - c
+            if m != c and 0x80 <= m <= 0x7ff and -128 <= d <= 127:
+                counts[d] = counts.get(d, 0) + 1
+
+        best = 0
+        if counts:
+            best = max(sorted(counts), key=lambda d: counts[d])
+
+        for c in range(block * 16, block * 16 + 16):
+            m = mapping.get(c, c)
+            if m == c:
+                continue
+
+            bit = 1 << (c % 16)
+            if m - c == best and 0x80 <= m <= 0x7ff:
+                apply[block] |= bit
+            else:
+                except_[block] |= bit
+
+        delta[block] = (((best >> 6) & 3) << 6) | (best & 63)
+
+    return [
+        delta,
+        [m & 0xff for m in apply],
+        [m >> 8 for m in apply],
+        [m & 0xff for m in except_],
+        [m >> 8 for m in except_],
+    ]
+
+
+def chained(table):
+    # row k is xored with row k - 1, see lookup in utf8case.cpp
+    result = table[:16]
+    for i in range(16, 128):
+        result.append(table[i] ^ table[i - 16])
+
+    return result
+
+
+def check_assumptions(mapping, name):
+
+    for c, m in mapping.items():
+        if c < 0x80:
+            assert m < 0x80, "%s: ASCII U+%04X maps outside ASCII" % (name, c)
+
+        # the vector code grows UTF-8 at most by half
+        assert len(chr(m).encode('utf-8')) * 2 <= len(chr(c).encode('utf-8')) * 3
+
+    # three-byte sequences with these leading bytes are copied in vectors
+    for lead in [0xe0] + list(range(0xe3, 0xea)) + list(range(0xeb, 0xef)):
+        first = (lead & 0x0f) << 12
+        for c in range(max(first, 0x800), first + 0x1000):
+            assert c not in mapping, "%s: U+%04X has a mapping" % (name, c)
+
+
+def format_bytes(table, indent):
+    lines = []
+    for i in range(0, len(table), 16):
+        lines.append(indent + ', '.join('0x%02x' % x for x in table[i:i + 16]) + ',')
+
+    return '\n'.join(lines)
+
+
+def generate(name, function):
+
+    mapping = mappings(function)
+    check_assumptions(mapping, name)
+
+    runs   = get_runs(mapping)
+    blocks = get_blocks(mapping)
+    ascii  = 'A' if name in ('lower', 'fold') else 'a'
+
+    lines = []
+    lines.append('    // %d code points, %d runs' % (len(mapping), len(runs)))
+    lines.append('    const Run %s_runs[] = {' % name)
+    for first, last, delta, step in runs:
+        lines.append('        {0x%04x, 0x%04x, %d, %d},' % (first, last, delta, step))
+    lines.append('    };')
+    lines.append('')
+
+    for suffix, transform in (('blocks', lambda t: t), ('blocks_chained', chained)):
+        lines.append('    const uint8_t %s_%s[5][128] = {' % (name, suffix))
+        for table in blocks:
+            lines.append('        {')
+            lines.append(format_bytes(transform(table), ' ' * 12))
+            lines.append('        },')
+        lines.append('    };')
+        lines.append('')
+
+    lines.append('    const Tables %s = {' % name)
+    lines.append("        %s_runs, %d, '%s', %s_blocks, %s_blocks_chained" % (name, len(runs), ascii, name, name))
+    lines.append('    };')
+
+    return '\n'.join(lines)
+
+
+def main():
+
+    output = []
+    output.append('// Generated by mkcasetables.py from Unicode %s, do not edit.' % unicodedata.unidata_version)
+    output.append('')
+    output.append('namespace utf8case {')
+    output.append('')
+    output.append(generate('lower', simple_lower))
+    output.append('')
+    output.append(generate('upper', simple_upper))
+    output.append('')
+    output.append(generate('fold', simple_fold))
+    output.append('')
+    output.append('} // namespace utf8case')
+
+    path = sys.argv[1] if len(sys.argv) > 1 else 'casetables.h'
+    with open(path, 'w') as f:
+        f.write('\n'.join(output) + '\n')
+
+
+if __name__ == '__main__':
+    main()
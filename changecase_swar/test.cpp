@@ -5,7 +5,8 @@
 #include <cassert>
 
 #include "gettime.cpp"
-#include "tolower.cpp"
+#include "foldhash.cpp"
+#include "utf8case.cpp"
 #include "fnv32.cpp"
 
 class CommandLine;
@@ -24,6 +25,8 @@ public:
 
 private:
     char* load_file(const char* path, size_t size);
+    void test_utf8(const char* buf, size_t size);
+    void test_hashing(const char* buf, size_t size);
     void usage();
 };
 
@@ -94,10 +97,15 @@ char* Application::load_file(const char* path, size_t size) {
 
 void Application::run() {
 
-    const bool test_scalar = cmd.has("scalar") || cmd.has("both");
-    const bool test_swar   = cmd.has("swar") || cmd.has("both");
+    const bool test_scalar = cmd.has("scalar") || cmd.has("both") || cmd.has("all");
+    const bool test_swar   = cmd.has("swar") || cmd.has("both") || cmd.has("all");
+    const bool test_avx2   = cmd.has("avx2") || cmd.has("all");
+    const bool test_avx512 = cmd.has("avx512") || cmd.has("all");
+    const bool test_utf    = cmd.has("utf8");
+    const bool test_hash   = cmd.has("hash");
 
-    if (cmd.count() != 2 || (test_scalar == false && test_swar == false)) {
+    if (cmd.count() < 2 || (test_scalar == false && test_swar == false && test_avx2 == false &&
+                            test_avx512 == false && test_utf == false && test_hash == false)) {
         usage();
 
         throw Terminate();
@@ -108,38 +116,243 @@ void Application::run() {
     const size_t size  = count*MiB;
 
     char* buf = load_file(cmd.get(0), size);
-    double ts = 0.0;
 
-    if (test_scalar) {
+    // the in-place procedures below modify the buffer
+    if (test_utf) {
+        test_utf8(buf, size);
+    }
+
+    if (test_hash) {
+        test_hashing(buf, size);
+    }
+
+    typedef void (*inplace_fun)(char*, size_t);
+
+    struct Procedure {
+        const char* name;
+        bool        enabled;
+        inplace_fun to_lower;
+        inplace_fun to_upper;
+    };
+
+    const Procedure procedures[] = {
+        {"scalar", test_scalar, scalar::to_lower_inplace, scalar::to_upper_inplace},
+        {"SWAR",   test_swar,   swar::to_lower_inplace,   swar::to_upper_inplace},
+#ifdef HAVE_AVX2_INSTRUCTIONS
+        {"AVX2",   test_avx2,   avx2::to_lower_inplace,   avx2::to_upper_inplace},
+#endif
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+        {"AVX512", test_avx512, avx512::to_lower_inplace, avx512::to_upper_inplace},
+#endif
+    };
+
+    for (int upper=0; upper < 2; upper++) {
+
+        double ts = 0.0;
+        for (const auto& procedure: procedures) {
+            if (!procedure.enabled) {
+                continue;
+            }
+
+            printf("testing %-6s %s... ", procedure.name, upper ? "to upper" : "to lower"); std::fflush(stdout);
+
+            const inplace_fun fun = upper ? procedure.to_upper : procedure.to_lower;
+
+            const auto t1 = time();
+            fun(buf, size);
+            const auto t2 = time();
+            const double t = (t2 - t1)/1000000.0;
+
+            printf("%0.4f (hash: %08x)", t, FNV32::get(buf, size));
+            if (ts == 0.0) {
+                ts = t;
+            } else {
+                printf(" speedup = %0.2f", (ts/t));
+            }
+
+            putchar('\n');
+        }
+    }
+
+    delete[] buf;
+}
+
+
+void Application::test_utf8(const char* buf, size_t size) {
+
+    typedef size_t (*convert_fun)(const char*, size_t, char*);
+
+    struct Procedure {
+        const char* name;
+        convert_fun fun;
+    };
+
+    struct Conversion {
+        const char* name;
+        Procedure procedures[4];
+    };
+
+    const Conversion conversions[] = {
+        {"to lower", {
+            {"scalar", utf8_to_lower_scalar},
+            {"SSE",    utf8_to_lower_sse},
+#ifdef HAVE_AVX2_INSTRUCTIONS
+            {"AVX2",   utf8_to_lower_avx2},
+#endif
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+            {"AVX512", utf8_to_lower_avx512},
+#endif
+        }},
+        {"to upper", {
+            {"scalar", utf8_to_upper_scalar},
+            {"SSE",    utf8_to_upper_sse},
+#ifdef HAVE_AVX2_INSTRUCTIONS
+            {"AVX2",   utf8_to_upper_avx2},
+#endif
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+            {"AVX512", utf8_to_upper_avx512},
+#endif
+        }},
+        {"fold", {
+            {"scalar", utf8_fold_scalar},
+            {"SSE",    utf8_fold_sse},
+#ifdef HAVE_AVX2_INSTRUCTIONS
+            {"AVX2",   utf8_fold_avx2},
+#endif
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+            {"AVX512", utf8_fold_avx512},
+#endif
+        }},
+    };
+
+    char* out = new char[utf8case_max_size(size)];
+
+    for (const auto& conversion: conversions) {
+
+        printf("UTF-8 %s\n", conversion.name);
+
+        double ts = 0.0;
+        for (const auto& procedure: conversion.procedures) {
+            if (procedure.fun == nullptr) {
+                break;
+            }
+
+            printf("testing %-8s... ", procedure.name); std::fflush(stdout);
+
+            const auto t1 = time();
+            const size_t n = procedure.fun(buf, size, out);
+            const auto t2 = time();
+            const double t = (t2 - t1)/1000000.0;
+
+            printf("%0.4f (hash: %08x)", t, FNV32::get(out, n));
+            if (ts == 0.0) {
+                ts = t;
+            } else {
+                printf(" speedup = %0.2f", (ts/t));
+            }
+
+            putchar('\n');
+        }
+    }
+
+    delete[] out;
+}
+
+
+// case-insensitive hashing: lowercasing a copy and hashing it, or the fused fold_hash64
+namespace hashing {
 
-        printf("testing scalar... "); std::fflush(stdout);
+    typedef uint64_t (*hash_fun)(const char* s, size_t n, char* tmp);
 
-        const auto t1 = time();
-        scalar::to_lower_inplace(buf, size);
-        const auto t2 = time();
-        ts = (t2 - t1)/1000000.0;
+    uint64_t lower_fnv32(const char* s, size_t n, char* tmp) {
 
-        printf("%0.4f (hash: %08x)\n", ts, FNV32::get(buf, size));
+        memcpy(tmp, s, n);
+        swar::to_lower_inplace(tmp, n);
+
+        return FNV32::get(tmp, n);
+    }
+
+    uint64_t lower_hash64(const char* s, size_t n, char* tmp) {
+
+        memcpy(tmp, s, n);
+#if defined(HAVE_AVX512BW_INSTRUCTIONS)
+        avx512::to_lower_inplace(tmp, n);
+        return hash64_avx512(tmp, n);
+#elif defined(HAVE_AVX2_INSTRUCTIONS)
+        avx2::to_lower_inplace(tmp, n);
+        return hash64_avx2(tmp, n);
+#else
+        swar::to_lower_inplace(tmp, n);
+        return hash64_scalar(tmp, n);
+#endif
+    }
+
+    uint64_t fused_scalar(const char* s, size_t n, char*) { return fold_hash64_scalar(s, n); }
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    uint64_t fused_avx2(const char* s, size_t n, char*)   { return fold_hash64_avx2(s, n); }
+#endif
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+    uint64_t fused_avx512(const char* s, size_t n, char*) { return fold_hash64_avx512(s, n); }
+#endif
+
+} // namespace hashing
+
+
+void Application::test_hashing(const char* buf, size_t size) {
+
+    using namespace hashing;
+
+    struct Method {
+        const char* name;
+        hash_fun    fun;
+    };
+
+    const Method methods[] = {
+        {"to lower + FNV32",    lower_fnv32},
+        {"to lower + hash64",   lower_hash64},
+        {"fold_hash64 scalar",  fused_scalar},
+#ifdef HAVE_AVX2_INSTRUCTIONS
+        {"fold_hash64 AVX2",    fused_avx2},
+#endif
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+        {"fold_hash64 AVX512",  fused_avx512},
+#endif
+    };
+
+    const size_t lengths[] = {16, 64, 1024, size};
+
+    char* tmp = new char[size];
+
+    puts("case-insensitive hashing of keys, GB/s (checksum: xor of all hashes)");
+    printf("%-20s", "key length");
+    for (size_t length: lengths) {
+        printf(" | %-20lu", length);
     }
+    putchar('\n');
+
+    for (const auto& method: methods) {
+
+        printf("%-20s", method.name); std::fflush(stdout);
 
-    if (test_swar) {
+        for (size_t length: lengths) {
 
-        printf("testing SWAR...   "); std::fflush(stdout);
+            uint64_t checksum = 0;
 
-        const auto t1 = time();
-        swar::to_lower_inplace(buf, size);
-        const auto t2 = time();
-        const double t = (t2 - t1)/1000000.0;
+            const auto t1 = time();
+            for (size_t i=0; i + length <= size; i += length) {
+                checksum ^= method.fun(buf + i, length, tmp);
+            }
+            const auto t2 = time();
+            const double t = (t2 - t1)/1000000.0;
 
-        printf("%0.4f (hash: %08x)", t, FNV32::get(buf, size));
-        if (test_scalar) {
-            printf(" speedup = %0.2f", (ts/t));
+            printf(" | %5.2f (%012lx)", size/t/1e9, checksum & 0xffffffffffff);
+            std::fflush(stdout);
         }
 
         putchar('\n');
     }
 
-    delete buf;
+    delete[] tmp;
 }
 
 
@@ -152,6 +365,11 @@ void Application::usage() {
     puts("- scalar - test the scalar code");
     puts("- swar   - test the SWAR code");
     puts("- both   - test both implementations");
+    puts("- avx2   - test the AVX2 code (test_avx2)");
+    puts("- avx512 - test the AVX512BW code (test_avx512)");
+    puts("- all    - test all compiled-in implementations");
+    puts("- utf8   - test UTF-8 to lower/to upper/fold (scalar and SIMD)");
+    puts("- hash   - compare case-insensitive hashing: to lower + hash vs fused fold_hash64");
 }
 
 
@@ -0,0 +1,54 @@
+#include <immintrin.h>
+
+namespace avx2 {
+
+    // The A ^ Z trick from swar::to_lower_ascii_mask, on bytes: there are no
+    // carries between bytes, thus it's valid for any input; non-ASCII bytes
+    // are excluded by their MSB.
+    __m256i change_case_ascii_mask(__m256i chars, char first) {
+
+        const __m256i A = _mm256_add_epi8(chars, _mm256_set1_epi8(128 - first));
+        const __m256i Z = _mm256_add_epi8(chars, _mm256_set1_epi8(128 - first - 26));
+
+        // MSB[i] is set if chars[i] is a letter, bit 5 is moved by the 16-bit shift
+        const __m256i letter = _mm256_andnot_si256(chars, _mm256_xor_si256(A, Z));
+
+        return _mm256_and_si256(_mm256_srli_epi16(letter, 2), _mm256_set1_epi8(0x20));
+    }
+
+    __m256i to_lower_ascii(__m256i chars) {
+
+        return _mm256_xor_si256(chars, change_case_ascii_mask(chars, 'A'));
+    }
+
+    __m256i to_upper_ascii(__m256i chars) {
+
+        return _mm256_xor_si256(chars, change_case_ascii_mask(chars, 'a'));
+    }
+
+
+    void to_lower_inplace(char* s, size_t n) {
+
+        size_t i;
+        for (i=0; i + 32 <= n; i += 32) {
+            __m256i* chunk = reinterpret_cast<__m256i*>(s + i);
+
+            _mm256_storeu_si256(chunk, to_lower_ascii(_mm256_loadu_si256(chunk)));
+        }
+
+        scalar::to_lower_inplace(s + i, n - i);
+    }
+
+    void to_upper_inplace(char* s, size_t n) {
+
+        size_t i;
+        for (i=0; i + 32 <= n; i += 32) {
+            __m256i* chunk = reinterpret_cast<__m256i*>(s + i);
+
+            _mm256_storeu_si256(chunk, to_upper_ascii(_mm256_loadu_si256(chunk)));
+        }
+
+        scalar::to_upper_inplace(s + i, n - i);
+    }
+
+} // namespace avx2
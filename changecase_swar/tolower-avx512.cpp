@@ -0,0 +1,55 @@
+#include <immintrin.h>
+
+namespace avx512 {
+
+    // see avx2::change_case_ascii_mask; here a letter mask is a kmask
+    __m512i change_case_ascii(__m512i chars, char first) {
+
+        const __m512i A = _mm512_add_epi8(chars, _mm512_set1_epi8(128 - first));
+        const __m512i Z = _mm512_add_epi8(chars, _mm512_set1_epi8(128 - first - 26));
+
+        const __mmask64 letter = _mm512_movepi8_mask(_mm512_andnot_si512(chars, _mm512_xor_si512(A, Z)));
+
+        return _mm512_mask_blend_epi8(letter, chars, _mm512_xor_si512(chars, _mm512_set1_epi8(0x20)));
+    }
+
+    __m512i to_lower_ascii(__m512i chars) {
+
+        return change_case_ascii(chars, 'A');
+    }
+
+    __m512i to_upper_ascii(__m512i chars) {
+
+        return change_case_ascii(chars, 'a');
+    }
+
+
+    // the tail is processed with masked loads and stores
+    template <typename CHANGE_CASE>
+    void change_case_inplace(char* s, size_t n, CHANGE_CASE change_case) {
+
+        size_t i;
+        for (i=0; i + 64 <= n; i += 64) {
+            __m512i* chunk = reinterpret_cast<__m512i*>(s + i);
+
+            _mm512_storeu_si512(chunk, change_case(_mm512_loadu_si512(chunk)));
+        }
+
+        if (i < n) {
+            const __mmask64 mask = (uint64_t(1) << (n - i)) - 1;
+
+            _mm512_mask_storeu_epi8(s + i, mask, change_case(_mm512_maskz_loadu_epi8(mask, s + i)));
+        }
+    }
+
+    void to_lower_inplace(char* s, size_t n) {
+
+        change_case_inplace(s, n, to_lower_ascii);
+    }
+
+    void to_upper_inplace(char* s, size_t n) {
+
+        change_case_inplace(s, n, to_upper_ascii);
+    }
+
+} // namespace avx512
@@ -2,6 +2,20 @@
 #include <cstdint>
 #include <cctype>
 
+// CHANGECASE_DISPATCH: AVX2 and AVX512BW procedures are compiled in with
+// GCC target pragmas, dispatch.cpp selects them at runtime
+#ifdef CHANGECASE_DISPATCH
+#   include <immintrin.h>
+#   include "../common/cpudispatch.h"
+#   define HAVE_AVX2_INSTRUCTIONS
+#   define HAVE_AVX512BW_INSTRUCTIONS
+#   define CHANGECASE_TARGET_BEGIN(isa) CPU_TARGET_BEGIN(isa)
+#   define CHANGECASE_TARGET_END CPU_TARGET_END
+#else
+#   define CHANGECASE_TARGET_BEGIN(isa)
+#   define CHANGECASE_TARGET_END
+#endif
+
 namespace scalar {
 
     void to_lower_inplace(char* s, size_t n) {
@@ -18,6 +32,20 @@ namespace scalar {
         }
     }
 
+    void to_upper_inplace(char* s, size_t n) {
+
+        for (size_t j=0; j < n; j++) {
+
+            if (s[j] >= 'a' && s[j] <= 'z') {
+
+                s[j] ^= (1 << 5);
+            } else if (static_cast<unsigned char>(s[j]) >= '\x7f') {
+
+                s[j] = toupper(s[j]);
+            }
+        }
+    }
+
 } // namespace scalar
 
 
@@ -53,6 +81,20 @@ namespace swar {
         return result;
     }
 
+    uint64_t to_upper_ascii_mask(uint64_t chars) {
+
+        // the same as to_lower_ascii_mask, for range 'a'..'z'
+        const uint64_t A = chars + packed_byte(128 - 'a');
+        const uint64_t Z = chars + packed_byte(128 - 'z' - 1);
+
+        return (A ^ Z) & packed_byte(0x80);
+    }
+
+    uint64_t to_upper_ascii(uint64_t chars) {
+
+        return chars ^ (to_upper_ascii_mask(chars) >> 2);
+    }
+
 
     void to_lower_inplace(char* str, size_t n) {
 
@@ -83,5 +125,48 @@ namespace swar {
         }
     }
 
+
+    void to_upper_inplace(char* str, size_t n) {
+
+        char* s = str;
+
+        {
+            const size_t k = n / 8;
+            for (size_t i=0; i < k; i++, s+=8) {
+
+                uint64_t* chunk = reinterpret_cast<uint64_t*>(s);
+
+                if (is_ascii(*chunk)) {
+
+                    *chunk = to_upper_ascii(*chunk);
+                } else {
+
+                    scalar::to_upper_inplace(s, 8);
+                }
+            }
+        }
+
+        {
+            const size_t k = n % 8;
+
+            if (k) {
+                scalar::to_upper_inplace(s, k);
+            }
+        }
+    }
+
 } // namespace swar
 
+
+#ifdef HAVE_AVX2_INSTRUCTIONS
+CHANGECASE_TARGET_BEGIN("avx2")
+#   include "tolower-avx2.cpp"
+CHANGECASE_TARGET_END
+#endif
+
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+CHANGECASE_TARGET_BEGIN("avx512bw")
+#   include "tolower-avx512.cpp"
+CHANGECASE_TARGET_END
+#endif
+
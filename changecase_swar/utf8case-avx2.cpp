@@ -0,0 +1,62 @@
+namespace utf8case {
+
+    struct AVX2 {
+        typedef __m256i vec;
+        static const int size = 32;
+        static const uint64_t all = 0xffffffff;
+
+        static FORCE_INLINE vec load(const uint8_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+        static FORCE_INLINE void store(uint8_t* p, vec v) { _mm256_storeu_si256((__m256i*)p, v); }
+        static FORCE_INLINE vec zero() { return _mm256_setzero_si256(); }
+        static FORCE_INLINE vec set1(uint8_t x) { return _mm256_set1_epi8(x); }
+        static FORCE_INLINE vec set16(uint8_t a, uint8_t b, uint8_t c, uint8_t d, uint8_t e, uint8_t f, uint8_t g, uint8_t h) {
+            return _mm256_setr_epi8(a, b, c, d, e, f, g, h, a, b, c, d, e, f, g, h,
+                                    a, b, c, d, e, f, g, h, a, b, c, d, e, f, g, h);
+        }
+
+        static FORCE_INLINE vec add(vec a, vec b) { return _mm256_add_epi8(a, b); }
+        static FORCE_INLINE vec sub(vec a, vec b) { return _mm256_sub_epi8(a, b); }
+        static FORCE_INLINE vec and_(vec a, vec b) { return _mm256_and_si256(a, b); }
+        static FORCE_INLINE vec or_(vec a, vec b) { return _mm256_or_si256(a, b); }
+        static FORCE_INLINE vec xor_(vec a, vec b) { return _mm256_xor_si256(a, b); }
+        static FORCE_INLINE vec andnot(vec a, vec b) { return _mm256_andnot_si256(a, b); }
+        static FORCE_INLINE vec slli16(vec a, int n) { return _mm256_slli_epi16(a, n); }
+        static FORCE_INLINE vec srli16(vec a, int n) { return _mm256_srli_epi16(a, n); }
+        static FORCE_INLINE vec cmpeq(vec a, vec b) { return _mm256_cmpeq_epi8(a, b); }
+        static FORCE_INLINE vec cmpgt(vec a, vec b) { return _mm256_cmpgt_epi8(a, b); }
+        static FORCE_INLINE vec blend(vec a, vec b, vec mask) { return _mm256_blendv_epi8(a, b, mask); }
+        static FORCE_INLINE uint64_t movemask(vec a) { return uint32_t(_mm256_movemask_epi8(a)); }
+        static FORCE_INLINE bool any(vec a) { return !_mm256_testz_si256(a, a); }
+
+        // byte shifts within 128-bit lanes get the neighbour byte from the other lane
+        static FORCE_INLINE vec shift_up(vec a) {
+            return _mm256_alignr_epi8(a, _mm256_permute2x128_si256(a, a, 0x08), 15);
+        }
+
+        static FORCE_INLINE vec shift_down(vec a) {
+            return _mm256_alignr_epi8(_mm256_permute2x128_si256(a, a, 0x81), a, 1);
+        }
+
+        static FORCE_INLINE vec lookup16(vec table, vec index) { return _mm256_shuffle_epi8(table, index); }
+
+        // see SSE::lookup
+        static FORCE_INLINE vec lookup(const Tables& t, int table, vec index) {
+            const uint8_t* row = t.blocks_chained[table];
+
+            vec result = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)row)), index);
+            for (int k=1; k < 8; k++) {
+                const vec r = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(row + 16*k)));
+                index  = _mm256_sub_epi8(index, _mm256_set1_epi8(16));
+                result = _mm256_xor_si256(result, _mm256_shuffle_epi8(r, index));
+            }
+
+            return result;
+        }
+    };
+
+} // namespace utf8case
+
+
+size_t utf8_to_lower_avx2(const char* in, size_t n, char* out) { return utf8case::convert<utf8case::AVX2>(utf8case::lower, in, n, out); }
+size_t utf8_to_upper_avx2(const char* in, size_t n, char* out) { return utf8case::convert<utf8case::AVX2>(utf8case::upper, in, n, out); }
+size_t utf8_fold_avx2(const char* in, size_t n, char* out)     { return utf8case::convert<utf8case::AVX2>(utf8case::fold,  in, n, out); }
@@ -0,0 +1,72 @@
+namespace utf8case {
+
+    struct AVX512 {
+        typedef __m512i vec;
+        static const int size = 64;
+        static const uint64_t all = 0xffffffffffffffffu;
+
+        static FORCE_INLINE vec load(const uint8_t* p) { return _mm512_loadu_si512((const __m512i*)p); }
+        static FORCE_INLINE void store(uint8_t* p, vec v) { _mm512_storeu_si512((__m512i*)p, v); }
+        static FORCE_INLINE vec zero() { return _mm512_setzero_si512(); }
+        static FORCE_INLINE vec set1(uint8_t x) { return _mm512_set1_epi8(x); }
+        static FORCE_INLINE vec set16(uint8_t a, uint8_t b, uint8_t c, uint8_t d, uint8_t e, uint8_t f, uint8_t g, uint8_t h) {
+            return _mm512_broadcast_i32x4(_mm_setr_epi8(a, b, c, d, e, f, g, h, a, b, c, d, e, f, g, h));
+        }
+
+        static FORCE_INLINE vec add(vec a, vec b) { return _mm512_add_epi8(a, b); }
+        static FORCE_INLINE vec sub(vec a, vec b) { return _mm512_sub_epi8(a, b); }
+        static FORCE_INLINE vec and_(vec a, vec b) { return _mm512_and_si512(a, b); }
+        static FORCE_INLINE vec or_(vec a, vec b) { return _mm512_or_si512(a, b); }
+        static FORCE_INLINE vec xor_(vec a, vec b) { return _mm512_xor_si512(a, b); }
+        static FORCE_INLINE vec andnot(vec a, vec b) { return _mm512_andnot_si512(a, b); }
+        static FORCE_INLINE vec slli16(vec a, int n) { return _mm512_slli_epi16(a, n); }
+        static FORCE_INLINE vec srli16(vec a, int n) { return _mm512_srli_epi16(a, n); }
+
+        // comparisons yield masks, the common code wants byte vectors
+        static FORCE_INLINE vec cmpeq(vec a, vec b) { return _mm512_movm_epi8(_mm512_cmpeq_epi8_mask(a, b)); }
+        static FORCE_INLINE vec cmpgt(vec a, vec b) { return _mm512_movm_epi8(_mm512_cmpgt_epi8_mask(a, b)); }
+        static FORCE_INLINE vec blend(vec a, vec b, vec mask) { return _mm512_mask_blend_epi8(_mm512_movepi8_mask(mask), a, b); }
+        static FORCE_INLINE uint64_t movemask(vec a) { return _mm512_movepi8_mask(a); }
+        static FORCE_INLINE bool any(vec a) { return _mm512_test_epi8_mask(a, a) != 0; }
+
+        // see AVX2::shift_up, the neighbour 128-bit lane is moved by valignd
+        static FORCE_INLINE vec shift_up(vec a) {
+            return _mm512_alignr_epi8(a, _mm512_alignr_epi32(a, zero(), 12), 15);
+        }
+
+        static FORCE_INLINE vec shift_down(vec a) {
+            return _mm512_alignr_epi8(_mm512_alignr_epi32(zero(), a, 4), a, 1);
+        }
+
+        static FORCE_INLINE vec lookup16(vec table, vec index) { return _mm512_shuffle_epi8(table, index); }
+
+#ifdef __AVX512VBMI__
+        // a single vpermi2b does the whole 128-entry lookup
+        static FORCE_INLINE vec lookup(const Tables& t, int table, vec index) {
+            const uint8_t* row = t.blocks[table];
+
+            return _mm512_permutex2var_epi8(load(row), index, load(row + 64));
+        }
+#else
+        // see SSE::lookup
+        static FORCE_INLINE vec lookup(const Tables& t, int table, vec index) {
+            const uint8_t* row = t.blocks_chained[table];
+
+            vec result = _mm512_shuffle_epi8(_mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)row)), index);
+            for (int k=1; k < 8; k++) {
+                const vec r = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)(row + 16*k)));
+                index  = _mm512_sub_epi8(index, _mm512_set1_epi8(16));
+                result = _mm512_xor_si512(result, _mm512_shuffle_epi8(r, index));
+            }
+
+            return result;
+        }
+#endif
+    };
+
+} // namespace utf8case
+
+
+size_t utf8_to_lower_avx512(const char* in, size_t n, char* out) { return utf8case::convert<utf8case::AVX512>(utf8case::lower, in, n, out); }
+size_t utf8_to_upper_avx512(const char* in, size_t n, char* out) { return utf8case::convert<utf8case::AVX512>(utf8case::upper, in, n, out); }
+size_t utf8_fold_avx512(const char* in, size_t n, char* out)     { return utf8case::convert<utf8case::AVX512>(utf8case::fold,  in, n, out); }
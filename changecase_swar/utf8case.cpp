@@ -0,0 +1,386 @@
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <immintrin.h>
+
+#ifndef FORCE_INLINE
+#   define FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+// UTF-8 case conversion: to lower, to upper and simple case folding, i.e.
+// Unicode simple mappings, where a code point maps to a single code point.
+//
+// Output may differ in length from input -- U+0130 lowercased is ASCII 'i',
+// U+023A lowercased is U+2C65, a three-byte sequence -- thus conversion is
+// not in-place.  Invalid bytes are copied unchanged.
+//
+// Vector code (SSE, AVX2, AVX-512) processes chunks of 16, 32 or 64 bytes:
+//
+// * ASCII letters are converted with the A ^ Z trick, like in swar::to_lower_ascii;
+// * two-byte sequences (U+0080..U+07FF: Latin-1 supplement, Latin Extended-A
+//   and B, Greek, Cyrillic, Armenian) are converted in-vector: tables indexed
+//   by code point >> 4 give a delta and a mask of code points in the block
+//   which are mapped by adding the delta (see mkcasetables.py);
+// * three-byte sequences of scripts without case (CJK, Hangul, Indic, etc.)
+//   are copied.
+//
+// Anything else -- other multi-byte sequences, code points which don't
+// follow the delta of their block (like U+00FF -> U+0178), invalid bytes --
+// ends a chunk; such a character is converted by the scalar code: UTF-8
+// decoding, binary search in runs of mappings and encoding.
+
+
+// Size of output buffer: a code point never grows by more than half of
+// its encoding, and vector code stores whole chunks.
+size_t utf8case_max_size(size_t n) {
+    return n + n/2 + 64;
+}
+
+
+namespace utf8case {
+
+    // each step-th code point from range [first, last] maps to code point + delta
+    struct Run {
+        uint32_t first;
+        uint32_t last;
+        int32_t  delta;
+        uint32_t step;
+    };
+
+    // rows of block tables, each has 128 entries indexed by code point >> 4
+    enum {
+        block_delta,
+        block_apply_lo,
+        block_apply_hi,
+        block_except_lo,
+        block_except_hi
+    };
+
+    struct Tables {
+        const Run*     runs;
+        size_t         run_count;
+        char           ascii_first;             // 'A' or 'a' -- ASCII letters which change case
+        const uint8_t  (*blocks)[128];          // used by permutations
+        const uint8_t  (*blocks_chained)[128];  // used by pshufb, see vector lookup
+    };
+
+} // namespace utf8case
+
+#include "casetables.h"
+
+namespace utf8case {
+
+    uint32_t map(const Tables& t, uint32_t cp) {
+
+        const Run* end = t.runs + t.run_count;
+        const Run* run = std::upper_bound(t.runs, end, cp, [](uint32_t cp, const Run& run) {
+            return cp < run.first;
+        });
+
+        if (run == t.runs) {
+            return cp;
+        }
+
+        run -= 1;
+        if (cp <= run->last && (cp - run->first) % run->step == 0) {
+            return cp + run->delta;
+        }
+
+        return cp;
+    }
+
+
+    // returns the length of sequence, 0 if it's invalid (overlong, surrogate, truncated)
+    FORCE_INLINE int decode(const uint8_t* s, const uint8_t* end, uint32_t& cp) {
+
+        const uint8_t b0 = s[0];
+        const ptrdiff_t n = end - s;
+
+        if (b0 < 0xc2) {
+            return 0;
+        }
+
+        if (b0 < 0xe0) {
+            if (n < 2 || (s[1] & 0xc0) != 0x80) {
+                return 0;
+            }
+
+            cp = (uint32_t(b0 & 0x1f) << 6) | (s[1] & 0x3f);
+            return 2;
+        }
+
+        if (b0 < 0xf0) {
+            if (n < 3 || (s[1] & 0xc0) != 0x80 || (s[2] & 0xc0) != 0x80) {
+                return 0;
+            }
+
+            cp = (uint32_t(b0 & 0x0f) << 12) | (uint32_t(s[1] & 0x3f) << 6) | (s[2] & 0x3f);
+            if (cp < 0x800 || (cp >= 0xd800 && cp <= 0xdfff)) {
+                return 0;
+            }
+
+            return 3;
+        }
+
+        if (b0 < 0xf5) {
+            if (n < 4 || (s[1] & 0xc0) != 0x80 || (s[2] & 0xc0) != 0x80 || (s[3] & 0xc0) != 0x80) {
+                return 0;
+            }
+
+            cp = (uint32_t(b0 & 0x07) << 18) | (uint32_t(s[1] & 0x3f) << 12) | (uint32_t(s[2] & 0x3f) << 6) | (s[3] & 0x3f);
+            if (cp < 0x10000 || cp > 0x10ffff) {
+                return 0;
+            }
+
+            return 4;
+        }
+
+        return 0;
+    }
+
+
+    FORCE_INLINE uint8_t* encode(uint32_t cp, uint8_t* out) {
+
+        if (cp < 0x80) {
+            *out++ = cp;
+        } else if (cp < 0x800) {
+            *out++ = 0xc0 | (cp >> 6);
+            *out++ = 0x80 | (cp & 0x3f);
+        } else if (cp < 0x10000) {
+            *out++ = 0xe0 | (cp >> 12);
+            *out++ = 0x80 | ((cp >> 6) & 0x3f);
+            *out++ = 0x80 | (cp & 0x3f);
+        } else {
+            *out++ = 0xf0 | (cp >> 18);
+            *out++ = 0x80 | ((cp >> 12) & 0x3f);
+            *out++ = 0x80 | ((cp >> 6) & 0x3f);
+            *out++ = 0x80 | (cp & 0x3f);
+        }
+
+        return out;
+    }
+
+
+    // converts characters starting before limit
+    FORCE_INLINE void convert_chars(const Tables& t, const uint8_t*& in, const uint8_t* limit,
+                                    const uint8_t* end, uint8_t*& out) {
+
+        while (in < limit) {
+            const uint8_t b = *in;
+            if (b < 0x80) {
+                *out++ = (uint8_t(b - t.ascii_first) < 26) ? (b ^ 0x20) : b;
+                in += 1;
+                continue;
+            }
+
+            uint32_t cp;
+            const int length = decode(in, end, cp);
+            if (length == 0) {
+                *out++ = b;
+                in += 1;
+                continue;
+            }
+
+            out = encode(map(t, cp), out);
+            in += length;
+        }
+    }
+
+
+    size_t convert_scalar(const Tables& t, const char* input, size_t n, char* output) {
+
+        const uint8_t* in  = (const uint8_t*)input;
+        const uint8_t* end = in + n;
+        uint8_t* out = (uint8_t*)output;
+
+        convert_chars(t, in, end, end, out);
+
+        return out - (uint8_t*)output;
+    }
+
+
+    // V is a vector of V::size bytes, V::movemask yields a bit for each byte
+    template <typename V>
+    size_t convert(const Tables& t, const char* input, size_t n, char* output) {
+
+        typedef typename V::vec vec;
+
+        const uint8_t* in  = (const uint8_t*)input;
+        const uint8_t* end = in + n;
+        uint8_t* out = (uint8_t*)output;
+
+        const vec ascii_A = V::set1(128 - t.ascii_first);
+        const vec ascii_Z = V::set1(128 - t.ascii_first - 26);
+        const vec bits    = V::set16(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+        const uint64_t last = uint64_t(1) << (V::size - 1);
+
+        while (end - in >= V::size) {
+            const vec v = V::load(in);
+
+            // A ^ Z trick, MSB of non-ASCII bytes are cleared
+            const vec A = V::add(v, ascii_A);
+            const vec Z = V::add(v, ascii_Z);
+            const vec letter = V::andnot(v, V::xor_(A, Z));
+            vec result = V::xor_(v, V::and_(V::srli16(letter, 2), V::set1(0x20)));
+
+            const uint64_t nonascii = V::movemask(v);
+            if (nonascii == 0) {
+                V::store(out, result);
+                in  += V::size;
+                out += V::size;
+                continue;
+            }
+
+            // signed comparisons: 0x80..0xbf = -128..-65, 0xc2..0xdf = -62..-33, etc.
+            const vec cont  = V::cmpgt(V::set1(0xc0), v);
+            const vec lead2 = V::and_(V::cmpgt(v, V::set1(0xc1)), V::cmpgt(V::set1(0xe0), v));
+            const vec lead3 = V::or_(V::cmpeq(v, V::set1(0xe0)),
+                                       V::andnot(V::cmpeq(v, V::set1(0xea)),
+                                                 V::and_(V::cmpgt(v, V::set1(0xe2)), V::cmpgt(V::set1(0xef), v))));
+
+            const uint64_t cont_mask  = V::movemask(cont);
+            const uint64_t lead2_mask = V::movemask(lead2);
+            const uint64_t lead3_mask = V::movemask(lead3);
+            const uint64_t expected   = ((((lead2_mask | lead3_mask) << 1) | (lead3_mask << 2)) & V::all);
+
+            // bytes the vector code can't handle: other leading bytes,
+            // missing or unexpected continuation bytes, exceptions
+            uint64_t bad = (nonascii & ~(cont_mask | lead2_mask | lead3_mask)) | (cont_mask ^ expected);
+
+            // the last character might be incomplete, it's stored
+            // unchanged and converted in the next iteration
+            size_t length = V::size;
+            if ((lead2_mask | lead3_mask) & last) {
+                length -= 1;
+            } else if (lead3_mask & (last >> 1)) {
+                length -= 2;
+            }
+
+            const uint64_t pair_mask = cont_mask & (lead2_mask << 1);
+            if (pair_mask) {
+                const vec pair  = V::and_(cont, V::shift_up(lead2));
+                const vec lead  = V::shift_up(v);
+                const vec block = V::or_(V::slli16(V::and_(lead, V::set1(0x1f)), 2),
+                                         V::and_(V::srli16(v, 4), V::set1(0x03)));
+
+                // bit (code point & 15) of a 16-bit mask
+                const vec bit  = V::lookup16(bits, V::and_(v, V::set1(0x07)));
+                const vec high = V::cmpeq(V::and_(v, V::set1(0x08)), V::set1(0x08));
+
+                const vec except = V::blend(V::lookup(t, block_except_lo, block),
+                                            V::lookup(t, block_except_hi, block), high);
+                bad |= ~V::movemask(V::cmpeq(V::and_(except, bit), V::zero())) & pair_mask;
+
+                const vec mask  = V::blend(V::lookup(t, block_apply_lo, block),
+                                           V::lookup(t, block_apply_hi, block), high);
+                const vec apply = V::andnot(V::cmpeq(V::and_(mask, bit), V::zero()), pair);
+                const vec delta = V::and_(V::lookup(t, block_delta, block), apply);
+
+                // delta = 64 * dh + dl, where dh = -2..1, dl = 0..63
+                const vec dl = V::and_(delta, V::set1(0x3f));
+                const vec dh = V::sub(V::xor_(V::and_(V::srli16(delta, 6), V::set1(0x03)), V::set1(0x02)),
+                                      V::set1(0x02));
+
+                const vec low   = V::add(V::and_(v, V::set1(0x3f)), dl);
+                const vec carry = V::cmpgt(low, V::set1(0x3f));
+                const vec tail  = V::or_(V::and_(low, V::set1(0x3f)), V::set1(0x80));
+
+                result = V::blend(result, tail, apply);
+                result = V::add(result, V::shift_down(V::sub(dh, carry)));
+            }
+
+            if (bad) {
+                // bytes before the character having the first bad byte are
+                // valid, a lead byte left without continuation is invalid
+                // and copied, like scalar code does; the character itself
+                // is converted by the scalar code
+                const int first = __builtin_ctzll(bad);
+                const uint64_t starts = ~cont_mask & ((uint64_t(2) << first) - 1);
+                length = starts ? 63 - __builtin_clzll(starts) : 0;
+
+                if (length == 0) {
+                    convert_chars(t, in, in + 1, end, out);
+                    continue;
+                }
+            }
+
+            V::store(out, result);
+            in  += length;
+            out += length;
+        }
+
+        convert_chars(t, in, end, end, out);
+
+        return out - (uint8_t*)output;
+    }
+
+
+    struct SSE {
+        typedef __m128i vec;
+        static const int size = 16;
+        static const uint64_t all = 0xffff;
+
+        static FORCE_INLINE vec load(const uint8_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+        static FORCE_INLINE void store(uint8_t* p, vec v) { _mm_storeu_si128((__m128i*)p, v); }
+        static FORCE_INLINE vec zero() { return _mm_setzero_si128(); }
+        static FORCE_INLINE vec set1(uint8_t x) { return _mm_set1_epi8(x); }
+        static FORCE_INLINE vec set16(uint8_t a, uint8_t b, uint8_t c, uint8_t d, uint8_t e, uint8_t f, uint8_t g, uint8_t h) {
+            return _mm_setr_epi8(a, b, c, d, e, f, g, h, a, b, c, d, e, f, g, h);
+        }
+
+        static FORCE_INLINE vec add(vec a, vec b) { return _mm_add_epi8(a, b); }
+        static FORCE_INLINE vec sub(vec a, vec b) { return _mm_sub_epi8(a, b); }
+        static FORCE_INLINE vec and_(vec a, vec b) { return _mm_and_si128(a, b); }
+        static FORCE_INLINE vec or_(vec a, vec b) { return _mm_or_si128(a, b); }
+        static FORCE_INLINE vec xor_(vec a, vec b) { return _mm_xor_si128(a, b); }
+        static FORCE_INLINE vec andnot(vec a, vec b) { return _mm_andnot_si128(a, b); }
+        static FORCE_INLINE vec slli16(vec a, int n) { return _mm_slli_epi16(a, n); }
+        static FORCE_INLINE vec srli16(vec a, int n) { return _mm_srli_epi16(a, n); }
+        static FORCE_INLINE vec cmpeq(vec a, vec b) { return _mm_cmpeq_epi8(a, b); }
+        static FORCE_INLINE vec cmpgt(vec a, vec b) { return _mm_cmpgt_epi8(a, b); }
+        static FORCE_INLINE vec blend(vec a, vec b, vec mask) { return _mm_blendv_epi8(a, b, mask); }
+        static FORCE_INLINE uint64_t movemask(vec a) { return uint16_t(_mm_movemask_epi8(a)); }
+        static FORCE_INLINE bool any(vec a) { return !_mm_testz_si128(a, a); }
+
+        // byte i gets byte i - 1 (i + 1), zeros shifted in
+        static FORCE_INLINE vec shift_up(vec a) { return _mm_slli_si128(a, 1); }
+        static FORCE_INLINE vec shift_down(vec a) { return _mm_srli_si128(a, 1); }
+
+        static FORCE_INLINE vec lookup16(vec table, vec index) { return _mm_shuffle_epi8(table, index); }
+
+        // 128-entry lookup with pshufb: an index is decremented by 16 for
+        // the next row, pshufb yields zero once it's negative; thus rows
+        // 0..k are summed for index in row k -- and tables are chained,
+        // row k holds xor of rows k and k - 1
+        static FORCE_INLINE vec lookup(const Tables& t, int table, vec index) {
+            const uint8_t* row = t.blocks_chained[table];
+
+            vec result = _mm_shuffle_epi8(load(row), index);
+            for (int k=1; k < 8; k++) {
+                index  = _mm_sub_epi8(index, _mm_set1_epi8(16));
+                result = _mm_xor_si128(result, _mm_shuffle_epi8(load(row + 16*k), index));
+            }
+
+            return result;
+        }
+    };
+
+} // namespace utf8case
+
+
+size_t utf8_to_lower_scalar(const char* in, size_t n, char* out) { return utf8case::convert_scalar(utf8case::lower, in, n, out); }
+size_t utf8_to_upper_scalar(const char* in, size_t n, char* out) { return utf8case::convert_scalar(utf8case::upper, in, n, out); }
+size_t utf8_fold_scalar(const char* in, size_t n, char* out)     { return utf8case::convert_scalar(utf8case::fold,  in, n, out); }
+
+size_t utf8_to_lower_sse(const char* in, size_t n, char* out) { return utf8case::convert<utf8case::SSE>(utf8case::lower, in, n, out); }
+size_t utf8_to_upper_sse(const char* in, size_t n, char* out) { return utf8case::convert<utf8case::SSE>(utf8case::upper, in, n, out); }
+size_t utf8_fold_sse(const char* in, size_t n, char* out)     { return utf8case::convert<utf8case::SSE>(utf8case::fold,  in, n, out); }
+
+
+#ifdef HAVE_AVX2_INSTRUCTIONS
+#   include "utf8case-avx2.cpp"
+#endif
+
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+#   include "utf8case-avx512.cpp"
+#endif
@@ -0,0 +1,232 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+
+#include "foldhash.cpp"
+#include "utf8case.cpp"
+
+typedef size_t (*convert_fun)(const char*, size_t, char*);
+
+
+std::string convert(convert_fun fun, const std::string& s) {
+
+    std::string out(utf8case_max_size(s.size()), '\0');
+    out.resize(fun(s.data(), s.size(), &out[0]));
+
+    return out;
+}
+
+
+bool check_examples() {
+
+    struct Example {
+        convert_fun fun;
+        const char* input;
+        const char* expected;
+    };
+
+    const Example examples[] = {
+        {utf8_to_lower_scalar, "Hello, World!",                "hello, world!"},
+        {utf8_to_upper_scalar, "Hello, World!",                "HELLO, WORLD!"},
+        {utf8_to_lower_scalar, "ZAŻÓŁĆ GĘŚLĄ JAŹŃ",            "zażółć gęślą jaźń"},
+        {utf8_to_upper_scalar, "Ærøskøbing straße",            "ÆRØSKØBING STRAßE"},
+        {utf8_to_lower_scalar, "ΟΔΥΣΣΕΥΣ Ά",                   "οδυσσευσ ά"},
+        {utf8_to_upper_scalar, "οδυσσεύς",                     "ΟΔΥΣΣΕΎΣ"},
+        {utf8_fold_scalar,     "ΟΔΥΣΣΕΎΣ οδυσσεύς µ",          "οδυσσεύσ οδυσσεύσ μ"},
+        {utf8_to_lower_scalar, "МОСКВА ЁЖ Ѓ",                  "москва ёж ѓ"},
+        {utf8_to_upper_scalar, "ÿ ı ſ",                        "Ÿ I S"},
+        {utf8_to_lower_scalar, "İ K Ⱥ",                        "i k ⱥ"},
+        {utf8_to_lower_scalar, "\xc3 \xff \xe0\x80\x80 \xed\xa0\x80", "\xc3 \xff \xe0\x80\x80 \xed\xa0\x80"},
+    };
+
+    for (const auto& e: examples) {
+        const std::string result = convert(e.fun, e.input);
+        if (result != e.expected) {
+            printf("'%s' converted to '%s', expected '%s'\n", e.input, result.c_str(), e.expected);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// pieces of random strings: ASCII, two-byte sequences, caseless three-byte
+// sequences -- all of them handled in vectors, unless a two-byte code point
+// is an exception for the conversion (like U+03C2 for to upper) -- then
+// other characters and invalid bytes
+const char* alphabet[] = {
+    "a", "Z", "m", "Q", " ", "0", "@", "[", "`", "{", "\x7f",
+    "à", "À", "ß", "×", "÷", "ą", "Ą", "ĸ", "ž", "Ž", "α", "Ω", "ς", "σ", "Σ", "ά", "Ά",
+    "ж", "Ж", "ѓ", "Ѓ", "ѣ", "Ѣ", "ԱԲ", "ա", "日本", "한", "ह",
+    "ÿ", "µ", "İ", "ı", "ſ", "Ÿ", "ϐ", "Ӏ", "€", "Ω", "K", "Ａ", "ａ", "𐐀", "𐐨", "😀",
+    "\x80", "\xbf", "\xc0", "\xc1", "\xc3", "\xe0\x80", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xff"
+};
+
+const size_t ascii_count  = 11;
+const size_t vector_count = 39;
+const size_t all_count    = sizeof(alphabet)/sizeof(alphabet[0]);
+
+
+std::string random_string(std::mt19937& random, size_t pieces, size_t count) {
+
+    std::string s;
+    for (size_t i=0; i < pieces; i++) {
+        // mostly ASCII, like real texts
+        if (random() % 4 != 0) {
+            s += alphabet[random() % ascii_count];
+        } else {
+            s += alphabet[random() % count];
+        }
+    }
+
+    return s;
+}
+
+
+bool test(const char* name, convert_fun fun, convert_fun reference) {
+
+    printf("%-24s... ", name);
+    fflush(stdout);
+
+    std::mt19937 random(0);
+    for (int k=0; k < 100*1000; k++) {
+        const size_t count = (k % 2) ? vector_count : all_count;
+        const std::string input = random_string(random, random() % 200, count);
+
+        const std::string expected = convert(reference, input);
+        const std::string result   = convert(fun, input);
+        if (result != expected) {
+            puts("FAILED");
+            printf("input size %lu: result differs from scalar code\n", input.size());
+            return false;
+        }
+    }
+
+    puts("OK");
+    return true;
+}
+
+
+typedef void (*inplace_fun)(char*, size_t);
+typedef uint64_t (*hash_fun)(const char*, size_t);
+
+
+// random bytes, mostly ASCII letters
+std::string random_bytes(std::mt19937& random, size_t n) {
+
+    std::string s(n, ' ');
+    for (auto& c: s) {
+        const uint32_t r = random();
+        c = (r % 4 != 0) ? "aZ@[`{mQ"[(r >> 8) % 8] : char(r >> 8);
+    }
+
+    return s;
+}
+
+
+bool test_inplace(const char* name, inplace_fun fun, inplace_fun reference) {
+
+    printf("%-24s... ", name);
+    fflush(stdout);
+
+    std::mt19937 random(0);
+    for (size_t n=0; n < 1000; n++) {
+        const std::string input = random_bytes(random, n);
+
+        std::string expected = input;
+        std::string result   = input;
+        reference(&expected[0], n);
+        fun(&result[0], n);
+
+        if (result != expected) {
+            puts("FAILED");
+            printf("size %lu: result differs from scalar code\n", n);
+            return false;
+        }
+    }
+
+    puts("OK");
+    return true;
+}
+
+
+// fold_hash64(s) must be equal to hash64(to_lower(s))
+bool test_hash(const char* name, hash_fun fun, bool fold) {
+
+    printf("%-24s... ", name);
+    fflush(stdout);
+
+    std::mt19937 random(0);
+    for (size_t n=0; n < 1000; n++) {
+        const std::string input = random_bytes(random, n);
+
+        std::string lower = input;
+        if (fold) {
+            scalar::to_lower_inplace(&lower[0], n);
+        }
+
+        if (fun(input.data(), n) != hash64_scalar(lower.data(), n)) {
+            puts("FAILED");
+            printf("size %lu: wrong hash value\n", n);
+            return false;
+        }
+    }
+
+    puts("OK");
+    return true;
+}
+
+
+int main() {
+
+    bool ok = true;
+
+    printf("%-24s... ", "examples");
+    if (check_examples()) {
+        puts("OK");
+    } else {
+        puts("FAILED");
+        ok = false;
+    }
+
+    ok = test_inplace("to lower (SWAR)",   swar::to_lower_inplace,   scalar::to_lower_inplace) && ok;
+    ok = test_inplace("to upper (SWAR)",   swar::to_upper_inplace,   scalar::to_upper_inplace) && ok;
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    ok = test_inplace("to lower (AVX2)",   avx2::to_lower_inplace,   scalar::to_lower_inplace) && ok;
+    ok = test_inplace("to upper (AVX2)",   avx2::to_upper_inplace,   scalar::to_upper_inplace) && ok;
+#endif
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+    ok = test_inplace("to lower (AVX512)", avx512::to_lower_inplace, scalar::to_lower_inplace) && ok;
+    ok = test_inplace("to upper (AVX512)", avx512::to_upper_inplace, scalar::to_upper_inplace) && ok;
+#endif
+
+    ok = test_hash("fold_hash64 (scalar)",  fold_hash64_scalar, true) && ok;
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    ok = test_hash("hash64 (AVX2)",         hash64_avx2,        false) && ok;
+    ok = test_hash("fold_hash64 (AVX2)",    fold_hash64_avx2,   true) && ok;
+#endif
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+    ok = test_hash("hash64 (AVX512)",       hash64_avx512,      false) && ok;
+    ok = test_hash("fold_hash64 (AVX512)",  fold_hash64_avx512, true) && ok;
+#endif
+
+    ok = test("UTF-8 to lower (SSE)",      utf8_to_lower_sse,    utf8_to_lower_scalar) && ok;
+    ok = test("UTF-8 to upper (SSE)",      utf8_to_upper_sse,    utf8_to_upper_scalar) && ok;
+    ok = test("UTF-8 fold (SSE)",          utf8_fold_sse,        utf8_fold_scalar) && ok;
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    ok = test("UTF-8 to lower (AVX2)",     utf8_to_lower_avx2,   utf8_to_lower_scalar) && ok;
+    ok = test("UTF-8 to upper (AVX2)",     utf8_to_upper_avx2,   utf8_to_upper_scalar) && ok;
+    ok = test("UTF-8 fold (AVX2)",         utf8_fold_avx2,       utf8_fold_scalar) && ok;
+#endif
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+    ok = test("UTF-8 to lower (AVX512)",   utf8_to_lower_avx512, utf8_to_lower_scalar) && ok;
+    ok = test("UTF-8 to upper (AVX512)",   utf8_to_upper_avx512, utf8_to_upper_scalar) && ok;
+    ok = test("UTF-8 fold (AVX512)",       utf8_fold_avx512,     utf8_fold_scalar) && ok;
+#endif
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,48 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <random>
+
+#include "dispatch.cpp"
+
+// checks the procedures selected for this CPU; run with
+// CPUDISPATCH_DISABLE=avx512bw or avx2 to check the others
+int main() {
+
+    printf("selected: %s, %s, %s\n",
+           cpu_select(dispatch::to_lower_variants)->name,
+           cpu_select(dispatch::hash64_variants)->name,
+           cpu_select(dispatch::fold_hash64_variants)->name);
+
+    std::mt19937 random(0);
+    for (size_t n=0; n < 1000; n++) {
+        std::string input(n, ' ');
+        for (auto& c: input) {
+            c = char(random());
+        }
+
+        std::string lower = input;
+        std::string upper = input;
+        std::string expected_lower = input;
+        std::string expected_upper = input;
+
+        to_lower_inplace(&lower[0], n);
+        to_upper_inplace(&upper[0], n);
+        scalar::to_lower_inplace(&expected_lower[0], n);
+        scalar::to_upper_inplace(&expected_upper[0], n);
+
+        if (lower != expected_lower || upper != expected_upper) {
+            printf("size %lu: case conversion differs from scalar code\n", n);
+            return EXIT_FAILURE;
+        }
+
+        if (hash64(input.data(), n) != hash64_scalar(input.data(), n) ||
+            fold_hash64(input.data(), n) != hash64_scalar(expected_lower.data(), n)) {
+            printf("size %lu: wrong hash value\n", n);
+            return EXIT_FAILURE;
+        }
+    }
+
+    puts("OK");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,33 @@
+#!/bin/bash
+# Throughput of byte-by-byte and SIMD scanners on a synthetic
+# LaTeX corpus.
+#
+# usage: bench.sh [number of files [size of file in MB]]
+
+FILES=${1:-16}
+SIZE_MB=${2:-16}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+python3 - "$DIR" $FILES $SIZE_MB <<'PY'
+import sys
+dir, files, size = sys.argv[1], int(sys.argv[2]), int(sys.argv[3]) * 1024 * 1024
+paragraph = (
+    "\\section{Introduction} Lorem ipsum dolor sit amet, consectetur adipiscing elit,\n"
+    "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua. See \\cite{knuth84}\n"
+    "and equation~\\eqref{eq:1}: $\\frac{a}{b} = \\sqrt[3]{x}$ where 50\\% of values\n"
+    "% a comment with {unbalanced brackets\n"
+    "lie in the interval $[0, 1)$. Ut enim ad minim veniam, quis nostrud exercitation\n"
+    "ullamco laboris nisi ut aliquip ex ea commodo consequat.\n\n"
+)
+text = paragraph * (size // len(paragraph))
+for i in range(files):
+    open('%s/%03d.tex' % (dir, i), 'w').write(text)
+PY
+
+for prog in ./checktex ./checktex_avx2; do
+    for threads in $(printf "1\n%s\n" $(nproc) | sort -un); do
+        echo -n "$prog -S -t $threads: "; $prog -v -S -t $threads "$DIR"/*.tex
+        echo -n "$prog    -t $threads: "; $prog -v -t $threads "$DIR"/*.tex
+    done
+done
@@ -1,145 +1,466 @@
-/* 
+/*
  * Wojciech Mula wojciech_mula[at]poczta.onet.pl
  * 11-12.07.2004
  * public domain
+ *
+ * usage: checktex [-t threads] [-b brackets] [-S] [-v] file...
+ *
+ * Input is processed in 64-byte blocks.  SIMD compares (SSE2, or AVX2
+ * when compiled with -mavx2) produce bitmasks of special characters:
+ * brackets, '%', '\' and newlines.  Then:
+ *
+ * - escaped characters (odd number of preceding backslashes) are found
+ *   with add-with-carry over the backslash mask;
+ * - comments span from an unescaped '%' to the next newline, ranges
+ *   are built by subtracting single-bit masks;
+ * - blocks that contain no bracket outside comments are skipped,
+ *   only newlines are counted with popcount.
+ *
+ * Option -b selects checked bracket pairs (default "{}"), for example
+ * -b "{}[]()".  Files are checked in parallel (-t), reports are printed
+ * in the order of arguments.  Option -S selects the byte-by-byte
+ * scanner, -v prints throughput.  Exit status is 1 if any problem
+ * was found.
  */
-
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <immintrin.h>
 
-#define STACK_SIZE 512
-struct {
-	int line, column;
-} stack[STACK_SIZE];
-int stack_pointer = 0;
+typedef struct {
+	long	line, column;
+	char	bracket;
+} group_t;
 
-int sp() {
-	return stack_pointer;
-}
+typedef struct {
+	group_t* items;
+	size_t	size;
+	size_t	capacity;
+} bracket_stack;
 
-int full() {
-	return stack_pointer == STACK_SIZE;
+int empty(bracket_stack* s) {
+	return s->size == 0;
 }
 
-int empty() {
-	return stack_pointer == 0;
-}
+void push(bracket_stack* s, long line, long column, char bracket) {
+	if (s->size == s->capacity) {
+		s->capacity = s->capacity ? 2*s->capacity : 64;
+		s->items = realloc(s->items, s->capacity * sizeof(group_t));
+		if (s->items == NULL) {
+			fputs("Can't allocate memory for the stack.\n", stderr);
+			exit(2);
+		}
+	}
 
-void push(int line, int column) {
-	stack[stack_pointer].line	= line;
-	stack[stack_pointer].column	= column;
-	stack_pointer++;
+	s->items[s->size].line		= line;
+	s->items[s->size].column	= column;
+	s->items[s->size].bracket	= bracket;
+	s->size++;
 }
 
-void pop(int *line, int *column) {
-	stack_pointer--;
-	if (line != NULL)
-		*line	= stack[stack_pointer].line;
-	if (column != NULL)
-		*column	= stack[stack_pointer].column;
+group_t pop(bracket_stack* s) {
+	return s->items[--s->size];
 }
 
-int check_TeX_parentheses(const char* filename) {
-#define size (1024*8)	
-	static char buffer[size];
-	FILE* f;
-	size_t readed;
-	
-	int line	= 1;
-	int column	= 1;
-	int comment	= 0;
-	int level;
-	
-	char prev	= 0;
-	char *this;
+/* checked brackets, e.g. closing['{'] == '}' and opening['}'] == '{' */
+static char opening[256];
+static char closing[256];
+
+typedef struct {
+	const char*	filename;
+	FILE*		out;
+	bracket_stack	stack;
+	long		line;
+	const char*	line_start;
+} checker;
+
+/* returns 0 on error */
+static int bracket(checker* c, const char* pos, char ch) {
+	const long column = pos - c->line_start + 1;
+	group_t g;
 
-	f = fopen(filename, "rb");	/* read-only */
-	if (f==NULL) {
-		printf("Can't open file '%s'.\n", filename);
+	if (closing[(uint8_t)ch]) {
+		push(&c->stack, c->line, column, ch);
+		return 1;
+	}
+
+	if (empty(&c->stack)) {
+		fprintf(c->out, "%s: extra closing bracket at line %ld, column %ld.\n", c->filename, c->line, column);
+		return 0;
+	}
+
+	g = pop(&c->stack);
+	if (g.bracket != opening[(uint8_t)ch]) {
+		fprintf(c->out, "%s: '%c' at line %ld, column %ld closes '%c' opened at line %ld, column %ld.\n",
+			c->filename, ch, c->line, column, g.bracket, g.line, g.column);
 		return 0;
 	}
 
-	while (readed = fread(buffer, sizeof(char), size, f)) {
-	
-	this = buffer;
+	return 1;
+}
+
+/* byte-by-byte scanner, the original algorithm */
+static int scan_scalar(checker* c, const char* data, size_t size) {
+	const char* end = data + size;
+	const char* p;
+	int comment = 0;
+	int escaped = 0;
 
-	while (readed--) {
-		if (*this == '\n') {
+	for (p = data; p < end; p++) {
+		const char ch = *p;
+		if (ch == '\n') {
 			comment = 0; /* new line ends comment */
-			column  = 1;
-			line++;
-			
-			prev = *this++;
+			escaped = 0;
+			c->line++;
+			c->line_start = p + 1;
 			continue;
 		}
-	
-		/* do not check chars inside comments 
-		   nor escaped: \{, \}, \% */
-		if (comment || prev == '\\') {
-			if (*this == '\\')
-				/* without this condition program reports 
-				   extra closing bracket for TeX code "\\{ ... }" */
-				prev = 0;
-				 
-			else
-				prev = *this;
-			this++;
-			column++;
+
+		/* do not check chars inside comments nor escaped: \{, \}, \% */
+		if (comment)
+			continue;
+
+		if (escaped) {
+			/* "\\{ ... }" --- the second backslash doesn't escape */
+			escaped = 0;
 			continue;
 		}
-		
-		switch (*this) {
-			case '%': /* comment started */
-				comment = 1;
-				break;	
-			case '{': /* new group opened */
-				if (!full())
-					push(line, column);
-				else {
-					puts("Stack is full, recompile the program with larger stack (incrase STACK_SIZE).");
-					goto error;
-				}
-				break;
-			case  '}': /* toplevel group closed */
-				if (!empty())
-					pop(NULL, NULL);
-				else {
-					printf("%s: extra closing bracket at line %d, column %d\n.", filename, line, column);
-					goto error;
-				}
-				break;
+
+		if (ch == '\\')
+			escaped = 1;
+		else
+		if (ch == '%')
+			comment = 1;
+		else
+		if (opening[(uint8_t)ch] || closing[(uint8_t)ch]) {
+			if (!bracket(c, p, ch))
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+typedef struct {
+	uint64_t backslash;
+	uint64_t percent;
+	uint64_t newline;
+	uint64_t brackets;
+} masks_t;
+
+static uint64_t eq_mask(const char* p, char ch) {
+#ifdef __AVX2__
+	const __m256i v = _mm256_set1_epi8(ch);
+	const uint64_t lo = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), v));
+	const uint64_t hi = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 32)), v));
+	return lo | (hi << 32);
+#else
+	const __m128i v = _mm_set1_epi8(ch);
+	uint64_t m0 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p +  0)), v));
+	uint64_t m1 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 16)), v));
+	uint64_t m2 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 32)), v));
+	uint64_t m3 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 48)), v));
+	return m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+#endif
+}
+
+static char bracket_chars[7];	/* checked brackets, zero-terminated */
+
+static masks_t classify(const char* p) {
+	masks_t m;
+	const char* b;
+
+	m.backslash	= eq_mask(p, '\\');
+	m.percent	= eq_mask(p, '%');
+	m.newline	= eq_mask(p, '\n');
+	m.brackets	= 0;
+	for (b = bracket_chars; *b; b++)
+		m.brackets |= eq_mask(p, *b);
+
+	return m;
+}
+
+/* characters preceded by an odd number of backslashes; carry is 0 or 1 */
+static uint64_t find_escaped(uint64_t backslash, uint64_t* carry) {
+	const uint64_t even_bits = UINT64_C(0x5555555555555555);
+	uint64_t follows_escape, odd_starts, sequences;
+
+	backslash &= ~*carry;
+	follows_escape = (backslash << 1) | *carry;
+	odd_starts = backslash & ~even_bits & ~follows_escape;
+	*carry = __builtin_add_overflow(odd_starts, backslash, &sequences);
+	return (even_bits ^ (sequences << 1)) & follows_escape;
+}
+
+/* bits from an unescaped '%' up to (excluding) the next newline */
+static uint64_t find_comments(uint64_t percent, uint64_t newline, int* carry) {
+	uint64_t mask = 0;
+
+	if (*carry) {
+		if (newline == 0)
+			return ~UINT64_C(0);
+
+		mask = (newline & -newline) - 1;
+		percent &= ~mask;
+		*carry = 0;
+	}
+
+	while (percent) {
+		const uint64_t start = percent & -percent;
+		const uint64_t after = newline & ~((start << 1) - 1);
+		if (after == 0) {
+			mask |= -start;
+			*carry = 1;
+			break;
 		}
 
-		prev = *this++;
-		column++;
+		const uint64_t end = after & -after;
+		mask |= end - start;
+		percent &= -end;
 	}
+
+	return mask;
+}
+
+static void skip_lines(checker* c, const char* block, uint64_t newline) {
+	if (newline) {
+		c->line += __builtin_popcountll(newline);
+		c->line_start = block + 64 - __builtin_clzll(newline);
 	}
+}
 
-ok:
-	if (!empty()) {
-		if (sp() > 1)
-			printf("There are some opened groups:\n");
-		else
-			printf("There is an opened group:\n");
+static int scan_simd(checker* c, const char* data, size_t size) {
+	uint64_t escape_carry = 0;
+	int comment_carry = 0;
+	char tail[64];
+	size_t off;
+
+	for (off = 0; off < size; off += 64) {
+		const char* block = data + off;
+		const char* src = block;
+		if (size - off < 64) {
+			memset(tail, 0, sizeof(tail));
+			memcpy(tail, block, size - off);
+			src = tail;
+		}
+
+		const masks_t m = classify(src);
+		const uint64_t escaped = find_escaped(m.backslash, &escape_carry);
+		const uint64_t comment = find_comments(m.percent & ~escaped, m.newline, &comment_carry);
+		uint64_t events  = m.brackets & ~escaped & ~comment;
+		uint64_t newline = m.newline;
+
+		while (events) {
+			const int i = __builtin_ctzll(events);
+			const uint64_t before = newline & ((UINT64_C(1) << i) - 1);
+			skip_lines(c, block, before);
+			newline &= ~before;
+
+			if (!bracket(c, block + i, src[i]))
+				return 0;
 
-		while (!empty()) {
-			level = sp();
-			pop(&line, &column);
-			printf("%s: level %d, line %d, column %d\n", 
-				filename, level, line, column);
+			events &= events - 1;
 		}
+
+		skip_lines(c, block, newline);
 	}
-	fclose(f);
+
 	return 1;
-error:
-	fclose(f);
-	return 0;
-#undef size
+}
+
+static int use_scalar = 0;
+
+/* returns number of problems found, output goes to c->out */
+size_t check_TeX_parentheses(checker* c, size_t* bytes) {
+	struct stat st;
+	const char* data;
+	int fd, ok;
+	size_t level;
+
+	*bytes = 0;
+	fd = open(c->filename, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		fprintf(c->out, "Can't open file '%s'.\n", c->filename);
+		if (fd >= 0)
+			close(fd);
+		return 1;
+	}
+
+	c->line = 1;
+	if (st.st_size == 0) {
+		close(fd);
+		return 0;
+	}
+
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		fprintf(c->out, "Can't map file '%s'.\n", c->filename);
+		return 1;
+	}
+
+	madvise((void*)data, st.st_size, MADV_SEQUENTIAL);
+	c->line_start = data;
+	if (use_scalar)
+		ok = scan_scalar(c, data, st.st_size);
+	else
+		ok = scan_simd(c, data, st.st_size);
+
+	munmap((void*)data, st.st_size);
+	*bytes = st.st_size;
+
+	if (!ok)
+		return 1;
+
+	if (empty(&c->stack))
+		return 0;
+
+	if (c->stack.size > 1)
+		fprintf(c->out, "There are some opened groups:\n");
+	else
+		fprintf(c->out, "There is an opened group:\n");
+
+	level = c->stack.size;
+	while (!empty(&c->stack)) {
+		const size_t l = c->stack.size;
+		const group_t g = pop(&c->stack);
+		fprintf(c->out, "%s: level %zu, line %ld, column %ld\n",
+			c->filename, l, g.line, g.column);
+	}
+
+	return level;
+}
+
+/* files are taken by threads from a shared counter */
+typedef struct {
+	char**	files;
+	size_t	count;
+	size_t	next;
+	char**	reports;
+	size_t*	problems;
+	size_t	bytes;
+} job_t;
+
+static void* worker(void* arg) {
+	job_t* job = (job_t*)arg;
+	size_t i, bytes, total = 0;
+	size_t report_size;
+	checker c;
+
+	memset(&c, 0, sizeof(c));
+	while ((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->count) {
+		c.filename = job->files[i];
+		c.stack.size = 0;
+		c.out = open_memstream(&job->reports[i], &report_size);
+		if (c.out == NULL) {
+			perror("open_memstream");
+			exit(2);
+		}
+
+		job->problems[i] = check_TeX_parentheses(&c, &bytes);
+		fclose(c.out);
+		total += bytes;
+	}
+
+	free(c.stack.items);
+	__atomic_fetch_add(&job->bytes, total, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void usage(void) {
+	puts("usage: checktex [-t threads] [-b brackets] [-S] [-v] file...");
 }
 
 int main(int argc, char* argv[]) {
-	int i;
-	for (i=1; i<argc; i++)
-		check_TeX_parentheses(argv[i]);
-	return 0;
+	const char* brackets = "{}";
+	unsigned threads = sysconf(_SC_NPROCESSORS_ONLN);
+	int verbose = 0;
+	int result = 0;
+	pthread_t* id;
+	job_t job;
+	size_t i, k;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:b:Sv")) != -1) {
+		switch (opt) {
+			case 't': threads = atoi(optarg); break;
+			case 'b': brackets = optarg; break;
+			case 'S': use_scalar = 1; break;
+			case 'v': verbose = 1; break;
+			default:
+				usage();
+				return 2;
+		}
+	}
+
+	if (strlen(brackets) % 2 != 0 || strlen(brackets) >= sizeof(bracket_chars)) {
+		puts("brackets must be given as pairs: {}, [] or ()");
+		return 2;
+	}
+
+	strcpy(bracket_chars, brackets);
+	for (i=0; brackets[i]; i += 2) {
+		closing[(uint8_t)brackets[i]]     = brackets[i + 1];
+		opening[(uint8_t)brackets[i + 1]] = brackets[i];
+	}
+
+	if (threads == 0)
+		threads = 1;
+
+	job.files    = argv + optind;
+	job.count    = argc - optind;
+	job.next     = 0;
+	job.bytes    = 0;
+	job.reports  = calloc(job.count, sizeof(char*));
+	job.problems = calloc(job.count, sizeof(size_t));
+	id = calloc(threads, sizeof(pthread_t));
+	if (job.reports == NULL || job.problems == NULL || id == NULL) {
+		fputs("Can't allocate memory.\n", stderr);
+		return 2;
+	}
+
+	const double t0 = now();
+	for (k=0; k < threads; k++) {
+		if (pthread_create(&id[k], NULL, worker, &job) != 0) {
+			fprintf(stderr, "Can't create thread #%zu, running %zu thread(s).\n", k + 1, (k > 0) ? k : 1);
+			break;
+		}
+	}
+
+	// workers take files from the shared job, any number of them does all
+	if (k == 0)
+		worker(&job);
+	for (i=0; i < k; i++)
+		pthread_join(id[i], NULL);
+	const double t1 = now();
+
+	for (i=0; i < job.count; i++) {
+		fputs(job.reports[i], stdout);
+		free(job.reports[i]);
+		if (job.problems[i])
+			result = 1;
+	}
+
+	if (verbose)
+		fprintf(stderr, "%zu file(s), %.1f MB, %.3f s, %.1f MB/s\n",
+			job.count, job.bytes / 1e6, t1 - t0, job.bytes / 1e6 / (t1 - t0));
+
+	free(job.reports);
+	free(job.problems);
+	free(id);
+	return result;
 }
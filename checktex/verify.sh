@@ -0,0 +1,34 @@
+#!/bin/bash
+# Compares the SIMD scanner with the byte-by-byte one on random inputs
+# built from special characters.
+
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+python3 - "$DIR" <<'PY'
+import random, sys
+random.seed(1)
+alphabet = ['{', '}', '[', ']', '(', ')', '%', '\\', '\\\\', '\n', 'a', ' ', 'xyz']
+for i in range(500):
+    n = random.choice([1, 10, 63, 64, 65, 200, 1000, 5000])
+    weights = [random.random() for _ in alphabet]
+    text = ''.join(random.choices(alphabet, weights, k=n))
+    open('%s/%03d.tex' % (sys.argv[1], i), 'w').write(text)
+    # and a balanced one: up to 69 levels of nested braces
+    open('%s/%03d-bal.tex' % (sys.argv[1], i), 'w').write('{' * (i % 70) + 'x' * (i % 7) + '}' * (i % 70) + '\n')
+PY
+
+status=0
+for prog in ./checktex ./checktex_avx2; do
+    for brackets in '{}' '{}[]()'; do
+        for f in "$DIR"/*.tex; do
+            if ! cmp -s <($prog -b "$brackets" -S "$f") <($prog -b "$brackets" "$f"); then
+                echo "$prog -b '$brackets' differs on $f"
+                status=1
+            fi
+        done
+    done
+done
+
+[ $status == 0 ] && echo "OK"
+exit $status
@@ -0,0 +1,673 @@
+/*
+	Micro-benchmark harness
+
+	Every subproject used to time things on its own: gettimeofday,
+	clock(), rdtsc macros copied from other projects; results were
+	printed in ad hoc formats and often came from a single run.  This
+	header gives all speed programs the same machinery:
+
+	* TSC timestamps, serialized with lfence/rdtscp, the frequency of
+	  TSC is calibrated against CLOCK_MONOTONIC; the overhead of an
+	  empty measurement is subtracted;
+
+	* hardware counters (perf_event_open): cycles, instructions,
+	  branch-misses and L1D read misses, user space only, read as a
+	  group; when the kernel or a VM doesn't provide them results
+	  simply lack these numbers (then "cycles" are TSC ticks, which
+	  equal core cycles only at the nominal frequency); when the group
+	  shares the PMU with other users (perf, the NMI watchdog) it is
+	  multiplexed, counts of such samples are scaled by time enabled
+	  over time running and the result tells their fraction;
+
+	* warmup runs, then `repeat` samples; reported are min, median
+	  and MAD (median absolute deviation) of time, and medians of the
+	  counters, all divided by the number of operations per sample;
+
+	* BENCH_KEEP(x) and BENCH_CLOBBER() stop the compiler from
+	  removing or hoisting the measured code;
+
+	* output as a human-readable text, CSV or JSON lines; records
+	  carry the CPU model and the compiler, GB/s are given if field
+	  `bytes` (bytes processed by an operation) is set.
+
+	Names follow the convention "kernel/isa/size", like "bfs/avx512f/64"
+	(ISA and size are optional), scripts/benchdb.py splits them so.
+
+	Usage:
+
+		bench b;
+		bench_begin(&b, "scalar/1024", 1000, 1024);  // name, repeat, operations per sample
+		while (bench_next(&b)) {
+			BENCH_KEEP(scalar(data, 1024));
+		}
+		bench_report(&b);                              // b.result holds numbers
+
+	Don't leave the loop with break, check the results of the measured
+	code outside it.  Field `warmup` (default: repeat/10) can be changed
+	after bench_begin.  Setting field `pinned` keeps repeat and warmup
+	as given, for code that can't be run more than once (like filling
+	a container).
+
+	Environment variables:
+
+	* BENCH_FORMAT  --- text (default), csv or json;
+	* BENCH_OUTPUT  --- append records to the file instead of stdout;
+	* BENCH_REPEAT, BENCH_WARMUP --- override values set by a program
+	  (unless the measurement is pinned);
+	* BENCH_PERF=0  --- don't use hardware counters.
+
+	Header-only, works in C99 and C++, x86 (32 and 64-bit) Linux only.
+	Include it before any other header in C programs, it needs _GNU_SOURCE.
+*/
+#ifndef BENCH_H_included__
+#define BENCH_H_included__
+
+#ifndef _GNU_SOURCE
+#   define _GNU_SOURCE
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <cpuid.h>
+
+#if defined(__clang__)
+#   define BENCH_COMPILER "clang " __clang_version__
+#elif defined(__GNUC__)
+#   define BENCH_COMPILER "gcc " __VERSION__
+#else
+#   define BENCH_COMPILER "unknown"
+#endif
+
+enum {
+	BENCH_CYCLES,
+	BENCH_INSTRUCTIONS,
+	BENCH_BRANCH_MISSES,
+	BENCH_L1D_MISSES,
+	BENCH_COUNTERS
+};
+
+/* names used in CSV and JSON */
+static const char* const bench_counter_names[BENCH_COUNTERS] = {
+	"cycles", "instructions", "branch_misses", "l1d_misses"
+};
+
+enum {
+	BENCH_TEXT,
+	BENCH_CSV,
+	BENCH_JSON
+};
+
+
+/* an empty asm which uses the value and may read any memory */
+#define BENCH_KEEP(x)   __asm__ volatile ("" : : "r,m" (x) : "memory")
+
+/* the compiler must assume any memory was read and written */
+#define BENCH_CLOBBER() __asm__ volatile ("" : : : "memory")
+
+
+static inline uint64_t bench_tsc_begin(void) {
+	uint32_t lo, hi;
+	/* lfence: the preceding instructions have completed */
+	__asm__ volatile ("lfence\n\trdtsc" : "=a" (lo), "=d" (hi) : : "memory");
+	return ((uint64_t)hi << 32) | lo;
+}
+
+
+static inline uint64_t bench_tsc_end(void) {
+	uint32_t lo, hi, aux;
+	/* rdtscp waits for the measured code, lfence keeps the following code out */
+	__asm__ volatile ("rdtscp\n\tlfence" : "=a" (lo), "=d" (hi), "=c" (aux) : : "memory");
+	return ((uint64_t)hi << 32) | lo;
+}
+
+
+/* state shared by all benchmarks of a program */
+typedef struct {
+	int         initialized;
+	double      tsc_hz;
+	int         leader;                 /* fd of perf group, -1 if counters are not available */
+	int         fd[BENCH_COUNTERS];
+	int         slot[BENCH_COUNTERS];   /* position in the group read, -1 if not opened */
+	int         nr;
+	const char* perf_error;
+	uint64_t    overhead[1 + BENCH_COUNTERS];
+	int         format;
+	FILE*       out;
+	int         header_printed;
+	char        cpu[49];                /* brand string */
+} bench_context;
+
+
+static inline double bench_now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+/* busy waits 20 ms, enough to get the frequency with error below 0.01% */
+static inline double bench_calibrate_tsc(void) {
+	const double t0 = bench_now_ns();
+	const uint64_t c0 = bench_tsc_begin();
+	double t1;
+	uint64_t c1;
+
+	do {
+		t1 = bench_now_ns();
+		c1 = bench_tsc_end();
+	} while (t1 - t0 < 20e6);
+
+	return (double)(c1 - c0) * 1e9 / (t1 - t0);
+}
+
+
+static inline void bench_cpu_model(char* cpu) {
+	unsigned regs[12];
+	char* s;
+	int i;
+
+	strcpy(cpu, "unknown");
+	if (__get_cpuid_max(0x80000000, NULL) < 0x80000004)
+		return;
+
+	for (i=0; i < 3; i++)
+		__get_cpuid(0x80000002 + i, &regs[4*i], &regs[4*i + 1], &regs[4*i + 2], &regs[4*i + 3]);
+
+	memcpy(cpu, regs, 48);
+	cpu[48] = '\0';
+
+	/* the string is padded with spaces */
+	for (s=cpu; *s == ' '; s++)
+		;
+	memmove(cpu, s, strlen(s) + 1);
+	for (i=strlen(cpu); i > 0 && cpu[i - 1] == ' '; i--)
+		cpu[i - 1] = '\0';
+}
+
+
+static inline int bench_perf_open(uint32_t type, uint64_t config, int group) {
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size           = sizeof(attr);
+	attr.type           = type;
+	attr.config         = config;
+	attr.disabled       = (group == -1);
+	attr.exclude_kernel = 1;
+	attr.exclude_hv     = 1;
+	attr.read_format    = PERF_FORMAT_GROUP
+	                    | PERF_FORMAT_TOTAL_TIME_ENABLED
+	                    | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	return (int)syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+
+/* counters which can't be opened are skipped, the first opened one leads the group */
+static inline void bench_perf_init(bench_context* ctx) {
+	static const struct {
+		uint32_t type;
+		uint64_t config;
+	} events[BENCH_COUNTERS] = {
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+		{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+		                     | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+		                     | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+	};
+	const char* env = getenv("BENCH_PERF");
+	int i;
+
+	ctx->leader = -1;
+	ctx->nr = 0;
+	for (i=0; i < BENCH_COUNTERS; i++) {
+		ctx->fd[i] = -1;
+		ctx->slot[i] = -1;
+	}
+
+	if (env != NULL && strcmp(env, "0") == 0) {
+		ctx->perf_error = "disabled with BENCH_PERF=0";
+		return;
+	}
+
+	for (i=0; i < BENCH_COUNTERS; i++) {
+		const int fd = bench_perf_open(events[i].type, events[i].config, ctx->leader);
+		if (fd < 0) {
+			if (ctx->perf_error == NULL)
+				ctx->perf_error = strerror(errno);
+			continue;
+		}
+
+		if (ctx->leader < 0)
+			ctx->leader = fd;
+
+		ctx->fd[i] = fd;
+		ctx->slot[i] = ctx->nr++;
+	}
+
+	if (ctx->leader >= 0) {
+		ioctl(ctx->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(ctx->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+}
+
+
+/* values are [counters..., time enabled, time running] */
+static inline void bench_read_counters(const bench_context* ctx, uint64_t* values) {
+	uint64_t buf[3 + BENCH_COUNTERS];	/* nr, time enabled, time running, counters... */
+	int i;
+
+	if (ctx->leader < 0 || read(ctx->leader, buf, sizeof(buf)) <= 0)
+		memset(buf, 0, sizeof(buf));
+
+	for (i=0; i < BENCH_COUNTERS; i++)
+		values[i] = (ctx->slot[i] >= 0) ? buf[3 + ctx->slot[i]] : 0;
+
+	values[BENCH_COUNTERS]     = buf[1];
+	values[BENCH_COUNTERS + 1] = buf[2];
+}
+
+
+/*
+	A sample is [TSC ticks, counters...].  Counters are read outside
+	the TSC interval, the reads themselves are a part of the overhead.
+	If the group was not on the PMU all the time, the counts are
+	extrapolated to the whole interval and 1 is returned.
+*/
+static inline void bench_sample_start(const bench_context* ctx, uint64_t* start) {
+	bench_read_counters(ctx, start + 1);
+	start[0] = bench_tsc_begin();
+}
+
+
+static inline int bench_sample_stop(const bench_context* ctx, const uint64_t* start, uint64_t* sample) {
+	uint64_t counters[2 + BENCH_COUNTERS];
+	uint64_t enabled, running;
+	int i;
+
+	sample[0] = bench_tsc_end() - start[0];
+	bench_read_counters(ctx, counters);
+	for (i=0; i < BENCH_COUNTERS; i++)
+		sample[1 + i] = counters[i] - start[1 + i];
+
+	enabled = counters[BENCH_COUNTERS]     - start[1 + BENCH_COUNTERS];
+	running = counters[BENCH_COUNTERS + 1] - start[2 + BENCH_COUNTERS];
+	if (running == enabled)
+		return 0;
+
+	for (i=0; i < BENCH_COUNTERS; i++)
+		sample[1 + i] = (running > 0) ? (uint64_t)((double)sample[1 + i] * enabled / running) : 0;
+
+	return 1;
+}
+
+
+/* minimum of empty measurements */
+static inline void bench_calibrate_overhead(bench_context* ctx) {
+	uint64_t start[3 + BENCH_COUNTERS];
+	uint64_t sample[1 + BENCH_COUNTERS];
+	int i, k;
+
+	for (k=0; k < 1 + BENCH_COUNTERS; k++)
+		ctx->overhead[k] = UINT64_MAX;
+
+	for (i=0; i < 1000; i++) {
+		bench_sample_start(ctx, start);
+		BENCH_CLOBBER();
+		bench_sample_stop(ctx, start, sample);
+
+		for (k=0; k < 1 + BENCH_COUNTERS; k++)
+			if (sample[k] < ctx->overhead[k])
+				ctx->overhead[k] = sample[k];
+	}
+}
+
+
+static inline bench_context* bench_ctx(void) {
+	static bench_context ctx;
+
+	if (!ctx.initialized) {
+		const char* format = getenv("BENCH_FORMAT");
+		const char* output = getenv("BENCH_OUTPUT");
+
+		ctx.format = BENCH_TEXT;
+		if (format != NULL && strcmp(format, "csv") == 0)
+			ctx.format = BENCH_CSV;
+		else if (format != NULL && strcmp(format, "json") == 0)
+			ctx.format = BENCH_JSON;
+		else if (format != NULL && strcmp(format, "text") != 0)
+			fprintf(stderr, "bench: unknown BENCH_FORMAT '%s', using text\n", format);
+
+		ctx.out = stdout;
+		if (output != NULL && *output != '\0') {
+			ctx.out = fopen(output, "a");
+			if (ctx.out == NULL) {
+				fprintf(stderr, "bench: can't open '%s': %s\n", output, strerror(errno));
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		bench_cpu_model(ctx.cpu);
+		bench_perf_init(&ctx);
+		ctx.tsc_hz = bench_calibrate_tsc();
+		bench_calibrate_overhead(&ctx);
+		ctx.initialized = 1;
+	}
+
+	return &ctx;
+}
+
+
+static inline int bench_format(void) {
+	return bench_ctx()->format;
+}
+
+
+static inline int bench_has_counter(int counter) {
+	return bench_ctx()->slot[counter] >= 0;
+}
+
+
+/* all values are per operation; counters are negative when not available */
+typedef struct {
+	double min_ns;
+	double median_ns;
+	double mad_ns;
+	double tsc;                         /* TSC ticks, median */
+	double counter[BENCH_COUNTERS];     /* medians */
+	double multiplexed;                 /* fraction of samples with scaled counters */
+} bench_result;
+
+typedef struct {
+	char         name[128];
+	int          repeat;
+	int          warmup;
+	int          pinned;                /* BENCH_REPEAT and BENCH_WARMUP are ignored */
+	double       ops;                   /* operations in a sample */
+	double       bytes;                 /* bytes processed by an operation, 0 if not applicable */
+	int          iteration;             /* the running sample, negative during warmup */
+	uint64_t     start[3 + BENCH_COUNTERS]; /* [TSC, counters..., time enabled, time running] */
+	int          multiplexed;           /* samples with scaled counters */
+	uint64_t*    samples;               /* repeat rows of [TSC, counters...] */
+	bench_result result;
+} bench;
+
+
+static inline void bench_begin(bench* b, const char* name, int repeat, double ops) {
+	int i;
+
+	bench_ctx();
+
+	snprintf(b->name, sizeof(b->name), "%s", name);
+	b->repeat      = (repeat > 0) ? repeat : 1;
+	b->warmup      = b->repeat / 10;
+	b->pinned      = 0;
+	b->ops         = (ops > 0) ? ops : 1;
+	b->bytes       = 0;
+	b->iteration   = 0;
+	b->multiplexed = 0;
+	b->samples     = NULL;
+
+	memset(&b->result, 0, sizeof(b->result));
+	for (i=0; i < BENCH_COUNTERS; i++)
+		b->result.counter[i] = -1.0;
+}
+
+
+static inline int bench_compare_u64(const void* a, const void* b) {
+	const uint64_t x = *(const uint64_t*)a;
+	const uint64_t y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+
+static inline int bench_compare_double(const void* a, const void* b) {
+	const double x = *(const double*)a;
+	const double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+
+/* column k of samples minus the overhead, sorted; returns the median */
+static inline double bench_column(const bench* b, int k, uint64_t* tmp) {
+	const uint64_t overhead = bench_ctx()->overhead[k];
+	const int n = b->repeat;
+	int i;
+
+	for (i=0; i < n; i++) {
+		const uint64_t v = b->samples[i * (1 + BENCH_COUNTERS) + k];
+		tmp[i] = (v > overhead) ? v - overhead : 0;
+	}
+
+	qsort(tmp, n, sizeof(tmp[0]), bench_compare_u64);
+
+	if (n % 2)
+		return (double)tmp[n/2];
+	else
+		return ((double)tmp[n/2 - 1] + (double)tmp[n/2]) / 2;
+}
+
+
+static inline void bench_finish(bench* b) {
+	const bench_context* ctx = bench_ctx();
+	const int n = b->repeat;
+	const double ns = 1e9 / ctx->tsc_hz / b->ops;
+	uint64_t* tmp = (uint64_t*)malloc(n * sizeof(uint64_t));
+	double* dev = (double*)malloc(n * sizeof(double));
+	double median, mad;
+	int i, k;
+
+	if (tmp == NULL || dev == NULL) {
+		fputs("bench: out of memory\n", stderr);
+		exit(EXIT_FAILURE);
+	}
+
+	median = bench_column(b, 0, tmp);
+	for (i=0; i < n; i++)
+		dev[i] = (tmp[i] > median) ? tmp[i] - median : median - tmp[i];
+
+	qsort(dev, n, sizeof(dev[0]), bench_compare_double);
+	mad = (n % 2) ? dev[n/2] : (dev[n/2 - 1] + dev[n/2]) / 2;
+
+	b->result.min_ns    = tmp[0] * ns;
+	b->result.median_ns = median * ns;
+	b->result.mad_ns    = mad * ns;
+	b->result.tsc       = median / b->ops;
+
+	for (k=0; k < BENCH_COUNTERS; k++)
+		if (ctx->slot[k] >= 0)
+			b->result.counter[k] = bench_column(b, 1 + k, tmp) / b->ops;
+
+	b->result.multiplexed = (double)b->multiplexed / n;
+
+	free(dev);
+	free(tmp);
+	free(b->samples);
+	b->samples = NULL;
+}
+
+
+/* ends the running sample and starts the next one; returns 0 when all were taken */
+static inline int bench_next(bench* b) {
+	const bench_context* ctx = bench_ctx();
+
+	if (b->samples == NULL) {
+		const char* repeat = getenv("BENCH_REPEAT");
+		const char* warmup = getenv("BENCH_WARMUP");
+
+		if (!b->pinned && repeat != NULL && atoi(repeat) > 0)
+			b->repeat = atoi(repeat);
+		if (!b->pinned && warmup != NULL && atoi(warmup) >= 0)
+			b->warmup = atoi(warmup);
+
+		b->samples = (uint64_t*)malloc(b->repeat * (1 + BENCH_COUNTERS) * sizeof(uint64_t));
+		if (b->samples == NULL) {
+			fputs("bench: out of memory\n", stderr);
+			exit(EXIT_FAILURE);
+		}
+
+		b->iteration = -b->warmup;
+	} else {
+		uint64_t sample[1 + BENCH_COUNTERS];
+		const int multiplexed = bench_sample_stop(ctx, b->start, sample);
+
+		if (b->iteration >= 0) {
+			memcpy(b->samples + b->iteration * (1 + BENCH_COUNTERS), sample, sizeof(sample));
+			b->multiplexed += multiplexed;
+		}
+
+		b->iteration += 1;
+		if (b->iteration == b->repeat) {
+			bench_finish(b);
+			return 0;
+		}
+	}
+
+	bench_sample_start(ctx, b->start);
+	return 1;
+}
+
+
+/* cycles per operation: from the counter, or TSC ticks if it's not available */
+static inline double bench_cycles(const bench_result* r) {
+	return (r->counter[BENCH_CYCLES] >= 0) ? r->counter[BENCH_CYCLES] : r->tsc;
+}
+
+
+/* bytes/ns = GB/s; negative if not applicable */
+static inline double bench_gbs(const bench* b) {
+	return (b->bytes > 0 && b->result.median_ns > 0) ? b->bytes / b->result.median_ns : -1.0;
+}
+
+
+static inline void bench_print_value(FILE* f, double value, const char* absent) {
+	if (value >= 0)
+		fprintf(f, "%.6g", value);
+	else
+		fputs(absent, f);
+}
+
+
+static inline void bench_print_json_string(FILE* f, const char* s) {
+	fputc('"', f);
+	for (/**/; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			fprintf(f, "\\%c", *s);
+		else if ((unsigned char)*s < 0x20)
+			fprintf(f, "\\u%04x", *s);
+		else
+			fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+
+static inline void bench_print_csv_string(FILE* f, const char* s) {
+	fputc('"', f);
+	for (/**/; *s; s++) {
+		if (*s == '"')
+			fputc('"', f);
+		fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+
+static inline void bench_report(const bench* b) {
+	bench_context* ctx = bench_ctx();
+	const bench_result* r = &b->result;
+	FILE* f = ctx->out;
+	int k;
+
+	switch (ctx->format) {
+		case BENCH_TEXT:
+			if (!ctx->header_printed) {
+				fprintf(f, "# TSC %.3f GHz, counters: ", ctx->tsc_hz / 1e9);
+				if (ctx->leader >= 0) {
+					for (k=0; k < BENCH_COUNTERS; k++)
+						if (ctx->slot[k] >= 0)
+							fprintf(f, "%s ", bench_counter_names[k]);
+					fputc('\n', f);
+				} else
+					fprintf(f, "not available (%s), cycles are TSC ticks\n", ctx->perf_error);
+				fprintf(f, "# %s, %s\n", ctx->cpu, BENCH_COMPILER);
+			}
+
+			fprintf(f, "%-40s %10.3f ns/op (min %.3f, mad %4.1f%%) %8.2f cycles/op",
+				b->name, r->median_ns, r->min_ns,
+				(r->median_ns > 0) ? 100.0 * r->mad_ns / r->median_ns : 0.0,
+				bench_cycles(r));
+
+			if (b->bytes > 0)
+				fprintf(f, "  %.2f GB/s", bench_gbs(b));
+			if (r->counter[BENCH_INSTRUCTIONS] >= 0 && r->counter[BENCH_CYCLES] > 0)
+				fprintf(f, "  IPC %.2f", r->counter[BENCH_INSTRUCTIONS] / r->counter[BENCH_CYCLES]);
+			if (r->counter[BENCH_BRANCH_MISSES] >= 0)
+				fprintf(f, "  br-miss/op %.3f", r->counter[BENCH_BRANCH_MISSES]);
+			if (r->counter[BENCH_L1D_MISSES] >= 0)
+				fprintf(f, "  L1D-miss/op %.3f", r->counter[BENCH_L1D_MISSES]);
+			if (r->multiplexed > 0)
+				fprintf(f, "  (multiplexed %.0f%%)", 100.0 * r->multiplexed);
+			fputc('\n', f);
+			break;
+
+		case BENCH_CSV:
+			if (!ctx->header_printed) {
+				fputs("name,repeat,ops,min_ns,median_ns,mad_ns,tsc,tsc_ghz", f);
+				for (k=0; k < BENCH_COUNTERS; k++)
+					fprintf(f, ",%s", bench_counter_names[k]);
+				fputs(",multiplexed,gb_s,cpu,compiler\n", f);
+			}
+
+			bench_print_csv_string(f, b->name);
+			fprintf(f, ",%d,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g",
+				b->repeat, b->ops, r->min_ns, r->median_ns, r->mad_ns, r->tsc, ctx->tsc_hz / 1e9);
+			for (k=0; k < BENCH_COUNTERS; k++) {
+				fputc(',', f);
+				bench_print_value(f, r->counter[k], "");
+			}
+			fprintf(f, ",%.6g,", r->multiplexed);
+			bench_print_value(f, bench_gbs(b), "");
+			fputc(',', f);
+			bench_print_csv_string(f, ctx->cpu);
+			fputc(',', f);
+			bench_print_csv_string(f, BENCH_COMPILER);
+			fputc('\n', f);
+			break;
+
+		case BENCH_JSON:
+			fputs("{\"name\": ", f);
+			bench_print_json_string(f, b->name);
+			fprintf(f, ", \"repeat\": %d, \"ops\": %.6g, \"min_ns\": %.6g, \"median_ns\": %.6g, "
+				   "\"mad_ns\": %.6g, \"tsc\": %.6g, \"tsc_ghz\": %.6g",
+				b->repeat, b->ops, r->min_ns, r->median_ns, r->mad_ns, r->tsc, ctx->tsc_hz / 1e9);
+			for (k=0; k < BENCH_COUNTERS; k++) {
+				fprintf(f, ", \"%s\": ", bench_counter_names[k]);
+				bench_print_value(f, r->counter[k], "null");
+			}
+			fprintf(f, ", \"multiplexed\": %.6g", r->multiplexed);
+			fputs(", \"gb_s\": ", f);
+			bench_print_value(f, bench_gbs(b), "null");
+			fputs(", \"cpu\": ", f);
+			bench_print_json_string(f, ctx->cpu);
+			fputs(", \"compiler\": ", f);
+			bench_print_json_string(f, BENCH_COMPILER);
+			fputs("}\n", f);
+			break;
+	}
+
+	ctx->header_printed = 1;
+	fflush(f);
+}
+
+#endif
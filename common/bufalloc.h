@@ -0,0 +1,307 @@
+/*
+	Allocation of large buffers for benchmarks
+
+	Results of memory-bound benchmarks depend on the kind of pages
+	(transparent huge pages kick in or not) and, on NUMA machines,
+	on the node memory comes from.  Functions below make this explicit:
+
+	* pages: 4 KB (THP disabled), THP, explicit 2 MB or 1 GB huge pages;
+	  explicit huge pages must be reserved (/proc/sys/vm/nr_hugepages or
+	  hugepagesz=1G on the kernel command line), if they are not available
+	  allocation falls back to a smaller kind, field `pages` of buf_t
+	  tells what was really used;
+	* NUMA placement: first touch (memory comes from the node of the
+	  thread that allocates the buffer, as the buffer is pre-faulted)
+	  or interleaved over all nodes;
+	* alignment: buffers are always page-aligned, optionally aligned
+	  to a larger power of two;
+	* pre-faulting: all pages are touched, so page faults don't
+	  disturb measurements.
+
+	Defaults can be changed without recompilation with environment
+	variables BUFALLOC_PAGES (4k, thp, 2m, 1g) and BUFALLOC_NUMA
+	(local, interleave); case doesn't matter, unknown values are
+	reported on stderr.
+
+	Header-only, works in C99 and C++.  Include it before any other
+	header in C programs, it needs _GNU_SOURCE.
+*/
+#ifndef BUFALLOC_H_included__
+#define BUFALLOC_H_included__
+
+#ifndef _GNU_SOURCE
+#   define _GNU_SOURCE
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#ifndef MAP_HUGE_SHIFT
+#   define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#   define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#   define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+typedef enum {
+	BUF_PAGES_4K,
+	BUF_PAGES_THP,
+	BUF_PAGES_2M,
+	BUF_PAGES_1G
+} buf_pages;
+
+typedef enum {
+	BUF_NUMA_LOCAL,
+	BUF_NUMA_INTERLEAVE
+} buf_numa;
+
+typedef struct {
+	buf_pages pages;
+	buf_numa  numa;
+	size_t    align;	/* 0 or power of two; page alignment is always guaranteed */
+	int       prefault;
+} buf_options;
+
+typedef struct {
+	void*     ptr;		/* aligned pointer */
+	size_t    size;		/* requested size */
+	buf_pages pages;	/* kind of pages actually used */
+	void*     map;		/* whole mapping */
+	size_t    map_size;
+} buf_t;
+
+
+static inline const char* buf_pages_name(buf_pages pages) {
+	switch (pages) {
+		case BUF_PAGES_4K:  return "4k";
+		case BUF_PAGES_THP: return "thp";
+		case BUF_PAGES_2M:  return "2m";
+		case BUF_PAGES_1G:  return "1g";
+	}
+	return "?";
+}
+
+
+/* defaults: 4 KB pages, first touch, pre-faulted; environment overrides */
+static inline buf_options buf_default_options(void) {
+	static int warned = 0;	/* unknown values are reported once */
+	buf_options opt;
+	opt.pages    = BUF_PAGES_4K;
+	opt.numa     = BUF_NUMA_LOCAL;
+	opt.align    = 0;
+	opt.prefault = 1;
+
+	const char* pages = getenv("BUFALLOC_PAGES");
+	if (pages != NULL) {
+		if (strcasecmp(pages, "4k") == 0)
+			opt.pages = BUF_PAGES_4K;
+		else if (strcasecmp(pages, "thp") == 0)
+			opt.pages = BUF_PAGES_THP;
+		else if (strcasecmp(pages, "2m") == 0)
+			opt.pages = BUF_PAGES_2M;
+		else if (strcasecmp(pages, "1g") == 0)
+			opt.pages = BUF_PAGES_1G;
+		else if (!warned)
+			fprintf(stderr, "bufalloc: unknown BUFALLOC_PAGES=%s (4k, thp, 2m, 1g), using 4k\n", pages);
+	}
+
+	const char* numa = getenv("BUFALLOC_NUMA");
+	if (numa != NULL) {
+		if (strcasecmp(numa, "local") == 0)
+			opt.numa = BUF_NUMA_LOCAL;
+		else if (strcasecmp(numa, "interleave") == 0)
+			opt.numa = BUF_NUMA_INTERLEAVE;
+		else if (!warned)
+			fprintf(stderr, "bufalloc: unknown BUFALLOC_NUMA=%s (local, interleave), using local\n", numa);
+	}
+
+	warned = 1;
+
+	return opt;
+}
+
+
+static inline size_t buf_page_size(buf_pages pages) {
+	switch (pages) {
+		case BUF_PAGES_1G:  return 1024ul*1024*1024;
+		case BUF_PAGES_2M:
+		case BUF_PAGES_THP: return 2ul*1024*1024;
+		default:            return (size_t)sysconf(_SC_PAGESIZE);
+	}
+}
+
+
+/* interleaves pages over all online nodes, without libnuma */
+static inline void buf_interleave(void* ptr, size_t size) {
+#ifdef SYS_mbind
+	unsigned long mask[16];
+	int node;
+	memset(mask, 0, sizeof(mask));
+	for (node=0; node < (int)(8*sizeof(mask)); node++) {
+		char path[64];
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", node);
+		if (access(path, F_OK) == 0)
+			mask[node / (8*sizeof(long))] |= 1ul << (node % (8*sizeof(long)));
+	}
+
+	const int MPOL_INTERLEAVE_ = 3;
+	if (syscall(SYS_mbind, ptr, size, MPOL_INTERLEAVE_, mask, 8*sizeof(mask), 0) != 0)
+		perror("bufalloc: mbind");
+#else
+	(void)ptr;
+	(void)size;
+#endif
+}
+
+
+static inline void* buf_map_huge(size_t size, int flags) {
+	void* p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+	               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | flags, -1, 0);
+	return (p == MAP_FAILED) ? NULL : p;
+}
+
+
+/* returns 0 on success, -1 if memory can't be mapped */
+static inline int buf_alloc_opt(buf_t* b, size_t size, const buf_options* opt) {
+	buf_pages pages = opt->pages;
+
+	memset(b, 0, sizeof(*b));
+	b->size = size;
+	if (size == 0)
+		size = 1;
+
+	/* explicit huge pages, degrade 1G -> 2M -> THP; over-allocated
+	   when the requested alignment is larger than a huge page */
+	if (pages == BUF_PAGES_1G) {
+		const size_t huge  = buf_page_size(BUF_PAGES_1G);
+		const size_t extra = (opt->align > huge) ? opt->align : 0;
+		b->map_size = (size + extra + huge - 1) & ~(huge - 1);
+		b->map = buf_map_huge(b->map_size, MAP_HUGE_1GB);
+		if (b->map == NULL)
+			pages = BUF_PAGES_2M;
+	}
+
+	if (pages == BUF_PAGES_2M) {
+		const size_t huge  = buf_page_size(BUF_PAGES_2M);
+		const size_t extra = (opt->align > huge) ? opt->align : 0;
+		b->map_size = (size + extra + huge - 1) & ~(huge - 1);
+		b->map = buf_map_huge(b->map_size, MAP_HUGE_2MB);
+		if (b->map == NULL)
+			pages = BUF_PAGES_THP;
+	}
+
+	if (b->map != NULL) {
+		size_t align = buf_page_size(pages);
+		if (opt->align > align)
+			align = opt->align;
+
+		b->ptr = (void*)(((uintptr_t)b->map + align - 1) & ~(uintptr_t)(align - 1));
+	} else {
+		/* regular mapping, over-allocated to get the requested alignment */
+		size_t align = buf_page_size(pages);
+		if (opt->align > align)
+			align = opt->align;
+
+		const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+		const size_t rounded = (size + page - 1) & ~(page - 1);
+
+		b->map_size = rounded + align;
+		b->map = mmap(NULL, b->map_size, PROT_READ | PROT_WRITE,
+		              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (b->map == MAP_FAILED) {
+			b->map = NULL;
+			return -1;
+		}
+
+		b->ptr = (void*)(((uintptr_t)b->map + align - 1) & ~(uintptr_t)(align - 1));
+		madvise(b->map, b->map_size, (pages == BUF_PAGES_THP) ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+	}
+
+	b->pages = pages;
+
+	if (opt->numa == BUF_NUMA_INTERLEAVE)
+		buf_interleave(b->map, b->map_size);
+
+	if (opt->prefault) {
+		const size_t step = (size_t)sysconf(_SC_PAGESIZE);
+		volatile char* p = (volatile char*)b->ptr;
+		size_t i;
+		for (i=0; i < size; i += step)
+			p[i] = 0;
+		p[size - 1] = 0;
+	}
+
+	return 0;
+}
+
+
+static inline int buf_alloc(buf_t* b, size_t size) {
+	const buf_options opt = buf_default_options();
+	return buf_alloc_opt(b, size, &opt);
+}
+
+
+static inline void buf_free(buf_t* b) {
+	if (b->map != NULL)
+		munmap(b->map, b->map_size);
+
+	b->map = NULL;
+	b->ptr = NULL;
+}
+
+
+/* allocates or terminates the program, handy in benchmarks */
+static inline void* buf_alloc_or_die(buf_t* b, size_t size) {
+	if (buf_alloc(b, size) < 0) {
+		fprintf(stderr, "bufalloc: can't allocate %lu bytes\n", (unsigned long)size);
+		exit(EXIT_FAILURE);
+	}
+
+	return b->ptr;
+}
+
+
+#ifdef __cplusplus
+
+// RAII array with the interface of std::vector needed by speed programs
+template <typename T>
+class buf_array {
+
+	buf_t buf;
+	size_t count;
+
+public:
+	explicit buf_array(size_t n) : count(n) {
+		buf_alloc_or_die(&buf, n * sizeof(T));
+	}
+
+	~buf_array() {
+		buf_free(&buf);
+	}
+
+	buf_array(const buf_array&) = delete;
+	buf_array& operator=(const buf_array&) = delete;
+
+	T* data()                           { return (T*)buf.ptr; }
+	const T* data() const               { return (const T*)buf.ptr; }
+	size_t size() const                 { return count; }
+	T* begin()                          { return data(); }
+	T* end()                            { return data() + count; }
+	T& operator[](size_t i)             { return data()[i]; }
+	const T& operator[](size_t i) const { return data()[i]; }
+	buf_pages pages() const             { return buf.pages; }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,299 @@
+/*
+	Runtime CPU feature detection and function dispatch
+
+	Subprojects used to pick an instruction set at build time (-mavx2
+	and HAVE_AVX2_INSTRUCTIONS, separate binaries for each ISA); a binary
+	shipped to a mixed fleet can't do that.  With this header a single
+	binary contains all variants of a kernel and selects the fastest one
+	the CPU (and the OS) supports:
+
+	* cpu_features() returns a bitmask of CPU_xxx flags, detected once
+	  with CPUID; AVX and AVX-512 are reported only if XGETBV says the
+	  OS saves the vector state;
+
+	* environment variable CPUDISPATCH_DISABLE (comma-separated names,
+	  like "avx512f,avx2") masks features, thus every path can be tested
+	  on a single machine;
+
+	* a kernel family is an array of cpu_variant, ordered from the best
+	  to the baseline; cpu_select() returns the first variant whose
+	  required features are present.
+
+	Variants are compiled in the same translation unit as the rest of
+	a program, with CPU_TARGET_BEGIN("avx2") ... CPU_TARGET_END around
+	them (GCC target pragmas); the program itself is compiled without
+	-mavx2 & co.  Include standard headers and <immintrin.h> *before*
+	a target region, otherwise inline functions from these headers might
+	get compiled with the target ISA.
+
+	Variants are resolved lazily, at the first call, not in global
+	constructors nor in GNU ifunc resolvers (they run before libc is
+	initialized, getenv is not reliable there), thus no AVX instruction
+	can be executed before the check.  A typical family:
+
+		static const cpu_variant bfs_variants[] = {
+			CPU_VARIANT(CPU_AVX512F, avx512f_bfs),
+			CPU_VARIANT(0,           scalar_bfs),
+		};
+
+		typedef uint64_t (*bfs_fun)(const uint64_t*, size_t);
+
+		uint64_t bfs(const uint64_t* data, size_t n) {
+			static cpu_fun fun = NULL;
+			return ((bfs_fun)cpu_resolve(&fun, bfs_variants))(data, n);
+		}
+
+	cpu_resolve keeps the selected function in a static pointer with
+	atomic loads and stores, so the first calls may come from several
+	threads.  In C++ a function-local static initialized with
+	cpu_select() does the same.
+
+	Header-only, works in C99 and C++, x86 (32 and 64-bit) only.
+*/
+#ifndef CPUDISPATCH_H_included__
+#define CPUDISPATCH_H_included__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cpuid.h>
+
+enum {
+	CPU_SSE2            = 1u << 0,
+	CPU_SSE3            = 1u << 1,
+	CPU_SSSE3           = 1u << 2,
+	CPU_SSE41           = 1u << 3,
+	CPU_SSE42           = 1u << 4,
+	CPU_POPCNT          = 1u << 5,
+	CPU_AVX             = 1u << 6,
+	CPU_AVX2            = 1u << 7,
+	CPU_FMA             = 1u << 8,
+	CPU_BMI1            = 1u << 9,
+	CPU_BMI2            = 1u << 10,
+	CPU_AVX512F         = 1u << 11,
+	CPU_AVX512DQ        = 1u << 12,
+	CPU_AVX512CD        = 1u << 13,
+	CPU_AVX512BW        = 1u << 14,
+	CPU_AVX512VL        = 1u << 15,
+	CPU_AVX512VBMI      = 1u << 16,
+	CPU_AVX512VBMI2     = 1u << 17,
+	CPU_AVX512BITALG    = 1u << 18,
+	CPU_AVX512VPOPCNTDQ = 1u << 19
+};
+
+#define CPU_AVX512_ALL (CPU_AVX512F | CPU_AVX512DQ | CPU_AVX512CD | CPU_AVX512BW | CPU_AVX512VL | \
+                        CPU_AVX512VBMI | CPU_AVX512VBMI2 | CPU_AVX512BITALG | CPU_AVX512VPOPCNTDQ)
+
+typedef struct {
+	uint32_t    feature;
+	const char* name;	/* as in /proc/cpuinfo */
+} cpu_feature_name;
+
+static const cpu_feature_name cpu_feature_names[] = {
+	{CPU_SSE2,            "sse2"},
+	{CPU_SSE3,            "sse3"},
+	{CPU_SSSE3,           "ssse3"},
+	{CPU_SSE41,           "sse4_1"},
+	{CPU_SSE42,           "sse4_2"},
+	{CPU_POPCNT,          "popcnt"},
+	{CPU_AVX,             "avx"},
+	{CPU_AVX2,            "avx2"},
+	{CPU_FMA,             "fma"},
+	{CPU_BMI1,            "bmi1"},
+	{CPU_BMI2,            "bmi2"},
+	{CPU_AVX512F,         "avx512f"},
+	{CPU_AVX512DQ,        "avx512dq"},
+	{CPU_AVX512CD,        "avx512cd"},
+	{CPU_AVX512BW,        "avx512bw"},
+	{CPU_AVX512VL,        "avx512vl"},
+	{CPU_AVX512VBMI,      "avx512vbmi"},
+	{CPU_AVX512VBMI2,     "avx512_vbmi2"},
+	{CPU_AVX512BITALG,    "avx512_bitalg"},
+	{CPU_AVX512VPOPCNTDQ, "avx512_vpopcntdq"},
+	{0, NULL}
+};
+
+
+static inline uint64_t cpu_xgetbv(uint32_t index) {
+	uint32_t lo, hi;
+	/* the mnemonic would need -mxsave */
+	__asm__ volatile (".byte 0x0f, 0x01, 0xd0" : "=a" (lo), "=d" (hi) : "c" (index));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+
+/*
+	Features which can't be used without others are cleared.  GCC's
+	target("avx512f") implies AVX2 and FMA, such code may use them.
+*/
+static inline uint32_t cpu_normalize(uint32_t f) {
+	if (!(f & CPU_AVX))
+		f &= ~(CPU_AVX2 | CPU_FMA | CPU_AVX512_ALL);
+
+	if (!(f & CPU_AVX2) || !(f & CPU_FMA) || !(f & CPU_AVX512F))
+		f &= ~CPU_AVX512_ALL;
+
+	return f;
+}
+
+
+/* what CPUID and XGETBV report, CPUDISPATCH_DISABLE is not applied */
+static inline uint32_t cpu_detect(void) {
+	unsigned eax, ebx, ecx, edx;
+	uint32_t f = 0;
+	uint64_t xcr0 = 0;
+
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return 0;
+
+	if (edx & (1u << 26)) f |= CPU_SSE2;
+	if (ecx & (1u << 0))  f |= CPU_SSE3;
+	if (ecx & (1u << 9))  f |= CPU_SSSE3;
+	if (ecx & (1u << 19)) f |= CPU_SSE41;
+	if (ecx & (1u << 20)) f |= CPU_SSE42;
+	if (ecx & (1u << 23)) f |= CPU_POPCNT;
+	if (ecx & (1u << 12)) f |= CPU_FMA;
+
+	/* OSXSAVE: the OS uses XSAVE, XCR0 tells which registers are saved */
+	if (ecx & (1u << 27))
+		xcr0 = cpu_xgetbv(0);
+
+	/* XMM and YMM state */
+	if ((ecx & (1u << 28)) && (xcr0 & 0x06) == 0x06)
+		f |= CPU_AVX;
+
+	if (__get_cpuid_max(0, NULL) >= 7) {
+		__cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+		if (ebx & (1u << 3))  f |= CPU_BMI1;
+		if (ebx & (1u << 8))  f |= CPU_BMI2;
+		if (ebx & (1u << 5))  f |= CPU_AVX2;
+
+		/* opmask, upper halves of ZMM0-15 and ZMM16-31 */
+		if ((xcr0 & 0xe6) == 0xe6) {
+			if (ebx & (1u << 16)) f |= CPU_AVX512F;
+			if (ebx & (1u << 17)) f |= CPU_AVX512DQ;
+			if (ebx & (1u << 28)) f |= CPU_AVX512CD;
+			if (ebx & (1u << 30)) f |= CPU_AVX512BW;
+			if (ebx & (1u << 31)) f |= CPU_AVX512VL;
+			if (ecx & (1u << 1))  f |= CPU_AVX512VBMI;
+			if (ecx & (1u << 6))  f |= CPU_AVX512VBMI2;
+			if (ecx & (1u << 12)) f |= CPU_AVX512BITALG;
+			if (ecx & (1u << 14)) f |= CPU_AVX512VPOPCNTDQ;
+		}
+	}
+
+	return cpu_normalize(f);
+}
+
+
+/* parses a comma-separated list of feature names; unknown names are reported */
+static inline uint32_t cpu_parse_features(const char* list) {
+	uint32_t f = 0;
+
+	while (list != NULL && *list != '\0') {
+		const char* end = strchr(list, ',');
+		const size_t len = (end != NULL) ? (size_t)(end - list) : strlen(list);
+		int i, found = 0;
+
+		for (i=0; cpu_feature_names[i].name != NULL; i++) {
+			const char* name = cpu_feature_names[i].name;
+			if (strlen(name) == len && strncmp(name, list, len) == 0) {
+				f |= cpu_feature_names[i].feature;
+				found = 1;
+				break;
+			}
+		}
+
+		if (!found && len > 0)
+			fprintf(stderr, "cpudispatch: unknown feature '%.*s'\n", (int)len, list);
+
+		list = (end != NULL) ? end + 1 : NULL;
+	}
+
+	return f;
+}
+
+
+/* detected features, minus CPUDISPATCH_DISABLE; cached */
+static inline uint32_t cpu_features(void) {
+	/* bit 31 marks the cache valid; a race just repeats detection */
+	static uint32_t cached = 0;
+	uint32_t features = __atomic_load_n(&cached, __ATOMIC_RELAXED);
+
+	if (features == 0) {
+		const uint32_t disabled = cpu_parse_features(getenv("CPUDISPATCH_DISABLE"));
+		features = cpu_normalize(cpu_detect() & ~disabled) | (1u << 31);
+		__atomic_store_n(&cached, features, __ATOMIC_RELAXED);
+	}
+
+	return features & ~(1u << 31);
+}
+
+
+static inline int cpu_has(uint32_t features) {
+	return (cpu_features() & features) == features;
+}
+
+
+static inline void cpu_print_features(FILE* f, uint32_t features) {
+	int i;
+	for (i=0; cpu_feature_names[i].name != NULL; i++)
+		if (features & cpu_feature_names[i].feature)
+			fprintf(f, "%s ", cpu_feature_names[i].name);
+
+	fputc('\n', f);
+}
+
+
+/* any function pointer, casts between function pointer types are legal in C and C++ */
+typedef void (*cpu_fun)(void);
+
+typedef struct {
+	uint32_t    required;
+	cpu_fun     fun;
+	const char* name;
+} cpu_variant;
+
+#define CPU_VARIANT(required, fun) {(required), (cpu_fun)(fun), #fun}
+
+
+/* the first variant that can run, variants go from the best one; NULL if none */
+static inline const cpu_variant* cpu_select_n(const cpu_variant* variants, size_t count) {
+	const uint32_t features = cpu_features();
+	size_t i;
+
+	for (i=0; i < count; i++)
+		if ((variants[i].required & features) == variants[i].required)
+			return &variants[i];
+
+	return NULL;
+}
+
+#define cpu_select(variants) cpu_select_n((variants), sizeof(variants)/sizeof((variants)[0]))
+
+
+/* the function of the selected variant, cached in *slot (initially NULL);
+   thread-safe, concurrent first calls just select the same one again */
+static inline cpu_fun cpu_resolve_n(cpu_fun* slot, const cpu_variant* variants, size_t count) {
+	cpu_fun fun = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+
+	if (fun == NULL) {
+		fun = cpu_select_n(variants, count)->fun;
+		__atomic_store_n(slot, fun, __ATOMIC_RELEASE);
+	}
+
+	return fun;
+}
+
+#define cpu_resolve(slot, variants) cpu_resolve_n((slot), (variants), sizeof(variants)/sizeof((variants)[0]))
+
+
+/* compile code between these macros for the given ISA, like "avx2" or "avx512bw,avx512vl" */
+#define CPU_PRAGMA__(x) _Pragma(#x)
+#define CPU_TARGET_BEGIN(isa) _Pragma("GCC push_options") CPU_PRAGMA__(GCC target(isa))
+#define CPU_TARGET_END _Pragma("GCC pop_options")
+
+#endif
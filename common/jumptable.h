@@ -0,0 +1,143 @@
+/*
+	Multi-way dispatch without a chain of conditional branches
+
+	A decoder that handles several classes of input (lengths of varints,
+	sizes of small arrays, kinds of errors) usually tests them one after
+	another or uses a switch.  A chain of compares is a sequence of
+	branches, each one mispredicted on random input; a switch becomes
+	a bounds check and an indirect jump through a table -- one jump
+	shared by all cases, so the predictor sees only its global history.
+
+	This header gives three ways to jump directly to the code of
+	a class, when the class index is computed without branches (for
+	instance with tzcnt, see jumptable_tzcnt):
+
+	* JUMPTABLE_DEFINE/JUMPTABLE_GOTO --- labels as values (computed
+	  goto); the table is a static array of label addresses, there is no
+	  bounds check;
+
+	* JUMPTABLE_ASM_GOTO --- asm goto emitting the jump and a table of
+	  32-bit label offsets in .rodata (position-independent); the
+	  compiler sees neither the table nor the index arithmetic;
+
+	* JUMPTABLE_THREADED --- for functions repeating the dispatch at the
+	  end of every case, so that each case has its own indirect jump and
+	  its own predictor entry (threaded code, like in interpreters); it
+	  stops GCC from merging these identical tails back into one jump;
+
+	* jumptable_tzcnt --- the index of the lowest set bit of a mask,
+	  grouped by 2^shift bits; a sentinel bit sets the maximum index,
+	  reserved for "none of the above" (an error, a slow path).
+
+	The index must be in the range of the table, nothing is checked.
+	A switch can lose its bounds check too when the default case is
+	__builtin_unreachable(), yet the jump stays shared.
+
+	Usage:
+
+		JUMPTABLE_DEFINE(classes, one, two, error);
+		JUMPTABLE_GOTO(classes, jumptable_tzcnt(mask, 1ull << 16, 3));
+	one:
+		...
+
+	Header-only, works in C99 and C++ (GNU extensions), asm goto needs
+	GCC 4.5+ or clang 9+ and x86-64.  At most 16 labels in a table.
+*/
+#ifndef JUMPTABLE_H_included__
+#define JUMPTABLE_H_included__
+
+#include <stdint.h>
+
+#define JUMPTABLE_CAT__(a, b) JUMPTABLE_CAT2__(a, b)
+#define JUMPTABLE_CAT2__(a, b) a##b
+
+#define JUMPTABLE_COUNT__(...) \
+	JUMPTABLE_COUNT2__(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define JUMPTABLE_COUNT2__(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, n, ...) n
+
+#define JUMPTABLE_MAP1__(m, a)      m(a)
+#define JUMPTABLE_MAP2__(m, a, ...) m(a) JUMPTABLE_MAP1__(m, __VA_ARGS__)
+#define JUMPTABLE_MAP3__(m, a, ...) m(a) JUMPTABLE_MAP2__(m, __VA_ARGS__)
+#define JUMPTABLE_MAP4__(m, a, ...) m(a) JUMPTABLE_MAP3__(m, __VA_ARGS__)
+#define JUMPTABLE_MAP5__(m, a, ...) m(a) JUMPTABLE_MAP4__(m, __VA_ARGS__)
+#define JUMPTABLE_MAP6__(m, a, ...) m(a) JUMPTABLE_MAP5__(m, __VA_ARGS__)
+#define JUMPTABLE_MAP7__(m, a, ...) m(a) JUMPTABLE_MAP6__(m, __VA_ARGS__)
+#define JUMPTABLE_MAP8__(m, a, ...) m(a) JUMPTABLE_MAP7__(m, __VA_ARGS__)
+#define JUMPTABLE_MAP9__(m, a, ...) m(a) JUMPTABLE_MAP8__(m, __VA_ARGS__)
+#define JUMPTABLE_MAP10__(m, a, ...) m(a) JUMPTABLE_MAP9__(m, __VA_ARGS__)
+#define JUMPTABLE_MAP11__(m, a, ...) m(a) JUMPTABLE_MAP10__(m, __VA_ARGS__)
+#define JUMPTABLE_MAP12__(m, a, ...) m(a) JUMPTABLE_MAP11__(m, __VA_ARGS__)
+#define JUMPTABLE_MAP13__(m, a, ...) m(a) JUMPTABLE_MAP12__(m, __VA_ARGS__)
+#define JUMPTABLE_MAP14__(m, a, ...) m(a) JUMPTABLE_MAP13__(m, __VA_ARGS__)
+#define JUMPTABLE_MAP15__(m, a, ...) m(a) JUMPTABLE_MAP14__(m, __VA_ARGS__)
+#define JUMPTABLE_MAP16__(m, a, ...) m(a) JUMPTABLE_MAP15__(m, __VA_ARGS__)
+
+// m(label) for each label
+#define JUMPTABLE_MAP__(m, ...) \
+	JUMPTABLE_CAT__(JUMPTABLE_MAP, JUMPTABLE_CAT__(JUMPTABLE_COUNT__(__VA_ARGS__), __))(m, __VA_ARGS__)
+
+// identical tails of cases would be merged by cross-jumping
+#if defined(__clang__)
+#	define JUMPTABLE_THREADED
+#else
+#	define JUMPTABLE_THREADED __attribute__((optimize("no-crossjumping")))
+#endif
+
+//---------------------------------------------------------------------------
+// computed goto
+
+#define JUMPTABLE_ADDRESS__(label) __extension__ &&label,
+
+// a table of labels of the current function
+#define JUMPTABLE_DEFINE(name, ...) \
+	static const void* const name[] = { JUMPTABLE_MAP__(JUMPTABLE_ADDRESS__, __VA_ARGS__) }
+
+// (with -pedantic GCC warns about computed goto, __extension__ can't be
+// put before a statement)
+#define JUMPTABLE_GOTO(name, index) \
+	do { \
+		_Pragma("GCC diagnostic push") \
+		_Pragma("GCC diagnostic ignored \"-Wpedantic\"") \
+		goto *(name)[(index)]; \
+		_Pragma("GCC diagnostic pop") \
+	} while (0)
+
+//---------------------------------------------------------------------------
+// asm goto
+
+#if defined(__x86_64__)
+
+#define JUMPTABLE_OFFSET__(label) ".long %l[" #label "] - .Ljumptable%=\n\t"
+
+// jumps to the index-th label, never falls through
+#define JUMPTABLE_ASM_GOTO(index, ...) \
+	do { \
+		__asm__ goto ( \
+			"lea     .Ljumptable%=(%%rip), %%r11\n\t" \
+			"movslq  (%%r11, %q0, 4), %%rax\n\t" \
+			"add     %%r11, %%rax\n\t" \
+			"jmp     *%%rax\n\t" \
+			".pushsection .rodata\n\t" \
+			".balign 4\n" \
+			".Ljumptable%=:\n\t" \
+			JUMPTABLE_MAP__(JUMPTABLE_OFFSET__, __VA_ARGS__) \
+			".popsection\n\t" \
+			: /* no output */ \
+			: "r" ((uint64_t)(index)) \
+			: "rax", "r11", "cc" \
+			: __VA_ARGS__ \
+		); \
+		__builtin_unreachable(); \
+	} while (0)
+
+#endif
+
+//---------------------------------------------------------------------------
+// tzcnt
+
+// (index of the lowest set bit of mask | sentinel) >> shift; sentinel != 0
+static inline unsigned jumptable_tzcnt(uint64_t mask, uint64_t sentinel, int shift) {
+	return (unsigned)__builtin_ctzll(mask | sentinel) >> shift;
+}
+
+#endif
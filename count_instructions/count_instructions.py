@@ -1,35 +1,177 @@
-import sys
+"""
+Static and dynamic instruction mix
+
+Static: instructions of binaries (objdump -d) are counted by mnemonic,
+ISA extension and port pressure class.
+
+Dynamic (--run): the program is sampled, with `perf record` when perf
+works, otherwise with ./sampler (ptrace, timer based); samples in the
+main executable are attributed to instructions and aggregated by ISA
+extension, port class, mnemonic and basic block, next to the static
+counts of the same binary --- it shows which SIMD paths really run.
+
+	$ python count_instructions.py /usr/bin/*
+	$ python count_instructions.py --run -- ../wide-bfs/benchmark
+	$ python count_instructions.py --run --sampler=ptrace --blocks=20 -- ./speed 1000000
+"""
+
+from __future__ import print_function, division
+
+import os
 import re
+import sys
+import shutil
+import tempfile
+import argparse
 import subprocess
 
-def main(paths):
-	freq = {}
-	instructions = load_instructions('instruction.txt')
+here = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(here, '..', 'scripts'))
+
+from table import Table
 
-	n = len(paths)
+
+def main():
+	parser = argparse.ArgumentParser(description='static and dynamic instruction mix')
+	parser.add_argument('paths', nargs='*', help='binaries (static counts), or a program with its arguments (--run)')
+	parser.add_argument('--run', action='store_true', help='run and sample the program given after --')
+	parser.add_argument('--sampler', choices=['auto', 'perf', 'ptrace'], default='auto')
+	parser.add_argument('--frequency', type=int, default=1000, help='samples per second (default: 1000)')
+	parser.add_argument('--blocks', type=int, default=10, help='number of hot basic blocks shown (default: 10)')
+	parser.add_argument('--mnemonics', type=int, default=20, help='number of mnemonics shown with --run (default: 20)')
+	args = parser.parse_args()
+
+	if not args.paths:
+		parser.print_usage(sys.stderr)
+		return 1
+
+	instructions = load_instructions(os.path.join(here, 'instruction.txt'))
+
+	if args.run:
+		return run(args, instructions)
+
+	freq = {}
+	classes = {}
+	n = len(args.paths)
 	try:
-		for index, path in enumerate(paths):
+		for index, path in enumerate(args.paths):
 			sys.stderr.write('%d/%d: %s\n' % (index+1, n, path))
 
-			lines = disassemble(path)
-			if lines is not None:
-				update_freq(freq, lines, instructions)
+			code = disassemble(path)
+			if code is not None:
+				update_freq(freq, code.instructions, instructions)
+				for i in code.instructions:
+					for key in (('isa', i.isa), ('port', i.port)):
+						classes[key] = classes.get(key, 0) + 1
 	finally:
 		print_freq(freq)
+		print()
+		print_classes(classes, 'ISA extension', 'isa', ISA_ORDER)
+		print_classes(classes, 'port class', 'port', PORT_ORDER)
+
+	return 0
+
+
+# disassembly -----------------------------------------------------------------
+
+class Instruction(object):
+	__slots__ = ('address', 'mnemonic', 'operands', 'function', 'block', 'isa', 'port')
+
+	def __init__(self, address, mnemonic, operands, function):
+		self.address  = address
+		self.mnemonic = mnemonic
+		self.operands = operands
+		self.function = function
+		self.block    = None
+		self.isa      = classify_isa(mnemonic, operands)
+		self.port     = classify_port(mnemonic, operands)
+
+
+class Code(object):
+	def __init__(self, instructions, segments):
+		self.instructions = instructions	# sorted by address
+		self.segments     = segments		# [(file offset, vaddr, size)]
+		self.by_address   = dict((i.address, i) for i in instructions)
+		self.addresses    = [i.address for i in instructions]
+		self.blocks       = split_blocks(instructions)
+
+
+	def find(self, address):
+		"""instruction containing address"""
+		import bisect
+		index = bisect.bisect_right(self.addresses, address) - 1
+		if index < 0:
+			return None
+
+		return self.instructions[index]
+
+
+	def vaddr(self, file_offset):
+		for offset, vaddr, size in self.segments:
+			if offset <= file_offset < offset + size:
+				return file_offset - offset + vaddr
+
+
+PREFIXES = set(['rep', 'repz', 'repe', 'repnz', 'repne', 'lock', 'bnd', 'notrack',
+                'data16', 'addr32', 'cs', 'ds', 'ss', 'es', 'fs', 'gs'])
+
+line_re     = re.compile(r'^\s*([0-9a-f]+):\t(.*)$')
+function_re = re.compile(r'^([0-9a-f]+) <(.*)>:$')
+target_re   = re.compile(r'^([0-9a-f]+) <')
 
 
 def disassemble(path):
 	args = [
 		'objdump',
 		'-d',
+		'-M', 'intel',
 		'--no-show-raw-insn',
 		path
 	]
 
 	proc = subprocess.Popen(args, stdout=subprocess.PIPE)
 	res  = proc.communicate()[0]
-	if proc.wait() == 0:
-		return res.splitlines()
+	if proc.wait() != 0:
+		return None
+
+	instructions = []
+	function = ''
+	for line in res.decode('utf-8', 'replace').splitlines():
+		m = function_re.match(line)
+		if m:
+			function = m.group(2)
+			continue
+
+		m = line_re.match(line)
+		if not m:
+			continue
+
+		text = m.group(2).split('#')[0].split()
+		while text and (text[0] in PREFIXES or text[0].startswith('rex')):
+			text.pop(0)
+
+		if not text or text[0] == '(bad)':
+			continue
+
+		instructions.append(Instruction(int(m.group(1), 16), text[0], ' '.join(text[1:]), function))
+
+	return Code(instructions, load_segments(path))
+
+
+def load_segments(path):
+	"""LOAD entries of program headers: (offset, vaddr, filesz)"""
+
+	out = subprocess.check_output(['objdump', '-p', path]).decode('utf-8', 'replace').splitlines()
+	result = []
+	for line, next_line in zip(out, out[1:]):
+		fields = line.split()
+		if fields[:1] == ['LOAD']:
+			offset = int(fields[2], 16)
+			vaddr  = int(fields[4], 16)
+			size   = int(next_line.split()[1], 16)
+			result.append((offset, vaddr, size))
+
+	return result
 
 
 def load_instructions(path):
@@ -44,41 +186,359 @@ def load_instructions(path):
 	return result
 
 
-def update_freq(freq, lines, known_instructions):
-	for line in lines:
-		line   = line.strip()
-		fields = line.split()
+# classification --------------------------------------------------------------
 
-		if len(fields) == 0:
-			continue
+ISA_ORDER = ['base', 'BMI', 'x87', 'MMX', 'SSE', 'AVX', 'AVX2', 'FMA', 'AVX-512']
 
-		if not re.match('^\d+:$', fields[0]):
-			continue
+BMI = set(['andn', 'bextr', 'blsi', 'blsmsk', 'blsr', 'bzhi', 'lzcnt', 'tzcnt',
+           'mulx', 'pdep', 'pext', 'rorx', 'sarx', 'shlx', 'shrx'])
+
+AVX2_XMM = re.compile(r'^vp(broadcast|maskmov|sllv|srlv|srav|gather)|^vgather|^vinserti128|^vextracti128|^vperm2i128|^vpermq|^vpermd|^vpblendd')
+
+zmm_re  = re.compile(r'\bzmm\d+|\bk[0-7]\b|\{k[0-7]\}')
+ymm_re  = re.compile(r'\bymm\d+')
+xmm_hi  = re.compile(r'\bxmm(1[6-9]|2\d|3[01])\b')
+xmm_re  = re.compile(r'\bxmm\d+')
+mmx_re  = re.compile(r'\bmm[0-7]\b')
+
+
+def classify_isa(mnemonic, operands):
+	if zmm_re.search(operands) or xmm_hi.search(operands) or mnemonic.startswith('k'):
+		return 'AVX-512'
+
+	if mnemonic.startswith('vfm') or mnemonic.startswith('vfnm'):
+		return 'FMA'
+
+	if mnemonic.startswith('v'):
+		if AVX2_XMM.match(mnemonic):
+			return 'AVX2'
+		if ymm_re.search(operands) and mnemonic.startswith('vp'):
+			return 'AVX2'
+
+		return 'AVX'
+
+	if mmx_re.search(operands):
+		return 'MMX'
+
+	if xmm_re.search(operands):
+		return 'SSE'
+
+	if mnemonic in BMI or mnemonic == 'popcnt':
+		return 'BMI'
+
+	if mnemonic.startswith('f') and not mnemonic.startswith('fxsave') and not mnemonic.startswith('fxrstor'):
+		return 'x87'
+
+	return 'base'
+
+
+PORT_ORDER = ['branch', 'load', 'store', 'scalar ALU', 'vector ALU', 'shuffle',
+              'multiply/FMA', 'divide/sqrt', 'gather/scatter', 'nop']
+
+shuffle_re = re.compile(r'shuf|perm|unpck|pack|align|insert|extract|broadcast|compress|expand|'
+                        r'movhlps|movlhps|movddup|movsldup|movshdup|^v?pmov[sz]x|^vpmovq|^vpmovd|^vpmovw|^vpmovus|^vpmovs')
+multiply_re = re.compile(r'mul|^v?pmadd|^vfn?m|^vpdp')
+divide_re   = re.compile(r'div|sqrt|rcp|rsqrt')
+
+
+def classify_port(mnemonic, operands):
+	if mnemonic.startswith('j') or mnemonic in ('call', 'ret', 'loop', 'loope', 'loopne', 'jmp'):
+		return 'branch'
+
+	if mnemonic.startswith('nop') or mnemonic == 'endbr64':
+		return 'nop'
+
+	if 'gather' in mnemonic or 'scatter' in mnemonic:
+		return 'gather/scatter'
+
+	if divide_re.search(mnemonic):
+		return 'divide/sqrt'
+
+	if multiply_re.search(mnemonic):
+		return 'multiply/FMA'
+
+	if shuffle_re.search(mnemonic):
+		return 'shuffle'
+
+	# pure data movement: Intel syntax, the destination is first
+	if re.match(r'^(v?mov|push|pop|lods|stos|movs)', mnemonic) and not mnemonic.startswith('movmsk') \
+	   and not mnemonic.startswith('vpmovm') and not mnemonic.startswith('vpmovb2m'):
+		fields = operands.split(',')
+		if mnemonic == 'push' or mnemonic.startswith('stos') or '[' in fields[0]:
+			return 'store'
+		if mnemonic == 'pop' or mnemonic.startswith('lods') or any('[' in op for op in fields[1:]):
+			return 'load'
 
-		fields.pop(0)
-		instruction = fields[0]
-		if instruction in known_instructions:
-			freq[instruction] = freq.get(instruction, 0) + 1
-		else:
-			sys.stderr.write("ERROR: unknown instruction '%s'\n" % instruction)
-			sys.stderr.write(" line: " + line + "\n");
+	if mnemonic.startswith('v') or xmm_re.search(operands) or mmx_re.search(operands):
+		return 'vector ALU'
+
+	return 'scalar ALU'
+
+
+# basic blocks ----------------------------------------------------------------
+
+def is_branch(instruction):
+	return instruction.port == 'branch' and instruction.mnemonic != 'call'
+
+
+def split_blocks(instructions):
+	"""leaders: function starts, branch targets, instructions after branches"""
+
+	leaders = set()
+	previous = None
+	for instruction in instructions:
+		if previous is None or previous.function != instruction.function or is_branch(previous):
+			leaders.add(instruction.address)
+
+		if is_branch(instruction):
+			m = target_re.match(instruction.operands)
+			if m:
+				leaders.add(int(m.group(1), 16))
+
+		previous = instruction
+
+	blocks = []
+	for instruction in instructions:
+		if instruction.address in leaders or not blocks:
+			blocks.append([])
+		blocks[-1].append(instruction)
+		instruction.block = blocks[-1][0].address
+
+	return blocks
+
+
+# static counts ---------------------------------------------------------------
+
+def update_freq(freq, instructions, known_instructions):
+	unknown = {}
+	for instruction in instructions:
+		mnemonic = instruction.mnemonic
+		freq[mnemonic] = freq.get(mnemonic, 0) + 1
+		if mnemonic not in known_instructions:
+			unknown[mnemonic] = unknown.get(mnemonic, 0) + 1
+
+	for mnemonic in sorted(unknown):
+		sys.stderr.write("WARNING: instruction '%s' not in instruction.txt (%d times)\n" % (mnemonic, unknown[mnemonic]))
 
 	return freq
 
 
 def print_freq(freq):
-	L = freq.items()
-	L.sort(key=lambda k: k[1], reverse=True)
+	L = sorted(freq.items(), key=lambda k: k[1], reverse=True)
 
 	total = sum(count for instruction, count in L)
 
 	for instruction, count in L:
-		print "%20s %10d %10.2f%%" % (instruction, count, (100.0*count)/total)
+		print("%20s %10d %10.2f%%" % (instruction, count, (100.0*count)/total))
 
 
+def print_classes(classes, title, kind, order):
+	total = sum(count for (k, _), count in classes.items() if k == kind)
 
-if __name__ == '__main__':
-	if len(sys.argv) > 1:
-		main(sys.argv[1:])
+	table = Table()
+	table.set_header([title, 'count', '%'])
+	for name in order:
+		if (kind, name) in classes:
+			count = classes[(kind, name)]
+			table.add_row([name, str(count), percent(count, total)])
+
+	print(table)
+	print()
+
+
+# dynamic counts --------------------------------------------------------------
+
+class Samples(object):
+	def __init__(self):
+		self.exe  = None
+		self.maps = []		# (start, end, file offset)
+		self.ips  = []
+
+
+	def file_offset(self, ip):
+		for start, end, offset in self.maps:
+			if start <= ip < end:
+				return ip - start + offset
+
+
+def run(args, known_instructions):
+	program = args.paths
+	workdir = tempfile.mkdtemp(prefix='count_instructions')
+	try:
+		samples = None
+		if args.sampler in ('auto', 'perf'):
+			samples = sample_perf(program, args.frequency, workdir)
+			if samples is None and args.sampler == 'perf':
+				sys.stderr.write('perf record failed\n')
+				return 1
+
+		if samples is None:
+			samples = sample_ptrace(program, args.frequency, workdir)
+	finally:
+		shutil.rmtree(workdir)
+
+	if samples is None or samples.exe is None:
+		sys.stderr.write('no samples\n')
+		return 1
+
+	code = disassemble(samples.exe)
+	if code is None:
+		sys.stderr.write("can't disassemble %s\n" % samples.exe)
+		return 1
+
+	hits = {}
+	outside = 0
+	for ip in samples.ips:
+		offset = samples.file_offset(ip)
+		vaddr  = code.vaddr(offset) if offset is not None else None
+		instruction = code.find(vaddr) if vaddr is not None else None
+		if instruction is None:
+			outside += 1
+			continue
+
+		hits[instruction.address] = hits.get(instruction.address, 0) + 1
+
+	report(samples.exe, code, hits, len(samples.ips), outside, args)
+	return 0
+
+
+def sample_perf(program, frequency, workdir):
+	data = os.path.join(workdir, 'perf.data')
+	for event in ('cycles:u', 'cpu-clock'):
+		try:
+			status = subprocess.call(['perf', 'record', '-q', '-F', str(frequency), '-e', event, '-o', data, '--'] + program)
+		except OSError:
+			return None
+
+		if status == 0 and os.path.exists(data):
+			break
 	else:
-		sys.stderr.write("usage: %s list-of-paths\n" % sys.argv[0])
+		return None
+
+	try:
+		out = subprocess.check_output(['perf', 'script', '-i', data, '--show-mmap-events', '-F', 'ip,dso'])
+	except (OSError, subprocess.CalledProcessError):
+		return None
+
+	exe = os.path.realpath(shutil.which(program[0]) if hasattr(shutil, 'which') and shutil.which(program[0]) else program[0])
+	return parse_perf_script(out.decode('utf-8', 'replace'), exe)
+
+
+mmap_re = re.compile(r'PERF_RECORD_MMAP2? .*?\[0x([0-9a-f]+)\(0x([0-9a-f]+)\) @ (?:0x)?([0-9a-f]+)[ \]].*\s(\S+)\s*$')
+ip_re   = re.compile(r'^\s*([0-9a-f]+)\s+\((.*)\)\s*$')
+
+
+def parse_perf_script(text, exe):
+	samples = Samples()
+	samples.exe = exe
+	for line in text.splitlines():
+		m = mmap_re.search(line)
+		if m:
+			if os.path.realpath(m.group(4)) == exe:
+				start, length, offset = (int(m.group(i), 16) for i in (1, 2, 3))
+				samples.maps.append((start, start + length, offset))
+			continue
+
+		m = ip_re.match(line)
+		if m:
+			samples.ips.append(int(m.group(1), 16))
+
+	return samples
+
+
+def sample_ptrace(program, frequency, workdir):
+	sampler = os.path.join(here, 'sampler')
+	if not os.path.exists(sampler):
+		sys.stderr.write('%s not found, run make\n' % sampler)
+		return None
+
+	out = os.path.join(workdir, 'samples')
+	interval = max(1, 1000000 // frequency)
+	if subprocess.call([sampler, '-i', str(interval), '-o', out, '--'] + program) != 0:
+		return None
+
+	samples = Samples()
+	for line in open(out):
+		fields = line.split(None, 1)
+		if fields[0] == 'exe':
+			samples.exe = fields[1].strip()
+		elif fields[0] == 'map':
+			samples.maps.append(tuple(int(x, 16) for x in fields[1].split()))
+		elif fields[0] == 'ip':
+			samples.ips.append(int(fields[1], 16))
+
+	return samples
+
+
+def percent(count, total):
+	return '%0.1f%%' % (100.0 * count / total) if total else '-'
+
+
+def report(exe, code, hits, total, outside, args):
+	inside = total - outside
+	print('%s: %d samples, %d (%s) in the executable, %d in libraries and kernel'
+	      % (exe, total, inside, percent(inside, total), outside))
+	print()
+
+	static  = {}
+	dynamic = {}
+	for instruction in code.instructions:
+		n = hits.get(instruction.address, 0)
+		for key in (('isa', instruction.isa), ('port', instruction.port), ('mnemonic', instruction.mnemonic)):
+			static[key]  = static.get(key, 0) + 1
+			dynamic[key] = dynamic.get(key, 0) + n
+
+	n_static = len(code.instructions)
+
+	def summary(title, kind, order):
+		table = Table()
+		table.set_header([title, 'static', 'static %', 'samples', 'samples %'])
+		for name in order:
+			key = (kind, name)
+			if key in static:
+				table.add_row([name, str(static[key]), percent(static[key], n_static),
+				               str(dynamic[key]), percent(dynamic[key], inside)])
+		print(table)
+		print()
+
+	summary('ISA extension', 'isa', ISA_ORDER)
+	summary('port class', 'port', PORT_ORDER)
+
+	mnemonics = sorted((name for kind, name in dynamic if kind == 'mnemonic' and dynamic[(kind, name)] > 0),
+	                   key=lambda name: dynamic[('mnemonic', name)], reverse=True)
+	summary('mnemonic', 'mnemonic', mnemonics[:args.mnemonics])
+
+	block_hits = []
+	for block in code.blocks:
+		n = sum(hits.get(i.address, 0) for i in block)
+		if n > 0:
+			block_hits.append((n, block))
+
+	block_hits.sort(key=lambda item: item[0], reverse=True)
+
+	table = Table()
+	table.set_header(['block', 'function', 'instructions', 'samples %', 'ISA', 'hottest'])
+	for n, block in block_hits[:args.blocks]:
+		isas = {}
+		for i in block:
+			isas[i.isa] = isas.get(i.isa, 0) + 1
+
+		hottest = max(block, key=lambda i: hits.get(i.address, 0))
+		table.add_row([
+			'%x' % block[0].address,
+			shorten(block[0].function, 40),
+			str(len(block)),
+			percent(n, inside),
+			' '.join('%s:%d' % (isa, isas[isa]) for isa in ISA_ORDER if isa in isas),
+			'%s %s' % (hottest.mnemonic, shorten(hottest.operands, 30)),
+		])
+
+	print(table)
+
+
+def shorten(s, width):
+	return s if len(s) <= width else s[:width - 3] + '...'
+
+
+if __name__ == '__main__':
+	sys.exit(main())
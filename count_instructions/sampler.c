@@ -0,0 +1,191 @@
+/*
+	Sampling of the instruction pointer without hardware counters
+
+	The program is run under ptrace; every interval it's stopped with
+	SIGSTOP and RIP of the main thread is recorded.  That's what
+	"perf record -e cpu-clock" does, but it works where perf is not
+	installed or perf_event_open is not allowed (containers, VMs).
+	Samples are timer-based, thus they show where the time goes, and
+	skid is the same as of any interrupt: an instruction waiting for
+	its operands is usually the one reported.
+
+	Output (stdout or -o file), read by count_instructions.py:
+
+		exe  <path>
+		map  <start> <end> <file offset>	executable mappings of exe, hex
+		ip   <address>				one line per sample, hex
+
+	Only the main thread is sampled.
+
+	usage: sampler [-i microseconds] [-o file] -- program [args]
+*/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ptrace.h>
+#include <sys/user.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+void die(const char* msg) {
+	perror(msg);
+	exit(EXIT_FAILURE);
+}
+/*------------------------------------------------------------------------*/
+
+void print_maps(FILE* out, pid_t pid) {
+	char path[64];
+	char exe[4096];
+	char line[8192];
+	ssize_t len;
+	FILE* f;
+
+	snprintf(path, sizeof(path), "/proc/%d/exe", (int)pid);
+	len = readlink(path, exe, sizeof(exe) - 1);
+	if (len < 0)
+		die("readlink");
+
+	exe[len] = '\0';
+	fprintf(out, "exe %s\n", exe);
+
+	snprintf(path, sizeof(path), "/proc/%d/maps", (int)pid);
+	f = fopen(path, "r");
+	if (f == NULL)
+		die("fopen");
+
+	while (fgets(line, sizeof(line), f)) {
+		unsigned long start, end, offset;
+		char perms[8];
+		int name = 0;
+
+		/* start-end perms offset dev inode name */
+		if (sscanf(line, "%lx-%lx %7s %lx %*s %*s %n", &start, &end, perms, &offset, &name) < 4)
+			continue;
+
+		if (perms[2] != 'x' || name == 0)
+			continue;
+
+		line[strcspn(line, "\n")] = '\0';
+		if (strcmp(line + name, exe) == 0)
+			fprintf(out, "map %lx %lx %lx\n", start, end, offset);
+	}
+
+	fclose(f);
+}
+/*------------------------------------------------------------------------*/
+
+int main(int argc, char* argv[]) {
+	long interval = 1000;
+	FILE* out = stdout;
+	unsigned long samples = 0;
+	struct timespec delay;
+	pid_t pid;
+	int status, opt;
+
+	while ((opt = getopt(argc, argv, "+i:o:")) != -1) {
+		switch (opt) {
+			case 'i':
+				interval = atol(optarg);
+				break;
+			case 'o':
+				out = fopen(optarg, "w");
+				if (out == NULL)
+					die(optarg);
+				break;
+			default:
+				goto usage;
+		}
+	}
+
+	if (optind >= argc || interval <= 0)
+		goto usage;
+
+	pid = fork();
+	if (pid < 0)
+		die("fork");
+
+	if (pid == 0) {
+		if (ptrace(PTRACE_TRACEME, 0, NULL, NULL) < 0)
+			die("ptrace(TRACEME)");
+
+		execvp(argv[optind], argv + optind);
+		die(argv[optind]);
+	}
+
+	/* stopped after exec, the executable is mapped */
+	if (waitpid(pid, &status, 0) < 0 || !WIFSTOPPED(status)) {
+		fputs("sampler: program didn't start\n", stderr);
+		return EXIT_FAILURE;
+	}
+
+	print_maps(out, pid);
+	ptrace(PTRACE_CONT, pid, NULL, NULL);
+
+	delay.tv_sec  = interval / 1000000;
+	delay.tv_nsec = (interval % 1000000) * 1000;
+
+	while (1) {
+		int sig;
+
+		nanosleep(&delay, NULL);
+		if (kill(pid, SIGSTOP) < 0)
+			break;
+
+		/* other signals may come first, they are passed to the program */
+		while (1) {
+			if (waitpid(pid, &status, 0) < 0)
+				die("waitpid");
+
+			if (WIFEXITED(status) || WIFSIGNALED(status))
+				goto done;
+
+			sig = WSTOPSIG(status);
+			if (sig == SIGSTOP)
+				break;
+
+			ptrace(PTRACE_CONT, pid, NULL, (void*)(intptr_t)sig);
+		}
+
+		{
+			struct user_regs_struct regs;
+			if (ptrace(PTRACE_GETREGS, pid, NULL, &regs) == 0) {
+#if defined(__x86_64__)
+				fprintf(out, "ip %llx\n", (unsigned long long)regs.rip);
+#else
+				fprintf(out, "ip %lx\n", (unsigned long)regs.eip);
+#endif
+				samples++;
+			}
+		}
+
+		ptrace(PTRACE_CONT, pid, NULL, NULL);
+	}
+
+done:
+	if (WIFEXITED(status) && WEXITSTATUS(status) != 0)
+		fprintf(stderr, "sampler: program exited with status %d\n", WEXITSTATUS(status));
+	if (WIFSIGNALED(status))
+		fprintf(stderr, "sampler: program killed by signal %d\n", WTERMSIG(status));
+
+	fprintf(stderr, "sampler: %lu samples\n", samples);
+	fclose(out);
+
+	/* exit status of the program, like a shell reports it */
+	if (WIFEXITED(status))
+		return WEXITSTATUS(status);
+	if (WIFSIGNALED(status))
+		return 128 + WTERMSIG(status);
+
+	return EXIT_FAILURE;
+
+usage:
+	fprintf(stderr, "usage: %s [-i microseconds] [-o file] -- program [args]\n", argv[0]);
+	return EXIT_FAILURE;
+}
+/*------------------------------------------------------------------------*/
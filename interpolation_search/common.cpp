@@ -1,41 +1,4 @@
-#include <sys/time.h>
-
-
-class measure_item_t {
-    const std::string name;
-    uint32_t t1, t2;
-
-public:
-    measure_item_t(const std::string& name) : name(name) {}
-
-public:
-    void print() const {
-        std::printf("%20s: %10.4fs\n", name.c_str(), get_time());
-    }
-
-    void print(const measure_item_t& other) const {
-        std::printf("%20s: %10.4fs (speedup: %0.2f)\n", name.c_str(), get_time(), other.get_time()/get_time());
-    }
-
-	double get_time() const {
-		return (t2 - t1)/1000000.0;
-	}
-
-	void start() {
-		t1 = get_time();
-	}
-
-	void stop() {
-		t2 = get_time();
-	}
-
-private:
-	uint32_t get_time(void) {
-		static struct timeval T;
-		gettimeofday(&T, NULL);
-		return (T.tv_sec * 1000000) + T.tv_usec;
-	}
-};
+#include "../common/bench.h"
 
 
 template <typename Middle>
@@ -60,21 +23,30 @@ std::size_t count(const ArrayType& array, Middle middle, const std::string& name
 }
 
 
+// prints the time of searching all keys, median of 5 passes; with
+// BENCH_FORMAT=csv or json a bench.h record is written instead
 template <typename Middle>
-measure_item_t speed(const ArrayType& array, Middle middle, const std::string& name) {
-
-    measure_item_t m(name);
-    m.start();
+double speed(const ArrayType& array, Middle middle, const std::string& name, const std::string& group) {
 
     const auto n = array.size();
-    for (auto i=0u; i < n; i++) {
-        search(array, i, middle);
+
+    bench b;
+    bench_begin(&b, (name + ", " + group + "/" + std::to_string(n)).c_str(), 5, n);
+    b.warmup = 1;
+    while (bench_next(&b)) {
+        for (auto i=0u; i < n; i++) {
+            BENCH_KEEP(search(array, i, middle));
+        }
     }
 
-    m.stop();
-    m.print();
+    const double seconds = b.result.median_ns * n / 1e9;
+    if (bench_format() == BENCH_TEXT) {
+        std::printf("%20s: %10.4fs\n", name.c_str(), seconds);
+    } else {
+        bench_report(&b);
+    }
 
-    return m;
+    return seconds;
 }
 
 
@@ -10,11 +10,13 @@
 template <typename Value, typename... Args>
 void test(const std::size_t n, Value value, const std::string& name, Args... args) {
 
-    printf("\n%s\n", name.c_str());
+    if (bench_format() == BENCH_TEXT) {
+        printf("\n%s\n", name.c_str());
+    }
     const auto array = prepare(n, value, args...);
 
-    speed(array, bin_middle, "binary search");
-    speed(array, interpolation_middle, "interpolation search");
+    speed(array, bin_middle, "binary search", name);
+    speed(array, interpolation_middle, "interpolation search", name);
 }
 
 
@@ -1,3 +1,4 @@
+#include "../common/bufalloc.h"
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -28,11 +29,12 @@ int main(int argc, char* argv[]) {
 	const uint32_t MiB  = 1024*1024;
 	const uint32_t size = 16*MiB;
 
-	char* buffer = (char*)malloc(size);
-
-	if (buffer == NULL)
+	buf_t buf;
+	if (buf_alloc(&buf, size) < 0)
 		return EXIT_FAILURE;
 
+	char* buffer = (char*)buf.ptr;
+
 	memset(buffer, '?', size);
 	buffer[size - 1] = '\0';
 
@@ -44,6 +46,6 @@ int main(int argc, char* argv[]) {
 		printf("time: %0.3f\n", dt);
 	}
 
-	free(buffer);
+	buf_free(&buf);
 	return EXIT_SUCCESS;
 }
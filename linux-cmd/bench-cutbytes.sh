@@ -0,0 +1,43 @@
+#!/bin/bash
+# Compares cutbytes with dd and tail -c | head -c when extracting
+# a range from the middle of a file, to a file and to a pipe.
+#
+# usage: bench-cutbytes.sh [file size in MB [range size in MB]]
+
+SIZE_MB=${1:-2048}
+RANGE_MB=${2:-1024}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+head -c ${SIZE_MB}M /dev/urandom > "$DIR/input"
+OFFSET=$(( (SIZE_MB - RANGE_MB) / 2 * 1024 * 1024 + 12345 ))
+COUNT=$(( RANGE_MB * 1024 * 1024 ))
+
+measure() {
+    local name=$1
+    shift
+    local start=$(date +%s.%N)
+    sh -c "$*"
+    local end=$(date +%s.%N)
+    awk -v name="$name" -v mb=$RANGE_MB -v t0=$start -v t1=$end \
+        'BEGIN {t = t1 - t0; printf "%-25s %8.3f s %10.1f MB/s\n", name, t, mb/t}'
+}
+
+IN="$DIR/input"
+OUT="$DIR/output"
+DD="dd if=$IN bs=1M iflag=skip_bytes,count_bytes skip=$OFFSET count=$COUNT status=none"
+TAIL="tail -c +$((OFFSET + 1)) $IN | head -c $COUNT"
+CUT="./cutbytes $IN $OFFSET $COUNT"
+
+echo "$RANGE_MB MB range of $SIZE_MB MB file"
+for target in file pipe; do
+    if [ $target == file ]; then
+        redirect="> $OUT"
+    else
+        redirect="| cat > /dev/null"
+    fi
+
+    measure "dd ($target)"       "$DD $redirect"
+    measure "tail|head ($target)" "$TAIL $redirect"
+    measure "cutbytes ($target)" "$CUT $redirect"
+done
@@ -0,0 +1,33 @@
+#!/bin/bash
+# Compares throughput of ./tee and GNU tee.
+#
+# usage: bench-tee.sh [size in MB [number of output files]]
+
+SIZE_MB=${1:-1024}
+OUTPUTS=${2:-2}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+head -c ${SIZE_MB}M /dev/urandom > "$DIR/input"
+
+outputs=""
+for i in $(seq $OUTPUTS); do
+    outputs="$outputs $DIR/out$i"
+done
+
+measure() {
+    local name=$1
+    shift
+    local start=$(date +%s.%N)
+    "$@"
+    local end=$(date +%s.%N)
+    awk -v name="$name" -v mb=$SIZE_MB -v t0=$start -v t1=$end \
+        'BEGIN {t = t1 - t0; printf "%-30s %8.3f s %10.1f MB/s\n", name, t, mb/t}'
+}
+
+echo "$SIZE_MB MB, $OUTPUTS file(s) + stdout"
+for prog in "$(command -v tee)" ./tee; do
+    measure "$prog (pipe)" sh -c "cat '$DIR/input' | $prog $outputs > /dev/null"
+    measure "$prog (file)" sh -c "$prog $outputs < '$DIR/input' > /dev/null"
+done
+measure "./tee -t (pipe)" sh -c "cat '$DIR/input' | ./tee -t $outputs > /dev/null"
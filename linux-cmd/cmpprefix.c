@@ -13,19 +13,39 @@
 	file.jpg
 	cat.jpg
 
+	When more files are given (or "-" --- names are read from stdin,
+	one per line) files are checked in parallel, option -t sets the
+	number of threads; option -v prints files/s and GB/s.  Matching
+	names are printed in the input order.
+
 	Wojciech Mua, 2009-12-25
 	public domain
 
 */
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "filecmp.h"
+
+struct batch_arg {
+	char**		names;
+	char*		matched;
+	const char*	prefix;
+	int		preflen;
+};
 
 int parse_string(char* input, char* otput);
 void safe_print(char* string, int len);
 void help();
+int match(const char* filename, const char* prefix, int preflen, char* buf);
+size_t match_job(size_t index, void* arg);
+int read_names(char*** names, size_t* count);
 
 int main(int argc, char* argv[]) {
 
@@ -34,24 +54,39 @@ int main(int argc, char* argv[]) {
 	int  len;
 	int  i;
 	int  result;
+	int  verbose = 0;
+	unsigned threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	for (i=1; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+		if (strcmp(argv[i], "-v") == 0)
+			verbose = 1;
+		else
+		if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else
+			break;
+	}
+
+	argc -= i - 1;
+	argv += i - 1;
 
 	if (argc < 3) {
 		help();
 		return EXIT_FAILURE;
 	}
-	
+
 	len = strlen(argv[1]);
 	if (len == 0) {
 		fprintf(stderr, "empty string\n");
 		return EXIT_FAILURE;
 	}
-	
+
 	prefix = malloc(len+1);
 	if (prefix == NULL) {
 		fprintf(stderr, "can't allocate %d byte(s)\n", len+1);
 		return EXIT_FAILURE;
 	}
-	
+
 	/* any escapes? */
 	len = parse_string(argv[1], prefix);
 #ifdef DEBUG
@@ -67,16 +102,54 @@ int main(int argc, char* argv[]) {
 		return EXIT_FAILURE;
 	}
 
-	errno = 0;
-	if (argc == 3) {	// just one file
+	if (argc == 3 && strcmp(argv[2], "-") != 0) {	// just one file
 		result = match(argv[2], prefix, len, buf) ?
 				EXIT_SUCCESS : EXIT_FAILURE;
 	}
-	else // more files
-	for (i=2; i < argc; i++) {
+	else { // more files
+		struct batch_arg arg;
+		size_t count;
+		size_t k;
+
+		if (argc == 3) {
+			if (read_names(&arg.names, &count) < 0) {
+				fprintf(stderr, "can't allocate memory\n");
+				return EXIT_FAILURE;
+			}
+		} else {
+			arg.names = argv + 2;
+			count = argc - 2;
+		}
+
+		/* at least one byte, calloc(0) may return NULL */
+		arg.matched = calloc(count + 1, 1);
+		arg.prefix  = prefix;
+		arg.preflen = len;
+		if (arg.matched == NULL) {
+			fprintf(stderr, "can't allocate memory\n");
+			return EXIT_FAILURE;
+		}
+
+		const double t0 = now();
+		const size_t bytes = batch_run(count, threads, match_job, &arg);
+		const double t1 = now();
+
+		for (k=0; k < count; k++) {
+			if (arg.matched[k])
+				puts(arg.names[k]);
+		}
+
+		if (verbose)
+			print_stats(count, bytes, t1 - t0);
+
+		if (argc == 3) {
+			for (k=0; k < count; k++)
+				free(arg.names[k]);
+			free(arg.names);
+		}
+
+		free(arg.matched);
 		result = EXIT_SUCCESS;
-		if (match(argv[i], prefix, len, buf))
-			puts(argv[i]);
 	}
 
 	free(buf);
@@ -87,10 +160,11 @@ int main(int argc, char* argv[]) {
 /*------------------------------------------------------------------------*/
 
 int match(const char* filename, const char* prefix, int preflen, char* buf) {
-	FILE* input;
-	
-	input = fopen(filename, "rb");
-	if (errno) {
+	int fd;
+	ssize_t readed;
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0) {
 		fprintf(stderr, "Can't open file '%s' (err=%d): %s\n",
 			filename,
 			errno,
@@ -98,28 +172,97 @@ int match(const char* filename, const char* prefix, int preflen, char* buf) {
 		);
 		return 0;
 	}
-	
-	if (fread(buf, 1, preflen, input) != preflen) {
+
+	/* just the first bytes are needed, don't let kernel read ahead */
+	posix_fadvise(fd, 0, preflen, POSIX_FADV_RANDOM);
+	readed = pread(fd, buf, preflen, 0);
+	close(fd);
+
+	if (readed != preflen) {
 		/* file shorter then prefix */
-		fclose(input);
 		return 0;
 	}
-	
-	fclose(input);
-	return (memcmp(prefix, buf, preflen) == 0);
+
+	return (mismatch(prefix, buf, preflen) == (size_t)preflen);
+}
+/*------------------------------------------------------------------------*/
+
+size_t match_job(size_t index, void* ptr) {
+	struct batch_arg* arg = (struct batch_arg*)ptr;
+	char buf[4096];
+	char* tmp = (arg->preflen <= (int)sizeof(buf)) ? buf : malloc(arg->preflen);
+
+	if (tmp == NULL)
+		return 0;
+
+	arg->matched[index] = match(arg->names[index], arg->prefix, arg->preflen, tmp);
+
+	if (tmp != buf)
+		free(tmp);
+
+	return arg->preflen;
+}
+/*------------------------------------------------------------------------*/
+
+/* returns 0 or -1 if memory can't be allocated; an empty list is valid */
+int read_names(char*** result, size_t* count) {
+	char**	names = NULL;
+	size_t	capacity = 0;
+	char*	line = NULL;
+	size_t	line_size = 0;
+	ssize_t	len;
+
+	*count = 0;
+	while ((len = getline(&line, &line_size, stdin)) > 0) {
+		if (line[len - 1] == '\n')
+			line[--len] = '\0';
+
+		if (len == 0)
+			continue;
+
+		if (*count == capacity) {
+			char** tmp;
+
+			capacity = capacity ? 2*capacity : 1024;
+			tmp = realloc(names, capacity * sizeof(char*));
+			if (tmp == NULL)
+				goto error;
+
+			names = tmp;
+		}
+
+		names[*count] = strdup(line);
+		if (names[*count] == NULL)
+			goto error;
+
+		*count += 1;
+	}
+
+	free(line);
+	*result = names;
+	return 0;
+
+error:
+	while (*count > 0)
+		free(names[--*count]);
+
+	free(names);
+	free(line);
+	return -1;
 }
 /*------------------------------------------------------------------------*/
 
 void help() {
-	puts("usage: cmpprefix file string");
+	puts("usage: cmpprefix [-t threads] [-v] string file...");
 	puts("");
 	puts("Program checks if file starts with string.");
 	puts("Nonprintable chars can be passed in format");
-	puts("\\xhh where h is a hex digit.");
+	puts("\\xhh where h is a hex digit.  If file is \"-\"");
+	puts("names are read from stdin.");
 	puts("");
 	puts("Example:");
 	puts("");
-	puts("cmpprefix file \"\\xff\\xd8\\xff\\xe0\\x00\\x10JFIF\" && echo \"JPEG without EXIF\"");
+	puts("cmpprefix \"\\xff\\xd8\\xff\\xe0\\x00\\x10JFIF\" file && echo \"JPEG without EXIF\"");
 }
 /*------------------------------------------------------------------------*/
 
@@ -140,14 +283,14 @@ int hexval(const char c) {
 int parse_string(char* input, char* output) {
 	char* c = input;
 	char* o = output;
-	
+
 	int h1, h2;
-	
+
 	while (*c) {
 		/* parse escape sequence \xhh */
 		if ( c[0] == '\\' &&
 		    (c[1] == 'x' || c[1] == 'X') &&
-		    (h2=hexval(c[2])) != -1 && 
+		    (h2=hexval(c[2])) != -1 &&
 		    (h1=hexval(c[3])) != -1
 		) {
 			*o++ = h2*16 + h1;
@@ -177,4 +320,3 @@ void safe_print(char* c, int n) {
 	}
 }
 /*------------------------------------------------------------------------*/
-
@@ -2,66 +2,205 @@
 	wm/2009-11-13
 	public domain
 
+	usage: cutbytes file offset count [offset count ...]
+	       cutbytes file -l list
+
+	Copies the given byte ranges of file to stdout; the list file
+	("-" is stdin) contains one "offset count" pair per line.
+
+	Data doesn't go through user space if possible; the method is
+	chosen by the type of stdout:
+	* regular file -- copy_file_range,
+	* pipe         -- splice,
+	* other        -- sendfile.
+	If a method is not supported, the next one is tried, finally
+	pread/write with a 1 MB buffer.
 */
+#define _GNU_SOURCE
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
 
 size_t parse_number(char* str, char* name);
 
-#define BUF_SIZE 4096
-char buffer[BUF_SIZE];
+#define BUF_SIZE (1024*1024)
+char* buffer;
+
+enum {COPY_FILE_RANGE, SPLICE, SENDFILE, READ_WRITE};
+
+const char* method_name[] = {"copy_file_range", "splice", "sendfile", "read/write"};
+
+int method;
+
+/*
+	Copies at most count bytes, returns number of bytes
+	copied (0 at EOF) or -1 and errno.
+*/
+ssize_t copy_chunk(int fd, off_t* offset, size_t count) {
+	ssize_t n;
+
+	switch (method) {
+		case COPY_FILE_RANGE:
+			return copy_file_range(fd, offset, STDOUT_FILENO, NULL, count, 0);
+
+		case SPLICE:
+			return splice(fd, offset, STDOUT_FILENO, NULL, count, SPLICE_F_MORE);
+
+		case SENDFILE:
+			return sendfile(STDOUT_FILENO, fd, offset, count);
+
+		default:
+			if (count > BUF_SIZE)
+				count = BUF_SIZE;
+
+			n = pread(fd, buffer, count, *offset);
+			if (n > 0) {
+				ssize_t written = 0;
+				while (written < n) {
+					const ssize_t k = write(STDOUT_FILENO, buffer + written, n - written);
+					if (k < 0) {
+						if (errno == EINTR)
+							continue;
+						return -1;
+					}
+					written += k;
+				}
+				*offset += n;
+			}
+			return n;
+	}
+}
+/*------------------------------------------------------------------------*/
+
+void copy_range(int fd, off_t offset, size_t count) {
+	size_t total = 0;
+
+	while (total < count) {
+		const ssize_t n = copy_chunk(fd, &offset, count - total);
+		if (n == 0)
+			break;	/* EOF */
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+
+			/* method not supported for these files, try the next one */
+			if (total == 0 && method < READ_WRITE &&
+			    (errno == EINVAL || errno == ENOSYS || errno == EXDEV ||
+			     errno == EBADF  || errno == EOPNOTSUPP)) {
+				method += 1;
+				continue;
+			}
+
+			perror("Can't copy data");
+			exit(EXIT_FAILURE);
+		}
+
+		total += n;
+	}
+}
+/*------------------------------------------------------------------------*/
+
+void copy_list(int fd, FILE* list) {
+	char	line[256];
+	char*	p;
+	int	lineno = 0;
+
+	while (fgets(line, sizeof(line), list)) {
+		lineno += 1;
+
+		p = line;
+		while (*p == ' ' || *p == '\t')
+			p++;
+
+		if (*p == '\n' || *p == '#' || *p == '\0')
+			continue;
+
+		char* end;
+		const size_t offset = strtoull(p, &end, 0);
+		if (end == p) {
+			fprintf(stderr, "line %d: invalid offset\n", lineno);
+			exit(EXIT_FAILURE);
+		}
+
+		p = end;
+		const size_t count = strtoull(p, &end, 0);
+		if (end == p) {
+			fprintf(stderr, "line %d: invalid count\n", lineno);
+			exit(EXIT_FAILURE);
+		}
+
+		copy_range(fd, offset, count);
+	}
+}
+/*------------------------------------------------------------------------*/
 
 int main(int argc, char* argv[]) {
-	FILE* file;
-	size_t offset;
-	size_t count;
-	size_t readed;
+	int fd;
+	int i;
+	struct stat st;
 
-	if (argc != 4) {
+	if (argc < 4 || (argc % 2 != 0 && strcmp(argv[2], "-l") != 0)) {
 		puts("Copy from given file to stdout count bytes starting at offset");
-		printf("usage: %s file offset count\n", argv[0]);
+		printf("usage: %s file offset count [offset count ...]\n", argv[0]);
+		printf("       %s file -l list\n", argv[0]);
 		exit(EXIT_FAILURE);
 	}
 
-	offset	= parse_number(argv[2], "offset");
-	count	= parse_number(argv[3], "count");
-
 	/* try open file */
-	errno	= 0;
-	file	= fopen(argv[1], "rb");
-	if (errno)
+	fd = open(argv[1], O_RDONLY);
+	if (fd < 0) {
 		perror("Can't open file");
+		exit(EXIT_FAILURE);
+	}
+
+	if (posix_memalign((void**)&buffer, 4096, BUF_SIZE) != 0) {
+		fprintf(stderr, "Can't allocate %d bytes\n", BUF_SIZE);
+		exit(EXIT_FAILURE);
+	}
 
-	/* seek to offset */
-	fseek(file, offset, SEEK_SET);
-	if (errno)
-		perror("Can't seek to given position");
-
-	/* copy to stdout count bytes */
-	while (1) {
-		if (count > BUF_SIZE)
-			readed = fread(buffer, 1, BUF_SIZE, file);
-		else
-			readed = fread(buffer, 1, count, file);
-
-		if (readed == 0)
-			break;
-	
-		if (errno)
-			perror("Can't read from file");
-
-		fwrite(buffer, 1, readed, stdout);
-		if (errno)
-			perror("Can't write to stdout");
-
-		count -= readed;
+	/* choose method by the output type */
+	if (fstat(STDOUT_FILENO, &st) < 0) {
+		perror("Can't stat stdout");
+		exit(EXIT_FAILURE);
 	}
 
-	fclose(file);
-	if (errno)
-		perror("Can't close file");
+	if (S_ISREG(st.st_mode))
+		method = COPY_FILE_RANGE;
+	else
+	if (S_ISFIFO(st.st_mode))
+		method = SPLICE;
+	else
+		method = SENDFILE;
+
+	if (strcmp(argv[2], "-l") == 0) {
+		FILE* list = (strcmp(argv[3], "-") == 0) ? stdin : fopen(argv[3], "r");
+		if (list == NULL) {
+			perror("Can't open list");
+			exit(EXIT_FAILURE);
+		}
+
+		copy_list(fd, list);
+		if (list != stdin)
+			fclose(list);
+	}
+	else
+	for (i=2; i + 1 < argc; i += 2) {
+		const off_t  offset = parse_number(argv[i], "offset");
+		const size_t count  = parse_number(argv[i + 1], "count");
+		copy_range(fd, offset, count);
+	}
+
+	if (getenv("CUTBYTES_VERBOSE"))
+		fprintf(stderr, "method: %s\n", method_name[method]);
 
+	close(fd);
+	free(buffer);
 	exit(EXIT_SUCCESS);
 }
 /*------------------------------------------------------------------------*/
@@ -71,9 +210,11 @@ size_t parse_number(char* str, char* name) {
 	char* err;
 
 	errno	= 0;
-	result	= strtoul(str, &err, 0);
-	if (errno)
+	result	= strtoull(str, &err, 0);
+	if (errno) {
 		perror(name);
+		exit(EXIT_FAILURE);
+	}
 	else
 	if (*err != '\0') {
 		fprintf(stderr, "%s: invalid number\n", name);
@@ -83,4 +224,3 @@ size_t parse_number(char* str, char* name) {
 	return result;
 }
 /*------------------------------------------------------------------------*/
-
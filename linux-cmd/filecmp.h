@@ -0,0 +1,131 @@
+/*
+	Helpers shared by prefixeq and cmpprefix
+
+	* mismatch   --- memcmp that returns the first differing offset,
+	                 AVX2 when compiled with -mavx2, SSE2 otherwise;
+	* batch_run  --- runs a job for items 0..count-1 in threads,
+	                 items are taken from a shared counter;
+	* now        --- wall clock in seconds.
+
+	public domain
+*/
+#ifndef FILECMP_H_included__
+#define FILECMP_H_included__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <immintrin.h>
+
+static size_t mismatch(const void* a, const void* b, size_t n) {
+	const uint8_t* p = (const uint8_t*)a;
+	const uint8_t* q = (const uint8_t*)b;
+	size_t i = 0;
+
+#ifdef __AVX2__
+	for (/**/; i + 64 <= n; i += 64) {
+		const __m256i e0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i)),
+		                                     _mm256_loadu_si256((const __m256i*)(q + i)));
+		const __m256i e1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i + 32)),
+		                                     _mm256_loadu_si256((const __m256i*)(q + i + 32)));
+		if (_mm256_movemask_epi8(_mm256_and_si256(e0, e1)) != -1) {
+			const uint64_t lo = (uint32_t)_mm256_movemask_epi8(e0);
+			const uint64_t hi = (uint32_t)_mm256_movemask_epi8(e1);
+			return i + __builtin_ctzll(~(lo | (hi << 32)));
+		}
+	}
+#endif
+	for (/**/; i + 16 <= n; i += 16) {
+		const __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i)),
+		                                  _mm_loadu_si128((const __m128i*)(q + i)));
+		const unsigned mask = _mm_movemask_epi8(eq);
+		if (mask != 0xffff)
+			return i + __builtin_ctz(~mask);
+	}
+
+	for (/**/; i < n; i++) {
+		if (p[i] != q[i])
+			return i;
+	}
+
+	return n;
+}
+/*------------------------------------------------------------------------*/
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+/*------------------------------------------------------------------------*/
+
+/* job returns the number of bytes it has read */
+typedef size_t (*batch_job)(size_t index, void* arg);
+
+struct batch_t {
+	batch_job	job;
+	void*		arg;
+	size_t		count;
+	size_t		next;
+	size_t		bytes;
+};
+
+static void* batch_thread(void* ptr) {
+	struct batch_t* batch = (struct batch_t*)ptr;
+	size_t bytes = 0;
+	size_t i;
+
+	while ((i = __atomic_fetch_add(&batch->next, 1, __ATOMIC_RELAXED)) < batch->count)
+		bytes += batch->job(i, batch->arg);
+
+	__atomic_fetch_add(&batch->bytes, bytes, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+/* returns the total number of bytes read by jobs */
+static size_t batch_run(size_t count, unsigned threads, batch_job job, void* arg) {
+	struct batch_t batch;
+	pthread_t* id;
+	unsigned i;
+
+	batch.job   = job;
+	batch.arg   = arg;
+	batch.count = count;
+	batch.next  = 0;
+	batch.bytes = 0;
+
+	id = (threads > 1) ? malloc(threads * sizeof(pthread_t)) : NULL;
+	if (id == NULL) {
+		batch_thread(&batch);
+		return batch.bytes;
+	}
+
+	for (i=0; i < threads; i++) {
+		if (pthread_create(&id[i], NULL, batch_thread, &batch) != 0)
+			break;
+	}
+
+	if (i == 0)
+		batch_thread(&batch);
+
+	while (i > 0)
+		pthread_join(id[--i], NULL);
+
+	free(id);
+	return batch.bytes;
+}
+/*------------------------------------------------------------------------*/
+
+static void print_stats(size_t files, size_t bytes, double time) {
+	if (time <= 0.0)
+		time = 1e-9;
+
+	fprintf(stderr, "%zu file(s), %.3f s, %.0f files/s, %.3f GB/s\n",
+		files, time, files / time, bytes / time / 1e9);
+}
+/*------------------------------------------------------------------------*/
+
+#endif
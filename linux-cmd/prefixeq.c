@@ -1,6 +1,6 @@
 /*
 	Program check if two file has common prefix.
-	
+
 	prefixeq file1 file2 size
 
 	is equivalent to
@@ -9,46 +9,99 @@
 	head -b size file2 > /tmp/2
 	cmp /tmp/1 /tmp/2
 
+	When prefixes differ the first differing offset is printed.
+
+	Batch mode:
+
+	prefixeq [-t threads] [-v] -b size < list
+
+	reads pairs of file names separated by a tab, one pair per line,
+	compares them in parallel and prints pairs with equal prefixes.
+	Option -v prints files/s and GB/s.
+
+	Regular files are mapped into memory (others are read) and
+	compared with SSE2/AVX2.
+
 
 	Wojciech Mua, 2009-12-25
 	public domain
 */
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-#define BUF_SIZE 1024
+#include "filecmp.h"
+
+#define BUF_SIZE (1024*1024)
+
+enum {EQUAL, DIFFERENT, ERROR};
+
+struct pair_t {
+	char*	file1;
+	char*	file2;
+	int	result;
+};
+
+struct batch_arg {
+	struct pair_t*	pairs;
+	size_t		size;
+};
+
+int compare(const char* name1, const char* name2, size_t size, size_t* offset);
+size_t compare_job(size_t index, void* arg);
+int batch(size_t size, unsigned threads, int verbose);
 
 int main(int argc, char* argv[]) {
-	FILE* file1;
-	FILE* file2;
-	char  buf1[BUF_SIZE];
-	char  buf2[BUF_SIZE];
-	int   size;
-	int   read;
-	size_t readed1;
-	size_t readed2;
-	char* err;
-	int   result;
-
-	if (argc < 4) {
-		puts("usage: cmpprefix file2 file1 size");
+	size_t	size;
+	size_t	offset;
+	char*	err;
+	int	result;
+	int	i;
+	int	batch_mode = 0;
+	int	verbose = 0;
+	unsigned threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	for (i=1; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+		if (strcmp(argv[i], "-b") == 0)
+			batch_mode = 1;
+		else
+		if (strcmp(argv[i], "-v") == 0)
+			verbose = 1;
+		else
+		if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else
+			break;
+	}
+
+	argc -= i - 1;
+	argv += i - 1;
+
+	if (batch_mode ? (argc != 2) : (argc < 4)) {
+		puts("usage: prefixeq file1 file2 size");
+		puts("       prefixeq [-t threads] [-v] -b size < list");
 		return EXIT_FAILURE;
 	}
-	
-	size = strtol(argv[3], &err, 0);
+
+	const char* arg = batch_mode ? argv[1] : argv[3];
+	size = strtoull(arg, &err, 0);
 	if (*err != '\0') {
 		fprintf(stderr,
 			"invalid digit '%c' at position %d\n",
 			*err,
-			err - &argv[3][0]
+			(int)(err - arg)
 		);
 		return EXIT_FAILURE;
 	}
 	else
-	if (size < 0) {
+	if (arg[0] == '-') {
 		fprintf(stderr, "size less then zero\n");
 		return EXIT_FAILURE;
 	}
@@ -58,71 +111,240 @@ int main(int argc, char* argv[]) {
 		return EXIT_FAILURE;
 	}
 
-	errno = 0;
-	file1 = fopen(argv[1], "rb");
-	if (errno) {
-		fprintf(stderr, "Can't open file 1 '%s' (err=%d): %s\n",
-			argv[1],
-			errno,
-			strerror(errno)
-		);
-		return EXIT_FAILURE;
-	}
+	if (batch_mode)
+		return batch(size, threads, verbose);
+
+	result = compare(argv[1], argv[2], size, &offset);
+	if (result == DIFFERENT)
+		printf("%s %s differ at offset %zu\n", argv[1], argv[2], offset);
+
+	return (result == EQUAL) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*------------------------------------------------------------------------*/
+
+static int open_file(const char* name, size_t size, struct stat* st) {
+	int fd;
 
-	file2 = fopen(argv[2], "rb");
-	if (errno) {
-		fprintf(stderr, "Can't open file 1 '%s' (err=%d): %s\n",
-			argv[1],
+	fd = open(name, O_RDONLY);
+	if (fd < 0 || fstat(fd, st) < 0) {
+		fprintf(stderr, "Can't open file '%s' (err=%d): %s\n",
+			name,
 			errno,
 			strerror(errno)
 		);
-		fclose(file1);
-		return EXIT_FAILURE;
+		if (fd >= 0)
+			close(fd);
+		return -1;
 	}
-	
-	result = EXIT_SUCCESS;
-	while (size > 0) {
-		read = (size < BUF_SIZE) ? size : BUF_SIZE;
-		readed1 = fread(buf1, 1, read, file1);
-		if (errno) {
-			fprintf(stderr, "Can't read from file 1 '%s' (err=%d): %s\n",
-				argv[1],
-				errno,
-				strerror(errno)
-			);
-			result = EXIT_FAILURE;
-			goto cleanup;
-		}
 
-		readed2 = fread(buf2, 1, read, file2);
-		if (errno) {
-			fprintf(stderr, "Can't read from file 2 '%s' (err=%d): %s\n",
-				argv[2],
-				errno,
-				strerror(errno)
-			);
-			result = EXIT_FAILURE;
-			goto cleanup;
+	posix_fadvise(fd, 0, size, POSIX_FADV_SEQUENTIAL);
+	posix_fadvise(fd, 0, size, POSIX_FADV_WILLNEED);
+	return fd;
+}
+/*------------------------------------------------------------------------*/
+
+/* reads until size bytes or EOF, works also for pipes */
+static ssize_t read_all(int fd, char* buf, size_t size) {
+	size_t total = 0;
+	while (total < size) {
+		const ssize_t n = read(fd, buf + total, size - total);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
 		}
+		if (n == 0)
+			break;
 
-		if (readed1 != read || readed2 != read) {
-			/* different sizes */
-			result = EXIT_FAILURE;
-			goto cleanup;
+		total += n;
+	}
+
+	return total;
+}
+/*------------------------------------------------------------------------*/
+
+static int compare_read(int fd1, int fd2, size_t size, size_t* offset) {
+	char*	buf1;
+	char*	buf2;
+	size_t	pos = 0;
+	int	result = EQUAL;
+
+	buf1 = malloc(BUF_SIZE);
+	buf2 = malloc(BUF_SIZE);
+	if (buf1 == NULL || buf2 == NULL) {
+		free(buf1);
+		free(buf2);
+		return ERROR;
+	}
+
+	while (pos < size) {
+		const size_t chunk = (size - pos < BUF_SIZE) ? size - pos : BUF_SIZE;
+		const ssize_t readed1 = read_all(fd1, buf1, chunk);
+		const ssize_t readed2 = read_all(fd2, buf2, chunk);
+		if (readed1 < 0 || readed2 < 0) {
+			fprintf(stderr, "Can't read (err=%d): %s\n", errno, strerror(errno));
+			result = ERROR;
+			break;
 		}
-		else
-		if (memcmp(buf1, buf2, read) != 0) {
-			result = EXIT_FAILURE;
-			goto cleanup;
+
+		const size_t n = (readed1 < readed2) ? readed1 : readed2;
+		const size_t diff = mismatch(buf1, buf2, n);
+		if (diff < n || (size_t)readed1 != chunk || (size_t)readed2 != chunk) {
+			*offset = pos + diff;
+			result = DIFFERENT;
+			break;
 		}
-		else
-			size -= read;
-	} 
+
+		pos += chunk;
+	}
+
+	free(buf1);
+	free(buf2);
+	return result;
+}
+/*------------------------------------------------------------------------*/
+
+int compare(const char* name1, const char* name2, size_t size, size_t* offset) {
+	struct stat st1, st2;
+	int	fd1, fd2;
+	size_t	common;
+	int	result;
+
+	fd1 = open_file(name1, size, &st1);
+	if (fd1 < 0)
+		return ERROR;
+
+	fd2 = open_file(name2, size, &st2);
+	if (fd2 < 0) {
+		close(fd1);
+		return ERROR;
+	}
+
+	if (!S_ISREG(st1.st_mode) || !S_ISREG(st2.st_mode)) {
+		result = compare_read(fd1, fd2, size, offset);
+		goto cleanup;
+	}
+
+	/* a file shorter than size never matches */
+	common = size;
+	if ((size_t)st1.st_size < common) common = st1.st_size;
+	if ((size_t)st2.st_size < common) common = st2.st_size;
+
+	if (common == 0) {
+		*offset = 0;
+		result = DIFFERENT;
+		goto cleanup;
+	}
+
+	void* map1 = mmap(NULL, common, PROT_READ, MAP_SHARED, fd1, 0);
+	void* map2 = mmap(NULL, common, PROT_READ, MAP_SHARED, fd2, 0);
+	if (map1 == MAP_FAILED || map2 == MAP_FAILED) {
+		if (map1 != MAP_FAILED) munmap(map1, common);
+		if (map2 != MAP_FAILED) munmap(map2, common);
+		result = compare_read(fd1, fd2, size, offset);
+		goto cleanup;
+	}
+
+	madvise(map1, common, MADV_SEQUENTIAL);
+	madvise(map2, common, MADV_SEQUENTIAL);
+
+	*offset = mismatch(map1, map2, common);
+	result = (*offset == size) ? EQUAL : DIFFERENT;
+
+	munmap(map1, common);
+	munmap(map2, common);
 
 cleanup:
-	fclose(file1);
-	fclose(file2);
+	close(fd1);
+	close(fd2);
 	return result;
 }
 /*------------------------------------------------------------------------*/
 
+size_t compare_job(size_t index, void* ptr) {
+	struct batch_arg* arg = (struct batch_arg*)ptr;
+	struct pair_t* pair = &arg->pairs[index];
+	size_t offset = 0;
+
+	pair->result = compare(pair->file1, pair->file2, arg->size, &offset);
+
+	/* both files were read up to the first difference */
+	return 2 * ((pair->result == EQUAL) ? arg->size : offset);
+}
+/*------------------------------------------------------------------------*/
+
+static void free_pairs(struct pair_t* pairs, size_t count) {
+	size_t i;
+	for (i=0; i < count; i++) {
+		free(pairs[i].file1);
+		free(pairs[i].file2);
+	}
+
+	free(pairs);
+}
+/*------------------------------------------------------------------------*/
+
+int batch(size_t size, unsigned threads, int verbose) {
+	struct batch_arg arg;
+	size_t	count = 0;
+	size_t	capacity = 0;
+	size_t	i;
+	char*	line = NULL;
+	size_t	line_size = 0;
+	ssize_t	len;
+
+	arg.pairs = NULL;
+	arg.size  = size;
+
+	while ((len = getline(&line, &line_size, stdin)) > 0) {
+		if (line[len - 1] == '\n')
+			line[len - 1] = '\0';
+
+		char* tab = strchr(line, '\t');
+		if (tab == NULL) {
+			fprintf(stderr, "expected 'file1<TAB>file2', got '%s'\n", line);
+			continue;
+		}
+		*tab = '\0';
+
+		if (count == capacity) {
+			const size_t new_capacity = capacity ? 2*capacity : 1024;
+			struct pair_t* pairs = realloc(arg.pairs, new_capacity * sizeof(struct pair_t));
+			if (pairs == NULL) {
+				fprintf(stderr, "can't allocate memory\n");
+				free_pairs(arg.pairs, count);
+				free(line);
+				return EXIT_FAILURE;
+			}
+
+			arg.pairs = pairs;
+			capacity  = new_capacity;
+		}
+
+		arg.pairs[count].file1 = strdup(line);
+		arg.pairs[count].file2 = strdup(tab + 1);
+		count += 1;
+		if (arg.pairs[count - 1].file1 == NULL || arg.pairs[count - 1].file2 == NULL) {
+			fprintf(stderr, "can't allocate memory\n");
+			free_pairs(arg.pairs, count);
+			free(line);
+			return EXIT_FAILURE;
+		}
+	}
+	free(line);
+
+	const double t0 = now();
+	const size_t bytes = batch_run(count, threads, compare_job, &arg);
+	const double t1 = now();
+
+	for (i=0; i < count; i++)
+		if (arg.pairs[i].result == EQUAL)
+			printf("%s\t%s\n", arg.pairs[i].file1, arg.pairs[i].file2);
+
+	if (verbose)
+		print_stats(2*count, bytes, t1 - t0);
+
+	free_pairs(arg.pairs, count);
+	return EXIT_SUCCESS;
+}
+/*------------------------------------------------------------------------*/
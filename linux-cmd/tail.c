@@ -1,66 +1,268 @@
-/* 
+/*
  * Wojciech Mua
  *
  * $Id: tail.c,v 1.1.1.1 2006-04-03 18:20:33 wojtek Exp $
+ *
+ * usage: tail [-f] n file
+ *
+ * A regular file is mapped into memory and scanned backwards for
+ * newlines with SSE2/AVX2, thus the cost depends on the size of output,
+ * not of the file.  Other files (pipes, devices) are read forward.
+ *
+ * With -f program then waits for new data using inotify.
  */
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <immintrin.h>
 
-int main(int argc, char* argv[]) {
-#define SIZE (1024*8)
-	static char buffer[SIZE];
+#define SIZE (1024*64)
+static char buffer[SIZE];
+
+static int write_all(const char* data, size_t size) {
+	while (size > 0) {
+		const ssize_t n = write(STDOUT_FILENO, data, size);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+
+		data += n;
+		size -= n;
+	}
+
+	return 0;
+}
+
+/*
+ * Returns pointer to the k-th newline (k >= 1) counting from the end
+ * of [start, end), or NULL if there are fewer newlines.
+ */
+static const char* find_newline_backward(const char* start, const char* end, size_t k) {
+	const char* p = end;
+
+#ifdef __AVX2__
+	const __m256i nl = _mm256_set1_epi8('\n');
+	while (p - start >= 32) {
+		p -= 32;
+		uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), nl));
+		const size_t count = __builtin_popcount(mask);
+		if (count < k) {
+			k -= count;
+			continue;
+		}
+
+		// clear k-1 highest bits
+		while (--k)
+			mask &= ~(UINT32_C(0x80000000) >> __builtin_clz(mask));
+
+		return p + 31 - __builtin_clz(mask);
+	}
+#else
+	const __m128i nl = _mm_set1_epi8('\n');
+	while (p - start >= 16) {
+		p -= 16;
+		uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), nl));
+		const size_t count = __builtin_popcount(mask);
+		if (count < k) {
+			k -= count;
+			continue;
+		}
+
+		while (--k)
+			mask &= ~(UINT32_C(0x80000000) >> __builtin_clz(mask));
+
+		return p + 31 - __builtin_clz(mask);
+	}
+#endif
+
+	while (p > start) {
+		if (*--p == '\n' && --k == 0)
+			return p;
+	}
+
+	return NULL;
+}
+
+/* prints last n lines of a regular file, returns offset of the file end */
+static off_t tail_mmap(int fd, size_t size, size_t n) {
+	const char* data;
+	const char* nl;
+	const char* end;
+
+	if (size == 0)
+		return 0;
+
+	data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED)
+		return -1;
+
+	madvise((void*)data, size, MADV_RANDOM);
+
+	// like the original forward scan: print everything
+	// after the (n+1)-th newline from the end
+	end = data + size;
+	nl  = find_newline_backward(data, end, n + 1);
+	if (nl != NULL)
+		write_all(nl + 1, end - nl - 1);
+	else
+		write_all(data, size);
+
+	munmap((void*)data, size);
+	return size;
+}
+
+/* prints last n lines of a stream, returns the number of bytes read */
+static off_t tail_stream(FILE* f, size_t n) {
 	size_t	readed;
-	size_t	off = 0;
-	
-	int	n = 0;
-	int	k = 0;
-	int	i = 0;
-	long	*offsets;
+	off_t	off = 0;
+	size_t	k = 0;
+	size_t	i = 0;
+	off_t	*offsets;
 	char	*p;
-	FILE	*f;
-	
-	if (argc != 3)
-		return 1;
 
-	n = strtol(argv[1], &p, 10);
-	if ((*p != '\0') || (n < 0))
-		return 2;
 	n++;
-
-	offsets = (long*)malloc(n*sizeof(long));
+	offsets = (off_t*)malloc(n*sizeof(off_t));
 	if (offsets == NULL)
-		return 3;
-	
-	f = fopen(argv[2], "r");
-	if (!f) {
+		return -1;
+
+	// the stream can't be rewound, remember the tail in a temporary file
+	FILE* tmp = tmpfile();
+	if (tmp == NULL) {
 		free(offsets);
-		return 4;
+		return -1;
 	}
 
 	while ((readed = fread(buffer, sizeof(char), SIZE, f))) {
-	p = buffer;
-	while (readed--) {
-		if (*p++ == '\n') {
-			offsets[i] = off+1;
-			i = (i+1) % n;
-			if (k < n) k++;
+		fwrite(buffer, sizeof(char), readed, tmp);
+		p = buffer;
+		while (readed--) {
+			if (*p++ == '\n') {
+				offsets[i] = off+1;
+				i = (i+1) % n;
+				if (k < n) k++;
+			}
+			off++;
 		}
-		off++;
 	}
+
+	if (k < n)
+		rewind(tmp);
+	else
+		fseeko(tmp, offsets[i], SEEK_SET);
+
+	fflush(stdout);
+	while ((readed = fread(buffer, sizeof(char), SIZE, tmp)))
+		write_all(buffer, readed);
+
+	free(offsets);
+	fclose(tmp);
+
+	return off;
+}
+
+/* prints data appended to the file, waits for events from inotify */
+static int follow(int fd, const char* path, off_t offset) {
+	char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	struct stat st;
+	int in;
+
+	in = inotify_init1(IN_CLOEXEC);
+	if (in < 0 || inotify_add_watch(in, path, IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF) < 0) {
+		perror("inotify");
+		return 5;
 	}
 
+	while (1) {
+		ssize_t readed;
 
-	if (k < n)
-		rewind(f);
-	else {
-		fseek(f, offsets[i], SEEK_SET);
+		if (fstat(fd, &st) < 0)
+			return 4;
+
+		if (st.st_size < offset) {
+			fprintf(stderr, "tail: %s: file truncated\n", path);
+			offset = 0;
+		}
+
+		while ((readed = pread(fd, buffer, SIZE, offset)) > 0) {
+			if (write_all(buffer, readed) < 0)
+				return 0;
+			offset += readed;
+		}
+
+		// removed (IN_DELETE_SELF doesn't come while the file is open)
+		if (st.st_nlink == 0)
+			return 0;
+
+		// wait for any change; all events are handled the same way
+		readed = read(in, events, sizeof(events));
+		if (readed < 0 && errno != EINTR)
+			return 5;
+
+		if (readed > 0) {
+			const struct inotify_event* ev = (const struct inotify_event*)events;
+			if (ev->mask & (IN_DELETE_SELF | IN_IGNORED))
+				return 0;
+		}
 	}
+}
 
-	while ((readed = fread(buffer, sizeof(char), SIZE, f)))
-		fwrite(buffer, sizeof(char), readed, stdout);
-	
-	free(offsets);
-	fclose(f);
+int main(int argc, char* argv[]) {
+	int	follow_mode = 0;
+	long	n;
+	char	*p;
+	int	fd;
+	off_t	offset;
+	struct stat st;
+
+	if (argc == 4 && strcmp(argv[1], "-f") == 0) {
+		follow_mode = 1;
+		argv++;
+		argc--;
+	}
+
+	if (argc != 3)
+		return 1;
+
+	n = strtol(argv[1], &p, 10);
+	if ((*p != '\0') || (n < 0))
+		return 2;
+
+	fd = open(argv[2], O_RDONLY);
+	if (fd < 0)
+		return 4;
+
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return 4;
+	}
+
+	offset = -1;
+	if (S_ISREG(st.st_mode))
+		offset = tail_mmap(fd, st.st_size, n);
+
+	if (offset < 0) {
+		FILE* f = fdopen(fd, "r");
+		if (f == NULL)
+			return 4;
+
+		offset = tail_stream(f, n);
+		fclose(f);
+		return (offset < 0) ? 3 : 0;
+	}
+
+	if (follow_mode)
+		return follow(fd, argv[2], offset);
 
+	close(fd);
 	return 0;
 }
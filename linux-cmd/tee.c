@@ -1,119 +1,721 @@
-/*
-	tee implementation
-
-	Author: Wojciech Mua
-	e-mail: wojciech_mula@poczta.onet.pl
-	www:    http://0x80.pl/
-
-	License: public domain
-
-	$Id$
-*/
-#include <stdlib.h>
-#include <stdio.h>
-#include <errno.h>
-#include <string.h>
-
-#ifndef __cplusplus
-	typedef char bool;
-#	define true  1
-#	define false 0
-#endif
-
-struct file_t {
-	FILE*	file;
-	bool	exit_on_failure;
-	char*	name;
-};
-
-#define BUF_SIZE 4096
-char buffer[BUF_SIZE];
-
-void tee(struct file_t* input, struct file_t* files, int count);
-
-int main(int argc, char* argv[]) {
-	struct file_t	input;
-	struct file_t*	files;
-	size_t  requested_size;
-	int	i, count;
-	bool	exit_on_failure = false;
-
-	requested_size = sizeof(struct file_t) * argc;
-	files = malloc(requested_size);
-	if (files == NULL) {
-		fprintf(stderr, "Can't allocate %u byte(s)\n", requested_size);
-		exit(EXIT_FAILURE);
-	}
-
-	input.file = stdin;
-	input.name = "<stdin>";
-	input.exit_on_failure = false;
-
-	count = 1;
-	files[0].file = stdout;
-	files[0].name = "<stdout>";
-	files[0].exit_on_failure = true;
-
-	for (i=1; i < argc; i++) {
-		if (strcmp(argv[i], "-i") == 0)
-			exit_on_failure = false;
-		else
-		if (strcmp(argv[i], "-e") == 0)
-			exit_on_failure = true;
-		else {
-			errno = 0;
-			files[count].file = fopen(argv[i], "wb");
-			files[count].name = argv[i];
-			files[count].exit_on_failure = exit_on_failure;
-			if (errno) {
-				fprintf(stderr, "Can't open file %s: %s\n", argv[i], strerror(errno));
-				if (exit_on_failure)
-					exit(EXIT_FAILURE);
-			}
-			else
-				count += 1;
-		}
-	} // for
-
-	// do the job
-	tee(&input, files, count);
-
-	// clean up
-	for (i=1; i < count; i++)
-		fclose(files[i].file);
-
-	free(files);
-
-	return EXIT_SUCCESS;
-
-}
-//---------------------------------------------------------------------------
-
-void tee(struct file_t* input, struct file_t* files, int count) {
-	int i;
-	size_t readed;
-	while (1) {
-		errno = 0;
-		readed = fread(buffer, 1, BUF_SIZE, input->file);
-		if (readed == 0)
-			break;
-		if (errno) {
-			fprintf(stderr, "can't read from %s: %s\n", input->name, strerror(errno));
-			if (input->exit_on_failure)
-				exit(EXIT_FAILURE);
-
-			continue;
-		}
-
-		for (i=0; i < count; i++) {
-			errno = 0;
-			fwrite(buffer, 1, readed, files[i].file);
-			if (errno) {
-				fprintf(stderr, "can't write to %s: %s\n", files[i].name, strerror(errno));
-				if (files[i].exit_on_failure)
-					exit(EXIT_FAILURE);
-			}
-		}
-	}
-}
-//---------------------------------------------------------------------------
+/*
+	tee implementation
+
+	Author: Wojciech Mua
+	e-mail: wojciech_mula@poczta.onet.pl
+	www:    http://0x80.pl/
+
+	License: public domain
+
+	$Id$
+
+	When the standard input is a pipe data never goes through user
+	space: tee(2) duplicates the contents of the input pipe into
+	an intermediate pipe per each output and splice(2) moves data from
+	intermediate pipes to outputs.  Otherwise data is copied with
+	read/write through a large, page-aligned buffer.
+
+	Option -t selects the asynchronous mode: input is read into a ring
+	of reference-counted blocks and each output is written by its own
+	thread, so a slow output doesn't stall the others.  Option -p sets
+	the policy for subsequent files, option -o the policy for the
+	standard output, when an output falls a whole ring behind:
+	* block --- wait for the output (default),
+	* drop  --- skip the oldest block for this output,
+	* spill --- save the oldest block in a temporary file; the output
+	            writes it later, before blocks from the ring.
+	Option -s prints per-output statistics on exit.  (-a is not used,
+	as it means "append" in the standard tee.)
+*/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <time.h>
+
+#ifndef __cplusplus
+	typedef char bool;
+#	define true  1
+#	define false 0
+#endif
+
+struct file_t {
+	int	fd;
+	bool	exit_on_failure;
+	bool	failed;
+	char*	name;
+	int	pipe[2];	// intermediate pipe (splice path)
+	bool	use_splice;	// false if output doesn't support splice
+	int	policy;		// async mode only
+};
+
+enum {POLICY_BLOCK, POLICY_DROP, POLICY_SPILL};
+
+#define BUF_SIZE  (1024*1024)
+#define PIPE_SIZE (1024*1024)
+char* buffer;
+
+void run_tee(struct file_t* input, struct file_t* files, int count);
+bool tee_splice(struct file_t* input, struct file_t* files, int count);
+void tee_buffered(struct file_t* input, struct file_t* files, int count);
+void tee_async(struct file_t* input, struct file_t* files, int count, bool print_stats);
+
+static int parse_policy(const char* name) {
+	if (strcmp(name, "block") == 0)
+		return POLICY_BLOCK;
+	if (strcmp(name, "drop") == 0)
+		return POLICY_DROP;
+	if (strcmp(name, "spill") == 0)
+		return POLICY_SPILL;
+
+	fprintf(stderr, "Unknown policy %s (block, drop or spill)\n", name);
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char* argv[]) {
+	struct file_t	input;
+	struct file_t*	files;
+	size_t  requested_size;
+	int	i, count;
+	bool	exit_on_failure = false;
+	bool	async = false;
+	bool	print_stats = false;
+	int	policy = POLICY_BLOCK;
+
+	requested_size = sizeof(struct file_t) * argc;
+	files = malloc(requested_size);
+	if (files == NULL) {
+		fprintf(stderr, "Can't allocate %zu byte(s)\n", requested_size);
+		exit(EXIT_FAILURE);
+	}
+
+	memset(&input, 0, sizeof(input));
+	input.fd = STDIN_FILENO;
+	input.name = "<stdin>";
+	input.exit_on_failure = false;
+
+	count = 1;
+	memset(files, 0, requested_size);
+	files[0].fd = STDOUT_FILENO;
+	files[0].name = "<stdout>";
+	files[0].exit_on_failure = true;
+
+	for (i=1; i < argc; i++) {
+		if (strcmp(argv[i], "-i") == 0)
+			exit_on_failure = false;
+		else
+		if (strcmp(argv[i], "-e") == 0)
+			exit_on_failure = true;
+		else
+		if (strcmp(argv[i], "-t") == 0)
+			async = true;
+		else
+		if (strcmp(argv[i], "-s") == 0)
+			print_stats = true;
+		else
+		if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+			policy = parse_policy(argv[++i]);
+		else
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			files[0].policy = parse_policy(argv[++i]);
+		else {
+			files[count].fd = open(argv[i], O_WRONLY | O_CREAT | O_TRUNC, 0666);
+			files[count].name = argv[i];
+			files[count].exit_on_failure = exit_on_failure;
+			files[count].policy = policy;
+			if (files[count].fd < 0) {
+				fprintf(stderr, "Can't open file %s: %s\n", argv[i], strerror(errno));
+				if (exit_on_failure)
+					exit(EXIT_FAILURE);
+			}
+			else
+				count += 1;
+		}
+	} // for
+
+	// do the job
+	if (async)
+		tee_async(&input, files, count, print_stats);
+	else
+		run_tee(&input, files, count);
+
+	// clean up
+	for (i=1; i < count; i++)
+		close(files[i].fd);
+
+	free(files);
+
+	return EXIT_SUCCESS;
+
+}
+//---------------------------------------------------------------------------
+
+static void write_failed(struct file_t* file, int error) {
+	fprintf(stderr, "can't write to %s: %s\n", file->name, strerror(error));
+	if (file->exit_on_failure)
+		exit(EXIT_FAILURE);
+
+	file->failed = true;
+}
+//---------------------------------------------------------------------------
+
+static void read_failed(struct file_t* input, int error) {
+	fprintf(stderr, "can't read from %s: %s\n", input->name, strerror(error));
+	if (input->exit_on_failure)
+		exit(EXIT_FAILURE);
+}
+//---------------------------------------------------------------------------
+
+void run_tee(struct file_t* input, struct file_t* files, int count) {
+	struct stat st;
+
+	if (posix_memalign((void**)&buffer, 4096, BUF_SIZE) != 0) {
+		fprintf(stderr, "Can't allocate %d byte(s)\n", BUF_SIZE);
+		exit(EXIT_FAILURE);
+	}
+
+	if (fstat(input->fd, &st) == 0 && S_ISFIFO(st.st_mode)) {
+		if (tee_splice(input, files, count))
+			return;
+	}
+
+	tee_buffered(input, files, count);
+}
+//---------------------------------------------------------------------------
+
+// writes whole data, returns 0 or errno
+static int write_all(int fd, const char* data, size_t size) {
+	while (size > 0) {
+		const ssize_t n = write(fd, data, size);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+
+			return errno;
+		}
+
+		data += n;
+		size -= n;
+	}
+
+	return 0;
+}
+//---------------------------------------------------------------------------
+
+// moves size bytes from the intermediate pipe to the output, returns 0 or
+// errno; on failure *size is the number of bytes left in the pipe
+static int drain_pipe(struct file_t* file, size_t* size) {
+	while (*size > 0) {
+		ssize_t n;
+		if (file->use_splice) {
+			n = splice(file->pipe[0], NULL, file->fd, NULL, *size, SPLICE_F_MOVE | SPLICE_F_MORE);
+			if (n < 0 && errno == EINVAL) {
+				// output doesn't support splice (e.g. opened with O_APPEND)
+				file->use_splice = false;
+				continue;
+			}
+		} else {
+			n = read(file->pipe[0], buffer, (*size < BUF_SIZE) ? *size : BUF_SIZE);
+			if (n > 0) {
+				const int err = write_all(file->fd, buffer, n);
+				*size -= n;
+				if (err)
+					return err;
+
+				continue;
+			}
+		}
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+
+			return errno;
+		}
+
+		*size -= n;
+	}
+
+	return 0;
+}
+//---------------------------------------------------------------------------
+
+// discards size bytes from the intermediate pipe of a failed output
+static void discard_pipe(struct file_t* file, size_t size) {
+	while (size > 0) {
+		const ssize_t n = read(file->pipe[0], buffer, (size < BUF_SIZE) ? size : BUF_SIZE);
+		if (n <= 0)
+			break;
+
+		size -= n;
+	}
+}
+//---------------------------------------------------------------------------
+
+// closes intermediate pipes of the first count files
+static void close_pipes(struct file_t* files, int count) {
+	int i;
+	for (i=0; i < count; i++) {
+		close(files[i].pipe[0]);
+		close(files[i].pipe[1]);
+	}
+}
+//---------------------------------------------------------------------------
+
+// returns false if the splice path can't be used at all
+bool tee_splice(struct file_t* input, struct file_t* files, int count) {
+	int i;
+	ssize_t n, dup;
+	long capacity;
+
+	// capacity of all pipes must be the same, so a single call
+	// of tee/splice moves a whole chunk from the input
+	fcntl(input->fd, F_SETPIPE_SZ, PIPE_SIZE);
+	capacity = fcntl(input->fd, F_GETPIPE_SZ);
+	if (capacity <= 0)
+		return false;
+
+	for (i=0; i < count; i++) {
+		if (pipe(files[i].pipe) < 0) {
+			close_pipes(files, i);
+			return false;
+		}
+
+		if (fcntl(files[i].pipe[1], F_SETPIPE_SZ, capacity) < capacity) {
+			close_pipes(files, i + 1);
+			return false;
+		}
+
+		files[i].use_splice = true;
+	}
+
+	while (1) {
+		// the first count-1 outputs get a copy of the input pipe...
+		n = 0;
+		for (i=0; i < count - 1; i++) {
+			if (files[i].failed)
+				continue;
+
+			do {
+				dup = tee(input->fd, files[i].pipe[1], (n > 0) ? n : capacity, 0);
+			} while (dup < 0 && errno == EINTR);
+
+			if (dup < 0) {
+				if (n == 0 && errno == EINVAL) {
+					close_pipes(files, count);
+					return false;
+				}
+
+				read_failed(input, errno);
+				close_pipes(files, count);
+				return true;
+			}
+
+			if (dup == 0)
+				goto eof;
+
+			if (n > 0 && dup != n) {
+				fprintf(stderr, "tee: unexpected short copy (%zd of %zd bytes)\n", dup, n);
+				exit(EXIT_FAILURE);
+			}
+
+			n = dup;
+		}
+
+		// ... and the last one consumes it
+		do {
+			dup = splice(input->fd, NULL, files[count - 1].pipe[1], NULL,
+			             (n > 0) ? n : capacity, SPLICE_F_MOVE);
+		} while (dup < 0 && errno == EINTR);
+
+		if (dup < 0) {
+			read_failed(input, errno);
+			close_pipes(files, count);
+			return true;
+		}
+
+		if (dup == 0)
+			goto eof;
+
+		if (n > 0 && dup != n) {
+			fprintf(stderr, "tee: unexpected short splice (%zd of %zd bytes)\n", dup, n);
+			exit(EXIT_FAILURE);
+		}
+
+		n = dup;
+
+		for (i=0; i < count; i++) {
+			if (files[i].failed) {
+				if (i == count - 1)
+					discard_pipe(&files[i], n);
+				continue;
+			}
+
+			size_t left = n;
+			const int err = drain_pipe(&files[i], &left);
+			if (err) {
+				write_failed(&files[i], err);
+				discard_pipe(&files[i], left);
+			}
+		}
+	}
+
+eof:
+	close_pipes(files, count);
+	return true;
+}
+//---------------------------------------------------------------------------
+
+void tee_buffered(struct file_t* input, struct file_t* files, int count) {
+	int i;
+	ssize_t readed;
+
+	while (1) {
+		readed = read(input->fd, buffer, BUF_SIZE);
+		if (readed == 0)
+			break;
+		if (readed < 0) {
+			if (errno == EINTR)
+				continue;
+
+			read_failed(input, errno);
+			break;
+		}
+
+		for (i=0; i < count; i++) {
+			if (files[i].failed)
+				continue;
+
+			const int err = write_all(files[i].fd, buffer, readed);
+			if (err)
+				write_failed(&files[i], err);
+		}
+	}
+}
+//---------------------------------------------------------------------------
+
+// asynchronous mode
+
+#define RING_BLOCKS 64
+#define BLOCK_SIZE  (256*1024)
+
+struct block_t {
+	char*	data;
+	size_t	size;
+	int	refcount;	// number of outputs that haven't written the block yet
+};
+
+struct sink_t {
+	struct file_t*	file;
+	pthread_t	thread;
+	char*		buffer;		// for data read back from the spill file
+	size_t		pos;		// sequence number of the next block to write
+	bool		busy;		// block pos is being written
+	bool		spilling;	// block pos-1 is being saved to the spill file
+	char*		orphan;		// data of a busy block detached from the ring
+	// spill file keeps blocks older than pos
+	FILE*		spill;
+	size_t		spill_written;
+	size_t		spill_read;
+	// statistics
+	size_t		bytes;
+	size_t		dropped;
+	size_t		spilled;
+	size_t		max_lag;	// in blocks
+	double		time;
+};
+
+static struct {
+	pthread_mutex_t	lock;
+	pthread_cond_t	data_ready;	// signalled by the reader
+	pthread_cond_t	space_free;	// signalled by sinks
+	struct block_t	ring[RING_BLOCKS];
+	size_t		head;		// sequence number of the next block read
+	bool		eof;
+} async;
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+//---------------------------------------------------------------------------
+
+static void sink_write(struct sink_t* sink, const char* data, size_t size) {
+	int err;
+	if (sink->file->failed)
+		return;
+
+	err = write_all(sink->file->fd, data, size);
+	if (err)
+		write_failed(sink->file, err);
+	else
+		sink->bytes += size;
+}
+//---------------------------------------------------------------------------
+
+static void* sink_thread(void* arg) {
+	struct sink_t* sink = (struct sink_t*)arg;
+	const double start = now();
+
+	pthread_mutex_lock(&async.lock);
+	while (1) {
+		// the reader is saving a block, it must be written first
+		if (sink->spilling) {
+			pthread_cond_wait(&async.data_ready, &async.lock);
+			continue;
+		}
+
+		// spilled blocks precede blocks from the ring
+		if (sink->spill_read < sink->spill_written) {
+			size_t size = sink->spill_written - sink->spill_read;
+			const off_t offset = sink->spill_read;
+			if (size > BLOCK_SIZE)
+				size = BLOCK_SIZE;
+
+			pthread_mutex_unlock(&async.lock);
+			if (pread(fileno(sink->spill), sink->buffer, size, offset) != (ssize_t)size) {
+				fprintf(stderr, "can't read spill file of %s: %s\n", sink->file->name, strerror(errno));
+				exit(EXIT_FAILURE);
+			}
+			sink_write(sink, sink->buffer, size);
+			pthread_mutex_lock(&async.lock);
+
+			sink->spill_read += size;
+			continue;
+		}
+
+		if (sink->pos == async.head) {
+			if (async.eof)
+				break;
+
+			pthread_cond_wait(&async.data_ready, &async.lock);
+			continue;
+		}
+
+		struct block_t* block = &async.ring[sink->pos % RING_BLOCKS];
+		const char* data = block->data;
+		const size_t size = block->size;
+		sink->busy = true;
+		pthread_mutex_unlock(&async.lock);
+
+		sink_write(sink, data, size);
+
+		pthread_mutex_lock(&async.lock);
+		sink->busy = false;
+		if (sink->orphan) {
+			// the reader has already released the block
+			free(sink->orphan);
+			sink->orphan = NULL;
+		} else {
+			sink->pos += 1;
+			block->refcount -= 1;
+			if (block->refcount == 0)
+				pthread_cond_signal(&async.space_free);
+		}
+	}
+	pthread_mutex_unlock(&async.lock);
+
+	sink->time = now() - start;
+	return NULL;
+}
+//---------------------------------------------------------------------------
+
+// applies drop or spill policy to sinks that still hold the oldest block;
+// sinks to spill are only marked, see spill_oldest; called with the lock held
+static void release_oldest(struct sink_t* sinks, int count) {
+	const size_t seq = async.head - RING_BLOCKS;
+	struct block_t* block = &async.ring[seq % RING_BLOCKS];
+	int i;
+
+	for (i=0; i < count; i++) {
+		struct sink_t* sink = &sinks[i];
+		if (sink->pos != seq || sink->file->policy == POLICY_BLOCK)
+			continue;
+
+		if (sink->busy && sink->orphan == NULL) {
+			// the sink is stuck in write: it keeps the data,
+			// the ring gets a fresh buffer
+			char* data;
+			if (posix_memalign((void**)&data, 4096, BLOCK_SIZE) != 0)
+				continue;
+
+			sink->orphan = block->data;
+			block->data = data;
+			sink->pos += 1;
+			block->refcount -= 1;
+			continue;
+		}
+
+		sink->pos += 1;
+		if (sink->file->policy == POLICY_SPILL)
+			sink->spilling = true;	// keeps its reference
+		else {
+			sink->dropped += block->size;
+			block->refcount -= 1;
+		}
+	}
+}
+//---------------------------------------------------------------------------
+
+// saves the oldest block in spill files of marked sinks; called with the
+// lock held, the lock is released for the I/O.  The block can't be reused
+// meanwhile, as marked sinks still hold it; spill files and spill_written
+// are changed only by the reader.
+static void spill_oldest(struct sink_t* sinks, int count) {
+	const size_t seq = async.head - RING_BLOCKS;
+	struct block_t* block = &async.ring[seq % RING_BLOCKS];
+	bool any = false;
+	int i;
+
+	for (i=0; i < count; i++)
+		any |= sinks[i].spilling;
+
+	if (!any)
+		return;
+
+	pthread_mutex_unlock(&async.lock);
+	for (i=0; i < count; i++) {
+		struct sink_t* sink = &sinks[i];
+		if (!sink->spilling)
+			continue;
+
+		if (sink->spill == NULL)
+			sink->spill = tmpfile();
+		if (sink->spill == NULL || pwrite(fileno(sink->spill), block->data, block->size, sink->spill_written) != (ssize_t)block->size) {
+			fprintf(stderr, "can't spill data of %s: %s\n", sink->file->name, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+	}
+	pthread_mutex_lock(&async.lock);
+
+	for (i=0; i < count; i++) {
+		struct sink_t* sink = &sinks[i];
+		if (!sink->spilling)
+			continue;
+
+		sink->spilling = false;
+		sink->spill_written += block->size;
+		sink->spilled += block->size;
+		block->refcount -= 1;
+	}
+	pthread_cond_broadcast(&async.data_ready);
+}
+//---------------------------------------------------------------------------
+
+static void update_lag(struct sink_t* sinks, int count) {
+	int i;
+	for (i=0; i < count; i++) {
+		const size_t lag = async.head - sinks[i].pos;
+		if (lag > sinks[i].max_lag)
+			sinks[i].max_lag = lag;
+	}
+}
+//---------------------------------------------------------------------------
+
+static void show_stats(struct sink_t* sinks, int count) {
+	int i;
+	const double MB = 1024.0*1024.0;
+
+	fprintf(stderr, "%-20s %12s %12s %12s %12s %10s\n", "output", "written MB", "dropped MB", "spilled MB", "max lag MB", "MB/s");
+	for (i=0; i < count; i++) {
+		const struct sink_t* s = &sinks[i];
+		fprintf(stderr, "%-20s %12.1f %12.1f %12.1f %12.1f %10.1f\n",
+		        s->file->name,
+		        s->bytes / MB,
+		        s->dropped / MB,
+		        s->spilled / MB,
+		        (double)s->max_lag * BLOCK_SIZE / MB,
+		        (s->time > 0.0) ? s->bytes / MB / s->time : 0.0);
+	}
+}
+//---------------------------------------------------------------------------
+
+void tee_async(struct file_t* input, struct file_t* files, int count, bool print_stats) {
+	struct sink_t* sinks;
+	ssize_t readed;
+	int i;
+
+	sinks = calloc(count, sizeof(struct sink_t));
+	if (sinks == NULL) {
+		fprintf(stderr, "Can't allocate %zu byte(s)\n", count * sizeof(struct sink_t));
+		exit(EXIT_FAILURE);
+	}
+
+	pthread_mutex_init(&async.lock, NULL);
+	pthread_cond_init(&async.data_ready, NULL);
+	pthread_cond_init(&async.space_free, NULL);
+	for (i=0; i < RING_BLOCKS; i++) {
+		if (posix_memalign((void**)&async.ring[i].data, 4096, BLOCK_SIZE) != 0) {
+			fprintf(stderr, "Can't allocate %d byte(s)\n", BLOCK_SIZE);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	for (i=0; i < count; i++) {
+		sinks[i].file = &files[i];
+		sinks[i].buffer = malloc(BLOCK_SIZE);
+		if (sinks[i].buffer == NULL || pthread_create(&sinks[i].thread, NULL, sink_thread, &sinks[i]) != 0) {
+			fprintf(stderr, "Can't start thread for %s\n", files[i].name);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	while (1) {
+		struct block_t* block = &async.ring[async.head % RING_BLOCKS];
+
+		// only the reader changes head, thus the block can be
+		// filled without the lock once all outputs released it
+		pthread_mutex_lock(&async.lock);
+		update_lag(sinks, count);
+		while (block->refcount > 0) {
+			release_oldest(sinks, count);
+			spill_oldest(sinks, count);
+			if (block->refcount > 0)
+				pthread_cond_wait(&async.space_free, &async.lock);
+		}
+		pthread_mutex_unlock(&async.lock);
+
+		do {
+			readed = read(input->fd, block->data, BLOCK_SIZE);
+		} while (readed < 0 && errno == EINTR);
+
+		if (readed < 0)
+			read_failed(input, errno);
+
+		pthread_mutex_lock(&async.lock);
+		if (readed <= 0)
+			async.eof = true;
+		else {
+			block->size = readed;
+			block->refcount = count;
+			async.head += 1;
+		}
+		pthread_cond_broadcast(&async.data_ready);
+		pthread_mutex_unlock(&async.lock);
+
+		if (readed <= 0)
+			break;
+	}
+
+	for (i=0; i < count; i++) {
+		pthread_join(sinks[i].thread, NULL);
+		free(sinks[i].buffer);
+		if (sinks[i].spill)
+			fclose(sinks[i].spill);
+	}
+
+	if (print_stats)
+		show_stats(sinks, count);
+
+	for (i=0; i < RING_BLOCKS; i++)
+		free(async.ring[i].data);
+
+	free(sinks);
+}
+//---------------------------------------------------------------------------
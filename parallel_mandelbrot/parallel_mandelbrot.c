@@ -33,6 +33,7 @@
 		- DEBUG		- be verbose
 
 */
+#include "../common/bufalloc.h"
 #include <pthread.h>
 #include <errno.h>
 #include <stdint.h>
@@ -74,7 +75,11 @@ pthread_t threads[THREAD_NUM];
 #define JOBS_COUNT ((WIDTH)/SIZE * (HEIGHT)/SIZE)
 
 
-uint8_t Image[HEIGHT][WIDTH];
+// allocated with ../common/bufalloc.h, page kind and NUMA placement
+// are controlled by BUFALLOC_PAGES and BUFALLOC_NUMA
+buf_t   image_buf;
+uint8_t (*Image)[WIDTH];
+#define IMAGE_SIZE ((size_t)WIDTH * HEIGHT)
 
 typedef struct {
 	int id;
@@ -175,7 +180,8 @@ uint32_t get_time(void) {
 
 int main() {
 
-	memset(Image, 127, sizeof(Image));
+	Image = buf_alloc_or_die(&image_buf, IMAGE_SIZE);
+	memset(Image, 127, IMAGE_SIZE);
 
 	int x, y, i;
 	FILE* f;
@@ -250,12 +256,14 @@ int main() {
 	f = fopen("mandelbrot.pgm", "wb");
 	if (f != NULL) {
 		fprintf(f, "P5\n%d %d 255\n", (int)WIDTH, (int)HEIGHT);
-		fwrite(Image, sizeof(Image), 1, f);
+		fwrite(Image, IMAGE_SIZE, 1, f);
 		fclose(f);
+		buf_free(&image_buf);
 		return 0;
 	}
 	else {
 		puts("ERROR: Can't open file for writing!");
+		buf_free(&image_buf);
 		return 1;
 	}
 
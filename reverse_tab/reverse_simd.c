@@ -0,0 +1,546 @@
+/*
+	Reversing arrays and swapping byte order --- 64-bit SIMD library
+
+	License: BSD
+
+	----------------------------------------------------------------------
+
+	Procedures work on arrays of n elements, each `size` bytes long:
+
+	* reverse_copy_xxx(src, dst, n, size) - dst[i] = src[n - 1 - i],
+	  arrays must not overlap; size = 1, 2, 4, 8 or 16;
+
+	* reverse_inplace_xxx(data, n, size) - the same, in place;
+
+	* bswap_xxx(src, dst, n, size) - byte order of each element is
+	  reversed (endianness conversion); src may be equal to dst;
+	  size = 2, 4, 8 or 16.
+
+	All return 0, or -1 when size is not supported.
+
+	Vector versions (xxx = ssse3, avx2, avx512) use a single PSHUFB per
+	register, its pattern depends on the element size; AVX2 and AVX512BW
+	additionally reverse order of 128-bit lanes.  When AVX512VBMI is
+	available a single VPERMB does both.  Tails, shorter than a vector,
+	are processed by overlapping vectors; only arrays shorter than a vector
+	go to the narrower version, down to the scalar code.
+
+	Compilation:
+
+		-mssse3
+		-mavx2 -DHAVE_AVX2_INSTRUCTIONS
+		-mavx512bw -DHAVE_AVX512BW_INSTRUCTIONS (implies AVX2)
+
+	or, without any -m flags, -DREVERSE_DISPATCH: all versions are
+	compiled in (each for its ISA, with GCC target pragmas), and
+	reverse_copy(), reverse_inplace() and bswap_array() call the fastest
+	version the CPU supports --- see ../common/cpudispatch.h.  The VPERMB
+	variant is not used then.
+*/
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <immintrin.h>
+
+#define REVERSE_INLINE static inline __attribute__((always_inline))
+
+#ifdef REVERSE_DISPATCH
+#   include "../common/cpudispatch.h"
+#   define HAVE_AVX2_INSTRUCTIONS
+#   define HAVE_AVX512BW_INSTRUCTIONS
+#   define REVERSE_TARGET_BEGIN(isa) CPU_TARGET_BEGIN(isa)
+#   define REVERSE_TARGET_END CPU_TARGET_END
+#else
+#   define REVERSE_TARGET_BEGIN(isa)
+#   define REVERSE_TARGET_END
+#endif
+
+static int reverse_valid_size(size_t size) {
+	return size == 1 || size == 2 || size == 4 || size == 8 || size == 16;
+}
+//---------------------------------------------------------------------------
+
+static int bswap_valid_size(size_t size) {
+	return size == 2 || size == 4 || size == 8 || size == 16;
+}
+//---------------------------------------------------------------------------
+
+/*
+	Shuffle patterns, indexed by log2(size).
+
+	reverse_patterns reverse order of elements in a 64-byte register, i.e.
+	byte j of result is taken from element (64/size - 1 - j/size), the
+	same byte within element.  VPERMB uses 6 lower bits of indices and
+	PSHUFB just 4, thus any 16-byte row is the pattern reversing
+	elements within a 128-bit lane.
+
+	bswap_patterns reverse bytes within elements; size = 1 is a no-op.
+*/
+static const uint8_t reverse_patterns[5][64] __attribute__((aligned(64))) = {
+	{ // size = 1
+		63, 62, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49, 48,
+		47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 32,
+		31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16,
+		15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  0
+	},
+	{ // size = 2
+		62, 63, 60, 61, 58, 59, 56, 57, 54, 55, 52, 53, 50, 51, 48, 49,
+		46, 47, 44, 45, 42, 43, 40, 41, 38, 39, 36, 37, 34, 35, 32, 33,
+		30, 31, 28, 29, 26, 27, 24, 25, 22, 23, 20, 21, 18, 19, 16, 17,
+		14, 15, 12, 13, 10, 11,  8,  9,  6,  7,  4,  5,  2,  3,  0,  1
+	},
+	{ // size = 4
+		60, 61, 62, 63, 56, 57, 58, 59, 52, 53, 54, 55, 48, 49, 50, 51,
+		44, 45, 46, 47, 40, 41, 42, 43, 36, 37, 38, 39, 32, 33, 34, 35,
+		28, 29, 30, 31, 24, 25, 26, 27, 20, 21, 22, 23, 16, 17, 18, 19,
+		12, 13, 14, 15,  8,  9, 10, 11,  4,  5,  6,  7,  0,  1,  2,  3
+	},
+	{ // size = 8
+		56, 57, 58, 59, 60, 61, 62, 63, 48, 49, 50, 51, 52, 53, 54, 55,
+		40, 41, 42, 43, 44, 45, 46, 47, 32, 33, 34, 35, 36, 37, 38, 39,
+		24, 25, 26, 27, 28, 29, 30, 31, 16, 17, 18, 19, 20, 21, 22, 23,
+		 8,  9, 10, 11, 12, 13, 14, 15,  0,  1,  2,  3,  4,  5,  6,  7
+	},
+	{ // size = 16
+		48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63,
+		32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47,
+		16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31,
+		 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15
+	}
+};
+
+static const uint8_t bswap_patterns[5][16] __attribute__((aligned(16))) = {
+	{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
+	{ 1,  0,  3,  2,  5,  4,  7,  6,  9,  8, 11, 10, 13, 12, 15, 14},
+	{ 3,  2,  1,  0,  7,  6,  5,  4, 11, 10,  9,  8, 15, 14, 13, 12},
+	{ 7,  6,  5,  4,  3,  2,  1,  0, 15, 14, 13, 12, 11, 10,  9,  8},
+	{15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  0}
+};
+
+static size_t log2_size(size_t size) {
+	return __builtin_ctzl(size);
+}
+//---------------------------------------------------------------------------
+
+// scalar code
+
+int reverse_copy_scalar(const void* src, void* dst, size_t n, size_t size) {
+	size_t i;
+
+	if (!reverse_valid_size(size))
+		return -1;
+
+	switch (size) {
+		case 1: {
+			const uint8_t* s = (const uint8_t*)src;
+			uint8_t* d = (uint8_t*)dst;
+			for (i=0; i < n; i++)
+				d[i] = s[n - 1 - i];
+			break;
+		}
+		case 2: {
+			const uint16_t* s = (const uint16_t*)src;
+			uint16_t* d = (uint16_t*)dst;
+			for (i=0; i < n; i++)
+				d[i] = s[n - 1 - i];
+			break;
+		}
+		case 4: {
+			const uint32_t* s = (const uint32_t*)src;
+			uint32_t* d = (uint32_t*)dst;
+			for (i=0; i < n; i++)
+				d[i] = s[n - 1 - i];
+			break;
+		}
+		case 8: {
+			const uint64_t* s = (const uint64_t*)src;
+			uint64_t* d = (uint64_t*)dst;
+			for (i=0; i < n; i++)
+				d[i] = s[n - 1 - i];
+			break;
+		}
+		default:
+			for (i=0; i < n; i++)
+				memcpy((uint8_t*)dst + i*16, (const uint8_t*)src + (n - 1 - i)*16, 16);
+			break;
+	}
+
+	return 0;
+}
+//---------------------------------------------------------------------------
+
+int reverse_inplace_scalar(void* data, size_t n, size_t size) {
+	uint8_t tmp[16];
+	uint8_t* a;
+	uint8_t* b;
+
+	if (!reverse_valid_size(size))
+		return -1;
+
+	if (n < 2)
+		return 0;
+
+	a = (uint8_t*)data;
+	b = (uint8_t*)data + (n - 1)*size;
+	while (a < b) {
+		memcpy(tmp, a, size);
+		memcpy(a, b, size);
+		memcpy(b, tmp, size);
+		a += size;
+		b -= size;
+	}
+
+	return 0;
+}
+//---------------------------------------------------------------------------
+
+int bswap_scalar(const void* src, void* dst, size_t n, size_t size) {
+	size_t i;
+
+	if (!bswap_valid_size(size))
+		return -1;
+
+	// elements are accessed with memcpy, arrays may be unaligned
+	for (i=0; i < n; i++) {
+		const uint8_t* s = (const uint8_t*)src + i*size;
+		uint8_t* d = (uint8_t*)dst + i*size;
+		switch (size) {
+			case 2: {
+				uint16_t x;
+				memcpy(&x, s, 2);
+				x = __builtin_bswap16(x);
+				memcpy(d, &x, 2);
+				break;
+			}
+			case 4: {
+				uint32_t x;
+				memcpy(&x, s, 4);
+				x = __builtin_bswap32(x);
+				memcpy(d, &x, 4);
+				break;
+			}
+			case 8: {
+				uint64_t x;
+				memcpy(&x, s, 8);
+				x = __builtin_bswap64(x);
+				memcpy(d, &x, 8);
+				break;
+			}
+			default: {
+				uint64_t lo, hi;
+				memcpy(&lo, s, 8);
+				memcpy(&hi, s + 8, 8);
+				lo = __builtin_bswap64(lo);
+				hi = __builtin_bswap64(hi);
+				memcpy(d, &hi, 8);
+				memcpy(d + 8, &lo, 8);
+				break;
+			}
+		}
+	}
+
+	return 0;
+}
+//---------------------------------------------------------------------------
+
+/*
+	Vector loops are written once, as macros parametrized by:
+	type of register (T), its size in bytes (V), load/store and the
+	function transforming a register (SHUFFLE); the narrower version
+	(NARROW) handles arrays shorter than a vector.
+
+	The last, partial vector is processed by overlapping the previous one;
+	data are loaded before any store, thus it works in place, too.
+*/
+
+#define DEFINE_REVERSE_COPY(name, T, V, LOAD, STORE, SHUFFLE, NARROW)	\
+	REVERSE_INLINE void name(const uint8_t* src, uint8_t* dst,		\
+				 size_t n, size_t size, T pattern) {		\
+		const size_t bytes = n*size;					\
+		size_t i;							\
+		T first;							\
+		if (bytes < V) {						\
+			NARROW(src, dst, n, size);				\
+			return;							\
+		}								\
+		first = LOAD((const T*)src);					\
+		for (i=0; i + V <= bytes; i += V) {				\
+			const T x = LOAD((const T*)(src + bytes - V - i));	\
+			STORE((T*)(dst + i), SHUFFLE(x, pattern));		\
+		}								\
+		STORE((T*)(dst + bytes - V), SHUFFLE(first, pattern));		\
+	}
+
+#define DEFINE_REVERSE_INPLACE(name, T, V, LOAD, STORE, SHUFFLE, NARROW)	\
+	REVERSE_INLINE void name(uint8_t* data, size_t n, size_t size,		\
+				 T pattern) {					\
+		uint8_t* lo = data;						\
+		uint8_t* hi = data + n*size;					\
+		while (hi - lo >= V) {						\
+			const T a = LOAD((const T*)lo);				\
+			const T b = LOAD((const T*)(hi - V));			\
+			STORE((T*)lo,       SHUFFLE(b, pattern));		\
+			STORE((T*)(hi - V), SHUFFLE(a, pattern));		\
+			if (hi - lo < 2*V)					\
+				return;						\
+			lo += V;						\
+			hi -= V;						\
+		}								\
+		NARROW(lo, (hi - lo)/size, size);				\
+	}
+
+#define DEFINE_BSWAP(name, T, V, LOAD, STORE, SHUFFLE, NARROW)			\
+	REVERSE_INLINE void name(const uint8_t* src, uint8_t* dst,		\
+				 size_t n, size_t size, T pattern) {		\
+		const size_t bytes = n*size;					\
+		size_t i;							\
+		T last;								\
+		if (bytes < V) {						\
+			NARROW(src, dst, n, size);				\
+			return;							\
+		}								\
+		last = LOAD((const T*)(src + bytes - V));			\
+		for (i=0; i + V <= bytes; i += V) {				\
+			const T x = LOAD((const T*)(src + i));			\
+			STORE((T*)(dst + i), SHUFFLE(x, pattern));		\
+		}								\
+		STORE((T*)(dst + bytes - V), SHUFFLE(last, pattern));		\
+	}
+
+// SSSE3
+
+REVERSE_TARGET_BEGIN("ssse3")
+
+REVERSE_INLINE __m128i shuffle_ssse3(__m128i x, __m128i pattern) {
+	return _mm_shuffle_epi8(x, pattern);
+}
+
+static __m128i reverse_pattern_ssse3(size_t size) {
+	return _mm_load_si128((const __m128i*)reverse_patterns[log2_size(size)]);
+}
+
+static __m128i bswap_pattern_ssse3(size_t size) {
+	return _mm_load_si128((const __m128i*)bswap_patterns[log2_size(size)]);
+}
+
+DEFINE_REVERSE_COPY(reverse_copy_ssse3_loop, __m128i, 16, _mm_loadu_si128, _mm_storeu_si128,
+		    shuffle_ssse3, reverse_copy_scalar)
+DEFINE_REVERSE_INPLACE(reverse_inplace_ssse3_loop, __m128i, 16, _mm_loadu_si128, _mm_storeu_si128,
+		       shuffle_ssse3, reverse_inplace_scalar)
+DEFINE_BSWAP(bswap_ssse3_loop, __m128i, 16, _mm_loadu_si128, _mm_storeu_si128,
+	     shuffle_ssse3, bswap_scalar)
+
+int reverse_copy_ssse3(const void* src, void* dst, size_t n, size_t size) {
+	if (!reverse_valid_size(size))
+		return -1;
+
+	reverse_copy_ssse3_loop((const uint8_t*)src, (uint8_t*)dst, n, size,
+				reverse_pattern_ssse3(size));
+	return 0;
+}
+//---------------------------------------------------------------------------
+
+int reverse_inplace_ssse3(void* data, size_t n, size_t size) {
+	if (!reverse_valid_size(size))
+		return -1;
+
+	reverse_inplace_ssse3_loop((uint8_t*)data, n, size,
+				   reverse_pattern_ssse3(size));
+	return 0;
+}
+//---------------------------------------------------------------------------
+
+int bswap_ssse3(const void* src, void* dst, size_t n, size_t size) {
+	if (!bswap_valid_size(size))
+		return -1;
+
+	bswap_ssse3_loop((const uint8_t*)src, (uint8_t*)dst, n, size,
+			 bswap_pattern_ssse3(size));
+	return 0;
+}
+//---------------------------------------------------------------------------
+
+REVERSE_TARGET_END
+
+#ifdef HAVE_AVX2_INSTRUCTIONS
+
+REVERSE_TARGET_BEGIN("avx2")
+
+// reverse within lanes, then swap lanes
+REVERSE_INLINE __m256i reverse_avx2(__m256i x, __m256i pattern) {
+	return _mm256_permute4x64_epi64(_mm256_shuffle_epi8(x, pattern), 0x4e);
+}
+
+REVERSE_INLINE __m256i bswap_avx2_shuffle(__m256i x, __m256i pattern) {
+	return _mm256_shuffle_epi8(x, pattern);
+}
+
+static __m256i reverse_pattern_avx2(size_t size) {
+	return _mm256_load_si256((const __m256i*)reverse_patterns[log2_size(size)]);
+}
+
+static __m256i bswap_pattern_avx2(size_t size) {
+	return _mm256_broadcastsi128_si256(bswap_pattern_ssse3(size));
+}
+
+DEFINE_REVERSE_COPY(reverse_copy_avx2_loop, __m256i, 32, _mm256_loadu_si256, _mm256_storeu_si256,
+		    reverse_avx2, reverse_copy_ssse3)
+DEFINE_REVERSE_INPLACE(reverse_inplace_avx2_loop, __m256i, 32, _mm256_loadu_si256, _mm256_storeu_si256,
+		       reverse_avx2, reverse_inplace_ssse3)
+DEFINE_BSWAP(bswap_avx2_loop, __m256i, 32, _mm256_loadu_si256, _mm256_storeu_si256,
+	     bswap_avx2_shuffle, bswap_ssse3)
+
+int reverse_copy_avx2(const void* src, void* dst, size_t n, size_t size) {
+	if (!reverse_valid_size(size))
+		return -1;
+
+	reverse_copy_avx2_loop((const uint8_t*)src, (uint8_t*)dst, n, size,
+			       reverse_pattern_avx2(size));
+	return 0;
+}
+//---------------------------------------------------------------------------
+
+int reverse_inplace_avx2(void* data, size_t n, size_t size) {
+	if (!reverse_valid_size(size))
+		return -1;
+
+	reverse_inplace_avx2_loop((uint8_t*)data, n, size,
+				  reverse_pattern_avx2(size));
+	return 0;
+}
+//---------------------------------------------------------------------------
+
+int bswap_avx2(const void* src, void* dst, size_t n, size_t size) {
+	if (!bswap_valid_size(size))
+		return -1;
+
+	bswap_avx2_loop((const uint8_t*)src, (uint8_t*)dst, n, size,
+			bswap_pattern_avx2(size));
+	return 0;
+}
+//---------------------------------------------------------------------------
+
+REVERSE_TARGET_END
+
+#endif // HAVE_AVX2_INSTRUCTIONS
+
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+
+REVERSE_TARGET_BEGIN("avx512bw")
+
+REVERSE_INLINE __m512i load_avx512(const __m512i* p) {
+	return _mm512_loadu_si512(p);
+}
+
+REVERSE_INLINE void store_avx512(__m512i* p, __m512i x) {
+	_mm512_storeu_si512(p, x);
+}
+
+#ifdef __AVX512VBMI__
+// a single VPERMB, pattern covers the whole register
+REVERSE_INLINE __m512i reverse_avx512(__m512i x, __m512i pattern) {
+	return _mm512_permutexvar_epi8(pattern, x);
+}
+#else
+// reverse within lanes, then reverse order of lanes
+REVERSE_INLINE __m512i reverse_avx512(__m512i x, __m512i pattern) {
+	x = _mm512_shuffle_epi8(x, pattern);
+	return _mm512_shuffle_i64x2(x, x, 0x1b);
+}
+#endif
+
+static __m512i reverse_pattern_avx512(size_t size) {
+	return _mm512_load_si512(reverse_patterns[log2_size(size)]);
+}
+
+REVERSE_INLINE __m512i bswap_avx512_shuffle(__m512i x, __m512i pattern) {
+	return _mm512_shuffle_epi8(x, pattern);
+}
+
+DEFINE_REVERSE_COPY(reverse_copy_avx512_loop, __m512i, 64, load_avx512, store_avx512,
+		    reverse_avx512, reverse_copy_avx2)
+DEFINE_REVERSE_INPLACE(reverse_inplace_avx512_loop, __m512i, 64, load_avx512, store_avx512,
+		       reverse_avx512, reverse_inplace_avx2)
+DEFINE_BSWAP(bswap_avx512_loop, __m512i, 64, load_avx512, store_avx512,
+	     bswap_avx512_shuffle, bswap_avx2)
+
+int reverse_copy_avx512(const void* src, void* dst, size_t n, size_t size) {
+	if (!reverse_valid_size(size))
+		return -1;
+
+	reverse_copy_avx512_loop((const uint8_t*)src, (uint8_t*)dst, n, size,
+				 reverse_pattern_avx512(size));
+	return 0;
+}
+//---------------------------------------------------------------------------
+
+int reverse_inplace_avx512(void* data, size_t n, size_t size) {
+	if (!reverse_valid_size(size))
+		return -1;
+
+	reverse_inplace_avx512_loop((uint8_t*)data, n, size,
+				    reverse_pattern_avx512(size));
+	return 0;
+}
+//---------------------------------------------------------------------------
+
+int bswap_avx512(const void* src, void* dst, size_t n, size_t size) {
+	if (!bswap_valid_size(size))
+		return -1;
+
+	bswap_avx512_loop((const uint8_t*)src, (uint8_t*)dst, n, size,
+			  _mm512_broadcast_i32x4(bswap_pattern_ssse3(size)));
+	return 0;
+}
+//---------------------------------------------------------------------------
+
+REVERSE_TARGET_END
+
+#endif // HAVE_AVX512BW_INSTRUCTIONS
+
+#ifdef REVERSE_DISPATCH
+
+typedef int (*reverse_copy_fun)(const void*, void*, size_t, size_t);
+typedef int (*reverse_inplace_fun)(void*, size_t, size_t);
+
+static const cpu_variant reverse_copy_variants[] = {
+	CPU_VARIANT(CPU_AVX512BW, reverse_copy_avx512),
+	CPU_VARIANT(CPU_AVX2,     reverse_copy_avx2),
+	CPU_VARIANT(CPU_SSSE3,    reverse_copy_ssse3),
+	CPU_VARIANT(0,            reverse_copy_scalar)
+};
+
+static const cpu_variant reverse_inplace_variants[] = {
+	CPU_VARIANT(CPU_AVX512BW, reverse_inplace_avx512),
+	CPU_VARIANT(CPU_AVX2,     reverse_inplace_avx2),
+	CPU_VARIANT(CPU_SSSE3,    reverse_inplace_ssse3),
+	CPU_VARIANT(0,            reverse_inplace_scalar)
+};
+
+static const cpu_variant bswap_variants[] = {
+	CPU_VARIANT(CPU_AVX512BW, bswap_avx512),
+	CPU_VARIANT(CPU_AVX2,     bswap_avx2),
+	CPU_VARIANT(CPU_SSSE3,    bswap_ssse3),
+	CPU_VARIANT(0,            bswap_scalar)
+};
+
+int reverse_copy(const void* src, void* dst, size_t n, size_t size) {
+	static cpu_fun fun = NULL;
+	return ((reverse_copy_fun)cpu_resolve(&fun, reverse_copy_variants))(src, dst, n, size);
+}
+//---------------------------------------------------------------------------
+
+int reverse_inplace(void* data, size_t n, size_t size) {
+	static cpu_fun fun = NULL;
+	return ((reverse_inplace_fun)cpu_resolve(&fun, reverse_inplace_variants))(data, n, size);
+}
+//---------------------------------------------------------------------------
+
+int bswap_array(const void* src, void* dst, size_t n, size_t size) {
+	static cpu_fun fun = NULL;
+	return ((reverse_copy_fun)cpu_resolve(&fun, bswap_variants))(src, dst, n, size);
+}
+//---------------------------------------------------------------------------
+
+#endif // REVERSE_DISPATCH
@@ -45,7 +45,6 @@ unsigned gettime() {
 
 void swap_tab(char* c, size_t n) {
 	char *a, *b, t;
-	size_t i;
 
 	a = c;
 	b = c + n - 1;
@@ -61,6 +60,7 @@ void swap_tab(char* c, size_t n) {
 }
 //---------------------------------------------------------------------------
 
+#ifdef __i386__
 void swap_tab_asm(char* c, size_t n) {
 	asm volatile (
 		"	leal -1(%%esi,%%ecx), %%edi	\n"	// edi = last
@@ -455,6 +455,42 @@ void swap_tab_pshufb_unrolled(char* c, size_t n) {
 }
 //---------------------------------------------------------------------------
 
+#endif // __i386__
+
+#ifdef __x86_64__
+/*
+	64-bit build: inline asm above is 32-bit only, the driver measures
+	procedures from reverse_simd.c, reversing arrays of bytes
+*/
+#include "reverse_simd.c"
+
+void swap_tab_lib_ssse3(char* c, size_t n) {
+	reverse_inplace_ssse3(c, n, 1);
+}
+//---------------------------------------------------------------------------
+
+#ifdef HAVE_AVX2_INSTRUCTIONS
+void swap_tab_lib_avx2(char* c, size_t n) {
+	reverse_inplace_avx2(c, n, 1);
+}
+//---------------------------------------------------------------------------
+#endif
+
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+void swap_tab_lib_avx512(char* c, size_t n) {
+	reverse_inplace_avx512(c, n, 1);
+}
+//---------------------------------------------------------------------------
+#endif
+
+#ifdef REVERSE_DISPATCH
+void swap_tab_lib_dispatch(char* c, size_t n) {
+	reverse_inplace(c, n, 1);
+}
+//---------------------------------------------------------------------------
+#endif
+#endif // __x86_64__
+
 #define SIZE (1024*1024)
 
 char tab1[SIZE];
@@ -511,6 +547,7 @@ typedef struct {
 } function_t;
 
 function_t functions[] = {
+#ifdef __i386__
 	{swap_tab_asm,			"x86",		"x86 assembler implementation", 0},
 	{swap_tab_bswap,		"bswap",	"asm: BSWAP", 0},
 	{swap_tab_bswap_unrolled,	"bswap2",	"asm: 2 x BSWAP", 0},
@@ -518,6 +555,22 @@ function_t functions[] = {
 	{swap_tab_sse_unrolled,		"sse2",		"asm: SEE2 implementation - unrolled loop", 0},
 	{swap_tab_pshufb,		"pshufb",	"asm: SSSE3 - PSHUFB", 0},
 	{swap_tab_pshufb_unrolled,	"pshufb2",	"asm: SSSE3 - 2 x PSHUFB", 0},
+#endif
+#ifdef __x86_64__
+	{swap_tab,			"c",		"C implementation", 0},
+#ifdef REVERSE_DISPATCH
+	// versions not supported by CPU can't be listed
+	{swap_tab_lib_dispatch,		"auto",		"reverse_simd: the best version for CPU", 0},
+#else
+	{swap_tab_lib_ssse3,		"ssse3",	"reverse_simd: SSSE3", 0},
+#ifdef HAVE_AVX2_INSTRUCTIONS
+	{swap_tab_lib_avx2,		"avx2",		"reverse_simd: AVX2", 0},
+#endif
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+	{swap_tab_lib_avx512,		"avx512",	"reverse_simd: AVX512BW", 0},
+#endif
+#endif
+#endif
 	{NULL, NULL, NULL, 0}
 };
 
@@ -606,7 +659,7 @@ void verify_single(int index, size_t table_size, size_t offset, size_t iteration
 //---------------------------------------------------------------------------
 
 int main(int argc, char* argv[]) {
-	size_t i, j, n, k, offset;
+	size_t i, n, k = 0, offset;
 	int  index;
 	char mode = '?';
 
@@ -635,7 +688,7 @@ int main(int argc, char* argv[]) {
 			if (argc > 4) {
 				n = atoi(argv[2]);
 				offset = atoi(argv[3]) % 16;
-				printf("table size = %d, offset = %d\n", n, offset);
+				printf("table size = %d, offset = %d\n", (int)n, (int)offset);
 				
 				init_tabs(n);
 				memcpy(tab2, tab1, n);
@@ -670,7 +723,7 @@ int main(int argc, char* argv[]) {
 				n = atoi(argv[3]);
 				k = atoi(argv[4]);
 				
-				printf("table size = %d, offset = %d, iterations count = %d\n", n, offset, k);
+				printf("table size = %d, offset = %d, iterations count = %d\n", (int)n, (int)offset, (int)k);
 				
 				init_tabs(n);
 				memcpy(tab2, tab1, n);
@@ -0,0 +1,149 @@
+/*
+	Verifies procedures from reverse_simd.c against trivial byte-level
+	references, for all element sizes, array lengths 0..300 and
+	misaligned pointers.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "reverse_simd.c"
+#include "../common/cpudispatch.h"
+
+#define MAX_BYTES (16*300 + 64)
+
+typedef int (*copy_fun_t)(const void*, void*, size_t, size_t);
+typedef int (*inplace_fun_t)(void*, size_t, size_t);
+
+typedef struct {
+	const char*	name;
+	uint32_t	required;	/* versions not supported by CPU are skipped */
+	copy_fun_t	reverse_copy;
+	inplace_fun_t	reverse_inplace;
+	copy_fun_t	bswap;
+} implementation_t;
+
+implementation_t implementations[] = {
+	{"scalar",	0,		reverse_copy_scalar,	reverse_inplace_scalar,	bswap_scalar},
+	{"SSSE3",	CPU_SSSE3,	reverse_copy_ssse3,	reverse_inplace_ssse3,	bswap_ssse3},
+#ifdef HAVE_AVX2_INSTRUCTIONS
+	{"AVX2",	CPU_AVX2,	reverse_copy_avx2,	reverse_inplace_avx2,	bswap_avx2},
+#endif
+#ifdef HAVE_AVX512BW_INSTRUCTIONS
+	{"AVX512BW",	CPU_AVX512BW,	reverse_copy_avx512,	reverse_inplace_avx512,	bswap_avx512},
+#endif
+#ifdef REVERSE_DISPATCH
+	{"dispatch",	0,		reverse_copy,		reverse_inplace,	bswap_array},
+#endif
+	{NULL, 0, NULL, NULL, NULL}
+};
+
+uint8_t input[MAX_BYTES];
+uint8_t expected[MAX_BYTES];
+uint8_t result[MAX_BYTES];
+
+void reference_reverse(const uint8_t* src, uint8_t* dst, size_t n, size_t size) {
+	size_t i, j;
+	for (i=0; i < n; i++)
+		for (j=0; j < size; j++)
+			dst[i*size + j] = src[(n - 1 - i)*size + j];
+}
+//---------------------------------------------------------------------------
+
+void reference_bswap(const uint8_t* src, uint8_t* dst, size_t n, size_t size) {
+	size_t i, j;
+	for (i=0; i < n; i++)
+		for (j=0; j < size; j++)
+			dst[i*size + j] = src[i*size + (size - 1 - j)];
+}
+//---------------------------------------------------------------------------
+
+int verify(const implementation_t* impl) {
+	static const size_t sizes[] = {1, 2, 4, 8, 16};
+	size_t k, n, offset;
+
+	for (k=0; k < sizeof(sizes)/sizeof(sizes[0]); k++) {
+		const size_t size = sizes[k];
+		for (n=0; n <= 300; n++) {
+			for (offset=0; offset < 3; offset++) {
+				const size_t bytes = n*size;
+				uint8_t* in  = input + offset;
+				uint8_t* out = result + offset;
+
+				reference_reverse(in, expected, n, size);
+
+				impl->reverse_copy(in, out, n, size);
+				if (memcmp(out, expected, bytes) != 0) {
+					printf("reverse_copy: size=%lu, n=%lu, offset=%lu: wrong result\n",
+						(unsigned long)size, (unsigned long)n, (unsigned long)offset);
+					return 0;
+				}
+
+				memcpy(out, in, bytes);
+				impl->reverse_inplace(out, n, size);
+				if (memcmp(out, expected, bytes) != 0) {
+					printf("reverse_inplace: size=%lu, n=%lu, offset=%lu: wrong result\n",
+						(unsigned long)size, (unsigned long)n, (unsigned long)offset);
+					return 0;
+				}
+
+				if (size == 1) {
+					if (impl->bswap(in, out, n, size) != -1) {
+						puts("bswap: size=1 not rejected");
+						return 0;
+					}
+					continue;
+				}
+
+				reference_bswap(in, expected, n, size);
+				impl->bswap(in, out, n, size);
+				if (memcmp(out, expected, bytes) != 0) {
+					printf("bswap: size=%lu, n=%lu, offset=%lu: wrong result\n",
+						(unsigned long)size, (unsigned long)n, (unsigned long)offset);
+					return 0;
+				}
+
+				// in place
+				memcpy(out, in, bytes);
+				impl->bswap(out, out, n, size);
+				if (memcmp(out, expected, bytes) != 0) {
+					printf("bswap in place: size=%lu, n=%lu, offset=%lu: wrong result\n",
+						(unsigned long)size, (unsigned long)n, (unsigned long)offset);
+					return 0;
+				}
+			}
+		}
+	}
+
+	if (impl->reverse_copy(input, result, 1, 3) != -1 || impl->reverse_inplace(input, 1, 32) != -1) {
+		puts("invalid size not rejected");
+		return 0;
+	}
+
+	return 1;
+}
+//---------------------------------------------------------------------------
+
+int main() {
+	size_t i;
+	int ok = 1;
+
+	for (i=0; i < MAX_BYTES; i++)
+		input[i] = rand();
+
+	for (i=0; implementations[i].name; i++) {
+		if (!cpu_has(implementations[i].required))
+			continue;
+
+		printf("%-10s... ", implementations[i].name);
+		fflush(stdout);
+		if (verify(&implementations[i]))
+			puts("OK");
+		else {
+			puts("FAILED");
+			ok = 0;
+		}
+	}
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+//---------------------------------------------------------------------------
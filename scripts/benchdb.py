@@ -0,0 +1,678 @@
+#!/usr/bin/env python
+"""
+Database of benchmark results
+
+Runs are imported from records written by common/bench.h (JSON lines or
+CSV, BENCH_FORMAT=json|csv) and stored in an SQLite file.  Each record is
+normalized to one schema:
+
+    kernel, isa, size           -- from fields of the same names, or split
+                                   from the name "kernel/isa/size"
+    ns/op, cycles/op, GB/s      -- median time, cycles (core cycles if the
+                                   counter was available, TSC ticks otherwise)
+    instructions, branch-misses, L1D misses per operation
+    cpu, compiler
+
+Two runs are compared key by key (kernel, isa, size); a change is reported
+when it's larger than the threshold *and* significant: with at least four
+records for a key on both sides (a program run several times with the same
+BENCH_OUTPUT) the Mann-Whitney U test is used, otherwise a z-test on medians
+and MADs of single records (the median ones), which sees only the noise
+within a run.
+
+    $ BENCH_FORMAT=json BENCH_OUTPUT=before.json ./benchmark
+    $ scripts/benchdb.py add before.json --label before
+    $ ... change the code ...
+    $ BENCH_FORMAT=json ./benchmark | scripts/benchdb.py add - --label after
+    $ scripts/benchdb.py compare before after --threshold 3
+
+Command compare exits with status 1 when there are regressions.  The
+database file is benchmarks.db, or $BENCHDB, or --db.
+"""
+
+from __future__ import print_function, division
+
+import os
+import sys
+import csv
+import json
+import math
+import sqlite3
+import argparse
+import platform
+import datetime
+import itertools
+import subprocess
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+from table import Table
+from utils import unicode_bar
+
+
+SCHEMA = """
+create table if not exists runs (
+    id          integer primary key,
+    label       text,
+    date        text,
+    git         text,
+    host        text,
+    cpu         text,
+    compiler    text,
+    source      text
+);
+
+create table if not exists results (
+    run             integer references runs(id),
+    name            text,
+    kernel          text,
+    isa             text,
+    size            integer,
+    repeat          integer,
+    ops             real,
+    min_ns          real,
+    median_ns       real,
+    mad_ns          real,
+    cycles          real,
+    cycles_source   text,
+    instructions    real,
+    branch_misses   real,
+    l1d_misses      real,
+    gb_s            real,
+    cpu             text,
+    compiler        text
+);
+"""
+
+RESULT_COLUMNS = ('name', 'kernel', 'isa', 'size', 'repeat', 'ops',
+                  'min_ns', 'median_ns', 'mad_ns', 'cycles', 'cycles_source',
+                  'instructions', 'branch_misses', 'l1d_misses', 'gb_s',
+                  'cpu', 'compiler')
+
+
+class Error(Exception):
+    pass
+
+
+# input ------------------------------------------------------------------------
+
+def split_name(name):
+    """kernel/isa/size -> (kernel, isa, size); isa and size are optional"""
+
+    parts = name.split('/')
+    size  = None
+    isa   = ''
+
+    if len(parts) > 1 and parts[-1].isdigit():
+        size = int(parts.pop())
+
+    if len(parts) > 1:
+        isa = parts.pop()
+
+    return '/'.join(parts), isa, size
+
+
+def number(value):
+    if value is None or value == '':
+        return None
+
+    return float(value)
+
+
+def normalize(record):
+
+    name = record['name']
+    kernel, isa, size = split_name(name)
+
+    result = {
+        'name'          : name,
+        'kernel'        : record.get('kernel', kernel),
+        'isa'           : record.get('isa', isa),
+        'size'          : record.get('size', size),
+        'repeat'        : int(record.get('repeat') or 1),
+        'ops'           : number(record.get('ops')),
+        'min_ns'        : number(record.get('min_ns')),
+        'median_ns'     : number(record['median_ns']),
+        'mad_ns'        : number(record.get('mad_ns')) or 0.0,
+        'instructions'  : number(record.get('instructions')),
+        'branch_misses' : number(record.get('branch_misses')),
+        'l1d_misses'    : number(record.get('l1d_misses')),
+        'gb_s'          : number(record.get('gb_s')),
+        'cpu'           : record.get('cpu') or '',
+        'compiler'      : record.get('compiler') or '',
+    }
+
+    if result['size'] is not None:
+        result['size'] = int(result['size'])
+
+    cycles = number(record.get('cycles'))
+    if cycles is not None:
+        result['cycles'] = cycles
+        result['cycles_source'] = 'pmu'
+    else:
+        result['cycles'] = number(record.get('tsc'))
+        result['cycles_source'] = 'tsc'
+
+    return result
+
+
+def read_records(file):
+    """JSON lines or CSV; other lines (programs print their own messages) are skipped"""
+
+    lines  = file.read().splitlines()
+    header = None
+    rows   = []
+
+    for line in lines:
+        line = line.strip()
+        if line.startswith('{'):
+            try:
+                rows.append(json.loads(line))
+            except ValueError:
+                pass
+        elif line.startswith('name,'):
+            header = next(csv.reader([line]))
+        elif header is not None and line.startswith('"'):
+            values = next(csv.reader([line]))
+            if len(values) == len(header):
+                rows.append(dict(zip(header, values)))
+
+    return [normalize(row) for row in rows if 'name' in row and 'median_ns' in row]
+
+
+def git_revision():
+    try:
+        with open(os.devnull, 'w') as null:
+            rev = subprocess.check_output(['git', 'rev-parse', '--short', 'HEAD'], stderr=null)
+            rev = rev.decode().strip()
+            if subprocess.call(['git', 'diff', '--quiet', 'HEAD'], stderr=null) != 0:
+                rev += '-dirty'
+
+            return rev
+    except (OSError, subprocess.CalledProcessError):
+        return ''
+
+
+# database ---------------------------------------------------------------------
+
+class Database(object):
+
+    def __init__(self, path):
+        self.connection = sqlite3.connect(path)
+        self.connection.row_factory = sqlite3.Row
+        self.connection.executescript(SCHEMA)
+
+
+    def add_run(self, label, source, records):
+
+        first = records[0]
+        cursor = self.connection.execute(
+            'insert into runs (label, date, git, host, cpu, compiler, source) values (?, ?, ?, ?, ?, ?, ?)',
+            (label,
+             datetime.datetime.now().strftime('%Y-%m-%d %H:%M:%S'),
+             git_revision(),
+             platform.node(),
+             first['cpu'],
+             first['compiler'],
+             source))
+
+        run = cursor.lastrowid
+        query = 'insert into results (run, %s) values (?%s)' % (', '.join(RESULT_COLUMNS), ', ?' * len(RESULT_COLUMNS))
+        for record in records:
+            self.connection.execute(query, [run] + [record[c] for c in RESULT_COLUMNS])
+
+        self.connection.commit()
+
+        return run
+
+
+    def remove_run(self, run):
+        self.connection.execute('delete from results where run = ?', (run,))
+        self.connection.execute('delete from runs where id = ?', (run,))
+        self.connection.commit()
+
+
+    def runs(self):
+        return self.connection.execute(
+            'select runs.*, count(results.run) as count from runs left join results on results.run = runs.id '
+            'group by runs.id order by runs.id').fetchall()
+
+
+    def run(self, ref):
+        """run id, label (the latest run with it), 'last' or 'last~N'"""
+
+        if ref.isdigit():
+            row = self.connection.execute('select * from runs where id = ?', (int(ref),)).fetchone()
+        elif ref == 'last' or ref.startswith('last~'):
+            skip = int(ref[5:] or 0) if ref != 'last' else 0
+            row = self.connection.execute('select * from runs order by id desc limit 1 offset ?', (skip,)).fetchone()
+        else:
+            row = self.connection.execute('select * from runs where label = ? order by id desc', (ref,)).fetchone()
+
+        if row is None:
+            raise Error("run '%s' not found" % ref)
+
+        return row
+
+
+    def results(self, run, pattern=None):
+        query = 'select * from results where run = ?'
+        args  = [run]
+        if pattern:
+            query += ' and name like ?'
+            args.append('%' + pattern + '%')
+
+        return self.connection.execute(query + ' order by rowid', args).fetchall()
+
+
+# statistics -------------------------------------------------------------------
+
+def median(values):
+    values = sorted(values)
+    n = len(values)
+    if n % 2:
+        return values[n//2]
+
+    return (values[n//2 - 1] + values[n//2]) / 2
+
+
+def median_record(rows):
+    return sorted(rows, key=lambda r: r['median_ns'])[(len(rows) - 1)//2]
+
+
+def normal_p_value(z):
+    """two-sided"""
+    return math.erfc(abs(z) / math.sqrt(2))
+
+
+def mann_whitney(a, b):
+    """two-sided p-value; exact for small samples, normal approximation otherwise"""
+
+    def u_statistic(x, y):
+        u = 0.0
+        for xi in x:
+            for yi in y:
+                if xi < yi:
+                    u += 1
+                elif xi == yi:
+                    u += 0.5
+        return u
+
+    n1, n2 = len(a), len(b)
+    u  = u_statistic(a, b)
+    mu = n1 * n2 / 2
+
+    pooled = list(a) + list(b)
+    splits = math.factorial(n1 + n2) // (math.factorial(n1) * math.factorial(n2))
+    if splits <= 20000:
+        extreme = 0
+        for indices in itertools.combinations(range(n1 + n2), n1):
+            chosen = set(indices)
+            x = [pooled[i] for i in chosen]
+            y = [pooled[i] for i in range(n1 + n2) if i not in chosen]
+            if abs(u_statistic(x, y) - mu) >= abs(u - mu) - 1e-9:
+                extreme += 1
+
+        return extreme / splits
+
+    sigma = math.sqrt(n1 * n2 * (n1 + n2 + 1) / 12)
+    return normal_p_value((u - mu) / sigma)
+
+
+def median_z_test(a, b):
+    """single records: standard error of a median is ~1.2533 sigma/sqrt(n), sigma ~1.4826 MAD"""
+
+    def standard_error(r):
+        return 1.2533 * 1.4826 * r['mad_ns'] / math.sqrt(max(r['repeat'], 1))
+
+    se = math.sqrt(standard_error(a)**2 + standard_error(b)**2)
+    diff = b['median_ns'] - a['median_ns']
+    if se == 0:
+        return 0.0 if diff != 0 else 1.0
+
+    return normal_p_value(diff / se)
+
+
+class Comparison(object):
+
+    def __init__(self, key, base, new, threshold, alpha):
+        self.key  = key
+        self.base = median([r['median_ns'] for r in base])
+        self.new  = median([r['median_ns'] for r in new])
+
+        # with three records the smallest possible p-value of U is 0.1
+        if len(base) >= 4 and len(new) >= 4:
+            self.test = 'U'
+            self.p = mann_whitney([r['median_ns'] for r in base], [r['median_ns'] for r in new])
+        else:
+            self.test = 'z'
+            self.p = median_z_test(median_record(base), median_record(new))
+
+        self.change = 100.0 * (self.new / self.base - 1) if self.base > 0 else 0.0
+
+        significant = self.p < alpha
+        if significant and self.change > threshold:
+            self.verdict = 'REGRESSION'
+        elif significant and self.change < -threshold:
+            self.verdict = 'improvement'
+        else:
+            self.verdict = '~'
+
+
+def group_by_key(rows):
+    groups = {}
+    order  = []
+    for row in rows:
+        key = (row['kernel'], row['isa'], row['size'])
+        if key not in groups:
+            groups[key] = []
+            order.append(key)
+        groups[key].append(row)
+
+    return order, groups
+
+
+# rendering --------------------------------------------------------------------
+
+def fmt(value, format='%0.3f'):
+    if value is None:
+        return '-'
+
+    return format % value
+
+
+def size_image(size):
+    return '' if size is None else str(size)
+
+
+def render_run(run, rows):
+
+    print('Run %d (%s), %s, git %s, %s' % (run['id'], run['label'], run['date'], run['git'] or '-', run['host']))
+    print('%s, %s' % (run['cpu'] or 'unknown CPU', run['compiler'] or 'unknown compiler'))
+    print()
+
+    table = Table()
+    table.set_header(['kernel', 'isa', 'size', 'ns/op', 'MAD', 'cycles/op', 'GB/s', 'IPC', 'br-miss/op', 'L1D-miss/op'])
+
+    for row in rows:
+        ipc = None
+        if row['instructions'] is not None and row['cycles_source'] == 'pmu' and row['cycles']:
+            ipc = row['instructions'] / row['cycles']
+
+        cycles = fmt(row['cycles'], '%0.2f')
+        if row['cycles_source'] == 'tsc':
+            cycles += ' (tsc)'
+
+        table.add_row([
+            row['kernel'],
+            row['isa'],
+            size_image(row['size']),
+            fmt(row['median_ns']),
+            fmt(100.0 * row['mad_ns'] / row['median_ns'] if row['median_ns'] else None, '%0.1f%%'),
+            cycles,
+            fmt(row['gb_s'], '%0.2f'),
+            fmt(ipc, '%0.2f'),
+            fmt(row['branch_misses']),
+            fmt(row['l1d_misses']),
+        ])
+
+    print(table)
+
+
+def render_comparison(comparisons):
+
+    table = Table()
+    table.set_header(['kernel', 'isa', 'size', 'base ns/op', 'new ns/op', 'change', 'p', 'verdict'])
+
+    for c in comparisons:
+        kernel, isa, size = c.key
+        table.add_row([
+            kernel,
+            isa,
+            size_image(size),
+            fmt(c.base),
+            fmt(c.new),
+            '%+0.1f%%' % c.change,
+            '%0.3f (%s)' % (c.p, c.test),
+            c.verdict,
+        ])
+
+    print(table)
+
+
+METRICS = {
+    'ns'     : ('median_ns', 'ns/op'),
+    'cycles' : ('cycles', 'cycles/op'),
+    'gb_s'   : ('gb_s', 'GB/s'),
+}
+
+
+def plot_text(series, metric):
+    """bars in the terminal, when matplotlib is not available"""
+
+    column, unit = METRICS[metric]
+    values = [row[column] for _, rows in series for row in rows if row[column] is not None]
+    if not values:
+        raise Error('no values of %s' % unit)
+
+    scale = 40.0 / max(values)
+    for label, rows in series:
+        print(label)
+        for row in rows:
+            if row[column] is None:
+                continue
+            print('  %-10s %10.3f %s %s' % (size_image(row['size']) or row['name'], row[column], unit,
+                                            unicode_bar(row[column] * scale)))
+
+
+def plot_image(series, metric, output):
+
+    import matplotlib
+    matplotlib.use('Agg')
+    import matplotlib.pyplot as plt
+
+    column, unit = METRICS[metric]
+    figure, axes = plt.subplots()
+
+    by_size = all(row['size'] for _, rows in series for row in rows)
+    for index, (label, rows) in enumerate(series):
+        rows = [row for row in rows if row[column] is not None]
+        if by_size:
+            rows.sort(key=lambda row: row['size'])
+            axes.plot([r['size'] for r in rows], [r[column] for r in rows], marker='o', label=label)
+        else:
+            width = 0.8 / len(series)
+            axes.bar([i + index * width for i in range(len(rows))], [r[column] for r in rows], width, label=label)
+            axes.set_xticks(range(len(rows)))
+            axes.set_xticklabels([r['name'] for r in rows], rotation=45, ha='right')
+
+    if by_size:
+        axes.set_xscale('log', base=2)
+        axes.set_xlabel('size')
+
+    axes.set_ylabel(unit)
+    axes.legend()
+    figure.tight_layout()
+    figure.savefig(output)
+
+
+# commands ---------------------------------------------------------------------
+
+def command_add(db, args):
+
+    records = []
+    for path in args.files:
+        if path == '-':
+            records.extend(read_records(sys.stdin))
+        else:
+            with open(path) as f:
+                records.extend(read_records(f))
+
+    if not records:
+        raise Error('no benchmark records found')
+
+    label = args.label or os.path.basename(args.files[0])
+    run = db.add_run(label, ' '.join(args.files), records)
+    print('run %d: %d results' % (run, len(records)))
+
+
+def command_runs(db, args):
+
+    table = Table()
+    table.set_header(['id', 'label', 'date', 'git', 'results', 'cpu', 'compiler'])
+    for run in db.runs():
+        table.add_row([str(run['id']), run['label'], run['date'], run['git'] or '-',
+                       str(run['count']), run['cpu'] or '-', run['compiler'] or '-'])
+
+    print(table)
+
+
+def command_show(db, args):
+    run = db.run(args.run)
+    render_run(run, db.results(run['id'], args.filter))
+
+
+def command_remove(db, args):
+    run = db.run(args.run)
+    db.remove_run(run['id'])
+
+
+def command_compare(db, args):
+
+    base = db.run(args.base)
+    new  = db.run(args.new)
+
+    base_order, base_groups = group_by_key(db.results(base['id'], args.filter))
+    _,          new_groups  = group_by_key(db.results(new['id'], args.filter))
+
+    print('base: run %d (%s), git %s, %s' % (base['id'], base['label'], base['git'] or '-', base['cpu']))
+    print('new:  run %d (%s), git %s, %s' % (new['id'], new['label'], new['git'] or '-', new['cpu']))
+    if base['cpu'] != new['cpu'] or base['compiler'] != new['compiler']:
+        print('warning: runs come from different CPUs or compilers')
+    print()
+
+    comparisons = []
+    for key in base_order:
+        if key in new_groups:
+            comparisons.append(Comparison(key, base_groups[key], new_groups[key], args.threshold, args.alpha))
+
+    missing = [key for key in base_order if key not in new_groups]
+
+    render_comparison(comparisons)
+
+    regressions  = sum(1 for c in comparisons if c.verdict == 'REGRESSION')
+    improvements = sum(1 for c in comparisons if c.verdict == 'improvement')
+    print()
+    print('%d compared, %d regressions, %d improvements (threshold %0.1f%%, alpha %0.3f), %d missing in new run'
+          % (len(comparisons), regressions, improvements, args.threshold, args.alpha, len(missing)))
+
+    return 1 if regressions else 0
+
+
+def merge(rows):
+    """records of the same key (repeated runs of a program): medians of metrics"""
+
+    if len(rows) == 1:
+        return rows[0]
+
+    merged = dict(rows[0])
+    for column, _ in METRICS.values():
+        values = [r[column] for r in rows if r[column] is not None]
+        merged[column] = median(values) if values else None
+
+    return merged
+
+
+def command_plot(db, args):
+
+    series = []
+    for ref in args.runs:
+        run = db.run(ref)
+        order, groups = group_by_key(db.results(run['id'], args.filter))
+
+        # a series is a run and an ISA of a kernel, points are sizes
+        lines = {}
+        names = []
+        for key in order:
+            kernel, isa, _ = key
+            label = '%s %s' % (kernel, isa) if isa else kernel
+            if len(args.runs) > 1:
+                label = '%s: %s' % (run['label'], label)
+            if label not in lines:
+                lines[label] = []
+                names.append(label)
+
+            lines[label].append(merge(groups[key]))
+
+        series.extend((name, lines[name]) for name in names)
+
+    if not series:
+        raise Error('nothing to plot')
+
+    if args.output:
+        try:
+            plot_image(series, args.metric, args.output)
+            return
+        except ImportError:
+            print('matplotlib not available, printing bars', file=sys.stderr)
+
+    plot_text(series, args.metric)
+
+
+def main():
+
+    parser = argparse.ArgumentParser(description='Database of benchmark results (common/bench.h records)')
+    parser.add_argument('--db', default=os.environ.get('BENCHDB', 'benchmarks.db'),
+                        help='SQLite file (default: $BENCHDB or benchmarks.db)')
+    commands = parser.add_subparsers(dest='command')
+
+    p = commands.add_parser('add', help='import results (JSON lines or CSV, - is stdin)')
+    p.add_argument('files', nargs='+')
+    p.add_argument('--label', help='name of the run (default: the file name)')
+
+    commands.add_parser('runs', help='list runs')
+
+    p = commands.add_parser('show', help='table of a run')
+    p.add_argument('run', help='id, label, last or last~N')
+    p.add_argument('--filter', help='substring of benchmark names')
+
+    p = commands.add_parser('remove', help='delete a run')
+    p.add_argument('run')
+
+    p = commands.add_parser('compare', help='compare two runs, exit status 1 on regressions')
+    p.add_argument('base')
+    p.add_argument('new')
+    p.add_argument('--threshold', type=float, default=5.0, help='minimum change in percents (default: 5)')
+    p.add_argument('--alpha', type=float, default=0.05, help='significance level (default: 0.05)')
+    p.add_argument('--filter')
+
+    p = commands.add_parser('plot', help='plot a metric against size (PNG with matplotlib, text bars otherwise)')
+    p.add_argument('runs', nargs='+')
+    p.add_argument('--metric', choices=sorted(METRICS), default='cycles')
+    p.add_argument('--output', help='image file')
+    p.add_argument('--filter')
+
+    args = parser.parse_args()
+    if args.command is None:
+        parser.print_help()
+        return 2
+
+    db = Database(args.db)
+    handlers = {
+        'add'     : command_add,
+        'runs'    : command_runs,
+        'show'    : command_show,
+        'remove'  : command_remove,
+        'compare' : command_compare,
+        'plot'    : command_plot,
+    }
+
+    try:
+        return handlers[args.command](db, args) or 0
+    except Error as e:
+        print('error: %s' % e, file=sys.stderr)
+        return 2
+
+
+if __name__ == '__main__':
+    sys.exit(main())
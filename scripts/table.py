@@ -105,5 +105,5 @@ if __name__ == '__main__':
     table.add_row(["bar", "105", "1.5"])
     table.add_row(["baz", "111", "0.2"])
 
-    print table
+    print(table)
 
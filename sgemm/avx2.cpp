@@ -0,0 +1,60 @@
+// Micro-kernel 6x16, AVX2 + FMA
+//
+// The same broadcast-multiply-add scheme as in SSE kernel, but a row of B
+// spans two ymm registers and there are six broadcasted A values, i.e.
+// twelve accumulators + two B rows + one broadcast = 15 of 16 registers.
+struct KernelAVX2 {
+
+    static const size_t MR = 6;
+    static const size_t NR = 16;
+
+    static const size_t MC = 144;
+    static const size_t KC = 256;
+    static const size_t NC = 4096;
+
+    static const char* name() {
+        return "AVX2 6x16";
+    }
+
+    static void kernel(size_t kc, const float* a, const float* b, float* C, size_t ldc, bool accumulate) {
+
+        __m256 c[MR][2];
+        if (accumulate) {
+            for (size_t i=0; i < MR; i++) {
+                c[i][0] = _mm256_loadu_ps(C + i*ldc + 0);
+                c[i][1] = _mm256_loadu_ps(C + i*ldc + 8);
+            }
+        } else {
+            for (size_t i=0; i < MR; i++) {
+                c[i][0] = _mm256_setzero_ps();
+                c[i][1] = _mm256_setzero_ps();
+            }
+        }
+
+        for (size_t k=0; k < kc; k++) {
+            const __m256 b0 = _mm256_load_ps(b + 0);
+            const __m256 b1 = _mm256_load_ps(b + 8);
+
+#define STEP(i) { \
+            const __m256 t = _mm256_broadcast_ss(a + i); \
+            c[i][0] = _mm256_fmadd_ps(t, b0, c[i][0]); \
+            c[i][1] = _mm256_fmadd_ps(t, b1, c[i][1]); \
+        }
+            STEP(0);
+            STEP(1);
+            STEP(2);
+            STEP(3);
+            STEP(4);
+            STEP(5);
+#undef STEP
+
+            a += MR;
+            b += NR;
+        }
+
+        for (size_t i=0; i < MR; i++) {
+            _mm256_storeu_ps(C + i*ldc + 0, c[i][0]);
+            _mm256_storeu_ps(C + i*ldc + 8, c[i][1]);
+        }
+    }
+};
@@ -0,0 +1,66 @@
+// Micro-kernel 12x32, AVX512F
+//
+// With 32 zmm registers the tile can be much larger than in AVX2: a row
+// of B spans two registers and twelve A values are broadcasted, i.e.
+// 24 accumulators + two B rows + one broadcast.
+struct KernelAVX512 {
+
+    static const size_t MR = 12;
+    static const size_t NR = 32;
+
+    static const size_t MC = 192;
+    static const size_t KC = 384;
+    static const size_t NC = 4096;
+
+    static const char* name() {
+        return "AVX512F 12x32";
+    }
+
+    static void kernel(size_t kc, const float* a, const float* b, float* C, size_t ldc, bool accumulate) {
+
+        __m512 c[MR][2];
+        if (accumulate) {
+            for (size_t i=0; i < MR; i++) {
+                c[i][0] = _mm512_loadu_ps(C + i*ldc + 0);
+                c[i][1] = _mm512_loadu_ps(C + i*ldc + 16);
+            }
+        } else {
+            for (size_t i=0; i < MR; i++) {
+                c[i][0] = _mm512_setzero_ps();
+                c[i][1] = _mm512_setzero_ps();
+            }
+        }
+
+        for (size_t k=0; k < kc; k++) {
+            const __m512 b0 = _mm512_load_ps(b + 0);
+            const __m512 b1 = _mm512_load_ps(b + 16);
+
+#define STEP(i) { \
+            const __m512 t = _mm512_set1_ps(a[i]); \
+            c[i][0] = _mm512_fmadd_ps(t, b0, c[i][0]); \
+            c[i][1] = _mm512_fmadd_ps(t, b1, c[i][1]); \
+        }
+            STEP(0);
+            STEP(1);
+            STEP(2);
+            STEP(3);
+            STEP(4);
+            STEP(5);
+            STEP(6);
+            STEP(7);
+            STEP(8);
+            STEP(9);
+            STEP(10);
+            STEP(11);
+#undef STEP
+
+            a += MR;
+            b += NR;
+        }
+
+        for (size_t i=0; i < MR; i++) {
+            _mm512_storeu_ps(C + i*ldc + 0,  c[i][0]);
+            _mm512_storeu_ps(C + i*ldc + 16, c[i][1]);
+        }
+    }
+};
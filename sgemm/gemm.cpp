@@ -0,0 +1,218 @@
+// Cache-blocked GEMM: C = A * B, all matrices are row-major
+//
+// The driver follows the well known Goto/BLIS scheme:
+//
+//  for jc in 0..N step NC                  -- NC columns of B and C
+//      for pc in 0..K step KC              -- KC x NC panel of B is packed (L3)
+//          for ic in 0..M step MC          -- MC x KC block of A is packed (L2)
+//              for jr in 0..NC step NR     -- KC x NR sliver of B stays in L1
+//                  for ir in 0..MC step MR
+//                      micro-kernel: MR x NR tile of C += sliver A * sliver B
+//
+// A micro-kernel is a class (see sse.cpp, avx2.cpp, avx512.cpp) that
+// defines register tile size MR x NR, block sizes MC, KC, NC and
+// the static function kernel.
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+float* gemm_alloc(size_t count) {
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, 64, count * sizeof(float)) != 0) {
+        throw std::bad_alloc();
+    }
+
+    return reinterpret_cast<float*>(ptr);
+}
+
+
+// Packs mc x kc block of A into row panels of height MR; within
+// a panel values are stored column by column, so the micro-kernel
+// reads MR consecutive floats for each k.  Missing rows are zeroed.
+template <size_t MR>
+void pack_A(size_t mc, size_t kc, const float* A, size_t lda, float* out) {
+
+    for (size_t i=0; i < mc; i += MR) {
+        const size_t rows = std::min(MR, mc - i);
+        for (size_t k=0; k < kc; k++) {
+            size_t r = 0;
+            for (/**/; r < rows; r++) {
+                *out++ = A[(i + r)*lda + k];
+            }
+            for (/**/; r < MR; r++) {
+                *out++ = 0.0f;
+            }
+        }
+    }
+}
+
+
+// Packs kc x nc panel of B into column slivers of width NR; within
+// a sliver values are stored row by row.  Missing columns are zeroed.
+template <size_t NR>
+void pack_B(size_t kc, size_t nc, const float* B, size_t ldb, float* out) {
+
+    for (size_t j=0; j < nc; j += NR) {
+        const size_t cols = std::min(NR, nc - j);
+        for (size_t k=0; k < kc; k++) {
+            const float* row = B + k*ldb + j;
+            size_t c = 0;
+            for (/**/; c < cols; c++) {
+                *out++ = row[c];
+            }
+            for (/**/; c < NR; c++) {
+                *out++ = 0.0f;
+            }
+        }
+    }
+}
+
+
+template <typename Kernel>
+void macro_kernel(size_t mc, size_t nc, size_t kc,
+                  const float* packedA, const float* packedB,
+                  float* C, size_t ldc, bool accumulate) {
+
+    const size_t MR = Kernel::MR;
+    const size_t NR = Kernel::NR;
+
+    alignas(64) float tile[MR * NR];
+
+    for (size_t jr=0; jr < nc; jr += NR) {
+        const size_t cols = std::min(NR, nc - jr);
+        const float* b = packedB + jr*kc;
+
+        for (size_t ir=0; ir < mc; ir += MR) {
+            const size_t rows = std::min(MR, mc - ir);
+            const float* a = packedA + ir*kc;
+            float* c = C + ir*ldc + jr;
+
+            if (rows == MR && cols == NR) {
+                Kernel::kernel(kc, a, b, c, ldc, accumulate);
+                continue;
+            }
+
+            // partial tile at the right or bottom edge of C
+            Kernel::kernel(kc, a, b, tile, NR, false);
+            for (size_t i=0; i < rows; i++) {
+                for (size_t j=0; j < cols; j++) {
+                    if (accumulate) {
+                        c[i*ldc + j] += tile[i*NR + j];
+                    } else {
+                        c[i*ldc + j] = tile[i*NR + j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+template <typename Kernel>
+class GEMM {
+
+    const size_t MR = Kernel::MR;
+    const size_t NR = Kernel::NR;
+    const size_t MC = Kernel::MC;
+    const size_t KC = Kernel::KC;
+    const size_t NC = Kernel::NC;
+
+    float* packedA;
+    float* packedB;
+
+public:
+    GEMM() {
+        packedA = gemm_alloc(MC * KC);
+        packedB = gemm_alloc(KC * ((NC + NR - 1)/NR) * NR);
+    }
+
+    ~GEMM() {
+        free(packedA);
+        free(packedB);
+    }
+
+    void run(size_t M, size_t N, size_t K,
+             const float* A, size_t lda,
+             const float* B, size_t ldb,
+             float* C, size_t ldc) {
+
+        if (K == 0) {
+            for (size_t i=0; i < M; i++) {
+                memset(C + i*ldc, 0, N * sizeof(float));
+            }
+            return;
+        }
+
+        for (size_t jc=0; jc < N; jc += NC) {
+            const size_t nc = std::min(NC, N - jc);
+
+            for (size_t pc=0; pc < K; pc += KC) {
+                const size_t kc = std::min(KC, K - pc);
+                pack_B<Kernel::NR>(kc, nc, B + pc*ldb + jc, ldb, packedB);
+
+                for (size_t ic=0; ic < M; ic += MC) {
+                    const size_t mc = std::min(MC, M - ic);
+                    pack_A<Kernel::MR>(mc, kc, A + ic*lda + pc, lda, packedA);
+
+                    macro_kernel<Kernel>(mc, nc, kc, packedA, packedB,
+                                         C + ic*ldc + jc, ldc, pc > 0);
+                }
+            }
+        }
+    }
+};
+
+
+template <typename Kernel>
+void sgemm(size_t M, size_t N, size_t K,
+           const float* A, size_t lda,
+           const float* B, size_t ldb,
+           float* C, size_t ldc) {
+
+    GEMM<Kernel> gemm;
+    gemm.run(M, N, K, A, lda, B, ldb, C, ldc);
+}
+
+
+// Multithreaded version: rows of A and C are split into contiguous
+// slabs (multiples of MR), each thread runs the whole blocked algorithm
+// on its slab with private packing buffers.  Panels of B are packed
+// independently by each thread, it costs K*N per thread, which is
+// negligible when M/threads is large enough.
+template <typename Kernel>
+void sgemm_threaded(size_t M, size_t N, size_t K,
+                    const float* A, size_t lda,
+                    const float* B, size_t ldb,
+                    float* C, size_t ldc,
+                    unsigned threads) {
+
+    const size_t MR = Kernel::MR;
+    const size_t tiles = (M + MR - 1) / MR;
+    if (threads > tiles) {
+        threads = tiles;
+    }
+
+    if (threads <= 1) {
+        sgemm<Kernel>(M, N, K, A, lda, B, ldb, C, ldc);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    size_t start = 0;
+    for (unsigned t=0; t < threads; t++) {
+        const size_t count = (tiles / threads + (t < tiles % threads)) * MR;
+        const size_t rows  = std::min(count, M - start);
+
+        workers.emplace_back(sgemm<Kernel>, rows, N, K,
+                             A + start*lda, lda,
+                             B, ldb,
+                             C + start*ldc, ldc);
+        start += rows;
+    }
+
+    for (auto& w: workers) {
+        w.join();
+    }
+}
@@ -0,0 +1,21 @@
+// Reference implementation: C = A * B, all matrices are row-major.
+//
+// The loop order is the same as in matmat_mult from sse/sse-matmult.c,
+// i.e. the textbook i-j-k triple loop.
+
+void sgemm_naive(size_t M, size_t N, size_t K,
+                 const float* A, size_t lda,
+                 const float* B, size_t ldb,
+                 float* C, size_t ldc) {
+
+    for (size_t i=0; i < M; i++) {
+        for (size_t j=0; j < N; j++) {
+            float sum = 0.0f;
+            for (size_t k=0; k < K; k++) {
+                sum += A[i*lda + k] * B[k*ldb + j];
+            }
+
+            C[i*ldc + j] = sum;
+        }
+    }
+}
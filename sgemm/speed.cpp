@@ -0,0 +1,98 @@
+#include "../common/bufalloc.h"
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <thread>
+
+#include "gettime.cpp"
+#include "all.cpp"
+
+
+class Test {
+
+    const size_t n;
+    buf_array<float> A;
+    buf_array<float> B;
+    buf_array<float> C;
+
+public:
+    Test(size_t size) : n(size), A(size*size), B(size*size), C(size*size) {
+        for (auto& x: A) x = rand()/float(RAND_MAX);
+        for (auto& x: B) x = rand()/float(RAND_MAX);
+    }
+
+    template <typename FUNCTION>
+    void measure(const char* name, FUNCTION fun) {
+
+        printf("%-28s... ", name); fflush(stdout);
+
+        // repeat small problems, so each measurement takes a while
+        const double flops = 2.0 * n * n * n;
+        const int repeat = std::max(1, int(1e9 / flops));
+
+        double best = 1e100;
+        for (int i=0; i < 3; i++) {
+            const double t1 = get_time();
+            for (int r=0; r < repeat; r++) {
+                fun(n, n, n, A.data(), n, B.data(), n, C.data(), n);
+            }
+            const double t2 = get_time();
+
+            best = std::min(best, (t2 - t1)/repeat);
+        }
+
+        printf("%8.3f ms %8.2f GFLOP/s\n", best * 1000.0, flops / best / 1e9);
+    }
+};
+
+
+unsigned threads = 1;
+
+template <typename Kernel>
+void threaded(size_t M, size_t N, size_t K,
+              const float* A, size_t lda,
+              const float* B, size_t ldb,
+              float* C, size_t ldc) {
+
+    sgemm_threaded<Kernel>(M, N, K, A, lda, B, ldb, C, ldc, threads);
+}
+
+
+int main(int argc, char* argv[]) {
+
+    // usage: speed [threads [size ...]]
+    threads = std::thread::hardware_concurrency();
+    if (argc > 1) {
+        threads = atoi(argv[1]);
+    }
+
+    std::vector<size_t> sizes;
+    for (int i=2; i < argc; i++) {
+        sizes.push_back(atoi(argv[i]));
+    }
+
+    if (sizes.empty()) {
+        sizes = {64, 128, 256, 512, 1024, 2048};
+    }
+
+    for (size_t n: sizes) {
+        printf("M = N = K = %lu, %u thread(s)\n", n, threads);
+
+        Test test(n);
+        if (n <= 512) {
+            test.measure("naive", sgemm_naive);
+        }
+
+        test.measure("SSE 4x8",                     sgemm<KernelSSE>);
+        test.measure("SSE 4x8 (threaded)",          threaded<KernelSSE>);
+#ifdef HAVE_AVX2_INSTRUCTIONS
+        test.measure("AVX2 6x16",                   sgemm<KernelAVX2>);
+        test.measure("AVX2 6x16 (threaded)",        threaded<KernelAVX2>);
+#endif
+#ifdef HAVE_AVX512_INSTRUCTIONS
+        test.measure("AVX512F 12x32",               sgemm<KernelAVX512>);
+        test.measure("AVX512F 12x32 (threaded)",    threaded<KernelAVX512>);
+#endif
+    }
+}
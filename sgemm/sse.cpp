@@ -0,0 +1,68 @@
+// Micro-kernel 4x8 --- two side-by-side copies of the 4x4 block
+// from sse/sse-matmult.c.
+//
+// For each k a row of packed B (8 floats) is loaded into two registers,
+// then each of four A values is broadcasted (shufps $0 in the original
+// code) and multiplied by the row; products are accumulated in eight
+// registers holding the 4x8 tile of C.
+struct KernelSSE {
+
+    static const size_t MR = 4;
+    static const size_t NR = 8;
+
+    static const size_t MC = 128;
+    static const size_t KC = 256;
+    static const size_t NC = 2048;
+
+    static const char* name() {
+        return "SSE 4x8";
+    }
+
+    // a: packed MR x kc panel (MR values per k)
+    // b: packed kc x NR panel (NR values per k)
+    static void kernel(size_t kc, const float* a, const float* b, float* C, size_t ldc, bool accumulate) {
+
+        __m128 c00, c01, c10, c11, c20, c21, c30, c31;
+        if (accumulate) {
+            c00 = _mm_loadu_ps(C + 0*ldc + 0); c01 = _mm_loadu_ps(C + 0*ldc + 4);
+            c10 = _mm_loadu_ps(C + 1*ldc + 0); c11 = _mm_loadu_ps(C + 1*ldc + 4);
+            c20 = _mm_loadu_ps(C + 2*ldc + 0); c21 = _mm_loadu_ps(C + 2*ldc + 4);
+            c30 = _mm_loadu_ps(C + 3*ldc + 0); c31 = _mm_loadu_ps(C + 3*ldc + 4);
+        } else {
+            c00 = c01 = c10 = c11 = c20 = c21 = c30 = c31 = _mm_setzero_ps();
+        }
+
+        for (size_t k=0; k < kc; k++) {
+            const __m128 b0 = _mm_load_ps(b + 0);
+            const __m128 b1 = _mm_load_ps(b + 4);
+
+            // a = [Aa, Ab, Ac, Ad]
+            const __m128 av = _mm_load_ps(a);
+            __m128 t;
+
+            t = _mm_shuffle_ps(av, av, 0x00);
+            c00 = _mm_add_ps(c00, _mm_mul_ps(t, b0));
+            c01 = _mm_add_ps(c01, _mm_mul_ps(t, b1));
+
+            t = _mm_shuffle_ps(av, av, 0x55);
+            c10 = _mm_add_ps(c10, _mm_mul_ps(t, b0));
+            c11 = _mm_add_ps(c11, _mm_mul_ps(t, b1));
+
+            t = _mm_shuffle_ps(av, av, 0xaa);
+            c20 = _mm_add_ps(c20, _mm_mul_ps(t, b0));
+            c21 = _mm_add_ps(c21, _mm_mul_ps(t, b1));
+
+            t = _mm_shuffle_ps(av, av, 0xff);
+            c30 = _mm_add_ps(c30, _mm_mul_ps(t, b0));
+            c31 = _mm_add_ps(c31, _mm_mul_ps(t, b1));
+
+            a += MR;
+            b += NR;
+        }
+
+        _mm_storeu_ps(C + 0*ldc + 0, c00); _mm_storeu_ps(C + 0*ldc + 4, c01);
+        _mm_storeu_ps(C + 1*ldc + 0, c10); _mm_storeu_ps(C + 1*ldc + 4, c11);
+        _mm_storeu_ps(C + 2*ldc + 0, c20); _mm_storeu_ps(C + 2*ldc + 4, c21);
+        _mm_storeu_ps(C + 3*ldc + 0, c30); _mm_storeu_ps(C + 3*ldc + 4, c31);
+    }
+};
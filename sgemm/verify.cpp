@@ -0,0 +1,136 @@
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+
+#include "all.cpp"
+
+
+class Verify {
+
+    std::vector<float> A;
+    std::vector<float> B;
+    std::vector<float> ref;
+    std::vector<float> C;
+
+public:
+    template <typename FUNCTION>
+    bool run(FUNCTION fun) {
+
+        static const size_t sizes[][3] = {
+            {1, 1, 1},
+            {4, 4, 4},
+            {3, 5, 7},
+            {12, 32, 1},
+            {17, 33, 65},
+            {64, 64, 64},
+            {100, 1, 300},
+            {1, 100, 300},
+            {257, 129, 513},
+            {300, 600, 1000},
+        };
+
+        for (const auto& s: sizes) {
+            if (!check(fun, s[0], s[1], s[2])) {
+                printf("failed for M=%lu, N=%lu, K=%lu\n", s[0], s[1], s[2]);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    template <typename FUNCTION>
+    bool check(FUNCTION fun, size_t M, size_t N, size_t K) {
+
+        // leading dimensions are deliberately larger than matrix sizes
+        const size_t lda = K + 3;
+        const size_t ldb = N + 5;
+        const size_t ldc = N + 7;
+
+        A.resize(M * lda);
+        B.resize(K * ldb);
+        ref.assign(M * ldc, 0.0f);
+        C.assign(M * ldc, -1.0f);
+
+        for (auto& x: A) x = random_float();
+        for (auto& x: B) x = random_float();
+
+        sgemm_naive(M, N, K, A.data(), lda, B.data(), ldb, ref.data(), ldc);
+        fun(M, N, K, A.data(), lda, B.data(), ldb, C.data(), ldc);
+
+        for (size_t i=0; i < M; i++) {
+            for (size_t j=0; j < N; j++) {
+                const float r = ref[i*ldc + j];
+                const float c = C[i*ldc + j];
+                // the order of summation differs, allow error growing with K
+                const float eps = 1e-5f * K + 1e-5f;
+                if (std::fabs(r - c) > eps) {
+                    printf("C[%lu, %lu] = %f, expected %f\n", i, j, c, r);
+                    return false;
+                }
+            }
+
+            // padding must be untouched
+            for (size_t j=N; j < ldc; j++) {
+                if (C[i*ldc + j] != -1.0f) {
+                    printf("C[%lu, %lu] (padding) was overwritten\n", i, j);
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    float random_float() {
+        return rand()/float(RAND_MAX) - 0.5f;
+    }
+};
+
+
+template <typename Kernel>
+void threaded4(size_t M, size_t N, size_t K,
+               const float* A, size_t lda,
+               const float* B, size_t ldb,
+               float* C, size_t ldc) {
+
+    sgemm_threaded<Kernel>(M, N, K, A, lda, B, ldb, C, ldc, 4);
+}
+
+
+template <typename FUNCTION>
+bool test(const char* name, FUNCTION fun) {
+
+    printf("%s... ", name); fflush(stdout);
+
+    Verify verify;
+    if (verify.run(fun)) {
+        puts("OK");
+        return true;
+    } else {
+        puts("FAILED");
+        return false;
+    }
+}
+
+
+int main() {
+
+    bool ok = true;
+
+    ok = test("SSE 4x8", sgemm<KernelSSE>) && ok;
+    ok = test("SSE 4x8 (4 threads)", threaded4<KernelSSE>) && ok;
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    ok = test("AVX2 6x16", sgemm<KernelAVX2>) && ok;
+    ok = test("AVX2 6x16 (4 threads)", threaded4<KernelAVX2>) && ok;
+#endif
+#ifdef HAVE_AVX512_INSTRUCTIONS
+    ok = test("AVX512F 12x32", sgemm<KernelAVX512>) && ok;
+    ok = test("AVX512F 12x32 (4 threads)", threaded4<KernelAVX512>) && ok;
+#endif
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
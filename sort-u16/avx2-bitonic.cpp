@@ -0,0 +1,142 @@
+// Bitonic sorting networks for 16, 32 and 64 words kept in 1, 2 or 4
+// AVX2 registers.
+//
+// Element i lives in register i / 16, lane i % 16.  A compare-exchange
+// step at distance j pairs element i with i ^ j:
+//
+// * j >= 16 --- partners are in different registers, thus a step is
+//   just min/max of two registers (swapped for descending blocks);
+// * j = 8 --- partner is in the other 128-bit lane (vpermq);
+// * j = 1, 2, 4 --- partner is within the lane (vpshufb).
+//
+// In the latter cases both min and max are computed for all lanes and
+// a blend selects the proper one: lane i gets the max when it is
+// the upper element of a pair ((i & j) != 0) in an ascending block
+// ((i & k) == 0), or the lower element in a descending block.
+
+namespace bitonic {
+
+    class Masks {
+    public:
+        // [log2(k)][log2(j)][register][lane]
+        uint16_t take_max[7][4][4][16];
+
+        Masks() {
+            for (int lk=1; lk <= 6; lk++) {
+                for (int lj=0; lj < 4 && lj < lk; lj++) {
+                    for (int r=0; r < 4; r++) {
+                        uint16_t* m = take_max[lk][lj][r];
+                        for (int lane=0; lane < 16; lane++) {
+                            const int i = r*16 + lane;
+                            const bool upper = (i & (1 << lj)) != 0;
+                            const bool desc  = (i & (1 << lk)) != 0;
+                            m[lane] = (upper != desc) ? 0xffff : 0x0000;
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    const Masks masks;
+
+
+    FORCE_INLINE __m256i partner(const __m256i v, int lj) {
+        switch (lj) {
+            case 0: // swap adjacent words
+                return _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+                    2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                    2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13));
+            case 1: // swap pairs of words
+                return _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+            case 2: // swap quadruples of words
+                return _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+            default: // swap 128-bit lanes
+                return _mm256_permute4x64_epi64(v, _MM_SHUFFLE(1, 0, 3, 2));
+        }
+    }
+
+
+    template <int R>
+    FORCE_INLINE void step(__m256i (&v)[R], int lk, int lj) {
+
+        if (lj >= 4) {
+            // partners in different registers
+            const int d = 1 << (lj - 4);
+            for (int r=0; r < R; r++) {
+                if (r & d) {
+                    continue;
+                }
+
+                const __m256i lo = _mm256_min_epu16(v[r], v[r + d]);
+                const __m256i hi = _mm256_max_epu16(v[r], v[r + d]);
+                const bool desc = ((r*16) & (1 << lk)) != 0;
+                v[r]     = desc ? hi : lo;
+                v[r + d] = desc ? lo : hi;
+            }
+        } else {
+            for (int r=0; r < R; r++) {
+                const __m256i p  = partner(v[r], lj);
+                const __m256i lo = _mm256_min_epu16(v[r], p);
+                const __m256i hi = _mm256_max_epu16(v[r], p);
+                const __m256i m  = _mm256_loadu_si256((const __m256i*)masks.take_max[lk][lj][r]);
+                v[r] = _mm256_blendv_epi8(lo, hi, m);
+            }
+        }
+    }
+
+
+    // sorts 16*R words
+    template <int R>
+    FORCE_INLINE void sort(__m256i (&v)[R]) {
+
+        const int logn = (R == 1) ? 4 : (R == 2) ? 5 : 6;
+        for (int lk=1; lk <= logn; lk++) {
+            for (int lj=lk - 1; lj >= 0; lj--) {
+                step<R>(v, lk, lj);
+            }
+        }
+    }
+
+
+    template <int R>
+    void sort_array(uint16_t* array, size_t n) {
+
+        uint16_t tmp[16*R];
+        memcpy(tmp, array, n * sizeof(uint16_t));
+        for (size_t i=n; i < 16*R; i++) {
+            tmp[i] = 0xffff;
+        }
+
+        __m256i v[R];
+        for (int r=0; r < R; r++) {
+            v[r] = _mm256_loadu_si256((const __m256i*)(tmp + 16*r));
+        }
+
+        sort<R>(v);
+
+        for (int r=0; r < R; r++) {
+            _mm256_storeu_si256((__m256i*)(tmp + 16*r), v[r]);
+        }
+        memcpy(array, tmp, n * sizeof(uint16_t));
+    }
+
+} // namespace bitonic
+
+
+// n <= 16
+void sort_u16_bitonic16(uint16_t* array, size_t n) {
+    bitonic::sort_array<1>(array, n);
+}
+
+
+// n <= 32
+void sort_u16_bitonic32(uint16_t* array, size_t n) {
+    bitonic::sort_array<2>(array, n);
+}
+
+
+// n <= 64
+void sort_u16_bitonic64(uint16_t* array, size_t n) {
+    bitonic::sort_array<4>(array, n);
+}
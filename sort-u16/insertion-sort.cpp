@@ -0,0 +1,22 @@
+// https://rosettacode.org/wiki/Sorting_algorithms/Insertion_sort
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+
+template <typename RandomAccessIterator, typename Predicate>
+void insertion_sort(RandomAccessIterator begin, RandomAccessIterator end,
+                    Predicate p) {
+  for (auto i = begin; i != end; ++i) {
+    std::rotate(std::upper_bound(begin, i, *i, p), i, i + 1);
+  }
+}
+
+template <typename RandomAccessIterator>
+void insertion_sort(RandomAccessIterator begin, RandomAccessIterator end) {
+  insertion_sort(
+      begin, end,
+      std::less<
+          typename std::iterator_traits<RandomAccessIterator>::value_type>());
+}
+
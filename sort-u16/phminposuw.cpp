@@ -0,0 +1,43 @@
+// Selection sort of up to 8 elements with PHMINPOSUW (SSE4.1).
+//
+// The idea comes from sse/sse4-insertionsort.c: PHMINPOSUW returns the
+// minimum of eight words together with its index; the minimum is saved
+// and then its lane is set to 0xffff, so the next iteration finds the
+// next smallest value.  Unused lanes are filled with 0xffff as well,
+// it doesn't matter if the input contains 0xffff --- the value is
+// the same, no matter which lane it comes from.
+
+namespace phminposuw {
+
+    const uint16_t max_lane[8][8] __attribute__((aligned(16))) = {
+        {0xffff, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+        {0x0000, 0xffff, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+        {0x0000, 0x0000, 0xffff, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+        {0x0000, 0x0000, 0x0000, 0xffff, 0x0000, 0x0000, 0x0000, 0x0000},
+        {0x0000, 0x0000, 0x0000, 0x0000, 0xffff, 0x0000, 0x0000, 0x0000},
+        {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0xffff, 0x0000, 0x0000},
+        {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0xffff, 0x0000},
+        {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0xffff}
+    };
+
+} // namespace phminposuw
+
+
+// n <= 8
+void sort_u16_phminposuw(uint16_t* array, size_t n) {
+
+    uint16_t tmp[8] __attribute__((aligned(16))) = {
+        0xffff, 0xffff, 0xffff, 0xffff, 0xffff, 0xffff, 0xffff, 0xffff
+    };
+    memcpy(tmp, array, n * sizeof(uint16_t));
+
+    __m128i v = _mm_load_si128((const __m128i*)tmp);
+    for (size_t i=0; i < n; i++) {
+        const __m128i  res   = _mm_minpos_epu16(v);
+        const uint32_t word  = _mm_cvtsi128_si32(res);
+        const uint32_t index = (word >> 16) & 0x7;
+
+        array[i] = uint16_t(word);
+        v = _mm_or_si128(v, _mm_load_si128((const __m128i*)phminposuw::max_lane[index]));
+    }
+}
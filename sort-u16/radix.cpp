@@ -0,0 +1,56 @@
+// LSD radix sort with two 8-bit digits.
+//
+// Both histograms are collected in a single pass; a pass is skipped
+// when all values have the same digit (for instance all values are
+// less than 256), it's quite common for histograms and small codes.
+
+void sort_u16_radix(uint16_t* array, size_t n, uint16_t* tmp) {
+
+    if (n < 2) {
+        return;
+    }
+
+    uint32_t count[2][256];
+    memset(count, 0, sizeof(count));
+
+    for (size_t i=0; i < n; i++) {
+        count[0][array[i] & 0xff] += 1;
+        count[1][array[i] >> 8]   += 1;
+    }
+
+    uint16_t* src = array;
+    uint16_t* dst = tmp;
+    for (int digit=0; digit < 2; digit++) {
+        const int shift = 8 * digit;
+        uint32_t* c = count[digit];
+
+        if (c[(src[0] >> shift) & 0xff] == n) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (int i=0; i < 256; i++) {
+            const uint32_t k = c[i];
+            c[i] = offset;
+            offset += k;
+        }
+
+        for (size_t i=0; i < n; i++) {
+            const uint16_t x = src[i];
+            dst[c[(x >> shift) & 0xff]++] = x;
+        }
+
+        std::swap(src, dst);
+    }
+
+    if (src != array) {
+        memcpy(array, src, n * sizeof(uint16_t));
+    }
+}
+
+
+void sort_u16_radix(uint16_t* array, size_t n) {
+
+    std::vector<uint16_t> tmp(n);
+    sort_u16_radix(array, n, tmp.data());
+}
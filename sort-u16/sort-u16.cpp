@@ -0,0 +1,43 @@
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <immintrin.h>
+
+#define FORCE_INLINE inline __attribute__((always_inline))
+
+#include "phminposuw.cpp"
+#include "radix.cpp"
+
+#ifdef HAVE_AVX2_INSTRUCTIONS
+#   include "avx2-bitonic.cpp"
+#endif
+
+
+// Sorts array of uint16_t in ascending order, picking an algorithm
+// by the size of input:
+//
+// *    0 ..  8 --- selection with PHMINPOSUW,
+// *    9 .. 64 --- AVX2 bitonic networks (std::sort if AVX2 is not available),
+// *   65 ..    --- radix sort.
+void sort_u16(uint16_t* array, size_t n) {
+
+    if (n <= 8) {
+        sort_u16_phminposuw(array, n);
+    }
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    else if (n <= 16) {
+        sort_u16_bitonic16(array, n);
+    } else if (n <= 32) {
+        sort_u16_bitonic32(array, n);
+    } else if (n <= 64) {
+        sort_u16_bitonic64(array, n);
+    }
+#else
+    else if (n <= 64) {
+        std::sort(array, array + n);
+    }
+#endif
+    else {
+        sort_u16_radix(array, n);
+    }
+}
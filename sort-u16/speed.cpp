@@ -0,0 +1,87 @@
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+#include "gettime.cpp"
+#include "sort-u16.cpp"
+#include "insertion-sort.cpp"
+
+
+class Test {
+
+    const size_t n;
+    const size_t iterations;
+    std::vector<uint16_t> input;
+    std::vector<uint16_t> work;
+
+public:
+    Test(size_t n) : n(n), iterations(std::max(size_t(1), size_t(50*1000*1000) / n)) {
+        // a few different inputs, to not train the branch predictor
+        input.resize(16 * n);
+        for (auto& x: input) x = rand();
+        work.resize(n);
+    }
+
+    template <typename FUNCTION>
+    void measure(const char* name, FUNCTION fun) {
+
+        printf("%-24s... ", name); fflush(stdout);
+
+        const auto t1 = get_time();
+        for (size_t i=0; i < iterations; i++) {
+            memcpy(work.data(), input.data() + (i % 16)*n, n * sizeof(uint16_t));
+            fun(work.data(), n);
+        }
+        const auto t2 = get_time();
+
+        const double t = (t2 - t1)/1000000.0;
+        printf("%6.3f s (%5.2f ns/element)\n", t, t * 1e9 / (double(iterations) * n));
+    }
+};
+
+
+void test_std_sort(uint16_t* array, size_t n) {
+    std::sort(array, array + n);
+}
+
+
+void test_insertion(uint16_t* array, size_t n) {
+    insertion_sort(array, array + n);
+}
+
+
+void test_radix(uint16_t* array, size_t n) {
+    sort_u16_radix(array, n);
+}
+
+
+int main() {
+
+    for (size_t n: {8, 16, 32, 64}) {
+        printf("sorting %lu elements\n", n);
+        Test test(n);
+        test.measure("std::sort",               test_std_sort);
+        test.measure("insertion sort",          test_insertion);
+        if (n <= 8) {
+            test.measure("PHMINPOSUW",          sort_u16_phminposuw);
+        }
+#ifdef HAVE_AVX2_INSTRUCTIONS
+        else if (n <= 16) {
+            test.measure("AVX2 bitonic",        sort_u16_bitonic16);
+        } else if (n <= 32) {
+            test.measure("AVX2 bitonic",        sort_u16_bitonic32);
+        } else {
+            test.measure("AVX2 bitonic",        sort_u16_bitonic64);
+        }
+#endif
+        test.measure("radix sort",              test_radix);
+    }
+
+    for (size_t n: {1000, 100*1000, 1000*1000}) {
+        printf("sorting %lu elements\n", n);
+        Test test(n);
+        test.measure("std::sort",               test_std_sort);
+        test.measure("radix sort",              test_radix);
+    }
+}
@@ -0,0 +1,125 @@
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+
+#include "sort-u16.cpp"
+
+void print(const char* s) {
+    printf("%s... ", s);
+    fflush(stdout);
+}
+
+
+class Test {
+
+    const size_t max_size;
+    std::vector<uint16_t> in;
+    std::vector<uint16_t> ref;
+
+public:
+    Test(size_t max_size) : max_size(max_size) {}
+
+    template <typename FUNCTION>
+    bool run(FUNCTION fun) {
+
+        for (size_t n=0; n <= max_size; n++) {
+            if (!check(fun, n)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    template <typename FUNCTION>
+    bool check(FUNCTION fun, size_t n) {
+
+        in.resize(n);
+
+        for (size_t i=0; i < n; i++) in[i] = i;
+        if (!compare(fun, "ascending")) return false;
+
+        for (size_t i=0; i < n; i++) in[i] = n - i;
+        if (!compare(fun, "descending")) return false;
+
+        for (size_t i=0; i < n; i++) in[i] = 42;
+        if (!compare(fun, "all same")) return false;
+
+        for (size_t i=0; i < n; i++) in[i] = (i % 2) ? 0xffff : 0;
+        if (!compare(fun, "extreme values")) return false;
+
+        for (int k=0; k < 100; k++) {
+            for (size_t i=0; i < n; i++) in[i] = rand();
+            if (!compare(fun, "random")) return false;
+
+            for (size_t i=0; i < n; i++) in[i] = rand() % 16;
+            if (!compare(fun, "random small")) return false;
+        }
+
+        return true;
+    }
+
+    template <typename FUNCTION>
+    bool compare(FUNCTION fun, const char* name) {
+
+        ref = in;
+        std::sort(ref.begin(), ref.end());
+        fun(in.data(), in.size());
+
+        if (in != ref) {
+            printf("failed: %s, size %lu\n", name, in.size());
+            return false;
+        }
+
+        return true;
+    }
+};
+
+
+template <typename FUNCTION>
+bool test(const char* name, size_t max_size, FUNCTION fun) {
+
+    print(name);
+
+    Test test(max_size);
+    if (test.run(fun)) {
+        puts("OK");
+        return true;
+    } else {
+        puts("FAILED");
+        return false;
+    }
+}
+
+
+int main() {
+
+    bool ok = true;
+
+    ok = test("PHMINPOSUW (n <= 8)", 8, sort_u16_phminposuw) && ok;
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    ok = test("AVX2 bitonic (n <= 16)", 16, sort_u16_bitonic16) && ok;
+    ok = test("AVX2 bitonic (n <= 32)", 32, sort_u16_bitonic32) && ok;
+    ok = test("AVX2 bitonic (n <= 64)", 64, sort_u16_bitonic64) && ok;
+#endif
+    ok = test("radix sort", 300, static_cast<void(*)(uint16_t*, size_t)>(sort_u16_radix)) && ok;
+    ok = test("sort_u16", 300, sort_u16) && ok;
+
+    print("sort_u16 (1M elements)");
+    {
+        std::vector<uint16_t> in(1000*1000);
+        for (auto& x: in) x = rand();
+        std::vector<uint16_t> ref = in;
+        std::sort(ref.begin(), ref.end());
+        sort_u16(in.data(), in.size());
+        if (in == ref) {
+            puts("OK");
+        } else {
+            puts("FAILED");
+            ok = false;
+        }
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,3 +1,4 @@
+#include "../common/bufalloc.h"
 #include <cstdio>
 #include <cstdlib>
 #include <cstdint>
@@ -12,13 +13,15 @@
 class TestCase {
 
     const size_t SIZE = 1024*1024*10;
+    buf_t buf1;
+    buf_t buf2;
     float* input1;
     float* input2;
 
 public:
     TestCase() {
-        input1 = new float[SIZE];
-        input2 = new float[SIZE];
+        input1 = (float*)buf_alloc_or_die(&buf1, SIZE * sizeof(float));
+        input2 = (float*)buf_alloc_or_die(&buf2, SIZE * sizeof(float));
         for (size_t i=0; i < SIZE; i++) {
             input1[i] = get_random();
             input2[i] = get_random();
@@ -26,8 +29,8 @@ public:
     }
 
     ~TestCase() {
-        delete[] input1;
-        delete[] input2;
+        buf_free(&buf1);
+        buf_free(&buf2);
     }
 
     template <typename FUNCTION>
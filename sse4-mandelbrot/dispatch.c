@@ -0,0 +1,49 @@
+//=== runtime dispatch - 64-bit code =====================================
+// All procedures are compiled in, the CPU decides which can be used.
+#include <immintrin.h>
+
+#include "../common/cpudispatch.h"
+
+#define AVX2
+#define AVX512F
+#define AVX512BW
+
+CPU_TARGET_BEGIN("avx2")
+#include "avx2-proc-64-bit.c"
+CPU_TARGET_END
+
+CPU_TARGET_BEGIN("avx512f")
+#include "avx512-proc-64-bit.c"
+#include "avx512-fma-proc-64-bit.c"
+CPU_TARGET_END
+
+CPU_TARGET_BEGIN("avx512bw,avx512vl")
+#include "avx512bw-proc-64-bit.c"
+CPU_TARGET_END
+
+// procedure "auto" is the first supported one; the FMA version is the
+// fastest on Skylake-X, although pixels on edges may differ a bit
+const cpu_variant mandelbrot_variants[] = {
+	{CPU_AVX512F,                 (cpu_fun)AVX512F_FMA_mandelbrot,  "AVX512F+FMA"},
+	{CPU_AVX512BW | CPU_AVX512VL, (cpu_fun)AVX512BW_mandelbrot,     "AVX512BW"},
+	{CPU_AVX512F,                 (cpu_fun)AVX512F_mandelbrot,      "AVX512F"},
+	{CPU_AVX2,                    (cpu_fun)AVX2_mandelbrot,         "AVX2"},
+	{0,                           (cpu_fun)SSE_mandelbrot,          "SSE"},
+	{0,                           (cpu_fun)FPU_mandelbrot,          "FPU"},
+};
+
+
+const char* dispatch_procedure(const char* name) {
+	size_t i;
+
+	if (strcasecmp(name, "auto") == 0)
+		return cpu_select(mandelbrot_variants)->name;
+
+	for (i=0; i < sizeof(mandelbrot_variants)/sizeof(mandelbrot_variants[0]); i++) {
+		const cpu_variant* v = &mandelbrot_variants[i];
+		if (strcasecmp(name, v->name) == 0 && !cpu_has(v->required))
+			die("procedure %s is not supported by this CPU", v->name);
+	}
+
+	return name;
+}
@@ -63,6 +63,9 @@ void die(const char* fmt, ...) {
 #include "fpu-proc.c"
 #if defined(VERSION32BIT)
 #   include "sse4-proc-32-bit.c"
+#elif defined(VERSION64BIT) && defined(DISPATCH)
+#   include "sse4-proc-64-bit.c"
+#   include "dispatch.c"
 #elif defined(VERSION64BIT)
 #   if defined(AVX2)
 #       include "avx2-proc-64-bit.c"
@@ -96,6 +99,9 @@ void help(char* progname) {
 
 	printf("%s procedure [Remin Immin Remax Immax [threshold] [maxiters]] [--dry-run]\n", progname);
     puts("");
+#if defined(DISPATCH)
+	puts("auto - select the fastest procedure supported by CPU");
+#endif
 	puts("FPU - select FPU procedure");
 #if defined(VERSION32BIT)
     #ifdef SSE2
@@ -161,23 +167,27 @@ int main(int argc, char* argv[]) {
 
 
 	// 1. function name
-	if (strcasecmp(argv[1], "FPU") == 0)
+	const char* procedure = argv[1];
+#if defined(DISPATCH)
+	procedure = dispatch_procedure(procedure);
+#endif
+	if (strcasecmp(procedure, "FPU") == 0)
 		function = FPUprocedure;
 
-	if (strcasecmp(argv[1], "SSE") == 0)
+	if (strcasecmp(procedure, "SSE") == 0)
 		function = SSEprocedure;
 #if defined(AVX2)
-	if (strcasecmp(argv[1], "AVX2") == 0)
+	if (strcasecmp(procedure, "AVX2") == 0)
 		function = AVX2procedure;
 #endif
 #if defined(AVX512F)
-	if (strcasecmp(argv[1], "AVX512F") == 0)
+	if (strcasecmp(procedure, "AVX512F") == 0)
 		function = AVX512procedure;
-	if (strcasecmp(argv[1], "AVX512F+FMA") == 0)
+	if (strcasecmp(procedure, "AVX512F+FMA") == 0)
 		function = AVX512F_FMA_procedure;
 #endif
 #if defined(AVX512BW)
-	if (strcasecmp(argv[1], "AVX512BW") == 0)
+	if (strcasecmp(procedure, "AVX512BW") == 0)
 		function = AVX512BW_procedure;
 #endif
 
@@ -315,7 +325,7 @@ int main(int argc, char* argv[]) {
             printf("AVX512F ");
 			fflush(stdout);
 			t1 = get_time();
-			AVX512F_FMA_mandelbrot(
+			AVX512F_mandelbrot(
 				Re_min, Re_max,
 				Im_min, Im_max,
 				threshold, maxiters,
@@ -336,7 +346,7 @@ int main(int argc, char* argv[]) {
             printf("AVX512F+FMA ");
 			fflush(stdout);
 			t1 = get_time();
-			AVX512F_mandelbrot(
+			AVX512F_FMA_mandelbrot(
 				Re_min, Re_max,
 				Im_min, Im_max,
 				threshold, maxiters,
@@ -350,13 +360,14 @@ int main(int argc, char* argv[]) {
 			    f = fopen("avx512f+fma.pgm", "wb");
             }
 #endif
+			break;
 
 		case AVX512BW_procedure:
 #if defined(AVX512BW)
             printf("AVX512BW ");
 			fflush(stdout);
 			t1 = get_time();
-			AVX512F_mandelbrot(
+			AVX512BW_mandelbrot(
 				Re_min, Re_max,
 				Im_min, Im_max,
 				threshold, maxiters,
@@ -7,19 +7,13 @@
 
 	initial release 3-04-2010
 */
+#include "../common/bench.h"
+
 #include <iostream>
 #include <vector>
 #include <map>
 #include <string>
 
-#include <sys/time.h>
-
-unsigned gettime() {
-	struct timeval tv;
-	gettimeofday(&tv, NULL);
-
-	return (tv.tv_sec * 1000000 + tv.tv_usec)/1000;
-}
 //---------------------------------------------------------------------------
 
 template <class TValue>
@@ -199,120 +193,101 @@ void char_map_t<TValue>::insert(const std::string& key, TValue val) {
 //---------------------------------------------------------------------------
 
 
-int main(int argc, char* argv[]) {
+// maps are filled once, thus inserting is measured in a single run
+// (BENCH_REPEAT would measure overwriting of existing keys)
+template <class TMap>
+void insert(TMap& map, const std::vector<std::string>& words, const char* name) {
+	const unsigned n = words.size();
+	bench b;
+
+	bench_begin(&b, name, 1, n);
+	b.pinned = 1;
+	b.warmup = 0;
+	while (bench_next(&b))
+		for (unsigned i=0; i < n; i++)
+			map.insert(words[i], i);
+
+	bench_report(&b);
+}
+//---------------------------------------------------------------------------
+
+template <class TMap>
+bool read(const TMap& map, const std::vector<std::string>& words, const char* name) {
+	const unsigned n = words.size();
+	unsigned found = 0;
+	bench b;
+
+	bench_begin(&b, name, 5, n);
+	b.warmup = 1;
+	while (bench_next(&b)) {
+		found = 0;
+		for (unsigned i=0; i < n; i++)
+			found += map.count(words[i]);
+
+		BENCH_KEEP(found);
+	}
+
+	bench_report(&b);
+	if (found != n) {
+		std::cerr << name << ": found " << found << " words of " << n << std::endl;
+		return false;
+	}
+
+	return true;
+}
+//---------------------------------------------------------------------------
+
+// std::map has no insert(key, value)
+template <class TKey, class TValue>
+class std_map_t: public std::map<TKey, TValue> {
+	public:
+		void insert(const TKey& key, TValue val) {
+			(*this)[key] = val;
+		}
+};
+//---------------------------------------------------------------------------
+
+
+int main() {
 	using namespace std;
 
 	size_char_map_t<int>	map1(1024);
 	size_map_t<int>		map2(1024);
 	char_map_t<int>		map3;
-	map<string, int>	map4;
+	std_map_t<string, int>	map4;
 
 	vector<string>		words;
 	string s;
-	unsigned t1, t2;
 
 	//--------------------------------------------------
-	t1 = gettime();
-	cout << "loading words..." << endl;
 	while (not cin.eof()) {
 		cin >> s;
 		if (not s.empty())
 			words.push_back(s);
 	}
-	t2 = gettime();
-	cout << t2 - t1 << " ms" << " words=" << words.size() << endl;
-
-	//--------------------------------------------------
-	t1 = gettime();
-	cout << "inserting into maps grouped by size & first char" << endl;
-	unsigned i, n = words.size();
-	for (i=0; i < n; i++) {
-		//cout << '#' << i << " '" << words[i] << '\'' << endl;
-		map1.insert(words[i], i);
-	}
-	t2 = gettime();
-	cout << t2 - t1 << " ms" << endl;
-
-	//--------------------------------------------------
-	t1 = gettime();
-	cout << "inserting into maps grouped by size" << endl;
-	for (i=0; i < n; i++)
-		//cout << '#' << i << " '" << words[i] << '\'' << endl;
-		map2.insert(words[i], i);
-
-	t2 = gettime();
-	cout << t2 - t1 << " ms" << endl;
-
-	//--------------------------------------------------
-	t1 = gettime();
-	cout << "inserting into maps grouped by first char" << endl;
-	for (i=0; i < n; i++)
-		//cout << '#' << i << " '" << words[i] << '\'' << endl;
-		map3.insert(words[i], i);
-
-	t2 = gettime();
-	cout << t2 - t1 << " ms" << endl;
+	cerr << "words=" << words.size() << endl;
 
 	//--------------------------------------------------
-	t1 = gettime();
-	cout << "inserting into std::map" << endl;
-	for (i=0; i < n; i++)
-		map4[words[i]] = i;
-
-	t2 = gettime();
-	cout << t2 - t1 << " ms" << endl;
+	insert(map1, words, "insert: grouped by size & first char");
+	insert(map2, words, "insert: grouped by size");
+	insert(map3, words, "insert: grouped by first char");
+	insert(map4, words, "insert: std::map");
 
 	//--------------------------------------------------
-	cout << endl;
-	cout <<  "size1=" << map1.size() <<
+	cerr << "size1=" << map1.size() <<
 		" size2=" << map2.size() <<
 		" size3=" << map3.size() <<
 		" size4=" << map4.size() << endl;
 
 	//--------------------------------------------------
-	t1 = gettime();
-	cout << "reading from maps grouped by size & first char" << endl;
-	for (i=0; i < n; i++)
-		if (map1.count(words[i]) == 0) {
-			cerr << "error1 at #" << i;
-			return 1;
-		}
-	t2 = gettime();
-	cout << t2 - t1 << " ms" << endl;
-
-	//--------------------------------------------------
-	t1 = gettime();
-	cout << "reading from maps grouped by size" << endl;
-	for (i=0; i < n; i++)
-		if (map2.count(words[i]) == 0) {
-			cerr << "error2 at #" << i;
-			return 1;
-		}
-	t2 = gettime();
-	cout << t2 - t1 << " ms" << endl;
-	
-	//--------------------------------------------------
-	t1 = gettime();
-	cout << "reading from maps grouped by first char" << endl;
-	for (i=0; i < n; i++)
-		if (map3.count(words[i]) == 0) {
-			cerr << "error3 at #" << i;
-			return 1;
-		}
-	t2 = gettime();
-	cout << t2 - t1 << " ms" << endl;
-
-
-	//--------------------------------------------------
-	t1 = gettime();
-	cout << "reading from std::map" << endl;
-	for (i=0; i < n; i++)
-		if (map4.count(words[i]) == 0) {
-			cerr << "error4 at #" << i;
-			return 1;
-		}
-	t2 = gettime();
-	cout << t2 - t1 << " ms" << endl;
+	if (not read(map1, words, "read: grouped by size & first char"))
+		return 1;
+	if (not read(map2, words, "read: grouped by size"))
+		return 1;
+	if (not read(map3, words, "read: grouped by first char"))
+		return 1;
+	if (not read(map4, words, "read: std::map"))
+		return 1;
 
 	return 0;
 }
@@ -0,0 +1,21 @@
+#include <cstring>
+#include <immintrin.h>
+
+#include "scalar.cpp"
+#include "sse.cpp"
+
+#ifdef HAVE_AVX512_INSTRUCTIONS
+#   ifndef HAVE_AVX2_INSTRUCTIONS
+#       define HAVE_AVX2_INSTRUCTIONS
+#   endif
+#endif
+
+#ifdef HAVE_AVX2_INSTRUCTIONS
+#   include "avx.cpp"
+#endif
+
+#ifdef HAVE_AVX512_INSTRUCTIONS
+#   include "avx512.cpp"
+#endif
+
+#include "transpose.cpp"
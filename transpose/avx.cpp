@@ -0,0 +1,78 @@
+// AVX tiles: 8x8 for 32-bit and 4x4 for 64-bit elements.  Unpacks
+// in AVX work within 128-bit lanes, thus the last step exchanges lanes
+// with vperm2f128.  Other element types use SSE tiles.
+
+template <typename T>
+struct TileAVX: TileSSE<T> {};
+
+
+template <>
+struct TileAVX<uint32_t> {
+
+    static const size_t B = 8;
+
+    static void transpose(const uint32_t* src, size_t lds, uint32_t* dst, size_t ldd) {
+        __m256 r[8];
+        for (size_t i=0; i < 8; i++) {
+            r[i] = _mm256_loadu_ps((const float*)(src + i*lds));
+        }
+
+        // t0 = [a0 b0 a1 b1 | a4 b4 a5 b5], t1 = [a2 b2 a3 b3 | a6 b6 a7 b7], ...
+        const __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+        const __m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+        const __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+        const __m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+        const __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]);
+        const __m256 t5 = _mm256_unpackhi_ps(r[4], r[5]);
+        const __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]);
+        const __m256 t7 = _mm256_unpackhi_ps(r[6], r[7]);
+
+        // u0 = [a0 b0 c0 d0 | a4 b4 c4 d4], u1 = [a1 b1 c1 d1 | a5 b5 c5 d5], ...
+        const __m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+        r[0] = _mm256_permute2f128_ps(u0, u4, 0x20);
+        r[1] = _mm256_permute2f128_ps(u1, u5, 0x20);
+        r[2] = _mm256_permute2f128_ps(u2, u6, 0x20);
+        r[3] = _mm256_permute2f128_ps(u3, u7, 0x20);
+        r[4] = _mm256_permute2f128_ps(u0, u4, 0x31);
+        r[5] = _mm256_permute2f128_ps(u1, u5, 0x31);
+        r[6] = _mm256_permute2f128_ps(u2, u6, 0x31);
+        r[7] = _mm256_permute2f128_ps(u3, u7, 0x31);
+
+        for (size_t i=0; i < 8; i++) {
+            _mm256_storeu_ps((float*)(dst + i*ldd), r[i]);
+        }
+    }
+};
+
+
+template <>
+struct TileAVX<uint64_t> {
+
+    static const size_t B = 4;
+
+    static void transpose(const uint64_t* src, size_t lds, uint64_t* dst, size_t ldd) {
+        const __m256d r0 = _mm256_loadu_pd((const double*)(src + 0*lds));
+        const __m256d r1 = _mm256_loadu_pd((const double*)(src + 1*lds));
+        const __m256d r2 = _mm256_loadu_pd((const double*)(src + 2*lds));
+        const __m256d r3 = _mm256_loadu_pd((const double*)(src + 3*lds));
+
+        // t0 = [a0 b0 | a2 b2], t1 = [a1 b1 | a3 b3]
+        const __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+        const __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+        const __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+        const __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+
+        _mm256_storeu_pd((double*)(dst + 0*ldd), _mm256_permute2f128_pd(t0, t2, 0x20));
+        _mm256_storeu_pd((double*)(dst + 1*ldd), _mm256_permute2f128_pd(t1, t3, 0x20));
+        _mm256_storeu_pd((double*)(dst + 2*ldd), _mm256_permute2f128_pd(t0, t2, 0x31));
+        _mm256_storeu_pd((double*)(dst + 3*ldd), _mm256_permute2f128_pd(t1, t3, 0x31));
+    }
+};
@@ -0,0 +1,79 @@
+// AVX512F tiles: 16x16 for 32-bit and 8x8 for 64-bit elements.
+//
+// After in-lane unpacks each 128-bit lane L of register u[m + 4*g] holds
+// four values of column 4L + m from rows 4g .. 4g + 3 (for 32-bit
+// elements); two rounds of vshufi32x4 gather lanes into whole columns.
+
+template <typename T>
+struct TileAVX512: TileAVX<T> {};
+
+
+template <>
+struct TileAVX512<uint32_t> {
+
+    static const size_t B = 16;
+
+    static void transpose(const uint32_t* src, size_t lds, uint32_t* dst, size_t ldd) {
+        __m512i r[16];
+        __m512i t[16];
+        for (size_t i=0; i < 16; i++) {
+            r[i] = _mm512_loadu_si512((const __m512i*)(src + i*lds));
+        }
+
+        for (size_t i=0; i < 16; i += 2) {
+            t[i + 0] = _mm512_unpacklo_epi32(r[i], r[i + 1]);
+            t[i + 1] = _mm512_unpackhi_epi32(r[i], r[i + 1]);
+        }
+
+        for (size_t i=0; i < 16; i += 4) {
+            r[i + 0] = _mm512_unpacklo_epi64(t[i + 0], t[i + 2]);
+            r[i + 1] = _mm512_unpackhi_epi64(t[i + 0], t[i + 2]);
+            r[i + 2] = _mm512_unpacklo_epi64(t[i + 1], t[i + 3]);
+            r[i + 3] = _mm512_unpackhi_epi64(t[i + 1], t[i + 3]);
+        }
+
+        for (size_t m=0; m < 4; m++) {
+            const __m512i v0 = _mm512_shuffle_i32x4(r[m + 0], r[m + 4],  0x88);
+            const __m512i v1 = _mm512_shuffle_i32x4(r[m + 0], r[m + 4],  0xdd);
+            const __m512i w0 = _mm512_shuffle_i32x4(r[m + 8], r[m + 12], 0x88);
+            const __m512i w1 = _mm512_shuffle_i32x4(r[m + 8], r[m + 12], 0xdd);
+
+            _mm512_storeu_si512((__m512i*)(dst + (m +  0)*ldd), _mm512_shuffle_i32x4(v0, w0, 0x88));
+            _mm512_storeu_si512((__m512i*)(dst + (m +  4)*ldd), _mm512_shuffle_i32x4(v1, w1, 0x88));
+            _mm512_storeu_si512((__m512i*)(dst + (m +  8)*ldd), _mm512_shuffle_i32x4(v0, w0, 0xdd));
+            _mm512_storeu_si512((__m512i*)(dst + (m + 12)*ldd), _mm512_shuffle_i32x4(v1, w1, 0xdd));
+        }
+    }
+};
+
+
+template <>
+struct TileAVX512<uint64_t> {
+
+    static const size_t B = 8;
+
+    static void transpose(const uint64_t* src, size_t lds, uint64_t* dst, size_t ldd) {
+        __m512i r[8];
+        __m512i t[8];
+        for (size_t i=0; i < 8; i++) {
+            r[i] = _mm512_loadu_si512((const __m512i*)(src + i*lds));
+        }
+
+        for (size_t i=0; i < 8; i += 2) {
+            t[i + 0] = _mm512_unpacklo_epi64(r[i], r[i + 1]);
+            t[i + 1] = _mm512_unpackhi_epi64(r[i], r[i + 1]);
+        }
+
+        for (size_t m=0; m < 2; m++) {
+            const __m512i v0 = _mm512_shuffle_i64x2(t[m + 0], t[m + 2], 0x88);
+            const __m512i v1 = _mm512_shuffle_i64x2(t[m + 0], t[m + 2], 0xdd);
+            const __m512i w0 = _mm512_shuffle_i64x2(t[m + 4], t[m + 6], 0x88);
+            const __m512i w1 = _mm512_shuffle_i64x2(t[m + 4], t[m + 6], 0xdd);
+
+            _mm512_storeu_si512((__m512i*)(dst + (m + 0)*ldd), _mm512_shuffle_i64x2(v0, w0, 0x88));
+            _mm512_storeu_si512((__m512i*)(dst + (m + 2)*ldd), _mm512_shuffle_i64x2(v1, w1, 0x88));
+            _mm512_storeu_si512((__m512i*)(dst + (m + 4)*ldd), _mm512_shuffle_i64x2(v0, w0, 0xdd));
+            _mm512_storeu_si512((__m512i*)(dst + (m + 6)*ldd), _mm512_shuffle_i64x2(v1, w1, 0xdd));
+        }
+    }
+};
@@ -0,0 +1,41 @@
+// Scalar tile --- a fallback for all element types, also used
+// at the edges of matrices, where a full SIMD tile does not fit.
+template <typename T>
+struct TileScalar {
+
+    static const size_t B = 8;
+
+    static void transpose(const T* src, size_t lds, T* dst, size_t ldd) {
+        for (size_t i=0; i < B; i++) {
+            for (size_t j=0; j < B; j++) {
+                dst[j*ldd + i] = src[i*lds + j];
+            }
+        }
+    }
+};
+
+
+template <typename T>
+void transpose_block_scalar(const T* src, size_t lds, T* dst, size_t ldd, size_t rows, size_t cols) {
+    for (size_t i=0; i < rows; i++) {
+        for (size_t j=0; j < cols; j++) {
+            dst[j*ldd + i] = src[i*lds + j];
+        }
+    }
+}
+
+
+template <typename T>
+void transpose_naive(const T* src, size_t rows, size_t cols, size_t lds, T* dst, size_t ldd) {
+    transpose_block_scalar(src, lds, dst, ldd, rows, cols);
+}
+
+
+template <typename T>
+void transpose_inplace_naive(T* A, size_t n, size_t ld) {
+    for (size_t i=0; i < n; i++) {
+        for (size_t j=i + 1; j < n; j++) {
+            std::swap(A[i*ld + j], A[j*ld + i]);
+        }
+    }
+}
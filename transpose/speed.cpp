@@ -0,0 +1,110 @@
+#include "../common/bufalloc.h"
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <thread>
+
+#include "gettime.cpp"
+#include "all.cpp"
+
+
+unsigned threads = 1;
+size_t rows = 4096;
+size_t cols = 4096;
+
+
+template <typename T>
+class Test {
+
+    buf_array<T> src;
+    buf_array<T> dst;
+
+public:
+    Test() : src(rows * cols), dst(rows * cols) {
+        for (auto& x: src) x = T(rand());
+    }
+
+    template <template <typename> class Tile>
+    void measure(const char* isa) {
+
+        char name[64];
+        snprintf(name, sizeof(name), "%s (tile %lux%lu)", isa, Tile<T>::B, Tile<T>::B);
+        printf("%-30s", name); fflush(stdout);
+
+        const double bytes = 2.0 * rows * cols * sizeof(T); // read + write
+
+        double best = 1e100;
+        for (int i=0; i < 3; i++) {
+            const double t1 = get_time();
+            if (threads > 1) {
+                transpose_threaded<Tile>(src.data(), rows, cols, cols, dst.data(), rows, threads);
+            } else {
+                transpose<Tile>(src.data(), rows, cols, cols, dst.data(), rows);
+            }
+            const double t2 = get_time();
+            best = std::min(best, t2 - t1);
+        }
+        printf("%7.2f GB/s", bytes / best / 1e9);
+
+        if (rows == cols) {
+            best = 1e100;
+            for (int i=0; i < 3; i++) {
+                const double t1 = get_time();
+                if (threads > 1) {
+                    transpose_inplace_threaded<Tile>(src.data(), rows, cols, threads);
+                } else {
+                    transpose_inplace<Tile>(src.data(), rows, cols);
+                }
+                const double t2 = get_time();
+                best = std::min(best, t2 - t1);
+            }
+            printf(" %7.2f GB/s (in-place)", bytes / best / 1e9);
+        }
+
+        putchar('\n');
+    }
+
+    void measure_naive() {
+
+        printf("%-30s", "naive"); fflush(stdout);
+
+        const double t1 = get_time();
+        transpose_naive(src.data(), rows, cols, cols, dst.data(), rows);
+        const double t2 = get_time();
+
+        printf("%7.2f GB/s\n", 2.0 * rows * cols * sizeof(T) / (t2 - t1) / 1e9);
+    }
+};
+
+
+template <typename T>
+void measure_all(const char* type) {
+
+    printf("%s, %lu x %lu, %u thread(s)\n", type, rows, cols, threads);
+
+    Test<T> test;
+    test.measure_naive();
+    test.template measure<TileScalar>("scalar");
+    test.template measure<TileSSE>("SSE");
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    test.template measure<TileAVX>("AVX");
+#endif
+#ifdef HAVE_AVX512_INSTRUCTIONS
+    test.template measure<TileAVX512>("AVX512F");
+#endif
+}
+
+
+int main(int argc, char* argv[]) {
+
+    // usage: speed [threads [rows [cols]]]
+    if (argc > 1) threads = atoi(argv[1]);
+    if (argc > 2) rows = cols = atoi(argv[2]);
+    if (argc > 3) cols = atoi(argv[3]);
+
+    measure_all<uint8_t>("8-bit");
+    measure_all<uint16_t>("16-bit");
+    measure_all<uint32_t>("32-bit");
+    measure_all<uint64_t>("64-bit");
+}
@@ -0,0 +1,106 @@
+// SSE tiles: NxN transposition of N = 16/T elements in log2(N) rounds
+// of unpack (a perfect shuffle); for 32-bit elements this is exactly
+// the sequence from sse/sse-transpose.c.
+//
+//      a0 a1 a2 a3         a0 c0 a1 c1         a0 b0 c0 d0
+//      b0 b1 b2 b3   -->   a2 c2 a3 c3   -->   a1 b1 c1 d1
+//      c0 c1 c2 c3         b0 d0 b1 d1         a2 b2 c2 d2
+//      d0 d1 d2 d3         b2 d2 b3 d3         a3 b3 c3 d3
+
+#define SSE_TRANSPOSE_ROUND(N, unpacklo, unpackhi) { \
+    __m128i t[N]; \
+    for (size_t i=0; i < N/2; i++) { \
+        t[2*i + 0] = unpacklo(r[i], r[i + N/2]); \
+        t[2*i + 1] = unpackhi(r[i], r[i + N/2]); \
+    } \
+    for (size_t i=0; i < N; i++) { \
+        r[i] = t[i]; \
+    } \
+}
+
+
+template <typename T>
+struct TileSSE;
+
+
+template <>
+struct TileSSE<uint8_t> {
+
+    static const size_t B = 16;
+
+    static void transpose(const uint8_t* src, size_t lds, uint8_t* dst, size_t ldd) {
+        __m128i r[B];
+        for (size_t i=0; i < B; i++) {
+            r[i] = _mm_loadu_si128((const __m128i*)(src + i*lds));
+        }
+
+        SSE_TRANSPOSE_ROUND(16, _mm_unpacklo_epi8, _mm_unpackhi_epi8);
+        SSE_TRANSPOSE_ROUND(16, _mm_unpacklo_epi8, _mm_unpackhi_epi8);
+        SSE_TRANSPOSE_ROUND(16, _mm_unpacklo_epi8, _mm_unpackhi_epi8);
+        SSE_TRANSPOSE_ROUND(16, _mm_unpacklo_epi8, _mm_unpackhi_epi8);
+
+        for (size_t i=0; i < B; i++) {
+            _mm_storeu_si128((__m128i*)(dst + i*ldd), r[i]);
+        }
+    }
+};
+
+
+template <>
+struct TileSSE<uint16_t> {
+
+    static const size_t B = 8;
+
+    static void transpose(const uint16_t* src, size_t lds, uint16_t* dst, size_t ldd) {
+        __m128i r[B];
+        for (size_t i=0; i < B; i++) {
+            r[i] = _mm_loadu_si128((const __m128i*)(src + i*lds));
+        }
+
+        SSE_TRANSPOSE_ROUND(8, _mm_unpacklo_epi16, _mm_unpackhi_epi16);
+        SSE_TRANSPOSE_ROUND(8, _mm_unpacklo_epi16, _mm_unpackhi_epi16);
+        SSE_TRANSPOSE_ROUND(8, _mm_unpacklo_epi16, _mm_unpackhi_epi16);
+
+        for (size_t i=0; i < B; i++) {
+            _mm_storeu_si128((__m128i*)(dst + i*ldd), r[i]);
+        }
+    }
+};
+
+
+template <>
+struct TileSSE<uint32_t> {
+
+    static const size_t B = 4;
+
+    static void transpose(const uint32_t* src, size_t lds, uint32_t* dst, size_t ldd) {
+        __m128i r[B];
+        for (size_t i=0; i < B; i++) {
+            r[i] = _mm_loadu_si128((const __m128i*)(src + i*lds));
+        }
+
+        SSE_TRANSPOSE_ROUND(4, _mm_unpacklo_epi32, _mm_unpackhi_epi32);
+        SSE_TRANSPOSE_ROUND(4, _mm_unpacklo_epi32, _mm_unpackhi_epi32);
+
+        for (size_t i=0; i < B; i++) {
+            _mm_storeu_si128((__m128i*)(dst + i*ldd), r[i]);
+        }
+    }
+};
+
+
+template <>
+struct TileSSE<uint64_t> {
+
+    static const size_t B = 2;
+
+    static void transpose(const uint64_t* src, size_t lds, uint64_t* dst, size_t ldd) {
+        const __m128i r0 = _mm_loadu_si128((const __m128i*)(src + 0*lds));
+        const __m128i r1 = _mm_loadu_si128((const __m128i*)(src + 1*lds));
+
+        _mm_storeu_si128((__m128i*)(dst + 0*ldd), _mm_unpacklo_epi64(r0, r1));
+        _mm_storeu_si128((__m128i*)(dst + 1*ldd), _mm_unpackhi_epi64(r0, r1));
+    }
+};
+
+#undef SSE_TRANSPOSE_ROUND
@@ -0,0 +1,245 @@
+// Transposition of large matrices
+//
+// Both procedures are cache-oblivious: a matrix is recursively split
+// along the longer dimension until a block fits in L1 cache (LEAF x LEAF
+// elements); then the block is transposed using register tiles.
+// A tile is a class (see scalar.cpp, sse.cpp, avx.cpp, avx512.cpp) that
+// defines size B and the static function transpose, which transposes
+// BxB elements from src to dst.
+//
+// * transpose         --- out-of-place, rectangular matrices,
+// * transpose_inplace --- in-place, square matrices.
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+namespace transpose_detail {
+
+    const size_t LEAF = 64;
+
+    // split point for a recursive step: a multiple of B if possible
+    size_t split(size_t n, size_t B) {
+        const size_t half = (n / 2) / B * B;
+        return (half > 0) ? half : n / 2;
+    }
+
+
+    template <typename Tile, typename T>
+    void leaf(const T* src, size_t lds, T* dst, size_t ldd, size_t rows, size_t cols) {
+
+        const size_t B  = Tile::B;
+        const size_t rb = rows - rows % B;
+        const size_t cb = cols - cols % B;
+
+        for (size_t i=0; i < rb; i += B) {
+            for (size_t j=0; j < cb; j += B) {
+                Tile::transpose(src + i*lds + j, lds, dst + j*ldd + i, ldd);
+            }
+        }
+
+        // right and bottom edges
+        transpose_block_scalar(src + cb, lds, dst + cb*ldd, ldd, rb, cols - cb);
+        transpose_block_scalar(src + rb*lds, lds, dst + rb, ldd, rows - rb, cols);
+    }
+
+
+    template <typename Tile, typename T>
+    void recursive(const T* src, size_t lds, T* dst, size_t ldd, size_t rows, size_t cols) {
+
+        if (rows <= LEAF && cols <= LEAF) {
+            leaf<Tile>(src, lds, dst, ldd, rows, cols);
+        } else if (rows >= cols) {
+            const size_t r = split(rows, Tile::B);
+            recursive<Tile>(src, lds, dst, ldd, r, cols);
+            recursive<Tile>(src + r*lds, lds, dst + r, ldd, rows - r, cols);
+        } else {
+            const size_t c = split(cols, Tile::B);
+            recursive<Tile>(src, lds, dst, ldd, rows, c);
+            recursive<Tile>(src + c, lds, dst + c*ldd, ldd, rows, cols - c);
+        }
+    }
+
+
+    // P := Q^T and Q := P^T for BxB tiles; Q is saved in a local buffer
+    // that stays in L1, then both tiles are transposed with registers.
+    template <typename Tile, typename T>
+    void swap_tiles(T* P, T* Q, size_t ld) {
+
+        const size_t B = Tile::B;
+        T tmp[B * B];
+
+        Tile::transpose(Q, ld, tmp, B);
+        Tile::transpose(P, ld, Q, ld);
+        for (size_t i=0; i < B; i++) {
+            memcpy(P + i*ld, tmp + i*B, B * sizeof(T));
+        }
+    }
+
+
+    // P is rows x cols, Q is cols x rows, both with the same stride
+    template <typename Tile, typename T>
+    void leaf_swap(T* P, T* Q, size_t ld, size_t rows, size_t cols) {
+
+        const size_t B  = Tile::B;
+        const size_t rb = rows - rows % B;
+        const size_t cb = cols - cols % B;
+
+        for (size_t i=0; i < rb; i += B) {
+            for (size_t j=0; j < cb; j += B) {
+                swap_tiles<Tile>(P + i*ld + j, Q + j*ld + i, ld);
+            }
+        }
+
+        for (size_t i=0; i < rows; i++) {
+            for (size_t j=(i < rb ? cb : 0); j < cols; j++) {
+                std::swap(P[i*ld + j], Q[j*ld + i]);
+            }
+        }
+    }
+
+
+    template <typename Tile, typename T>
+    void leaf_diagonal(T* A, size_t ld, size_t n) {
+
+        const size_t B  = Tile::B;
+        const size_t nb = n - n % B;
+        T tmp[B * B];
+
+        for (size_t i=0; i < nb; i += B) {
+            Tile::transpose(A + i*ld + i, ld, tmp, B);
+            for (size_t k=0; k < B; k++) {
+                memcpy(A + (i + k)*ld + i, tmp + k*B, B * sizeof(T));
+            }
+
+            for (size_t j=i + B; j < nb; j += B) {
+                swap_tiles<Tile>(A + i*ld + j, A + j*ld + i, ld);
+            }
+        }
+
+        for (size_t i=0; i < n; i++) {
+            for (size_t j=std::max(i + 1, (i < nb) ? nb : 0); j < n; j++) {
+                std::swap(A[i*ld + j], A[j*ld + i]);
+            }
+        }
+    }
+
+
+    template <typename Tile, typename T>
+    void recursive_swap(T* P, T* Q, size_t ld, size_t rows, size_t cols) {
+
+        if (rows <= LEAF && cols <= LEAF) {
+            leaf_swap<Tile>(P, Q, ld, rows, cols);
+        } else if (rows >= cols) {
+            const size_t r = split(rows, Tile::B);
+            recursive_swap<Tile>(P, Q, ld, r, cols);
+            recursive_swap<Tile>(P + r*ld, Q + r, ld, rows - r, cols);
+        } else {
+            const size_t c = split(cols, Tile::B);
+            recursive_swap<Tile>(P, Q, ld, rows, c);
+            recursive_swap<Tile>(P + c, Q + c*ld, ld, rows, cols - c);
+        }
+    }
+
+
+    template <typename Tile, typename T>
+    void recursive_diagonal(T* A, size_t ld, size_t n) {
+
+        if (n <= LEAF) {
+            leaf_diagonal<Tile>(A, ld, n);
+        } else {
+            const size_t k = split(n, Tile::B);
+            recursive_diagonal<Tile>(A, ld, k);
+            recursive_diagonal<Tile>(A + k*ld + k, ld, n - k);
+            recursive_swap<Tile>(A + k, A + k*ld, ld, k, n - k);
+        }
+    }
+
+} // namespace transpose_detail
+
+
+// dst (cols x rows) := src^T (rows x cols)
+template <template <typename> class Tile, typename T>
+void transpose(const T* src, size_t rows, size_t cols, size_t lds, T* dst, size_t ldd) {
+    transpose_detail::recursive<Tile<T>>(src, lds, dst, ldd, rows, cols);
+}
+
+
+// A (n x n) := A^T
+template <template <typename> class Tile, typename T>
+void transpose_inplace(T* A, size_t n, size_t ld) {
+    transpose_detail::recursive_diagonal<Tile<T>>(A, ld, n);
+}
+
+
+// Rows of src are split among threads; each thread writes
+// a disjoint set of columns of dst.
+template <template <typename> class Tile, typename T>
+void transpose_threaded(const T* src, size_t rows, size_t cols, size_t lds, T* dst, size_t ldd, unsigned threads) {
+
+    const size_t B = Tile<T>::B;
+    const size_t chunks = (rows + B - 1) / B;
+    threads = std::max(1u, std::min<unsigned>(threads, chunks));
+
+    std::vector<std::thread> workers;
+    size_t start = 0;
+    for (unsigned t=0; t < threads; t++) {
+        const size_t n = std::min(rows - start, (chunks / threads + (t < chunks % threads)) * B);
+        workers.emplace_back(transpose_detail::recursive<Tile<T>, T>,
+                             src + start*lds, lds, dst + start, ldd, n, cols);
+        start += n;
+    }
+
+    for (auto& w: workers) {
+        w.join();
+    }
+}
+
+
+// The matrix is divided into SxS blocks; pairs of blocks placed
+// symmetrically to the diagonal are independent, threads pick them
+// from a shared counter.
+template <template <typename> class Tile, typename T>
+void transpose_inplace_threaded(T* A, size_t n, size_t ld, unsigned threads) {
+
+    using namespace transpose_detail;
+
+    const size_t S = 256;
+    const size_t blocks = (n + S - 1) / S;
+    const size_t pairs  = blocks * (blocks + 1) / 2;
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t p = next++; p < pairs; p = next++) {
+            // decode p into (bi, bj), bi <= bj, row by row
+            size_t bi = 0;
+            size_t q  = p;
+            while (q >= blocks - bi) {
+                q  -= blocks - bi;
+                bi += 1;
+            }
+            const size_t bj = bi + q;
+
+            const size_t i = bi * S;
+            const size_t j = bj * S;
+            const size_t ni = std::min(S, n - i);
+            const size_t nj = std::min(S, n - j);
+            if (bi == bj) {
+                recursive_diagonal<Tile<T>>(A + i*ld + i, ld, ni);
+            } else {
+                recursive_swap<Tile<T>>(A + i*ld + j, A + j*ld + i, ld, ni, nj);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t=0; t < std::max(1u, threads); t++) {
+        workers.emplace_back(worker);
+    }
+
+    for (auto& w: workers) {
+        w.join();
+    }
+}
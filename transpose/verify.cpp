@@ -0,0 +1,117 @@
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+
+#include "all.cpp"
+
+
+template <typename T, template <typename> class Tile>
+class Verify {
+
+    std::vector<T> src;
+    std::vector<T> dst;
+    std::vector<T> ref;
+
+public:
+    bool run() {
+
+        static const size_t sizes[][2] = {
+            {1, 1},
+            {2, 3},
+            {16, 16},
+            {17, 15},
+            {64, 64},
+            {65, 129},
+            {300, 7},
+            {7, 300},
+            {513, 257},
+            {1000, 1000},
+        };
+
+        for (const auto& s: sizes) {
+            if (!check_out_of_place(s[0], s[1], 1) || !check_out_of_place(s[0], s[1], 3)) {
+                printf("out-of-place failed for %lu x %lu\n", s[0], s[1]);
+                return false;
+            }
+
+            if (!check_inplace(s[0], 1) || !check_inplace(s[0], 3)) {
+                printf("in-place failed for %lu x %lu\n", s[0], s[0]);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    bool check_out_of_place(size_t rows, size_t cols, unsigned threads) {
+
+        const size_t lds = cols + 3;
+        const size_t ldd = rows + 5;
+
+        src.resize(rows * lds);
+        for (auto& x: src) x = T(rand());
+        ref.assign(cols * ldd, T(0));
+        dst.assign(cols * ldd, T(0));
+
+        transpose_naive(src.data(), rows, cols, lds, ref.data(), ldd);
+        if (threads == 1) {
+            transpose<Tile>(src.data(), rows, cols, lds, dst.data(), ldd);
+        } else {
+            transpose_threaded<Tile>(src.data(), rows, cols, lds, dst.data(), ldd, threads);
+        }
+
+        return dst == ref;
+    }
+
+    bool check_inplace(size_t n, unsigned threads) {
+
+        const size_t ld = n + 1;
+
+        dst.resize(n * ld);
+        for (auto& x: dst) x = T(rand());
+        ref = dst;
+
+        transpose_inplace_naive(ref.data(), n, ld);
+        if (threads == 1) {
+            transpose_inplace<Tile>(dst.data(), n, ld);
+        } else {
+            transpose_inplace_threaded<Tile>(dst.data(), n, ld, threads);
+        }
+
+        return dst == ref;
+    }
+};
+
+
+template <template <typename> class Tile>
+bool test(const char* name) {
+
+    printf("%s... ", name); fflush(stdout);
+
+    const bool ok = Verify<uint8_t,  Tile>().run()
+                 && Verify<uint16_t, Tile>().run()
+                 && Verify<uint32_t, Tile>().run()
+                 && Verify<uint64_t, Tile>().run();
+
+    puts(ok ? "OK" : "FAILED");
+    return ok;
+}
+
+
+int main() {
+
+    bool ok = true;
+
+    ok = test<TileScalar>("scalar") && ok;
+    ok = test<TileSSE>("SSE") && ok;
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    ok = test<TileAVX>("AVX") && ok;
+#endif
+#ifdef HAVE_AVX512_INSTRUCTIONS
+    ok = test<TileAVX512>("AVX512F") && ok;
+#endif
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
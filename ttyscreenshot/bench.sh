@@ -0,0 +1,18 @@
+#!/bin/sh
+# Renders a dump of 64x160 screens, frames/s are printed on stderr
+
+FRAMES=${FRAMES:-100}
+TMP=$(mktemp)
+trap 'rm -f $TMP' EXIT
+
+for i in $(seq $FRAMES)
+do
+    printf '\100\240\000\000'
+    head -c $((64*160*2)) /dev/urandom
+done > $TMP
+
+for prog in "ttyscreenshot -s" ttyscreenshot ttyscreenshot_ssse3
+do
+    printf "%-20s" "$prog"
+    ./$prog -v -d $TMP 9 > /dev/null
+done
@@ -4,15 +4,16 @@
 	License: public domain
 
 	compile:
-		gcc -O2 ttyscreenshot.c -o ttyscreenshot
-	
-	
+		make
+
+
 	Author: Wojciech Mua
 	e-mail: wojciech_mula@poczta.onet.pl
 	www:    http://0x80.pl
 
 	Changelog:
 
+		2026-10-18: scanline rendering, dumps of /dev/vcsa, PSF fonts
 		2013-10-13: some cleanups
 		2008-06-21: initial relase
 */
@@ -23,6 +24,7 @@
 #include <limits.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -32,13 +34,22 @@
 #include <sys/ioctl.h>
 #include <sys/kd.h>
 
-extern int errno;
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+#include "../common/font_builtin.h"
+
 typedef void (*save_fun)(uint8_t char_code, uint8_t font_row, uint8_t fore, uint8_t back);
 
 /* aux functions */
 uint8_t swapbits(uint8_t b);
 void save_8bit_width(uint8_t char_code, uint8_t font_row, uint8_t fore, uint8_t back);
 void save_9bit_width(uint8_t char_code, uint8_t font_row, uint8_t fore, uint8_t back);
+void load_console(int console_num);
+void load_psf(const uint8_t* data, size_t size);
+void load_psf_file(const char* name);
+void init_expand_lookup();
 void die(char*);
 void ordie(char*);
 
@@ -48,6 +59,10 @@ void ordie(char*);
 
 /* font data */
 uint8_t font[CHAR_COUNT][CHAR_HEIGHT];
+int font_height = 16;
+
+/* font row expanded to 8 bytes: 0xff for set bits, the leftmost pixel first */
+uint64_t expand_lookup[256];
 
 /* palette data */
 uint8_t palette[16][3] = {
@@ -69,6 +84,13 @@ uint8_t palette[16][3] = {
 	{255, 255, 255}
 };
 
+/* contents of /dev/vcsa: lines, columns, cursor x, y, then pairs (char, attribute) */
+struct screen_t {
+	uint8_t		lines;
+	uint8_t		columns;
+	uint8_t*	cells;
+};
+
 
 void usage() {
 	fputs(
@@ -76,7 +98,8 @@ void usage() {
 		"(PNM is printed on standard output\n"
 		"\n"
 		"usage:\n"
-		"\tttyscreenshot [8|9] console-num\n"
+		"\tttyscreenshot [options] [8|9] console-num\n"
+		"\tttyscreenshot [options] -d dump [8|9]\n"
 		"\n"
 		"First argument is a character width in pixels;\n"
 		"9 pixels is a default width use by EGA/VGA cards,\n"
@@ -84,44 +107,301 @@ void usage() {
 		"\n"
 		"You need permissions to read /dev/vcsa[console-num] device.\n"
 		"\n"
+		"Options:\n"
+		"\t-d file  read screens from file (- is stdin) instead of console;\n"
+		"\t         the file contains one or more copies of /dev/vcsa,\n"
+		"\t         an image is printed for each screen\n"
+		"\t-f font  use PSF font (8 pixels wide) instead of console font;\n"
+		"\t         the builtin font is used with -d when not given\n"
+		"\t-s       render pixel by pixel (reference code)\n"
+		"\t-v       print frames/s on stderr\n"
+		"\n"
 		"Author: Wojciech Mua, http://www.republika.pl/wmula//\n",
-		
+
 		stderr
 	);
 	exit(EXIT_FAILURE);
 }
 
 
-int main(int argv, char* argc[]) {
+/* reads the next screen, returns 0 at the end of file */
+int read_screen(FILE* f, struct screen_t* screen) {
+	uint8_t header[4];
+	size_t size;
 
-	int fd;
-	struct consolefontdesc dsc;
-	char path[PATH_MAX];
-	save_fun save;
-	
-	int  char_width, console_num;	/* program arguments */
-	uint8_t lines, columns;			/* dimensions of console */
+	if (fread(header, 1, 4, f) != 4)
+		return 0;
+
+	screen->lines	= header[0];
+	screen->columns	= header[1];
+
+	size = screen->lines * screen->columns * 2;
+	screen->cells = (uint8_t*)realloc(screen->cells, size);
+	if (screen->cells == NULL)
+		die("malloc failed");
+
+	if (fread(screen->cells, 1, size, f) != size)
+		die("truncated screen dump");
 
-	/* aux vars: */
+	return 1;
+}
+
+
+/* reference code: each pixel is written separately */
+void save_screen_slow(const struct screen_t* screen, int char_width) {
+	save_fun save;
 	uint8_t c, attr, fore, back;
 	int  col, line, y;
 	uint8_t* char_row;
 
+	if (char_width == 8)
+		save = save_8bit_width;
+	else
+		save = save_9bit_width;
+
+	printf("P6\n%d %d\n255\n", screen->columns*char_width, screen->lines*font_height);
+	for (line=0; line < screen->lines; line++) {
+		char_row = screen->cells + line*screen->columns*2;
+
+		/* process each line of font data */
+		for (y=0; y < font_height; y++) {
+			for (col=0; col < screen->columns*2; col+=2) {
+				c    = char_row[col];   /* get charcode */
+				attr = swapbits(char_row[col+1]); /* get attribute - order of bits have to be fixed */
+
+				fore = attr & 0x0f; /* from attribute extract foreground color */
+				back = attr >> 4;   /* and background color */
+				save(c, font[c][y], fore, back);
+			}
+		}
+	}
+}
+
+
+/* expands y-th row of font for a line of chars into palette indices */
+void expand_scanline(const uint8_t* char_row, int columns, int char_width, int y, uint8_t* indices) {
+	const uint64_t ones = 0x0101010101010101llu;
+	uint8_t c, attr, fore, back, row;
+	uint64_t pixels;
+	int col;
+
+	for (col=0; col < columns; col++) {
+		c    = char_row[2*col];
+		attr = swapbits(char_row[2*col + 1]);
+		fore = attr & 0x0f;
+		back = attr >> 4;
+		row  = font[c][y];
+
+		/* select fore or back for all 8 pixels at once */
+		pixels = (back * ones) ^ (expand_lookup[row] & ((fore ^ back) * ones));
+		memcpy(indices, &pixels, 8);
+
+		/* 9-th column (see save_9bit_width) */
+		if (char_width == 9)
+			indices[8] = (c >= 0xbf && c <= 0xdf && (row & 0x01)) ? fore : back;
+
+		indices += char_width;
+	}
+}
+
+
+#ifdef __SSSE3__
+/* pshufb masks interleaving R, G, B vectors into 3 output vectors */
+__m128i interleave_mask[3][3];
+
+void init_interleave() {
+	uint8_t mask[3][3][16];
+	int v, c, j;
+
+	memset(mask, 0x80, sizeof(mask));
+	for (v=0; v < 3; v++)
+		for (j=0; j < 16; j++) {
+			const int k = 16*v + j;
+			mask[v][k % 3][j] = k / 3;
+		}
+
+	for (v=0; v < 3; v++)
+		for (c=0; c < 3; c++)
+			interleave_mask[v][c] = _mm_loadu_si128((__m128i*)mask[v][c]);
+}
+
+
+/* n is a multiply of 16, output has 3*n bytes */
+void indices_to_rgb(const uint8_t* indices, int n, uint8_t* rgb) {
+	uint8_t component[3][16];
+	__m128i lookup[3];
+	int i, v, c;
+
+	for (c=0; c < 3; c++) {
+		for (i=0; i < 16; i++)
+			component[c][i] = palette[i][c];
+
+		lookup[c] = _mm_loadu_si128((__m128i*)component[c]);
+	}
+
+	for (i=0; i < n; i += 16) {
+		const __m128i idx = _mm_loadu_si128((__m128i*)(indices + i));
+		__m128i comp[3];
+
+		for (c=0; c < 3; c++)
+			comp[c] = _mm_shuffle_epi8(lookup[c], idx);
+
+		for (v=0; v < 3; v++) {
+			const __m128i out = _mm_or_si128(
+				_mm_or_si128(_mm_shuffle_epi8(comp[0], interleave_mask[v][0]),
+				             _mm_shuffle_epi8(comp[1], interleave_mask[v][1])),
+				_mm_shuffle_epi8(comp[2], interleave_mask[v][2]));
+
+			_mm_storeu_si128((__m128i*)(rgb + 3*i + 16*v), out);
+		}
+	}
+}
+#else
+void indices_to_rgb(const uint8_t* indices, int n, uint8_t* rgb) {
+	int i;
+	for (i=0; i < n; i++, rgb += 3)
+		memcpy(rgb, palette[indices[i]], 3);
+}
+#endif
+
+
+/* fast code: whole scanlines are expanded and written */
+void save_screen(const struct screen_t* screen, int char_width) {
+	static uint8_t* indices = NULL;
+	static uint8_t* rgb = NULL;
+	static int capacity = 0;
+
+	const int width  = screen->columns*char_width;
+	const int padded = (width + 15) & ~15;
+	int line, y;
+
+	if (padded > capacity) {
+		capacity = padded;
+		indices  = (uint8_t*)realloc(indices, capacity + 8);
+		rgb      = (uint8_t*)realloc(rgb, 3*capacity);
+		if (indices == NULL || rgb == NULL)
+			die("malloc failed");
+
+		memset(indices, 0, capacity + 8);
+	}
+
+	printf("P6\n%d %d\n255\n", width, screen->lines*font_height);
+	for (line=0; line < screen->lines; line++) {
+		const uint8_t* char_row = screen->cells + line*screen->columns*2;
+
+		for (y=0; y < font_height; y++) {
+			expand_scanline(char_row, screen->columns, char_width, y, indices);
+			indices_to_rgb(indices, padded, rgb);
+			fwrite(rgb, 3, width, stdout);
+		}
+	}
+}
+
+
+int main(int argv, char* argc[]) {
+
+	char path[PATH_MAX];
+	FILE* input;
+	struct screen_t screen = {0, 0, NULL};
+
+	int  char_width = 9, console_num = -1;	/* program arguments */
+	char* dump_name = NULL;
+	char* font_name = NULL;
+	int  slow = 0, verbose = 0;
+	int  i, frames;
+	struct timespec t0, t1;
+
 
 	/* 1. Parse program arguments */
-	if (argv < 3)
-		usage();
+	for (i=1; i < argv && argc[i][0] == '-' && argc[i][1] != '\0'; i++) {
+		if (strcmp(argc[i], "-d") == 0 && i + 1 < argv)
+			dump_name = argc[++i];
+		else
+		if (strcmp(argc[i], "-f") == 0 && i + 1 < argv)
+			font_name = argc[++i];
+		else
+		if (strcmp(argc[i], "-s") == 0)
+			slow = 1;
+		else
+		if (strcmp(argc[i], "-v") == 0)
+			verbose = 1;
+		else
+			usage();
+	}
 
-	char_width = atoi(argc[1]);
-	if (char_width != 8 && char_width != 9)
+	if (i < argv && (strcmp(argc[i], "8") == 0 || strcmp(argc[i], "9") == 0))
+		char_width = atoi(argc[i++]);
+	else
+	if (dump_name == NULL)
 		die("First argument (character width) must be either 8 or 9.");
 
-	console_num = atoi(argc[2]);
-	if (console_num < 0 || console_num > 63)
-		die("Second argument (console number) must lie in range 0..63");
+	if (dump_name == NULL) {
+		if (i >= argv)
+			usage();
+
+		console_num = atoi(argc[i]);
+		if (console_num < 0 || console_num > 63)
+			die("Second argument (console number) must lie in range 0..63");
+	}
+
+
+	/* 2. Load fonts and palette */
+	if (console_num >= 0)
+		load_console(console_num);
+	else
+	if (font_name == NULL)
+		load_psf(font_builtin, sizeof(font_builtin));
+
+	if (font_name != NULL)
+		load_psf_file(font_name);
+
+	init_expand_lookup();
+#ifdef __SSSE3__
+	init_interleave();
+#endif
+
+	/* 3. Open screen(s) */
+	errno = 0;
+	if (dump_name == NULL) {
+		snprintf(path, PATH_MAX, "/dev/vcsa%d", console_num);
+		input = fopen(path, "r"); ordie("open(vcsa)");
+	}
+	else
+	if (strcmp(dump_name, "-") == 0)
+		input = stdin;
+	else {
+		input = fopen(dump_name, "r"); ordie("open(dump)");
+	}
+
+	/* 4. Save image(s) */
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (frames=0; read_screen(input, &screen); frames++) {
+		if (slow)
+			save_screen_slow(&screen, char_width);
+		else
+			save_screen(&screen, char_width);
+	}
+	fflush(stdout);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	if (verbose) {
+		const double time = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec)/1e9;
+		fprintf(stderr, "%d frame(s), %.3f s, %.1f frames/s\n", frames, time, frames/time);
+	}
+
+	free(screen.cells);
+	if (input != stdin)
+		fclose(input);
+
+	return 0;
+}
 
 
-	/* 2. Load fonts */
+void load_console(int console_num) {
+	int fd;
+	struct consolefontdesc dsc;
+	char path[PATH_MAX];
+
 	snprintf(path, PATH_MAX, "/dev/tty%d", console_num);
 	fd = open(path, O_RDWR); ordie("open(tty)");
 
@@ -130,58 +410,81 @@ int main(int argv, char* argc[]) {
 	dsc.chardata	= (void*)font;
 	ioctl(fd, GIO_FONTX, &dsc); ordie("ioctl(GIO_FONTX)");
 
-	/* 3. Load palette */
+	if (dsc.charheight > 0 && dsc.charheight <= CHAR_HEIGHT)
+		font_height = dsc.charheight;
+
+	/* palette */
 	ioctl(fd, GIO_CMAP, &palette);
 	if (errno) {
 		fprintf(stderr, "Can't load palette, using defaults.  Reason [errno=%d]: %s\n", errno, strerror(errno));
 		errno = 0;
 	}
-		
-	close(fd); ordie("close(tty)");
 
-	/* 4. Get dimensions of console */
-	snprintf(path, PATH_MAX, "/dev/vcsa%d", console_num);
-	fd = open(path, O_RDWR); ordie("open(vcsa)");
+	close(fd); ordie("close(tty)");
+}
 
-	read(fd, &lines, 1);   ordie("read(lines)");
-	read(fd, &columns, 1); ordie("read(columns)");
 
-	/* 5. Allocate cache memory for a chars row */
-	char_row = (uint8_t*)malloc(columns*2);
-	if (char_row == NULL)
-		die("malloc failed");
-	
-	lseek(fd, 4, SEEK_SET);
+void load_psf(const uint8_t* data, size_t size) {
+	uint32_t header[8];
+	unsigned count, charsize, height, width, offset, c;
 
-	/* 6. Save image */
-	if (char_width == 8)
-		save = save_8bit_width;
+	if (size >= 4 && data[0] == 0x36 && data[1] == 0x04) {
+		/* PSF1: magic, mode, charsize */
+		count	= (data[2] & 0x01) ? 512 : 256;
+		charsize= data[3];
+		height	= charsize;
+		width	= 8;
+		offset	= 4;
+	}
 	else
-		save = save_9bit_width;
+	if (size >= 32 && memcmp(data, "\x72\xb5\x4a\x86", 4) == 0) {
+		/* PSF2: magic, version, headersize, flags, length, charsize, height, width */
+		memcpy(header, data, sizeof(header));
+		offset	= header[2];
+		count	= header[4];
+		charsize= header[5];
+		height	= header[6];
+		width	= header[7];
+	}
+	else
+		die("Not a PSF font.");
 
+	if (count > CHAR_COUNT)
+		count = CHAR_COUNT;
 
-	printf("P6\n%d %d\n255\n", columns*char_width, lines*16);
-	for (line=0; line < lines; line++) {
-		/* load whole character row */
-		read(fd, char_row, columns*2);
+	if (width != 8 || height == 0 || height > CHAR_HEIGHT || charsize != height || offset + count*charsize > size)
+		die("Only PSF fonts 8 pixels wide and up to 32 pixels high are supported.");
 
-		/* process each line of font data */
-		for (y=0; y < 16; y++) {
-			for (col=0; col < columns*2; col+=2) {
-				c    = char_row[col];   /* get charcode */
-				attr = swapbits(char_row[col+1]); /* get attribute - order of bits have to be fixed */
+	memset(font, 0, sizeof(font));
+	for (c=0; c < count; c++)
+		memcpy(font[c], data + offset + c*charsize, charsize);
 
-				fore = attr & 0x0f; /* from attribute extract foreground color */
-				back = attr >> 4;   /* and background color */
-				save(c, font[c][y], fore, back);
-			}
-		}
-	}
+	font_height = height;
+}
 
-	free(char_row);
-	close(fd);
 
-	return 0;
+void load_psf_file(const char* name) {
+	uint8_t data[CHAR_COUNT*2*CHAR_HEIGHT + 64];
+	size_t size;
+	FILE* f;
+
+	f = fopen(name, "rb"); ordie("open(font)");
+	size = fread(data, 1, sizeof(data), f);
+	fclose(f);
+
+	load_psf(data, size);
+}
+
+
+void init_expand_lookup() {
+	int b, i;
+
+	for (b=0; b < 256; b++) {
+		expand_lookup[b] = 0;
+		for (i=0; i < 8; i++)
+			if (b & (0x80 >> i))
+				expand_lookup[b] |= (uint64_t)0xff << (8*i);
+	}
 }
 
 
@@ -194,6 +497,7 @@ uint8_t swapbits(uint8_t b) {
 
 void save_8bit_width(uint8_t char_code, uint8_t font_row, uint8_t fore, uint8_t back) {
 	uint8_t mask;
+	(void)char_code;
 	for (mask = 0x80; mask != 0; mask >>= 1) {
 		if (font_row & mask)
 			fwrite(&palette[fore][0], 3, 1, stdout);
@@ -0,0 +1,32 @@
+#!/bin/sh
+# Compares the scanline rendering with the reference (pixel by pixel) code
+# on random screens.
+
+TMP=$(mktemp -d)
+trap 'rm -rf $TMP' EXIT
+
+# 25x80, 37x101 and 64x160 screens
+for header in '\031\120\000\000' '\045\145\000\000' '\100\240\000\000'
+do
+    printf "$header" >> $TMP/dump
+    head -c $((64*160*2)) /dev/urandom | head -c $(printf "$header" | od -An -tu1 | awk '{print $1*$2*2}') >> $TMP/dump
+done
+
+status=0
+for width in 8 9
+do
+    ./ttyscreenshot -s -d $TMP/dump $width > $TMP/reference
+    for prog in ttyscreenshot ttyscreenshot_ssse3
+    do
+        ./$prog -d $TMP/dump $width > $TMP/result
+        if cmp -s $TMP/reference $TMP/result
+        then
+            echo "$prog, width $width: OK"
+        else
+            echo "$prog, width $width: FAILED"
+            status=1
+        fi
+    done
+done
+
+exit $status
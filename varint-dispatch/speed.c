@@ -0,0 +1,82 @@
+// Throughput of decoders on inputs with predictable and random lengths;
+// branch-misses are reported when hardware counters are available
+
+#include "../common/bench.h"
+
+#include "varint.c"
+
+#define N (64*1024)
+
+uint32_t values[N];
+uint32_t decoded[N];
+uint8_t  encoded[5*N];
+
+
+typedef struct {
+	const char* name;
+	int         percent[5];	// of lengths 1..5
+} distribution;
+
+static const distribution distributions[] = {
+	{"len1",    {100,  0,  0,  0,  0}},
+	{"len3",    {  0,  0,100,  0,  0}},
+	{"skewed",  { 90,  4,  3,  2,  1}},
+	{"uniform", { 20, 20, 20, 20, 20}},
+};
+
+
+size_t prepare(const distribution* d) {
+	size_t i;
+
+	for (i=0; i < N; i++) {
+		int r = rand() % 100;
+		int len = 1;
+
+		while (r >= d->percent[len - 1]) {
+			r -= d->percent[len - 1];
+			len += 1;
+		}
+
+		// the smallest value of the length plus random lower bits
+		values[i] = (len == 1) ? (uint32_t)rand() % 0x80
+		                       : ((uint32_t)1 << (7*(len - 1))) | ((uint32_t)rand() & ((1u << (7*(len - 1))) - 1));
+	}
+
+	return varint_encode(values, N, encoded);
+}
+
+
+int main() {
+	size_t i, j;
+
+	for (i=0; i < sizeof(distributions)/sizeof(distributions[0]); i++) {
+		const distribution* d = &distributions[i];
+		const size_t size = prepare(d);
+
+		for (j=0; j < VARINT_DECODERS; j++) {
+			const varint_decoder* dec = &varint_decoders[j];
+			char name[64];
+			bench b;
+
+			if (!cpu_has(dec->required))
+				continue;
+
+			if (dec->fun(encoded, encoded + size, decoded, N) != encoded + size
+			    || memcmp(values, decoded, sizeof(values)) != 0) {
+				printf("%s: wrong result\n", dec->name);
+				return EXIT_FAILURE;
+			}
+
+			snprintf(name, sizeof(name), "varint-%s/%s/%d", d->name, dec->name, N);
+			bench_begin(&b, name, 200, N);
+			b.bytes = (double)size / N;
+			while (bench_next(&b)) {
+				BENCH_KEEP(dec->fun(encoded, encoded + size, decoded, N));
+				BENCH_CLOBBER();
+			}
+			bench_report(&b);
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
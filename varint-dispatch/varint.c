@@ -0,0 +1,256 @@
+// Decoding of LEB128 varints (protobuf uint32): 7 bits per byte, the
+// least significant group first, bit 7 set in all bytes but the last.
+// A value takes 1..5 bytes; bits above 32 in the fifth byte are dropped,
+// more than five bytes is an error.
+//
+// Decoders take n values from in[0..end), store them in out and return
+// the pointer past the last byte, or NULL if input is malformed or
+// truncated.  The fast ones load 8 bytes at once, find the length class
+// with tzcnt and jump to the code of the class; the last values, where
+// 8 bytes are not available, are decoded by varint_decode_loop.
+//
+// * loop    --- a byte at a time, a branch per byte;
+// * ifchain --- tests of bit 7 of consecutive bytes, a branch per class;
+// * switch  --- the class index in a switch (a shared indirect jump);
+// * goto    --- computed goto, an indirect jump at the end of each class;
+// * asmgoto --- a jump table emitted by asm goto;
+// * pext    --- no dispatch: BMI2 pext gathers 7-bit groups of any length.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "../common/jumptable.h"
+#include "../common/cpudispatch.h"
+
+// bit 7 of the first five bytes
+#define VARINT_STOP_BITS	0x0000008080808080ull
+// the index 5 means: no last byte among the first five
+#define VARINT_SENTINEL		(1ull << 47)
+
+
+size_t varint_encode(const uint32_t* in, size_t n, uint8_t* out) {
+	uint8_t* p = out;
+	size_t i;
+
+	for (i=0; i < n; i++) {
+		uint32_t v = in[i];
+		while (v >= 0x80) {
+			*p++ = (v & 0x7f) | 0x80;
+			v >>= 7;
+		}
+
+		*p++ = v;
+	}
+
+	return p - out;
+}
+
+
+const uint8_t* varint_decode_loop(const uint8_t* in, const uint8_t* end, uint32_t* out, size_t n) {
+	size_t i;
+
+	for (i=0; i < n; i++) {
+		uint32_t v = 0;
+		int k;
+
+		for (k=0; k < 5; k++) {
+			uint8_t b;
+			if (in == end)
+				return NULL;
+
+			b = *in++;
+			v |= (uint32_t)(b & 0x7f) << (7*k);
+			if ((b & 0x80) == 0)
+				break;
+		}
+
+		if (k == 5)
+			return NULL;
+
+		out[i] = v;
+	}
+
+	return in;
+}
+
+
+// w holds at least len bytes of a value; len is a constant, the ifs vanish
+static inline uint32_t varint_value(uint64_t w, int len) {
+	uint32_t v = w & 0x7f;
+
+	if (len > 1) v |= (w >> 1) & 0x00003f80;
+	if (len > 2) v |= (w >> 2) & 0x001fc000;
+	if (len > 3) v |= (w >> 3) & 0x0fe00000;
+	if (len > 4) v |= (w >> 4) & 0xf0000000;
+
+	return v;
+}
+
+
+static inline uint64_t varint_load(const uint8_t* in) {
+	uint64_t w;
+	memcpy(&w, in, 8);
+	return w;
+}
+
+
+static inline unsigned varint_class(uint64_t w) {
+	return jumptable_tzcnt(~w & VARINT_STOP_BITS, VARINT_SENTINEL, 3);
+}
+
+
+const uint8_t* varint_decode_ifchain(const uint8_t* in, const uint8_t* end, uint32_t* out, size_t n) {
+	size_t i;
+
+	for (i=0; i < n && end - in >= 8; i++) {
+		const uint64_t w = varint_load(in);
+
+		if ((w & 0x80) == 0) {
+			out[i] = varint_value(w, 1);
+			in += 1;
+		} else if ((w & 0x8000) == 0) {
+			out[i] = varint_value(w, 2);
+			in += 2;
+		} else if ((w & 0x800000) == 0) {
+			out[i] = varint_value(w, 3);
+			in += 3;
+		} else if ((w & 0x80000000) == 0) {
+			out[i] = varint_value(w, 4);
+			in += 4;
+		} else if ((w & 0x8000000000) == 0) {
+			out[i] = varint_value(w, 5);
+			in += 5;
+		} else
+			return NULL;
+	}
+
+	return varint_decode_loop(in, end, out + i, n - i);
+}
+
+
+const uint8_t* varint_decode_switch(const uint8_t* in, const uint8_t* end, uint32_t* out, size_t n) {
+	size_t i;
+
+	for (i=0; i < n && end - in >= 8; i++) {
+		const uint64_t w = varint_load(in);
+
+		switch (varint_class(w)) {
+			case 0: out[i] = varint_value(w, 1); in += 1; break;
+			case 1: out[i] = varint_value(w, 2); in += 2; break;
+			case 2: out[i] = varint_value(w, 3); in += 3; break;
+			case 3: out[i] = varint_value(w, 4); in += 4; break;
+			case 4: out[i] = varint_value(w, 5); in += 5; break;
+			case 5: return NULL;
+			default: __builtin_unreachable();
+		}
+	}
+
+	return varint_decode_loop(in, end, out + i, n - i);
+}
+
+
+// the code of a class: store, advance, dispatch the next value (each
+// class has its own copy of the dispatch)
+#define VARINT_CASE(len, dispatch) \
+	out[i++] = varint_value(w, len); \
+	in += len; \
+	if (i == n || end - in < 8) \
+		goto tail; \
+	w = varint_load(in); \
+	dispatch;
+
+#define VARINT_GOTO JUMPTABLE_GOTO(classes, varint_class(w))
+
+JUMPTABLE_THREADED
+const uint8_t* varint_decode_goto(const uint8_t* in, const uint8_t* end, uint32_t* out, size_t n) {
+	JUMPTABLE_DEFINE(classes, len1, len2, len3, len4, len5, error);
+	uint64_t w;
+	size_t i = 0;
+
+	if (n == 0 || end - in < 8)
+		goto tail;
+
+	w = varint_load(in);
+	VARINT_GOTO;
+
+len1: VARINT_CASE(1, VARINT_GOTO)
+len2: VARINT_CASE(2, VARINT_GOTO)
+len3: VARINT_CASE(3, VARINT_GOTO)
+len4: VARINT_CASE(4, VARINT_GOTO)
+len5: VARINT_CASE(5, VARINT_GOTO)
+error:
+	return NULL;
+tail:
+	return varint_decode_loop(in, end, out + i, n - i);
+}
+
+#undef VARINT_GOTO
+#define VARINT_ASM_GOTO JUMPTABLE_ASM_GOTO(varint_class(w), len1, len2, len3, len4, len5, error)
+
+JUMPTABLE_THREADED
+const uint8_t* varint_decode_asmgoto(const uint8_t* in, const uint8_t* end, uint32_t* out, size_t n) {
+	uint64_t w;
+	size_t i = 0;
+
+	if (n == 0 || end - in < 8)
+		goto tail;
+
+	w = varint_load(in);
+	VARINT_ASM_GOTO;
+
+len1: VARINT_CASE(1, VARINT_ASM_GOTO)
+len2: VARINT_CASE(2, VARINT_ASM_GOTO)
+len3: VARINT_CASE(3, VARINT_ASM_GOTO)
+len4: VARINT_CASE(4, VARINT_ASM_GOTO)
+len5: VARINT_CASE(5, VARINT_ASM_GOTO)
+error:
+	return NULL;
+tail:
+	return varint_decode_loop(in, end, out + i, n - i);
+}
+
+#undef VARINT_ASM_GOTO
+#undef VARINT_CASE
+
+
+CPU_TARGET_BEGIN("bmi,bmi2")
+const uint8_t* varint_decode_pext(const uint8_t* in, const uint8_t* end, uint32_t* out, size_t n) {
+	size_t i;
+
+	for (i=0; i < n && end - in >= 8; i++) {
+		const uint64_t w = varint_load(in);
+		const unsigned len = varint_class(w) + 1;
+
+		if (len > 5)
+			return NULL;
+
+		// groups of the first len bytes
+		out[i] = (uint32_t)_pext_u64(w, _bzhi_u64(0x7f7f7f7f7full, 8*len));
+		in += len;
+	}
+
+	return varint_decode_loop(in, end, out + i, n - i);
+}
+CPU_TARGET_END
+
+
+typedef const uint8_t* (*varint_decode_fun)(const uint8_t*, const uint8_t*, uint32_t*, size_t);
+
+typedef struct {
+	varint_decode_fun fun;
+	const char*       name;
+	uint32_t          required;	// CPU_xxx flags
+} varint_decoder;
+
+static const varint_decoder varint_decoders[] = {
+	{varint_decode_loop,    "loop",    0},
+	{varint_decode_ifchain, "ifchain", 0},
+	{varint_decode_switch,  "switch",  0},
+	{varint_decode_goto,    "goto",    0},
+	{varint_decode_asmgoto, "asmgoto", 0},
+	{varint_decode_pext,    "pext",    CPU_BMI1 | CPU_BMI2},
+};
+
+#define VARINT_DECODERS (sizeof(varint_decoders)/sizeof(varint_decoders[0]))
@@ -0,0 +1,94 @@
+// All decoders against varint_decode_loop, on valid, truncated and
+// malformed input
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "varint.c"
+
+#define N 10000
+
+uint32_t values[N];
+uint32_t decoded[N];
+uint8_t  encoded[5*N + 16];
+
+
+uint32_t random_value() {
+	// all lengths are equally likely
+	const int bits = 7*(rand() % 5) + 7;
+	const uint32_t v = rand() ^ ((uint32_t)rand() << 16);
+
+	return (bits >= 32) ? v : v & ((1u << bits) - 1);
+}
+
+
+int verify(const varint_decoder* d) {
+	const uint8_t* end;
+	size_t size, n, i;
+
+	for (i=0; i < N; i++)
+		values[i] = random_value();
+
+	values[0] = 0;
+	values[1] = 0xffffffff;
+	values[2] = 0x7f;
+	values[3] = 0x80;
+
+	size = varint_encode(values, N, encoded);
+
+	// the whole input, then shorter ones: the end within the last 8 bytes
+	for (n=N; n + 20 > N; n--) {
+		const size_t len = varint_encode(values, n, encoded);
+
+		memset(decoded, 0, sizeof(decoded));
+		end = d->fun(encoded, encoded + len, decoded, n);
+		if (end != encoded + len || memcmp(values, decoded, n * sizeof(uint32_t)) != 0) {
+			printf("%s: n=%lu: wrong result\n", d->name, (unsigned long)n);
+			return 0;
+		}
+	}
+
+	size = varint_encode(values, N, encoded);
+
+	// truncated: the last value lacks its last byte
+	if (d->fun(encoded, encoded + size - 1, decoded, N) != NULL) {
+		printf("%s: truncated input not detected\n", d->name);
+		return 0;
+	}
+
+	// malformed: six bytes
+	for (i=0; i < 100; i++) {
+		const size_t at = varint_encode(values, i, encoded);
+		memcpy(encoded + at, "\x80\x80\x80\x80\x80\x01", 6);
+		varint_encode(values + i + 1, N - i - 1, encoded + at + 6);
+
+		if (d->fun(encoded, encoded + size + 16, decoded, N) != NULL) {
+			printf("%s: six-byte value at %lu not detected\n", d->name, (unsigned long)i);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+
+int main() {
+	size_t i;
+	int ok = 1;
+
+	for (i=0; i < VARINT_DECODERS; i++) {
+		const varint_decoder* d = &varint_decoders[i];
+
+		if (!cpu_has(d->required)) {
+			printf("%-8s: not supported\n", d->name);
+			continue;
+		}
+
+		if (verify(d))
+			printf("%-8s: OK\n", d->name);
+		else
+			ok = 0;
+	}
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
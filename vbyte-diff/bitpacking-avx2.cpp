@@ -0,0 +1,23 @@
+namespace bitpacking {
+
+    struct avx8 {
+        static const int lanes = 8;
+        __m256i v;
+
+        static FORCE_INLINE avx8 load(const uint32_t* p) { return {_mm256_loadu_si256((const __m256i*)p)}; }
+        FORCE_INLINE void store(uint32_t* p) const { _mm256_storeu_si256((__m256i*)p, v); }
+        static FORCE_INLINE avx8 set1(uint32_t x) { return {_mm256_set1_epi32(x)}; }
+
+        FORCE_INLINE avx8 operator|(const avx8& b) const { return {_mm256_or_si256(v, b.v)}; }
+        FORCE_INLINE avx8 operator&(const avx8& b) const { return {_mm256_and_si256(v, b.v)}; }
+        FORCE_INLINE avx8 operator+(const avx8& b) const { return {_mm256_add_epi32(v, b.v)}; }
+        FORCE_INLINE avx8 operator-(const avx8& b) const { return {_mm256_sub_epi32(v, b.v)}; }
+        FORCE_INLINE avx8 operator<<(int n) const { return {_mm256_slli_epi32(v, n)}; }
+        FORCE_INLINE avx8 operator>>(int n) const { return {_mm256_srli_epi32(v, n)}; }
+    };
+
+} // namespace bitpacking
+
+
+const bitpack_fun bitpack8_avx2[33]     = BITPACKING_TABLE(bitpacking::pack,   bitpacking::avx8);
+const bitpack_fun bitunpack8_avx2[33]   = BITPACKING_TABLE(bitpacking::unpack, bitpacking::avx8);
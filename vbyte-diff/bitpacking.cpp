@@ -0,0 +1,219 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <immintrin.h>
+
+#ifndef FORCE_INLINE
+#   define FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+// Vertical bit-packing: 32*L values are split into L lanes, value i goes
+// to lane i % L; each lane packs its 32 values into B words, so word k
+// of lane l is stored at out[k*L + l].  Thanks to that a vector register
+// of L words packs/unpacks L values at once with plain shifts.
+//
+// Both layouts, L = 4 and L = 8, are available; SSE handles 8 lanes as
+// two registers.  Before packing base is subtracted (frame-of-reference)
+// and bits above B are cleared; unpacking adds base back.
+
+
+typedef void (*bitpack_fun)(const uint32_t* in, uint32_t* out, uint32_t base);
+
+
+namespace bitpacking {
+
+    FORCE_INLINE constexpr uint32_t mask(int bits) {
+        return (bits == 32) ? 0xffffffff : (uint32_t(1) << bits) - 1;
+    }
+
+
+    // L-lane "vector" of plain integers, a reference for SIMD code
+    template <int L>
+    struct scalar {
+        static const int lanes = L;
+        uint32_t v[L];
+
+        static FORCE_INLINE scalar load(const uint32_t* p) {
+            scalar r; memcpy(r.v, p, sizeof(r.v)); return r;
+        }
+
+        FORCE_INLINE void store(uint32_t* p) const {
+            memcpy(p, v, sizeof(v));
+        }
+
+        static FORCE_INLINE scalar set1(uint32_t x) {
+            scalar r; for (int i=0; i < L; i++) r.v[i] = x; return r;
+        }
+
+#define SCALAR_OP(op, arg_type, arg) \
+        FORCE_INLINE scalar operator op(arg_type b) const { \
+            scalar r; for (int i=0; i < L; i++) r.v[i] = v[i] op arg; return r; \
+        }
+
+        SCALAR_OP(|, const scalar&, b.v[i])
+        SCALAR_OP(&, const scalar&, b.v[i])
+        SCALAR_OP(+, const scalar&, b.v[i])
+        SCALAR_OP(-, const scalar&, b.v[i])
+        SCALAR_OP(<<, int, b)
+        SCALAR_OP(>>, int, b)
+#undef SCALAR_OP
+    };
+
+
+    struct sse4 {
+        static const int lanes = 4;
+        __m128i v;
+
+        static FORCE_INLINE sse4 load(const uint32_t* p) { return {_mm_loadu_si128((const __m128i*)p)}; }
+        FORCE_INLINE void store(uint32_t* p) const { _mm_storeu_si128((__m128i*)p, v); }
+        static FORCE_INLINE sse4 set1(uint32_t x) { return {_mm_set1_epi32(x)}; }
+
+        FORCE_INLINE sse4 operator|(const sse4& b) const { return {_mm_or_si128(v, b.v)}; }
+        FORCE_INLINE sse4 operator&(const sse4& b) const { return {_mm_and_si128(v, b.v)}; }
+        FORCE_INLINE sse4 operator+(const sse4& b) const { return {_mm_add_epi32(v, b.v)}; }
+        FORCE_INLINE sse4 operator-(const sse4& b) const { return {_mm_sub_epi32(v, b.v)}; }
+        FORCE_INLINE sse4 operator<<(int n) const { return {_mm_slli_epi32(v, n)}; }
+        FORCE_INLINE sse4 operator>>(int n) const { return {_mm_srli_epi32(v, n)}; }
+    };
+
+
+    // 8 lanes in two SSE registers
+    struct sse8 {
+        static const int lanes = 8;
+        sse4 lo, hi;
+
+        static FORCE_INLINE sse8 load(const uint32_t* p) { return {sse4::load(p), sse4::load(p + 4)}; }
+        FORCE_INLINE void store(uint32_t* p) const { lo.store(p); hi.store(p + 4); }
+        static FORCE_INLINE sse8 set1(uint32_t x) { return {sse4::set1(x), sse4::set1(x)}; }
+
+        FORCE_INLINE sse8 operator|(const sse8& b) const { return {lo | b.lo, hi | b.hi}; }
+        FORCE_INLINE sse8 operator&(const sse8& b) const { return {lo & b.lo, hi & b.hi}; }
+        FORCE_INLINE sse8 operator+(const sse8& b) const { return {lo + b.lo, hi + b.hi}; }
+        FORCE_INLINE sse8 operator-(const sse8& b) const { return {lo - b.lo, hi - b.hi}; }
+        FORCE_INLINE sse8 operator<<(int n) const { return {lo << n, hi << n}; }
+        FORCE_INLINE sse8 operator>>(int n) const { return {lo >> n, hi >> n}; }
+    };
+
+
+    template <typename V, int B>
+    void pack(const uint32_t* in, uint32_t* out, uint32_t base) {
+
+        const int L = V::lanes;
+        if (B == 0) {
+            return;
+        }
+
+        const V b = V::set1(base);
+        const V m = V::set1(mask(B));
+
+        V   acc   = V::set1(0);
+        int shift = 0;
+        int k     = 0;
+
+        #pragma GCC unroll 32
+        for (int j=0; j < 32; j++) {
+            V v = V::load(in + j*L) - b;
+            if (B < 32) {
+                v = v & m;
+            }
+
+            acc = acc | (v << shift);
+            shift += B;
+            if (shift >= 32) {
+                acc.store(out + k*L);
+                k += 1;
+                shift -= 32;
+                // bits which didn't fit into the previous word
+                acc = (shift > 0) ? (v >> (B - shift)) : V::set1(0);
+            }
+        }
+    }
+
+
+    template <typename V, int B>
+    void unpack(const uint32_t* in, uint32_t* out, uint32_t base) {
+
+        const int L = V::lanes;
+        const V b = V::set1(base);
+
+        if (B == 0) {
+            for (int j=0; j < 32; j++) {
+                b.store(out + j*L);
+            }
+            return;
+        }
+
+        const V m = V::set1(mask(B));
+
+        V   w     = V::load(in);
+        int shift = 0;
+        int k     = 1;
+
+        #pragma GCC unroll 32
+        for (int j=0; j < 32; j++) {
+            V v = w >> shift;
+            shift += B;
+            if (shift > 32) {
+                // value spans two words
+                w = V::load(in + k*L);
+                k += 1;
+                shift -= 32;
+                v = v | (w << (B - shift));
+            } else if (shift == 32 && j < 31) {
+                w = V::load(in + k*L);
+                k += 1;
+                shift = 0;
+            }
+
+            if (B < 32) {
+                v = v & m;
+            }
+
+            (v + b).store(out + j*L);
+        }
+    }
+
+} // namespace bitpacking
+
+
+#define BITPACKING_TABLE(fun, V) { \
+    fun<V,  0>, fun<V,  1>, fun<V,  2>, fun<V,  3>, fun<V,  4>, fun<V,  5>, fun<V,  6>, fun<V,  7>, \
+    fun<V,  8>, fun<V,  9>, fun<V, 10>, fun<V, 11>, fun<V, 12>, fun<V, 13>, fun<V, 14>, fun<V, 15>, \
+    fun<V, 16>, fun<V, 17>, fun<V, 18>, fun<V, 19>, fun<V, 20>, fun<V, 21>, fun<V, 22>, fun<V, 23>, \
+    fun<V, 24>, fun<V, 25>, fun<V, 26>, fun<V, 27>, fun<V, 28>, fun<V, 29>, fun<V, 30>, fun<V, 31>, \
+    fun<V, 32>}
+
+// functions indexed by bit width 0..32; 4-lane layout packs 128 values,
+// 8-lane layout 256 values
+const bitpack_fun bitpack4_scalar[33]   = BITPACKING_TABLE(bitpacking::pack,   bitpacking::scalar<4>);
+const bitpack_fun bitunpack4_scalar[33] = BITPACKING_TABLE(bitpacking::unpack, bitpacking::scalar<4>);
+const bitpack_fun bitpack4_sse[33]      = BITPACKING_TABLE(bitpacking::pack,   bitpacking::sse4);
+const bitpack_fun bitunpack4_sse[33]    = BITPACKING_TABLE(bitpacking::unpack, bitpacking::sse4);
+
+const bitpack_fun bitpack8_scalar[33]   = BITPACKING_TABLE(bitpacking::pack,   bitpacking::scalar<8>);
+const bitpack_fun bitunpack8_scalar[33] = BITPACKING_TABLE(bitpacking::unpack, bitpacking::scalar<8>);
+const bitpack_fun bitpack8_sse[33]      = BITPACKING_TABLE(bitpacking::pack,   bitpacking::sse8);
+const bitpack_fun bitunpack8_sse[33]    = BITPACKING_TABLE(bitpacking::unpack, bitpacking::sse8);
+
+
+// Bit by bit packing, used to validate the layout.
+void bitpack_reference(const uint32_t* in, uint32_t* out, int bits, int lanes, uint32_t base) {
+
+    memset(out, 0, bits * lanes * sizeof(uint32_t));
+    for (int l=0; l < lanes; l++) {
+        int pos = 0;
+        for (int j=0; j < 32; j++) {
+            const uint32_t v = (in[j*lanes + l] - base) & bitpacking::mask(bits);
+            for (int t=0; t < bits; t++, pos++) {
+                if (v & (uint32_t(1) << t)) {
+                    out[(pos / 32)*lanes + l] |= uint32_t(1) << (pos % 32);
+                }
+            }
+        }
+    }
+}
+
+
+#ifdef HAVE_AVX2_INSTRUCTIONS
+#   include "bitpacking-avx2.cpp"
+#endif
@@ -0,0 +1,306 @@
+#include "streamvbyte.cpp"
+#include "bitpacking.cpp"
+
+#include <algorithm>
+
+// Block codec: input is split into blocks of 256 values (the last one is
+// padded), each block is saved with a scheme picked by the cost model:
+//
+// * frame-of-reference: values minus the block minimum, bit-packed with
+//   the smallest width that fits all of them;
+// * patched frame-of-reference (PFor): a smaller width b; values that
+//   don't fit are exceptions, their higher bits are stored separately;
+// * Stream VByte of values minus the block minimum.
+//
+// Block layout:
+//
+//   byte     b -- bit width 0..32 (FOR/PFor), 0xff -- Stream VByte
+//   uint32   minimum
+//   PFor:    byte e -- number of exceptions, 0..255
+//            b*32 bytes -- 8-lane bit-packed lower bits
+//            e bytes -- positions of exceptions
+//            Stream VByte of e higher parts (value >> b)
+//   VByte:   Stream VByte of 256 values
+//
+// The cost model uses only a histogram of bit widths of values (minus
+// minimum), like get_vbyte_statistics in vbyte.py.
+
+
+namespace blockcodec {
+
+    const size_t block_size = 256;
+    const uint8_t streamvbyte_tag = 0xff;
+
+    FORCE_INLINE int bit_width(uint32_t x) {
+        return x ? 32 - __builtin_clz(x) : 0;
+    }
+
+
+    struct Choice {
+        uint8_t tag;        // bit width or streamvbyte_tag
+        size_t  exceptions; // PFor: number of exceptions
+        size_t  size;       // estimated size in bytes
+    };
+
+
+    // counts[w] -- number of values having exactly w significant bits
+    Choice choose(const uint32_t counts[33]) {
+
+        // above[b] -- number of values wider than b bits
+        size_t above[33 + 24];
+        above[32] = 0;
+        for (int b=31; b >= 0; b--) {
+            above[b] = above[b + 1] + counts[b + 1];
+        }
+        std::fill(above + 33, above + 33 + 24, 0);
+
+        // Stream VByte: each value takes at least one byte, the next one if
+        // it's wider than 8 bits, etc.
+        const size_t vbyte = 1 + 4 + block_size/4 + block_size + above[8] + above[16] + above[24];
+
+        Choice best = {streamvbyte_tag, 0, vbyte};
+
+        int max_width = 32;
+        while (max_width > 0 && counts[max_width] == 0) {
+            max_width -= 1;
+        }
+
+        for (int b=max_width; b >= 0 && above[b] <= 255; b--) {
+            const size_t exceptions = above[b];
+
+            size_t size = 1 + 4 + 1 + 32*b;
+            if (exceptions > 0) {
+                // positions, control bytes and data of Stream VByte: higher
+                // part (w - b bits) takes ceil((w - b)/8) bytes
+                size += exceptions + (exceptions + 3)/4
+                      + above[b] + above[b + 8] + above[b + 16] + above[b + 24];
+            }
+
+            if (size < best.size) {
+                best.tag        = b;
+                best.exceptions = exceptions;
+                best.size       = size;
+            }
+        }
+
+        return best;
+    }
+
+
+    struct Scalar {
+        static FORCE_INLINE void pack(int b, const uint32_t* in, uint32_t* out, uint32_t base) {
+            bitpack8_scalar[b](in, out, base);
+        }
+
+        static FORCE_INLINE void unpack(int b, const uint32_t* in, uint32_t* out, uint32_t base) {
+            bitunpack8_scalar[b](in, out, base);
+        }
+
+        static FORCE_INLINE size_t encode(const uint32_t* in, size_t n, uint8_t* out) {
+            return streamvbyte_encode_scalar<false>(in, n, out);
+        }
+
+        static FORCE_INLINE size_t decode(const uint8_t* in, size_t size, uint32_t* out, size_t n) {
+            return streamvbyte_decode_scalar<false>(in, size, out, n);
+        }
+    };
+
+
+    struct SSE {
+        static FORCE_INLINE void pack(int b, const uint32_t* in, uint32_t* out, uint32_t base) {
+            bitpack8_sse[b](in, out, base);
+        }
+
+        static FORCE_INLINE void unpack(int b, const uint32_t* in, uint32_t* out, uint32_t base) {
+            bitunpack8_sse[b](in, out, base);
+        }
+
+        static FORCE_INLINE size_t encode(const uint32_t* in, size_t n, uint8_t* out) {
+            return streamvbyte_encode_sse<false>(in, n, out);
+        }
+
+        static FORCE_INLINE size_t decode(const uint8_t* in, size_t size, uint32_t* out, size_t n) {
+            return streamvbyte_decode_sse<false>(in, size, out, n);
+        }
+    };
+
+
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    struct AVX2 {
+        static FORCE_INLINE void pack(int b, const uint32_t* in, uint32_t* out, uint32_t base) {
+            bitpack8_avx2[b](in, out, base);
+        }
+
+        static FORCE_INLINE void unpack(int b, const uint32_t* in, uint32_t* out, uint32_t base) {
+            bitunpack8_avx2[b](in, out, base);
+        }
+
+        static FORCE_INLINE size_t encode(const uint32_t* in, size_t n, uint8_t* out) {
+            return streamvbyte_encode_avx2<false>(in, n, out);
+        }
+
+        static FORCE_INLINE size_t decode(const uint8_t* in, size_t size, uint32_t* out, size_t n) {
+            return streamvbyte_decode_avx2<false>(in, size, out, n);
+        }
+    };
+#endif
+
+
+    template <typename IMPL>
+    uint8_t* encode_block(const uint32_t* in, uint8_t* out) {
+
+        uint32_t min = in[0];
+        for (size_t i=1; i < block_size; i++) {
+            min = std::min(min, in[i]);
+        }
+
+        // four histograms, to not serialize increments of the same counter
+        uint32_t histogram[4][33] = {{0}};
+        for (size_t i=0; i < block_size; i += 4) {
+            histogram[0][bit_width(in[i + 0] - min)] += 1;
+            histogram[1][bit_width(in[i + 1] - min)] += 1;
+            histogram[2][bit_width(in[i + 2] - min)] += 1;
+            histogram[3][bit_width(in[i + 3] - min)] += 1;
+        }
+
+        uint32_t counts[33];
+        for (int w=0; w <= 32; w++) {
+            counts[w] = histogram[0][w] + histogram[1][w] + histogram[2][w] + histogram[3][w];
+        }
+
+        const Choice choice = choose(counts);
+
+        *out++ = choice.tag;
+        memcpy(out, &min, 4);
+        out += 4;
+
+        if (choice.tag == streamvbyte_tag) {
+            uint32_t tmp[block_size];
+            for (size_t i=0; i < block_size; i++) {
+                tmp[i] = in[i] - min;
+            }
+
+            return out + IMPL::encode(tmp, block_size, out);
+        }
+
+        const int b = choice.tag;
+        uint8_t& exceptions = *out++;
+
+        // SIMD code uses unaligned loads and stores, scalar memcpy
+        IMPL::pack(b, in, (uint32_t*)out, min);
+        out += 32*b;
+
+        uint32_t high[block_size];
+        size_t count = 0;
+        if (choice.exceptions > 0) {
+            // branchless: a slot is overwritten unless value is an exception
+            for (size_t i=0; i < block_size; i++) {
+                const uint32_t v = (in[i] - min) >> b;
+                out[count]  = i;
+                high[count] = v;
+                count += (v != 0);
+            }
+        }
+
+        exceptions = count;
+        if (exceptions > 0) {
+            out += exceptions;
+            out += IMPL::encode(high, exceptions, out);
+        }
+
+        return out;
+    }
+
+
+    template <typename IMPL>
+    const uint8_t* decode_block(const uint8_t* in, const uint8_t* end, uint32_t* out) {
+
+        const uint8_t tag = *in++;
+        uint32_t min;
+        memcpy(&min, in, 4);
+        in += 4;
+
+        if (tag == streamvbyte_tag) {
+            in += IMPL::decode(in, end - in, out, block_size);
+            for (size_t i=0; i < block_size; i++) {
+                out[i] += min;
+            }
+
+            return in;
+        }
+
+        const int b = tag;
+        const uint8_t exceptions = *in++;
+
+        IMPL::unpack(b, (const uint32_t*)in, out, min);
+        in += 32*b;
+
+        if (exceptions > 0) {
+            const uint8_t* position = in;
+            in += exceptions;
+
+            uint32_t high[block_size];
+            in += IMPL::decode(in, end - in, high, exceptions);
+            for (int i=0; i < exceptions; i++) {
+                out[position[i]] += high[i] << b;
+            }
+        }
+
+        return in;
+    }
+
+} // namespace blockcodec
+
+
+// Size of output buffer for blockcodec_encode.
+size_t blockcodec_max_size(size_t n) {
+    const size_t blocks = (n + blockcodec::block_size - 1) / blockcodec::block_size;
+
+    // the cost model never picks anything larger than FOR with 32 bits
+    return blocks * (1 + 4 + 1 + 4*blockcodec::block_size) + 16;
+}
+
+
+template <typename IMPL>
+size_t blockcodec_encode(const uint32_t* in, size_t n, uint8_t* out) {
+
+    using namespace blockcodec;
+
+    uint8_t* p = out;
+    size_t i;
+    for (i=0; i + block_size <= n; i += block_size) {
+        p = encode_block<IMPL>(in + i, p);
+    }
+
+    if (i < n) {
+        // pad the last block with its first value, thus neither minimum
+        // nor width changes
+        uint32_t tmp[block_size];
+        std::fill(std::copy(in + i, in + n, tmp), tmp + block_size, in[i]);
+        p = encode_block<IMPL>(tmp, p);
+    }
+
+    return p - out;
+}
+
+
+template <typename IMPL>
+size_t blockcodec_decode(const uint8_t* in, size_t size, uint32_t* out, size_t n) {
+
+    using namespace blockcodec;
+
+    const uint8_t* p   = in;
+    const uint8_t* end = in + size;
+    size_t i;
+    for (i=0; i + block_size <= n; i += block_size) {
+        p = decode_block<IMPL>(p, end, out + i);
+    }
+
+    if (i < n) {
+        uint32_t tmp[block_size];
+        p = decode_block<IMPL>(p, end, tmp);
+        std::copy(tmp, tmp + (n - i), out + i);
+    }
+
+    return p - in;
+}
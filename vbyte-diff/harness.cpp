@@ -0,0 +1,105 @@
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+// Common code of benchmarks: input data and measurement of encoders and
+// decoders.  An encoder is called as encode(in, n, out) and returns the
+// number of bytes, a decoder as decode(in, size, out, n).
+
+
+// the same input as in vbyte.py: uniform values from range [0, 2^bits - 1]
+std::vector<uint32_t> random_input(size_t n, int bits) {
+
+    std::mt19937 random(0);
+    const uint32_t max = (bits == 32) ? 0xffffffff : (uint32_t(1) << bits) - 1;
+    std::uniform_int_distribution<uint32_t> dist(0, max);
+
+    std::vector<uint32_t> data(n);
+    for (auto& x: data) x = dist(random);
+
+    return data;
+}
+
+
+// values from range [0, 2^bits - 1] with outliers, each 32-bit random,
+// placed at random positions with probability 1/every
+std::vector<uint32_t> outliers_input(size_t n, int bits, int every) {
+
+    std::vector<uint32_t> data = random_input(n, bits);
+
+    std::mt19937 random(1);
+    for (auto& x: data) {
+        if (random() % every == 0) {
+            x = random();
+        }
+    }
+
+    return data;
+}
+
+
+class Test {
+
+    const std::vector<uint32_t>& input;
+    const size_t iterations;
+    std::vector<uint8_t>  encoded;
+    std::vector<uint32_t> output;
+    size_t size;
+
+public:
+    Test(const std::vector<uint32_t>& input, size_t max_size)
+        : input(input)
+        , iterations(std::max(size_t(1), size_t(100*1000*1000) / input.size()))
+        , encoded(max_size)
+        , output(input.size())
+        , size(0) {}
+
+    size_t encoded_size() const {
+        return size;
+    }
+
+    // uncompressed size / encoded size
+    double ratio() const {
+        return 4.0 * input.size() / size;
+    }
+
+    // returns billions of integers per second
+    template <typename ENCODE>
+    double encode(ENCODE fun) {
+
+        const auto t1 = std::chrono::steady_clock::now();
+        for (size_t i=0; i < iterations; i++) {
+            size = fun(input.data(), input.size(), encoded.data());
+        }
+        const auto t2 = std::chrono::steady_clock::now();
+
+        return rate(t2 - t1);
+    }
+
+    template <typename DECODE>
+    double decode(DECODE fun) {
+
+        const auto t1 = std::chrono::steady_clock::now();
+        for (size_t i=0; i < iterations; i++) {
+            fun(encoded.data(), size, output.data(), output.size());
+        }
+        const auto t2 = std::chrono::steady_clock::now();
+
+        if (output != input) {
+            puts("decoding error");
+            exit(EXIT_FAILURE);
+        }
+
+        return rate(t2 - t1);
+    }
+
+private:
+    double rate(std::chrono::steady_clock::duration time) const {
+        const double t = std::chrono::duration<double>(time).count();
+        return double(iterations) * input.size() / t / 1e9;
+    }
+};
@@ -0,0 +1,207 @@
+#include <string>
+
+#include "harness.cpp"
+#include "blockcodec.cpp"
+
+
+template <bool delta>
+void measure_streamvbyte(const char* name, const std::vector<uint32_t>& input) {
+
+    Test test(input, streamvbyte_max_size(input.size()));
+
+#define ENCODE(fun) [](const uint32_t* in, size_t n, uint8_t* out) { return fun(in, n, out, 0); }
+#define DECODE(fun) [](const uint8_t* in, size_t size, uint32_t* out, size_t n) { return fun(in, size, out, n, 0); }
+
+    const double scalar_encode = test.encode(ENCODE(streamvbyte_encode_scalar<delta>));
+    const double scalar_decode = test.decode(DECODE(streamvbyte_decode_scalar<delta>));
+    const double sse_encode    = test.encode(ENCODE(streamvbyte_encode_sse<delta>));
+    const double sse_decode    = test.decode(DECODE(streamvbyte_decode_sse<delta>));
+
+    printf("%-8s %5.2f | %5.2f %5.2f | %5.2f %5.2f",
+           name, test.ratio(),
+           scalar_encode, scalar_decode, sse_encode, sse_decode);
+
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    const double avx2_encode   = test.encode(ENCODE(streamvbyte_encode_avx2<delta>));
+    const double avx2_decode   = test.decode(DECODE(streamvbyte_decode_avx2<delta>));
+
+    printf(" | %5.2f %5.2f", avx2_encode, avx2_decode);
+#endif
+
+#undef ENCODE
+#undef DECODE
+
+    putchar('\n');
+}
+
+
+void speed_streamvbyte() {
+
+    const size_t n = 1024 * 100;
+
+    puts("Stream VByte");
+    puts("ratio: uncompressed size / encoded size, speed: billions of integers/s");
+    puts("d1: input sorted, differences encoded");
+    puts("");
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    puts("bits mode     ratio | scalar      | SSE         | AVX2");
+    puts("                    | enc   dec   | enc   dec   | enc   dec");
+#else
+    puts("bits mode     ratio | scalar      | SSE");
+    puts("                    | enc   dec   | enc   dec");
+#endif
+
+    for (int bits: {1, 4, 8, 9, 12, 16, 17, 20, 24, 25, 28, 32}) {
+        std::vector<uint32_t> input = random_input(n, bits);
+
+        printf("%4d ", bits);
+        measure_streamvbyte<false>("raw", input);
+
+        std::sort(input.begin(), input.end());
+        printf("%4s ", "");
+        measure_streamvbyte<true>("d1", input);
+    }
+}
+
+
+// packs/unpacks blocks of the input, returns billions of integers/s
+double measure_bitpacking(bitpack_fun fun, const std::vector<uint32_t>& in, std::vector<uint32_t>& out, size_t block) {
+
+    const size_t blocks = in.size() / block;
+    const size_t iterations = 200*1000*1000 / in.size();
+
+    const auto t1 = std::chrono::steady_clock::now();
+    for (size_t k=0; k < iterations; k++) {
+        for (size_t i=0; i < blocks; i++) {
+            fun(in.data() + i*block, out.data() + i*block, 0);
+        }
+    }
+    const auto t2 = std::chrono::steady_clock::now();
+
+    const double t = std::chrono::duration<double>(t2 - t1).count();
+    return double(iterations) * in.size() / t / 1e9;
+}
+
+
+void speed_bitpacking() {
+
+    const size_t n = 256 * 64;
+
+    puts("Bit-packing");
+    puts("speed: billions of integers/s");
+    puts("");
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    puts("bits | 4 lanes                   | 8 lanes");
+    puts("     | scalar      | SSE         | scalar      | SSE         | AVX2");
+#else
+    puts("bits | 4 lanes                   | 8 lanes");
+    puts("     | scalar      | SSE         | scalar      | SSE");
+#endif
+    puts("     | pack  unp.  | pack  unp.  | pack  unp.  | pack  unp.  | pack  unp.");
+
+    std::vector<uint32_t> packed(n);
+    std::vector<uint32_t> unpacked(n);
+
+    for (int bits=1; bits <= 32; bits++) {
+        const std::vector<uint32_t> input = random_input(n, bits);
+
+        // the unpacking routine reads bits words of each block
+        for (size_t i=0; i < n; i += 128) bitpack4_scalar[bits](input.data() + i, packed.data() + i, 0);
+
+        printf("%4d ", bits);
+        printf("| %5.2f ", measure_bitpacking(bitpack4_scalar[bits], input, packed, 128));
+        printf("%5.2f ",   measure_bitpacking(bitunpack4_scalar[bits], packed, unpacked, 128));
+        printf("| %5.2f ", measure_bitpacking(bitpack4_sse[bits], input, packed, 128));
+        printf("%5.2f ",   measure_bitpacking(bitunpack4_sse[bits], packed, unpacked, 128));
+
+        for (size_t i=0; i < n; i += 256) bitpack8_scalar[bits](input.data() + i, packed.data() + i, 0);
+
+        printf("| %5.2f ", measure_bitpacking(bitpack8_scalar[bits], input, packed, 256));
+        printf("%5.2f ",   measure_bitpacking(bitunpack8_scalar[bits], packed, unpacked, 256));
+        printf("| %5.2f ", measure_bitpacking(bitpack8_sse[bits], input, packed, 256));
+        printf("%5.2f ",   measure_bitpacking(bitunpack8_sse[bits], packed, unpacked, 256));
+#ifdef HAVE_AVX2_INSTRUCTIONS
+        printf("| %5.2f ", measure_bitpacking(bitpack8_avx2[bits], input, packed, 256));
+        printf("%5.2f ",   measure_bitpacking(bitunpack8_avx2[bits], packed, unpacked, 256));
+#endif
+        putchar('\n');
+    }
+}
+
+
+template <typename IMPL>
+void measure_blockcodec(const char* name, const std::vector<uint32_t>& input) {
+
+    Test test(input, blockcodec_max_size(input.size()));
+
+    const double encode = test.encode(blockcodec_encode<IMPL>);
+    const double decode = test.decode(blockcodec_decode<IMPL>);
+
+    printf("%-24s %5.2f %5.2f %5.2f\n", name, test.ratio(), encode, decode);
+}
+
+
+void measure_streamvbyte_best(const char* name, const std::vector<uint32_t>& input) {
+
+    Test test(input, streamvbyte_max_size(input.size()));
+
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    const double encode = test.encode([](const uint32_t* in, size_t n, uint8_t* out) { return streamvbyte_encode_avx2<false>(in, n, out, 0); });
+    const double decode = test.decode([](const uint8_t* in, size_t size, uint32_t* out, size_t n) { return streamvbyte_decode_avx2<false>(in, size, out, n, 0); });
+#else
+    const double encode = test.encode([](const uint32_t* in, size_t n, uint8_t* out) { return streamvbyte_encode_sse<false>(in, n, out, 0); });
+    const double decode = test.decode([](const uint8_t* in, size_t size, uint32_t* out, size_t n) { return streamvbyte_decode_sse<false>(in, size, out, n, 0); });
+#endif
+
+    printf("%-24s %5.2f %5.2f %5.2f\n", name, test.ratio(), encode, decode);
+}
+
+
+void compare_codecs(const char* title, const std::vector<uint32_t>& input) {
+
+    printf("%s\n", title);
+    measure_streamvbyte_best("Stream VByte",          input);
+    measure_blockcodec<blockcodec::Scalar>("blocks (scalar)", input);
+    measure_blockcodec<blockcodec::SSE>("blocks (SSE)",       input);
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    measure_blockcodec<blockcodec::AVX2>("blocks (AVX2)",     input);
+#endif
+}
+
+
+void speed_blockcodec() {
+
+    const size_t n = 1024 * 100;
+
+    puts("Block codec (FOR/PFor/Stream VByte chosen per block)");
+    puts("ratio: uncompressed size / encoded size, speed: billions of integers/s");
+    puts("");
+    puts("codec                    ratio enc.  dec.");
+
+    compare_codecs("uniform, 4 bits",                   random_input(n, 4));
+    compare_codecs("uniform, 12 bits",                  random_input(n, 12));
+    compare_codecs("uniform, 20 bits",                  random_input(n, 20));
+    compare_codecs("uniform, 28 bits",                  random_input(n, 28));
+    compare_codecs("12 bits, 1% of 32-bit outliers",    outliers_input(n, 12, 100));
+    compare_codecs("4 bits, 3% of 32-bit outliers",     outliers_input(n, 4, 32));
+}
+
+
+int main(int argc, char* argv[]) {
+
+    const std::string what = (argc > 1) ? argv[1] : "all";
+
+    if (what == "all" || what == "streamvbyte") {
+        speed_streamvbyte();
+        putchar('\n');
+    }
+
+    if (what == "all" || what == "bitpacking") {
+        speed_bitpacking();
+        putchar('\n');
+    }
+
+    if (what == "all" || what == "blocks") {
+        speed_blockcodec();
+    }
+}
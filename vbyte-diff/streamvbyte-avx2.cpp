@@ -0,0 +1,123 @@
+// AVX2 variants process eight values (two control bytes) per iteration;
+// each 128-bit lane is handled like in the SSE code.
+
+namespace streamvbyte {
+
+    // prefix sum of 8 x uint32 plus the last value of previous vector
+    FORCE_INLINE __m256i prefix_sum(__m256i v, __m256i prev) {
+        v = _mm256_add_epi32(v, _mm256_slli_si256(v, 4));
+        v = _mm256_add_epi32(v, _mm256_slli_si256(v, 8));
+
+        // propagate the sum of lower lane to the upper lane
+        const __m256i lower = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 0, 0, 0, 3, 3, 3, 3));
+        v = _mm256_add_epi32(v, _mm256_blend_epi32(_mm256_setzero_si256(), lower, 0xf0));
+
+        return _mm256_add_epi32(v, _mm256_permutevar8x32_epi32(prev, _mm256_set1_epi32(7)));
+    }
+
+
+    FORCE_INLINE __m256i load_pair(const uint8_t* lo, const uint8_t* hi) {
+        return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)lo)),
+                                       _mm_loadu_si128((const __m128i*)hi), 1);
+    }
+
+} // namespace streamvbyte
+
+
+template <bool delta>
+size_t streamvbyte_encode_avx2(const uint32_t* in, size_t n, uint8_t* out, uint32_t prev = 0) {
+
+    using namespace streamvbyte;
+
+    const Tables& t = tables();
+
+    uint8_t* control = out;
+    uint8_t* data    = out + (n + 3)/4;
+
+    const __m256i t1 = _mm256_set1_epi32(0x100);
+    const __m256i t2 = _mm256_set1_epi32(0x10000);
+    const __m256i t3 = _mm256_set1_epi32(0x1000000);
+
+    __m256i prev_vec = _mm256_set1_epi32(prev);
+    size_t i;
+    for (i=0; i + 8 <= n; i += 8) {
+        const __m256i curr = _mm256_loadu_si256((const __m256i*)(in + i));
+        __m256i v = curr;
+        if (delta) {
+            // [prev[7], curr[0], ..., curr[6]]
+            const __m256i shifted = _mm256_permutevar8x32_epi32(curr, _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6));
+            const __m256i last    = _mm256_permutevar8x32_epi32(prev_vec, _mm256_set1_epi32(7));
+            v = _mm256_sub_epi32(curr, _mm256_blend_epi32(shifted, last, 0x01));
+            prev_vec = curr;
+        }
+
+        const int ge1 = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_max_epu32(v, t1), v)));
+        const int ge2 = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_max_epu32(v, t2), v)));
+        const int ge3 = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_max_epu32(v, t3), v)));
+
+        const uint16_t c  = control_bits(t, ge1, ge2, ge3);
+        const uint8_t  c0 = c & 0xff;
+        const uint8_t  c1 = c >> 8;
+        memcpy(control + i/4, &c, 2);
+
+        const __m256i shuffle = load_pair(t.encode[c0], t.encode[c1]);
+        const __m256i bytes   = _mm256_shuffle_epi8(v, shuffle);
+
+        _mm_storeu_si128((__m128i*)data, _mm256_castsi256_si128(bytes));
+        data += t.length[c0];
+        _mm_storeu_si128((__m128i*)data, _mm256_extracti128_si256(bytes, 1));
+        data += t.length[c1];
+    }
+
+    if (delta && i > 0) {
+        prev = in[i - 1];
+    }
+
+    data = encode_tail<delta>(in, i, n, control, data, prev);
+
+    return data - out;
+}
+
+
+template <bool delta>
+size_t streamvbyte_decode_avx2(const uint8_t* in, size_t size, uint32_t* out, size_t n, uint32_t prev = 0) {
+
+    using namespace streamvbyte;
+
+    const Tables& t = tables();
+
+    const uint8_t* control = in;
+    const uint8_t* data    = in + (n + 3)/4;
+    const uint8_t* end     = in + size;
+
+    __m256i prev_vec = _mm256_set1_epi32(prev);
+    size_t i;
+    for (i=0; i + 8 <= n; i += 8) {
+        const uint8_t c0 = control[i/4 + 0];
+        const uint8_t c1 = control[i/4 + 1];
+
+        const uint8_t* data1 = data + t.length[c0];
+        if (data1 + 16 > end) {
+            break;
+        }
+
+        const __m256i shuffle = load_pair(t.decode[c0], t.decode[c1]);
+        __m256i v = _mm256_shuffle_epi8(load_pair(data, data1), shuffle);
+        data = data1 + t.length[c1];
+
+        if (delta) {
+            v = prefix_sum(v, prev_vec);
+            prev_vec = v;
+        }
+
+        _mm256_storeu_si256((__m256i*)(out + i), v);
+    }
+
+    if (delta && i > 0) {
+        prev = out[i - 1];
+    }
+
+    data = decode_tail<delta>(control, data, end, out, i, n, prev);
+
+    return data - in;
+}
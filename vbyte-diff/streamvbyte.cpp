@@ -0,0 +1,247 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <immintrin.h>
+
+#define FORCE_INLINE inline __attribute__((always_inline))
+
+// Stream VByte layout: the control stream, ceil(n/4) bytes, each holding
+// 2-bit lengths (minus one) of four values, the first value in the lowest
+// bits; then the data stream, where values occupy 1..4 little endian bytes.
+//
+// In the differential (d1) mode deltas between consecutive values are
+// stored, the value preceding the first one is given by a caller.
+
+
+// Size of output buffer for encoders; SIMD code stores whole vectors,
+// thus may write up to 16 bytes past the encoded data.
+size_t streamvbyte_max_size(size_t n) {
+    return (n + 3)/4 + 4*n + 16;
+}
+
+
+namespace streamvbyte {
+
+    struct Tables {
+        uint8_t  length[256];       // size of data for a control byte
+        uint8_t  decode[256][16];   // pshufb pattern: data -> 4 x uint32
+        uint8_t  encode[256][16];   // pshufb pattern: 4 x uint32 -> data
+        uint16_t spread[256];       // bits 0..7 moved to even positions
+
+        Tables() {
+            for (int c=0; c < 256; c++) {
+                memset(decode[c], 0x80, 16);
+                memset(encode[c], 0x80, 16);
+
+                int k = 0;
+                for (int j=0; j < 4; j++) {
+                    const int len = ((c >> (2*j)) & 0x3) + 1;
+                    for (int b=0; b < len; b++, k++) {
+                        decode[c][4*j + b] = k;
+                        encode[c][k] = 4*j + b;
+                    }
+                }
+
+                length[c] = k;
+
+                spread[c] = 0;
+                for (int b=0; b < 8; b++) {
+                    if (c & (1 << b)) {
+                        spread[c] |= 1 << (2*b);
+                    }
+                }
+            }
+        }
+    };
+
+    const Tables& tables() {
+        static const Tables t;
+        return t;
+    }
+
+
+    FORCE_INLINE uint8_t length_code(uint32_t v) {
+        return (v > 0xff) + (v > 0xffff) + (v > 0xffffff);
+    }
+
+
+    // encodes values in[i..n-1], i is a multiply of 4
+    template <bool delta>
+    uint8_t* encode_tail(const uint32_t* in, size_t i, size_t n, uint8_t* control, uint8_t* data, uint32_t prev) {
+
+        for (/**/; i < n; i++) {
+            const uint32_t v = delta ? in[i] - prev : in[i];
+            const uint8_t code = length_code(v);
+            prev = in[i];
+
+            if (i % 4 == 0) {
+                control[i/4] = 0;
+            }
+
+            control[i/4] |= code << (2*(i % 4));
+            memcpy(data, &v, 4);
+            data += code + 1;
+        }
+
+        return data;
+    }
+
+
+    // decodes values out[i..n-1], i is a multiply of 4
+    template <bool delta>
+    const uint8_t* decode_tail(const uint8_t* control, const uint8_t* data, const uint8_t* end,
+                               uint32_t* out, size_t i, size_t n, uint32_t prev) {
+
+        for (/**/; i < n; i++) {
+            const int len = ((control[i/4] >> (2*(i % 4))) & 0x3) + 1;
+            uint32_t v = 0;
+            if (data + 4 <= end) {
+                memcpy(&v, data, 4);
+                v &= 0xffffffff >> (8*(4 - len));
+            } else {
+                memcpy(&v, data, len);
+            }
+            data += len;
+
+            if (delta) {
+                v += prev;
+                prev = v;
+            }
+
+            out[i] = v;
+        }
+
+        return data;
+    }
+
+
+    // control byte for four values, given masks of values >= 2^8, 2^16, 2^24
+    FORCE_INLINE uint16_t control_bits(const Tables& t, int ge1, int ge2, int ge3) {
+        // length codes are 0, 1, 2 or 3, thus ge3 implies ge2 implies ge1
+        const int bit0 = (ge1 & ~ge2) | ge3;
+        const int bit1 = ge2;
+
+        return t.spread[bit0] | (t.spread[bit1] << 1);
+    }
+
+
+    // prefix sum of 4 x uint32 plus the last value of previous vector
+    FORCE_INLINE __m128i prefix_sum(__m128i v, __m128i prev) {
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        return _mm_add_epi32(v, _mm_shuffle_epi32(prev, _MM_SHUFFLE(3, 3, 3, 3)));
+    }
+
+} // namespace streamvbyte
+
+
+template <bool delta>
+size_t streamvbyte_encode_scalar(const uint32_t* in, size_t n, uint8_t* out, uint32_t prev = 0) {
+
+    using namespace streamvbyte;
+
+    uint8_t* data = encode_tail<delta>(in, 0, n, out, out + (n + 3)/4, prev);
+
+    return data - out;
+}
+
+
+template <bool delta>
+size_t streamvbyte_decode_scalar(const uint8_t* in, size_t size, uint32_t* out, size_t n, uint32_t prev = 0) {
+
+    using namespace streamvbyte;
+
+    const uint8_t* data = decode_tail<delta>(in, in + (n + 3)/4, in + size, out, 0, n, prev);
+
+    return data - in;
+}
+
+
+template <bool delta>
+size_t streamvbyte_encode_sse(const uint32_t* in, size_t n, uint8_t* out, uint32_t prev = 0) {
+
+    using namespace streamvbyte;
+
+    const Tables& t = tables();
+
+    uint8_t* control = out;
+    uint8_t* data    = out + (n + 3)/4;
+
+    const __m128i t1 = _mm_set1_epi32(0x100);
+    const __m128i t2 = _mm_set1_epi32(0x10000);
+    const __m128i t3 = _mm_set1_epi32(0x1000000);
+
+    __m128i prev_vec = _mm_set1_epi32(prev);
+    size_t i;
+    for (i=0; i + 4 <= n; i += 4) {
+        const __m128i curr = _mm_loadu_si128((const __m128i*)(in + i));
+        __m128i v = curr;
+        if (delta) {
+            v = _mm_sub_epi32(curr, _mm_alignr_epi8(curr, prev_vec, 12));
+            prev_vec = curr;
+        }
+
+        // unsigned v >= threshold <=> max(v, threshold) == v
+        const int ge1 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_max_epu32(v, t1), v)));
+        const int ge2 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_max_epu32(v, t2), v)));
+        const int ge3 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_max_epu32(v, t3), v)));
+
+        const uint8_t c = control_bits(t, ge1, ge2, ge3);
+        control[i/4] = c;
+
+        const __m128i shuffle = _mm_loadu_si128((const __m128i*)t.encode[c]);
+        _mm_storeu_si128((__m128i*)data, _mm_shuffle_epi8(v, shuffle));
+        data += t.length[c];
+    }
+
+    if (delta && i > 0) {
+        prev = in[i - 1];
+    }
+
+    data = encode_tail<delta>(in, i, n, control, data, prev);
+
+    return data - out;
+}
+
+
+template <bool delta>
+size_t streamvbyte_decode_sse(const uint8_t* in, size_t size, uint32_t* out, size_t n, uint32_t prev = 0) {
+
+    using namespace streamvbyte;
+
+    const Tables& t = tables();
+
+    const uint8_t* control = in;
+    const uint8_t* data    = in + (n + 3)/4;
+    const uint8_t* end     = in + size;
+
+    __m128i prev_vec = _mm_set1_epi32(prev);
+    size_t i;
+    for (i=0; i + 4 <= n && data + 16 <= end; i += 4) {
+        const uint8_t c = control[i/4];
+
+        const __m128i shuffle = _mm_loadu_si128((const __m128i*)t.decode[c]);
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), shuffle);
+        data += t.length[c];
+
+        if (delta) {
+            v = prefix_sum(v, prev_vec);
+            prev_vec = v;
+        }
+
+        _mm_storeu_si128((__m128i*)(out + i), v);
+    }
+
+    if (delta && i > 0) {
+        prev = out[i - 1];
+    }
+
+    data = decode_tail<delta>(control, data, end, out, i, n, prev);
+
+    return data - in;
+}
+
+
+#ifdef HAVE_AVX2_INSTRUCTIONS
+#   include "streamvbyte-avx2.cpp"
+#endif
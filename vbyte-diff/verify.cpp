@@ -0,0 +1,251 @@
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include "blockcodec.cpp"
+
+void print(const char* s) {
+    printf("%-32s... ", s);
+    fflush(stdout);
+}
+
+
+typedef size_t (*encode_fun)(const uint32_t*, size_t, uint8_t*, uint32_t);
+typedef size_t (*decode_fun)(const uint8_t*, size_t, uint32_t*, size_t, uint32_t);
+
+
+class Test {
+
+    const encode_fun encode;
+    const decode_fun decode;
+    const encode_fun encode_ref;
+
+    std::vector<uint32_t> in;
+    std::vector<uint32_t> out;
+    std::vector<uint8_t>  encoded;
+    std::vector<uint8_t>  encoded_ref;
+
+public:
+    Test(encode_fun encode, decode_fun decode, encode_fun encode_ref)
+        : encode(encode)
+        , decode(decode)
+        , encode_ref(encode_ref) {}
+
+    bool run() {
+
+        for (size_t n=0; n <= 100; n++) {
+            if (!check(n)) {
+                return false;
+            }
+        }
+
+        for (size_t n: {1000, 1001, 1002, 1003, 100*1000}) {
+            if (!check(n)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    bool check(size_t n) {
+
+        in.resize(n);
+
+        for (size_t i=0; i < n; i++) in[i] = i;
+        if (!compare("ascending")) return false;
+
+        for (size_t i=0; i < n; i++) in[i] = n - i;
+        if (!compare("descending")) return false;
+
+        for (size_t i=0; i < n; i++) in[i] = (i % 2) ? 0xffffffff : 0;
+        if (!compare("extreme values")) return false;
+
+        for (int bits=1; bits <= 32; bits++) {
+            const uint32_t mask = (bits == 32) ? 0xffffffff : (uint32_t(1) << bits) - 1;
+            for (size_t i=0; i < n; i++) in[i] = (uint32_t(rand()) * 65537u + rand()) & mask;
+            if (!compare("random")) return false;
+
+            std::sort(in.begin(), in.end());
+            if (!compare("random sorted")) return false;
+        }
+
+        return true;
+    }
+
+    bool compare(const char* name) {
+
+        const size_t n = in.size();
+        const uint32_t prev = n ? in[0] / 2 : 0;
+
+        encoded.resize(streamvbyte_max_size(n));
+        encoded_ref.resize(streamvbyte_max_size(n));
+
+        const size_t size     = encode(in.data(), n, encoded.data(), prev);
+        const size_t size_ref = encode_ref(in.data(), n, encoded_ref.data(), prev);
+
+        if (size != size_ref || !std::equal(encoded.begin(), encoded.begin() + size, encoded_ref.begin())) {
+            printf("failed: %s, size %lu: encoded data differs from scalar code\n", name, n);
+            return false;
+        }
+
+        // no padding after data, decoder must not read past the end
+        encoded.resize(size);
+        encoded.shrink_to_fit();
+
+        out.assign(n, 0);
+        const size_t consumed = decode(encoded.data(), size, out.data(), n, prev);
+        if (consumed != size || out != in) {
+            printf("failed: %s, size %lu: decoded data differs\n", name, n);
+            return false;
+        }
+
+        return true;
+    }
+};
+
+
+bool test(const char* name, encode_fun encode, decode_fun decode, encode_fun encode_ref) {
+
+    print(name);
+
+    Test test(encode, decode, encode_ref);
+    if (test.run()) {
+        puts("OK");
+        return true;
+    } else {
+        puts("FAILED");
+        return false;
+    }
+}
+
+
+bool test_bitpacking(const char* name, const bitpack_fun* pack, const bitpack_fun* unpack, int lanes) {
+
+    print(name);
+
+    const size_t n = 32 * lanes;
+    std::vector<uint32_t> in(n);
+    std::vector<uint32_t> packed(n);
+    std::vector<uint32_t> expected(n);
+    std::vector<uint32_t> out(n);
+
+    for (int bits=0; bits <= 32; bits++) {
+        for (int k=0; k < 100; k++) {
+            const uint32_t base = (k % 2) ? rand() : 0;
+            for (auto& x: in) x = base + ((uint32_t(rand()) * 65537u + rand()) & bitpacking::mask(bits));
+
+            // packing must ignore higher bits
+            if (k % 4 == 3) {
+                for (auto& x: in) x += 0xf0000000;
+            }
+
+            std::fill(packed.begin(), packed.end(), 0);
+            pack[bits](in.data(), packed.data(), base);
+            bitpack_reference(in.data(), expected.data(), bits, lanes, base);
+
+            if (!std::equal(expected.begin(), expected.begin() + bits*lanes, packed.begin())) {
+                printf("failed: width %d: packed data differs from reference\n", bits);
+                puts("FAILED");
+                return false;
+            }
+
+            unpack[bits](packed.data(), out.data(), base);
+            for (size_t i=0; i < n; i++) {
+                if (out[i] != base + ((in[i] - base) & bitpacking::mask(bits))) {
+                    printf("failed: width %d: wrong value at %lu\n", bits, i);
+                    puts("FAILED");
+                    return false;
+                }
+            }
+        }
+    }
+
+    puts("OK");
+    return true;
+}
+
+
+template <typename IMPL>
+bool test_blockcodec(const char* name) {
+
+    print(name);
+
+    std::vector<uint32_t> in;
+    std::vector<uint8_t>  encoded;
+    std::vector<uint8_t>  encoded_ref;
+    std::vector<uint32_t> out;
+
+    for (size_t n: {0, 1, 100, 255, 256, 257, 1000, 10000}) {
+        for (int bits=0; bits <= 32; bits += 4) {
+            for (int every: {0, 2, 10, 100}) {
+                in.resize(n);
+                for (auto& x: in) {
+                    x = ((uint32_t(rand()) * 65537u + rand()) & bitpacking::mask(bits)) + 1000;
+                    if (every && rand() % every == 0) {
+                        x = uint32_t(rand()) * 65537u + rand();
+                    }
+                }
+
+                encoded.resize(blockcodec_max_size(n));
+                encoded_ref.resize(blockcodec_max_size(n));
+                const size_t size     = blockcodec_encode<IMPL>(in.data(), n, encoded.data());
+                const size_t size_ref = blockcodec_encode<blockcodec::Scalar>(in.data(), n, encoded_ref.data());
+
+                if (size != size_ref || !std::equal(encoded.begin(), encoded.begin() + size, encoded_ref.begin())) {
+                    printf("failed: size %lu, %d bits: encoded data differs from scalar code\n", n, bits);
+                    puts("FAILED");
+                    return false;
+                }
+
+                encoded.resize(size);
+                encoded.shrink_to_fit();
+
+                out.assign(n, 0);
+                const size_t consumed = blockcodec_decode<IMPL>(encoded.data(), size, out.data(), n);
+                if (consumed != size || out != in) {
+                    printf("failed: size %lu, %d bits: decoded data differs\n", n, bits);
+                    puts("FAILED");
+                    return false;
+                }
+            }
+        }
+    }
+
+    puts("OK");
+    return true;
+}
+
+
+int main() {
+
+    bool ok = true;
+
+    ok = test("scalar",          streamvbyte_encode_scalar<false>, streamvbyte_decode_scalar<false>, streamvbyte_encode_scalar<false>) && ok;
+    ok = test("scalar (d1)",     streamvbyte_encode_scalar<true>,  streamvbyte_decode_scalar<true>,  streamvbyte_encode_scalar<true>) && ok;
+    ok = test("SSE",             streamvbyte_encode_sse<false>,    streamvbyte_decode_sse<false>,    streamvbyte_encode_scalar<false>) && ok;
+    ok = test("SSE (d1)",        streamvbyte_encode_sse<true>,     streamvbyte_decode_sse<true>,     streamvbyte_encode_scalar<true>) && ok;
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    ok = test("AVX2",            streamvbyte_encode_avx2<false>,   streamvbyte_decode_avx2<false>,   streamvbyte_encode_scalar<false>) && ok;
+    ok = test("AVX2 (d1)",       streamvbyte_encode_avx2<true>,    streamvbyte_decode_avx2<true>,    streamvbyte_encode_scalar<true>) && ok;
+#endif
+
+    ok = test_bitpacking("bit-packing 4 lanes (scalar)", bitpack4_scalar, bitunpack4_scalar, 4) && ok;
+    ok = test_bitpacking("bit-packing 4 lanes (SSE)",    bitpack4_sse,    bitunpack4_sse,    4) && ok;
+    ok = test_bitpacking("bit-packing 8 lanes (scalar)", bitpack8_scalar, bitunpack8_scalar, 8) && ok;
+    ok = test_bitpacking("bit-packing 8 lanes (SSE)",    bitpack8_sse,    bitunpack8_sse,    8) && ok;
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    ok = test_bitpacking("bit-packing 8 lanes (AVX2)",   bitpack8_avx2,   bitunpack8_avx2,   8) && ok;
+#endif
+
+    ok = test_blockcodec<blockcodec::Scalar>("block codec (scalar)") && ok;
+    ok = test_blockcodec<blockcodec::SSE>("block codec (SSE)") && ok;
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    ok = test_blockcodec<blockcodec::AVX2>("block codec (AVX2)") && ok;
+#endif
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
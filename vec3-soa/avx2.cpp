@@ -0,0 +1,116 @@
+// AVX2 + FMA: eight vectors at once, the same scheme as SSE, including
+// rescaling of tiny and huge vectors.
+
+__m256 rsqrt_nr_avx2(const __m256 s) {
+    const __m256 half  = _mm256_set1_ps(0.5f);
+    const __m256 three = _mm256_set1_ps(3.0f);
+
+    const __m256 y0  = _mm256_rsqrt_ps(s);
+    const __m256 sy0 = _mm256_mul_ps(s, y0);
+    const __m256 t   = _mm256_fnmadd_ps(sy0, y0, three); // 3 - s*y0^2
+    const __m256 y1  = _mm256_mul_ps(_mm256_mul_ps(half, y0), t);
+
+    return _mm256_and_ps(y1, _mm256_cmp_ps(s, _mm256_setzero_ps(), _CMP_NEQ_OQ));
+}
+
+
+__m256 dot_avx2(__m256 x, __m256 y, __m256 z) {
+    return _mm256_fmadd_ps(x, x, _mm256_fmadd_ps(y, y, _mm256_mul_ps(z, z)));
+}
+
+
+bool out_of_range_avx2(__m256 s) {
+    const __m256 out = _mm256_or_ps(_mm256_cmp_ps(s, _mm256_set1_ps(FLT_MIN), _CMP_NGE_UQ),
+                                    _mm256_cmp_ps(s, _mm256_set1_ps(FLT_MAX), _CMP_GT_OQ));
+
+    return _mm256_movemask_ps(out) != 0;
+}
+
+
+__m256 scale_avx2(__m256 x, __m256 y, __m256 z) {
+    const __m256 abs = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 m = _mm256_max_ps(_mm256_max_ps(_mm256_and_ps(x, abs), _mm256_and_ps(y, abs)), _mm256_and_ps(z, abs));
+    m = _mm256_min_ps(m, _mm256_set1_ps(8.50705917e37f)); // 2^126
+
+    const __m256i e = _mm256_and_si256(_mm256_castps_si256(m), _mm256_set1_epi32(0x7f800000));
+    return _mm256_castsi256_ps(_mm256_sub_epi32(_mm256_set1_epi32(254 << 23), e));
+}
+
+
+void cross_avx2(const vec3_array& a, const vec3_array& b, vec3_array& out, size_t n) {
+    size_t i = 0;
+    for (/**/; i + 8 <= n; i += 8) {
+        const __m256 ax = _mm256_loadu_ps(a.x + i);
+        const __m256 ay = _mm256_loadu_ps(a.y + i);
+        const __m256 az = _mm256_loadu_ps(a.z + i);
+        const __m256 bx = _mm256_loadu_ps(b.x + i);
+        const __m256 by = _mm256_loadu_ps(b.y + i);
+        const __m256 bz = _mm256_loadu_ps(b.z + i);
+
+        _mm256_storeu_ps(out.x + i, _mm256_fmsub_ps(ay, bz, _mm256_mul_ps(az, by)));
+        _mm256_storeu_ps(out.y + i, _mm256_fmsub_ps(az, bx, _mm256_mul_ps(ax, bz)));
+        _mm256_storeu_ps(out.z + i, _mm256_fmsub_ps(ax, by, _mm256_mul_ps(ay, bx)));
+    }
+
+    vec3_array ta = {a.x + i, a.y + i, a.z + i};
+    vec3_array tb = {b.x + i, b.y + i, b.z + i};
+    vec3_array to = {out.x + i, out.y + i, out.z + i};
+    cross_sse(ta, tb, to, n - i);
+}
+
+
+void length_avx2(const vec3_array& a, float* out, size_t n) {
+    size_t i = 0;
+    for (/**/; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(a.x + i);
+        __m256 y = _mm256_loadu_ps(a.y + i);
+        __m256 z = _mm256_loadu_ps(a.z + i);
+        __m256 s = dot_avx2(x, y, z);
+
+        if (!out_of_range_avx2(s)) {
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(s, rsqrt_nr_avx2(s)));
+            continue;
+        }
+
+        const __m256 scale = scale_avx2(x, y, z);
+        x = _mm256_mul_ps(x, scale);
+        y = _mm256_mul_ps(y, scale);
+        z = _mm256_mul_ps(z, scale);
+        s = dot_avx2(x, y, z);
+
+        const __m256 unscale = _mm256_div_ps(_mm256_set1_ps(1.0f), scale);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_mul_ps(s, rsqrt_nr_avx2(s)), unscale));
+    }
+
+    vec3_array ta = {a.x + i, a.y + i, a.z + i};
+    length_sse(ta, out + i, n - i);
+}
+
+
+void normalize_avx2(const vec3_array& a, vec3_array& out, size_t n) {
+    size_t i = 0;
+    for (/**/; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(a.x + i);
+        __m256 y = _mm256_loadu_ps(a.y + i);
+        __m256 z = _mm256_loadu_ps(a.z + i);
+        __m256 s = dot_avx2(x, y, z);
+
+        if (out_of_range_avx2(s)) {
+            const __m256 scale = scale_avx2(x, y, z);
+            x = _mm256_mul_ps(x, scale);
+            y = _mm256_mul_ps(y, scale);
+            z = _mm256_mul_ps(z, scale);
+            s = dot_avx2(x, y, z);
+        }
+
+        const __m256 inv = rsqrt_nr_avx2(s);
+
+        _mm256_storeu_ps(out.x + i, _mm256_mul_ps(x, inv));
+        _mm256_storeu_ps(out.y + i, _mm256_mul_ps(y, inv));
+        _mm256_storeu_ps(out.z + i, _mm256_mul_ps(z, inv));
+    }
+
+    vec3_array ta = {a.x + i, a.y + i, a.z + i};
+    vec3_array to = {out.x + i, out.y + i, out.z + i};
+    normalize_sse(ta, to, n - i);
+}
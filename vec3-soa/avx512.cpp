@@ -0,0 +1,119 @@
+// AVX512F: sixteen vectors at once.
+//
+// vrsqrt14ps is more precise than rsqrtps (14 bits), after the Newton-Raphson
+// step the result is almost correctly rounded.  Tails are processed with
+// masked loads and stores, and zero inputs are handled by a mask as well.
+// Tiny and huge vectors (see sse.cpp) are rescaled with vgetexpps and
+// vscalefps, which handle denormals directly.
+
+__m512 rsqrt_nr_avx512(const __m512 s) {
+    const __m512 half  = _mm512_set1_ps(0.5f);
+    const __m512 three = _mm512_set1_ps(3.0f);
+
+    const __m512 y0  = _mm512_rsqrt14_ps(s);
+    const __m512 sy0 = _mm512_mul_ps(s, y0);
+    const __m512 t   = _mm512_fnmadd_ps(sy0, y0, three); // 3 - s*y0^2
+    const __m512 y1  = _mm512_mul_ps(_mm512_mul_ps(half, y0), t);
+
+    const __mmask16 nonzero = _mm512_cmp_ps_mask(s, _mm512_setzero_ps(), _CMP_NEQ_OQ);
+    return _mm512_maskz_mov_ps(nonzero, y1);
+}
+
+
+__m512 dot_avx512(__m512 x, __m512 y, __m512 z) {
+    return _mm512_fmadd_ps(x, x, _mm512_fmadd_ps(y, y, _mm512_mul_ps(z, z)));
+}
+
+
+// lanes with s outside normal floats (zero vectors included, for them
+// rescaling is a no-op)
+__mmask16 out_of_range_avx512(__m512 s) {
+    return _mm512_cmp_ps_mask(s, _mm512_set1_ps(FLT_MIN), _CMP_NGE_UQ)
+         | _mm512_cmp_ps_mask(s, _mm512_set1_ps(FLT_MAX), _CMP_GT_OQ);
+}
+
+
+// -e, where 2^e <= max(|x|, |y|, |z|) < 2^(e+1); 0 for zero vectors
+__m512 scale_exp_avx512(__m512 x, __m512 y, __m512 z) {
+    const __m512 m = _mm512_max_ps(_mm512_max_ps(_mm512_abs_ps(x), _mm512_abs_ps(y)), _mm512_abs_ps(z));
+    const __mmask16 nonzero = _mm512_cmp_ps_mask(m, _mm512_setzero_ps(), _CMP_NEQ_OQ);
+
+    return _mm512_maskz_sub_ps(nonzero, _mm512_setzero_ps(), _mm512_getexp_ps(m));
+}
+
+
+__mmask16 tail_mask(size_t i, size_t n) {
+    return (n - i >= 16) ? 0xffff : __mmask16((1u << (n - i)) - 1);
+}
+
+
+void cross_avx512(const vec3_array& a, const vec3_array& b, vec3_array& out, size_t n) {
+    for (size_t i=0; i < n; i += 16) {
+        const __mmask16 m = tail_mask(i, n);
+
+        const __m512 ax = _mm512_maskz_loadu_ps(m, a.x + i);
+        const __m512 ay = _mm512_maskz_loadu_ps(m, a.y + i);
+        const __m512 az = _mm512_maskz_loadu_ps(m, a.z + i);
+        const __m512 bx = _mm512_maskz_loadu_ps(m, b.x + i);
+        const __m512 by = _mm512_maskz_loadu_ps(m, b.y + i);
+        const __m512 bz = _mm512_maskz_loadu_ps(m, b.z + i);
+
+        _mm512_mask_storeu_ps(out.x + i, m, _mm512_fmsub_ps(ay, bz, _mm512_mul_ps(az, by)));
+        _mm512_mask_storeu_ps(out.y + i, m, _mm512_fmsub_ps(az, bx, _mm512_mul_ps(ax, bz)));
+        _mm512_mask_storeu_ps(out.z + i, m, _mm512_fmsub_ps(ax, by, _mm512_mul_ps(ay, bx)));
+    }
+}
+
+
+void length_avx512(const vec3_array& a, float* out, size_t n) {
+    for (size_t i=0; i < n; i += 16) {
+        const __mmask16 m = tail_mask(i, n);
+
+        __m512 x = _mm512_maskz_loadu_ps(m, a.x + i);
+        __m512 y = _mm512_maskz_loadu_ps(m, a.y + i);
+        __m512 z = _mm512_maskz_loadu_ps(m, a.z + i);
+        __m512 s = dot_avx512(x, y, z);
+
+        const __mmask16 rescale = out_of_range_avx512(s);
+        if (rescale == 0) {
+            _mm512_mask_storeu_ps(out + i, m, _mm512_mul_ps(s, rsqrt_nr_avx512(s)));
+            continue;
+        }
+
+        const __m512 e = _mm512_maskz_mov_ps(rescale, scale_exp_avx512(x, y, z));
+        x = _mm512_scalef_ps(x, e);
+        y = _mm512_scalef_ps(y, e);
+        z = _mm512_scalef_ps(z, e);
+        s = dot_avx512(x, y, z);
+
+        const __m512 len = _mm512_mul_ps(s, rsqrt_nr_avx512(s));
+        _mm512_mask_storeu_ps(out + i, m, _mm512_scalef_ps(len, _mm512_sub_ps(_mm512_setzero_ps(), e)));
+    }
+}
+
+
+void normalize_avx512(const vec3_array& a, vec3_array& out, size_t n) {
+    for (size_t i=0; i < n; i += 16) {
+        const __mmask16 m = tail_mask(i, n);
+
+        __m512 x = _mm512_maskz_loadu_ps(m, a.x + i);
+        __m512 y = _mm512_maskz_loadu_ps(m, a.y + i);
+        __m512 z = _mm512_maskz_loadu_ps(m, a.z + i);
+        __m512 s = dot_avx512(x, y, z);
+
+        const __mmask16 rescale = out_of_range_avx512(s);
+        if (rescale) {
+            const __m512 e = _mm512_maskz_mov_ps(rescale, scale_exp_avx512(x, y, z));
+            x = _mm512_scalef_ps(x, e);
+            y = _mm512_scalef_ps(y, e);
+            z = _mm512_scalef_ps(z, e);
+            s = dot_avx512(x, y, z);
+        }
+
+        const __m512 inv = rsqrt_nr_avx512(s);
+
+        _mm512_mask_storeu_ps(out.x + i, m, _mm512_mul_ps(x, inv));
+        _mm512_mask_storeu_ps(out.y + i, m, _mm512_mul_ps(y, inv));
+        _mm512_mask_storeu_ps(out.z + i, m, _mm512_mul_ps(z, inv));
+    }
+}
@@ -0,0 +1,8 @@
+#include <time.h>
+#include <sys/time.h>
+
+double get_time() {
+    struct timeval T;
+    gettimeofday(&T, NULL);
+    return T.tv_sec + T.tv_usec/1000000.0;
+}
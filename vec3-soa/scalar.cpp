@@ -0,0 +1,44 @@
+// Vectors are stored as structure of arrays: x[i], y[i], z[i] are
+// coordinates of the i-th vector.  Output may alias any input.
+
+struct vec3_array {
+    float* x;
+    float* y;
+    float* z;
+};
+
+
+void cross_scalar(const vec3_array& a, const vec3_array& b, vec3_array& out, size_t n) {
+    for (size_t i=0; i < n; i++) {
+        const float ax = a.x[i], ay = a.y[i], az = a.z[i];
+        const float bx = b.x[i], by = b.y[i], bz = b.z[i];
+
+        out.x[i] = ay*bz - az*by;
+        out.y[i] = az*bx - ax*bz;
+        out.z[i] = ax*by - ay*bx;
+    }
+}
+
+
+// The squared length is computed in double: in float it's denormal or
+// infinite for |v| below ~1e-19 or above ~1.8e19.
+void length_scalar(const vec3_array& a, float* out, size_t n) {
+    for (size_t i=0; i < n; i++) {
+        const double x = a.x[i], y = a.y[i], z = a.z[i];
+        out[i] = float(sqrt(x*x + y*y + z*z));
+    }
+}
+
+
+// zero vectors are left unchanged
+void normalize_scalar(const vec3_array& a, vec3_array& out, size_t n) {
+    for (size_t i=0; i < n; i++) {
+        const double x = a.x[i], y = a.y[i], z = a.z[i];
+        const double len = sqrt(x*x + y*y + z*z);
+        const double inv = (len > 0.0) ? 1.0/len : 0.0;
+
+        out.x[i] = float(x * inv);
+        out.y[i] = float(y * inv);
+        out.z[i] = float(z * inv);
+    }
+}
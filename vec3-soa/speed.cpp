@@ -0,0 +1,89 @@
+#include "../common/bufalloc.h"
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+
+#include "gettime.cpp"
+#include "all.cpp"
+
+
+class Test {
+
+    const size_t n;
+    buf_array<float> data;
+    vec3_array a;
+    vec3_array b;
+    vec3_array out;
+
+public:
+    Test(size_t n) : n(n), data(9*n) {
+        for (auto& x: data) x = rand()/float(RAND_MAX) - 0.5f;
+
+        float* p = data.data();
+        a   = {p + 0*n, p + 1*n, p + 2*n};
+        b   = {p + 3*n, p + 4*n, p + 5*n};
+        out = {p + 6*n, p + 7*n, p + 8*n};
+    }
+
+    template <typename CROSS, typename LENGTH, typename NORMALIZE>
+    void measure(const char* name, CROSS cross, LENGTH length, NORMALIZE normalize) {
+
+        printf("%-10s", name);
+
+        report([&]{ cross(a, b, out, n); });
+        report([&]{ length(a, out.x, n); });
+        report([&]{ normalize(a, out, n); });
+
+        putchar('\n');
+    }
+
+private:
+    template <typename FUNCTION>
+    void report(FUNCTION fun) {
+
+        // about 100M vectors per measurement
+        const size_t repeat = std::max(size_t(1), size_t(100*1000*1000) / n);
+
+        double best = 1e100;
+        for (int k=0; k < 3; k++) {
+            const double t1 = get_time();
+            for (size_t r=0; r < repeat; r++) {
+                fun();
+            }
+            const double t2 = get_time();
+            best = std::min(best, t2 - t1);
+        }
+
+        printf(" %12.1f", double(n) * repeat / best / 1e6);
+        fflush(stdout);
+    }
+};
+
+
+int main(int argc, char* argv[]) {
+
+    std::vector<size_t> sizes;
+    for (int i=1; i < argc; i++) {
+        sizes.push_back(atoi(argv[i]));
+    }
+
+    if (sizes.empty()) {
+        sizes = {4096, 1024*1024};
+    }
+
+    for (size_t n: sizes) {
+        printf("%lu vectors, Mvectors/s\n", n);
+        printf("%-10s %12s %12s %12s\n", "", "cross", "length", "normalize");
+
+        Test test(n);
+        test.measure("scalar", cross_scalar, length_scalar, normalize_scalar);
+        test.measure("SSE", cross_sse, length_sse, normalize_sse);
+#ifdef HAVE_AVX2_INSTRUCTIONS
+        test.measure("AVX2", cross_avx2, length_avx2, normalize_avx2);
+#endif
+#ifdef HAVE_AVX512_INSTRUCTIONS
+        test.measure("AVX512F", cross_avx512, length_avx512, normalize_avx512);
+#endif
+    }
+}
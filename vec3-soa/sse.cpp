@@ -0,0 +1,135 @@
+// SSE: four vectors at once.
+//
+// 1/sqrt(s) is approximated with rsqrtps (12 bits of precision) and
+// refined with one Newton-Raphson step:
+//
+//      y1 = y0 * (1.5 - 0.5 * s * y0^2)
+//
+// which gives about 22-23 bits.  For s = 0 rsqrtps yields +inf, thus
+// the result is masked out to get 0 (length) or leave zero vector as is.
+//
+// For |v| below ~1e-19 or above ~1.8e19 the squared length is denormal
+// or infinite.  Such vectors are rare, thus they are handled by a branch:
+// coordinates get scaled by a power of two (exactly), so that the largest
+// one is in [1, 4), and the result is scaled back.
+
+__m128 rsqrt_nr_sse(const __m128 s) {
+    const __m128 half  = _mm_set1_ps(0.5f);
+    const __m128 three = _mm_set1_ps(3.0f);
+
+    const __m128 y0   = _mm_rsqrt_ps(s);
+    const __m128 sy0  = _mm_mul_ps(s, y0);
+    const __m128 t    = _mm_sub_ps(three, _mm_mul_ps(sy0, y0)); // 3 - s*y0^2
+    const __m128 y1   = _mm_mul_ps(_mm_mul_ps(half, y0), t);
+
+    // zero where s == 0
+    return _mm_and_ps(y1, _mm_cmpneq_ps(s, _mm_setzero_ps()));
+}
+
+
+__m128 dot_sse(__m128 x, __m128 y, __m128 z) {
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+}
+
+
+// true if any s is outside normal floats; zero vectors take the slow
+// path as well (it handles them correctly), the check is kept minimal
+bool out_of_range_sse(__m128 s) {
+    const __m128 out = _mm_or_ps(_mm_cmpnge_ps(s, _mm_set1_ps(FLT_MIN)),
+                                 _mm_cmpgt_ps(s, _mm_set1_ps(FLT_MAX)));
+
+    return _mm_movemask_ps(out) != 0;
+}
+
+
+// 2^-e, where 2^e <= max(|x|, |y|, |z|) < 2^(e+1); e is at most 126,
+// so that 2^-e is a normal number
+__m128 scale_sse(__m128 x, __m128 y, __m128 z) {
+    const __m128 abs = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 m = _mm_max_ps(_mm_max_ps(_mm_and_ps(x, abs), _mm_and_ps(y, abs)), _mm_and_ps(z, abs));
+    m = _mm_min_ps(m, _mm_set1_ps(8.50705917e37f)); // 2^126
+
+    const __m128i e = _mm_and_si128(_mm_castps_si128(m), _mm_set1_epi32(0x7f800000));
+    return _mm_castsi128_ps(_mm_sub_epi32(_mm_set1_epi32(254 << 23), e));
+}
+
+
+void cross_sse(const vec3_array& a, const vec3_array& b, vec3_array& out, size_t n) {
+    size_t i = 0;
+    for (/**/; i + 4 <= n; i += 4) {
+        const __m128 ax = _mm_loadu_ps(a.x + i);
+        const __m128 ay = _mm_loadu_ps(a.y + i);
+        const __m128 az = _mm_loadu_ps(a.z + i);
+        const __m128 bx = _mm_loadu_ps(b.x + i);
+        const __m128 by = _mm_loadu_ps(b.y + i);
+        const __m128 bz = _mm_loadu_ps(b.z + i);
+
+        _mm_storeu_ps(out.x + i, _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by)));
+        _mm_storeu_ps(out.y + i, _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz)));
+        _mm_storeu_ps(out.z + i, _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx)));
+    }
+
+    vec3_array ta = {a.x + i, a.y + i, a.z + i};
+    vec3_array tb = {b.x + i, b.y + i, b.z + i};
+    vec3_array to = {out.x + i, out.y + i, out.z + i};
+    cross_scalar(ta, tb, to, n - i);
+}
+
+
+void length_sse(const vec3_array& a, float* out, size_t n) {
+    size_t i = 0;
+    for (/**/; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(a.x + i);
+        __m128 y = _mm_loadu_ps(a.y + i);
+        __m128 z = _mm_loadu_ps(a.z + i);
+        __m128 s = dot_sse(x, y, z);
+
+        // sqrt(s) = s * 1/sqrt(s)
+        if (!out_of_range_sse(s)) {
+            _mm_storeu_ps(out + i, _mm_mul_ps(s, rsqrt_nr_sse(s)));
+            continue;
+        }
+
+        const __m128 scale = scale_sse(x, y, z);
+        x = _mm_mul_ps(x, scale);
+        y = _mm_mul_ps(y, scale);
+        z = _mm_mul_ps(z, scale);
+        s = dot_sse(x, y, z);
+
+        const __m128 unscale = _mm_div_ps(_mm_set1_ps(1.0f), scale);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_mul_ps(s, rsqrt_nr_sse(s)), unscale));
+    }
+
+    vec3_array ta = {a.x + i, a.y + i, a.z + i};
+    length_scalar(ta, out + i, n - i);
+}
+
+
+void normalize_sse(const vec3_array& a, vec3_array& out, size_t n) {
+    size_t i = 0;
+    for (/**/; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(a.x + i);
+        __m128 y = _mm_loadu_ps(a.y + i);
+        __m128 z = _mm_loadu_ps(a.z + i);
+        __m128 s = dot_sse(x, y, z);
+
+        // direction doesn't change
+        if (out_of_range_sse(s)) {
+            const __m128 scale = scale_sse(x, y, z);
+            x = _mm_mul_ps(x, scale);
+            y = _mm_mul_ps(y, scale);
+            z = _mm_mul_ps(z, scale);
+            s = dot_sse(x, y, z);
+        }
+
+        const __m128 inv = rsqrt_nr_sse(s);
+
+        _mm_storeu_ps(out.x + i, _mm_mul_ps(x, inv));
+        _mm_storeu_ps(out.y + i, _mm_mul_ps(y, inv));
+        _mm_storeu_ps(out.z + i, _mm_mul_ps(z, inv));
+    }
+
+    vec3_array ta = {a.x + i, a.y + i, a.z + i};
+    vec3_array to = {out.x + i, out.y + i, out.z + i};
+    normalize_scalar(ta, to, n - i);
+}
@@ -0,0 +1,163 @@
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+
+#include "all.cpp"
+
+
+class Vectors {
+
+    std::vector<float> data;
+
+public:
+    vec3_array v;
+
+    Vectors(size_t n) : data(3*n) {
+        v.x = data.data();
+        v.y = data.data() + n;
+        v.z = data.data() + 2*n;
+    }
+
+    void random(size_t n) {
+        // magnitudes from 1e-3 to 1e+3, and edge ones: squared length
+        // of a vector is denormal or overflows below ~1e-19 and above ~1.8e19
+        static const float scales[] = {
+            1e-3f, 1e-2f, 1e-1f, 1e0f, 1e1f, 1e2f, 1e3f,
+            1e-35f, 1e-20f, 1e-19f, 1e19f, 1e20f, 1e35f
+        };
+
+        for (size_t i=0; i < n; i++) {
+            const float scale = scales[rand() % (sizeof(scales)/sizeof(scales[0]))];
+            v.x[i] = (rand()/float(RAND_MAX) - 0.5f) * scale;
+            v.y[i] = (rand()/float(RAND_MAX) - 0.5f) * scale;
+            v.z[i] = (rand()/float(RAND_MAX) - 0.5f) * scale;
+        }
+
+        // zero vectors must be handled as well
+        for (size_t i=0; i < n; i += 7) {
+            v.x[i] = v.y[i] = v.z[i] = 0.0f;
+        }
+    }
+};
+
+
+class Verify {
+
+    const size_t n;
+    Vectors a;
+    Vectors b;
+    Vectors out;
+    std::vector<float> len;
+
+public:
+    // largest relative errors observed
+    double max_cross_error  = 0.0;
+    double max_length_error = 0.0;
+    double max_norm_error   = 0.0;
+
+    Verify(size_t n) : n(n), a(n), b(n), out(n), len(n) {
+        a.random(n);
+        b.random(n);
+    }
+
+    template <typename CROSS, typename LENGTH, typename NORMALIZE>
+    void run(CROSS cross, LENGTH length, NORMALIZE normalize) {
+
+        cross(a.v, b.v, out.v, n);
+        for (size_t i=0; i < n; i++) {
+            const double ax = a.v.x[i], ay = a.v.y[i], az = a.v.z[i];
+            const double bx = b.v.x[i], by = b.v.y[i], bz = b.v.z[i];
+            // error of cross product depends on magnitudes of inputs, not the result
+            const double scale = norm(ax, ay, az) * norm(bx, by, bz);
+            // the product itself doesn't fit in normal floats
+            if (scale < FLT_MIN || scale > FLT_MAX) {
+                continue;
+            }
+
+            update(max_cross_error, (out.v.x[i] - (ay*bz - az*by)) / scale);
+            update(max_cross_error, (out.v.y[i] - (az*bx - ax*bz)) / scale);
+            update(max_cross_error, (out.v.z[i] - (ax*by - ay*bx)) / scale);
+        }
+
+        length(a.v, len.data(), n);
+        for (size_t i=0; i < n; i++) {
+            const double ref = norm(a.v.x[i], a.v.y[i], a.v.z[i]);
+            if (ref == 0.0) {
+                update(max_length_error, len[i] == 0.0f ? 0.0 : 1.0);
+            } else {
+                update(max_length_error, (len[i] - ref) / ref);
+            }
+        }
+
+        normalize(a.v, out.v, n);
+        for (size_t i=0; i < n; i++) {
+            const double ref = norm(a.v.x[i], a.v.y[i], a.v.z[i]);
+            if (ref == 0.0) {
+                const bool zero = (out.v.x[i] == 0.0f && out.v.y[i] == 0.0f && out.v.z[i] == 0.0f);
+                update(max_norm_error, zero ? 0.0 : 1.0);
+            } else {
+                update(max_norm_error, out.v.x[i] - a.v.x[i]/ref);
+                update(max_norm_error, out.v.y[i] - a.v.y[i]/ref);
+                update(max_norm_error, out.v.z[i] - a.v.z[i]/ref);
+            }
+        }
+    }
+
+private:
+    static double norm(double x, double y, double z) {
+        return sqrt(x*x + y*y + z*z);
+    }
+
+    static void update(double& max, double err) {
+        err = fabs(err);
+        if (!(err <= max)) { // NaN as well
+            max = err;
+        }
+    }
+};
+
+
+template <typename CROSS, typename LENGTH, typename NORMALIZE>
+bool test(const char* name, CROSS cross, LENGTH length, NORMALIZE normalize) {
+
+    printf("%-10s... ", name); fflush(stdout);
+
+    // 2^-20 --- single Newton-Raphson step gives ~22 bits
+    const double threshold = 1.0/(1 << 20);
+
+    double cross_err  = 0.0;
+    double length_err = 0.0;
+    double norm_err   = 0.0;
+    for (size_t n: {0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 100, 10007}) {
+        Verify verify(n);
+        verify.run(cross, length, normalize);
+
+        cross_err  = std::max(cross_err,  verify.max_cross_error);
+        length_err = std::max(length_err, verify.max_length_error);
+        norm_err   = std::max(norm_err,   verify.max_norm_error);
+    }
+
+    const bool ok = (cross_err <= threshold) && (length_err <= threshold) && (norm_err <= threshold);
+    printf("max error: cross %.2e, length %.2e, normalize %.2e --- %s\n",
+            cross_err, length_err, norm_err, ok ? "OK" : "FAILED");
+
+    return ok;
+}
+
+
+int main() {
+
+    bool ok = true;
+
+    ok = test("scalar", cross_scalar, length_scalar, normalize_scalar) && ok;
+    ok = test("SSE", cross_sse, length_sse, normalize_sse) && ok;
+#ifdef HAVE_AVX2_INSTRUCTIONS
+    ok = test("AVX2", cross_avx2, length_avx2, normalize_avx2) && ok;
+#endif
+#ifdef HAVE_AVX512_INSTRUCTIONS
+    ok = test("AVX512F", cross_avx512, length_avx512, normalize_avx512) && ok;
+#endif
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
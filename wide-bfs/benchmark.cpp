@@ -1,3 +1,5 @@
+#include "../common/bench.h"
+
 #include <cstdio>
 #include <cstdint>
 #include <cstdlib>
@@ -5,13 +7,37 @@
 #include <cassert>
 
 #include "config.h"
-#include "benchmark.h"
 
-#include "scalar.cpp"
-#include "x86.cpp"
-#ifdef HAVE_AVX512_INSTRUCTIONS
-#   include "avx512f.cpp"
-#endif
+#include "dispatch.cpp"
+
+typedef uint64_t (*bfs_fun)(const uint64_t*, size_t);
+
+// one sample is 100 calls, results are given per 64-bit word;
+// records are named bfs/variant/size
+void measure(const char* name, const char* variant, bfs_fun fun, const uint64_t* tab, size_t size, uint64_t expected) {
+
+    const int calls = 100;
+
+    const uint64_t result = fun(tab, size);
+    if (result != expected) {
+        printf("%s returned %lu, expected %lu\n", name, result, expected);
+        return;
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "bfs/%s/%lu", variant, size);
+
+    bench b;
+    bench_begin(&b, label, 1000, calls * size);
+    b.bytes = sizeof(uint64_t);
+    while (bench_next(&b)) {
+        for (int i=0; i < calls; i++) {
+            BENCH_KEEP(fun(tab, size));
+        }
+    }
+
+    bench_report(&b);
+}
 
 void demo(size_t size) {
 
@@ -24,24 +50,25 @@ void demo(size_t size) {
     memset(tab, 0, sizeof(tab));
     tab[size - 1] = 0x8000000000000000llu;
 
-    const size_t expected = scalar_bfs(tab, size);
+    const uint64_t expected = scalar_bfs(tab, size);
 
-    printf("size = %lu\n", size);
-    BEST_TIME(scalar_bfs(tab, size),    100000, expected, size);
-#ifndef HAVE_AVX512_INSTRUCTIONS // fails on KNL
-    BEST_TIME(x86_bfs(tab, size),       100000, expected, size);
-#endif
-#ifdef HAVE_AVX512_INSTRUCTIONS
-    BEST_TIME(avx512f_bfs(tab, size),   100000, expected, size);
-#endif
+    measure("scalar_bfs", "scalar", scalar_bfs, tab, size, expected);
+    if (!cpu_has(CPU_BMI1)) { // see dispatch.cpp
+        measure("x86_bfs", "x86", x86_bfs, tab, size, expected);
+    }
+    if (cpu_has(CPU_AVX512F)) {
+        measure("avx512f_bfs", "avx512f", avx512f_bfs, tab, size, expected);
+    }
+    measure("dispatched_bfs", "dispatch", dispatched_bfs, tab, size, expected);
 }
 
 int main() {
 
+    fprintf(stderr, "dispatched_bfs uses %s\n", dispatched_bfs_name());
+
     for (size_t n=3; n <= 10; n++) {
         demo(1llu << n);
     }
 
     return EXIT_SUCCESS;
 }
-
@@ -0,0 +1,32 @@
+#include <immintrin.h>
+
+#include "../common/cpudispatch.h"
+
+#include "scalar.cpp"
+#include "x86.cpp"
+
+CPU_TARGET_BEGIN("avx512f")
+#include "avx512f.cpp"
+CPU_TARGET_END
+
+// x86_bfs is not a variant: it relies on BSF setting ZF for zero input,
+// while on CPUs having BMI1 the encoding of TZCNT is executed as TZCNT,
+// thus it's correct only on CPUs without BMI1
+static const cpu_variant bfs_variants[] = {
+    CPU_VARIANT(CPU_AVX512F, avx512f_bfs),
+    CPU_VARIANT(0,           scalar_bfs),
+};
+
+typedef uint64_t (*bfs_fun)(const uint64_t*, size_t);
+
+const char* dispatched_bfs_name() {
+    return cpu_select(bfs_variants)->name;
+}
+
+uint64_t dispatched_bfs(const uint64_t* data, size_t n) {
+
+    // function-local statics are initialized once, even with threads
+    static const bfs_fun fun = (bfs_fun)cpu_select(bfs_variants)->fun;
+
+    return fun(data, n);
+}
@@ -5,11 +5,7 @@
 
 #include "config.h"
 
-#include "scalar.cpp"
-#include "x86.cpp"
-#ifdef HAVE_AVX512_INSTRUCTIONS
-#   include "avx512f.cpp"
-#endif
+#include "dispatch.cpp"
 
 template <typename FUN>
 void validate(const char* name, FUN fun) {
@@ -48,12 +44,13 @@ void validate(const char* name, FUN fun) {
 int main() {
 
     validate("scalar",  scalar_bfs);
-#ifndef HAVE_AVX512_INSTRUCTIONS
-    validate("x86",     x86_bfs);
-#endif
-#ifdef HAVE_AVX512_INSTRUCTIONS
-    validate("AVX512F", avx512f_bfs);
-#endif
+    if (!cpu_has(CPU_BMI1)) { // see dispatch.cpp
+        validate("x86",     x86_bfs);
+    }
+    if (cpu_has(CPU_AVX512F)) {
+        validate("AVX512F", avx512f_bfs);
+    }
+    validate(dispatched_bfs_name(), dispatched_bfs);
 
     return EXIT_SUCCESS;
 }
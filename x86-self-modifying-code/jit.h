@@ -0,0 +1,171 @@
+// A tiny x86-64 code generator with W^X-safe buffers
+//
+// x86linux_smc.c patches an immediate of already compiled code with
+// mprotect(PROT_WRITE | PROT_EXEC); a page that is writable and
+// executable at the same time is what exploits look for, and hardened
+// kernels (SELinux execmem, PaX) refuse it.  Here code is written into
+// a memfd mapped twice: a read-write view for the generator and a
+// read-exec view for callers; no page is ever W+X.  When memfd_create
+// is not available a single anonymous mapping is flipped with mprotect
+// between RW (emitting) and RX (running).
+//
+// x86 keeps instruction fetch coherent with stores to the same physical
+// memory, thus code written through one view may be executed through
+// the other right away; the only rule is not to rewrite a function
+// while another thread runs it.
+//
+// Instructions are appended with jit_emit(); forward jumps are emitted
+// with a zero displacement and patched later (jit_patch_rel32).
+
+#ifndef JIT_H_included__
+#define JIT_H_included__
+
+#ifndef _GNU_SOURCE
+#	define _GNU_SOURCE
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+typedef struct {
+	uint8_t* code;		// the writable view
+	uint8_t* exec;		// the executable view (the same as code if !dual)
+	size_t   size;
+	size_t   used;
+	size_t   start;		// the function being emitted
+	int      fd;
+	int      dual;
+	int      error;		// set on overflow
+} jit_buffer;
+
+
+// one anonymous mapping, RW or RX in turn
+static inline int jit_init_single(jit_buffer* jb, size_t size) {
+	const size_t page = sysconf(_SC_PAGESIZE);
+
+	memset(jb, 0, sizeof(*jb));
+	jb->size = (size + page - 1) & ~(page - 1);
+	jb->fd   = -1;
+	jb->code = mmap(NULL, jb->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (jb->code == MAP_FAILED)
+		return -1;
+
+	jb->exec = jb->code;
+	return 0;
+}
+
+
+// a memfd mapped twice, or jit_init_single if that fails
+static inline int jit_init(jit_buffer* jb, size_t size) {
+	const size_t page = sysconf(_SC_PAGESIZE);
+
+	memset(jb, 0, sizeof(*jb));
+	jb->size = (size + page - 1) & ~(page - 1);
+	jb->fd   = memfd_create("jit", MFD_CLOEXEC);
+
+	if (jb->fd >= 0 && ftruncate(jb->fd, jb->size) == 0) {
+		jb->code = mmap(NULL, jb->size, PROT_READ | PROT_WRITE, MAP_SHARED, jb->fd, 0);
+		jb->exec = mmap(NULL, jb->size, PROT_READ | PROT_EXEC,  MAP_SHARED, jb->fd, 0);
+		if (jb->code != MAP_FAILED && jb->exec != MAP_FAILED) {
+			jb->dual = 1;
+			return 0;
+		}
+
+		if (jb->code != MAP_FAILED)
+			munmap(jb->code, jb->size);
+		if (jb->exec != MAP_FAILED)
+			munmap(jb->exec, jb->size);
+	}
+
+	if (jb->fd >= 0)
+		close(jb->fd);
+
+	return jit_init_single(jb, size);
+}
+
+
+static inline void jit_free(jit_buffer* jb) {
+	munmap(jb->code, jb->size);
+	if (jb->dual) {
+		munmap(jb->exec, jb->size);
+		close(jb->fd);
+	}
+}
+
+
+// starts a new function; with a single mapping all functions are
+// unavailable until jit_end
+static inline void jit_begin(jit_buffer* jb) {
+	if (!jb->dual)
+		mprotect(jb->code, jb->size, PROT_READ | PROT_WRITE);
+
+	// functions start at 16-byte boundaries
+	jb->used  = (jb->used + 15) & ~(size_t)15;
+	jb->start = jb->used;
+}
+
+
+// returns the executable address of the function, NULL if it didn't fit
+static inline void* jit_end(jit_buffer* jb) {
+	if (!jb->dual)
+		mprotect(jb->code, jb->size, PROT_READ | PROT_EXEC);
+
+	if (jb->error)
+		return NULL;
+
+	return jb->exec + jb->start;
+}
+
+
+static inline size_t jit_offset(const jit_buffer* jb) {
+	return jb->used;
+}
+
+
+// appends n bytes given as ints
+static inline void jit_emit(jit_buffer* jb, int n, ...) {
+	va_list ap;
+	int i;
+
+	if (jb->used + n > jb->size) {
+		jb->error = 1;
+		return;
+	}
+
+	va_start(ap, n);
+	for (i=0; i < n; i++)
+		jb->code[jb->used++] = (uint8_t)va_arg(ap, int);
+	va_end(ap);
+}
+
+
+static inline void jit_emit32(jit_buffer* jb, uint32_t x) {
+	jit_emit(jb, 4, x & 0xff, (x >> 8) & 0xff, (x >> 16) & 0xff, x >> 24);
+}
+
+
+// the displacement ends at `at`, the offset just after a jump
+static inline void jit_patch_rel32(jit_buffer* jb, size_t at, size_t target) {
+	const int32_t rel = (int32_t)(target - at);
+
+	if (!jb->error)
+		memcpy(jb->code + at - 4, &rel, 4);
+}
+
+
+// jcc rel32 (cc = 0x4 for E/Z, 0x5 for NE/NZ); returns the offset to patch
+static inline size_t jit_jcc(jit_buffer* jb, int cc, size_t target) {
+	jit_emit(jb, 2, 0x0f, 0x80 | cc);
+	jit_emit32(jb, 0);
+	jit_patch_rel32(jb, jit_offset(jb), target);
+	return jit_offset(jb);
+}
+
+#define JIT_CC_Z	0x4
+#define JIT_CC_NZ	0x5
+
+#endif
@@ -0,0 +1,184 @@
+// Kernels taking a runtime constant, in two flavours: generic, where
+// the constant lives in a register or a table, and generated by jit.h,
+// where the constant is an immediate of the code.
+//
+// * bitmask: bit i of the result is set if array[i] == key (the scan
+//   from building-bitmask, 32 elements per output word);
+//
+// * PEXT with a constant mask: the mask is split into runs of
+//   consecutive ones (a "plan"), each run is a shift and an AND; the
+//   generic code interprets the plan, the generated code is the plan.
+
+#include "jit.h"
+
+//---------------------------------------------------------------------------
+// bitmask
+
+// n is a multiple of 32, like in building-bitmask
+void bitmask_generic(const uint32_t* array, size_t n, uint32_t key, uint32_t* bitvector) {
+	size_t i;
+	int j;
+
+	for (i=0; i < n/32; i++) {
+		uint32_t result = 0;
+
+		for (j=31; j >= 0; j--)
+			result = 2*result + (array[j] == key);
+
+		bitvector[i] = result;
+		array += 32;
+	}
+}
+
+
+typedef void (*bitmask_fun)(const uint32_t* array, size_t n, uint32_t* bitvector);
+
+// System V ABI: array = rdi, n = rsi, bitvector = rdx
+bitmask_fun jit_bitmask(jit_buffer* jb, uint32_t key) {
+	size_t loop, done;
+	int j;
+
+	jit_begin(jb);
+
+	jit_emit(jb, 3, 0x48, 0x89, 0xf1);		// mov   rcx, rsi
+	jit_emit(jb, 4, 0x48, 0xc1, 0xe9, 0x05);	// shr   rcx, 5
+	done = jit_jcc(jb, JIT_CC_Z, 0);		// jz    done
+
+	loop = jit_offset(jb);
+	jit_emit(jb, 2, 0x31, 0xc0);			// xor   eax, eax
+
+	// CF = (array[j] ^ key) < 1, i.e. array[j] == key; adc shifts it in
+	for (j=31; j >= 0; j--) {
+		jit_emit(jb, 4, 0x44, 0x8b, 0x47, 4*j);	// mov   r8d, [rdi + 4*j]
+		if (key != 0) {
+			jit_emit(jb, 3, 0x41, 0x81, 0xf0);	// xor   r8d, key
+			jit_emit32(jb, key);
+		}
+		jit_emit(jb, 4, 0x41, 0x83, 0xf8, 0x01);	// cmp   r8d, 1
+		jit_emit(jb, 2, 0x11, 0xc0);		// adc   eax, eax
+	}
+
+	jit_emit(jb, 2, 0x89, 0x02);			// mov   [rdx], eax
+	jit_emit(jb, 3, 0x48, 0x81, 0xc7);		// add   rdi, 128
+	jit_emit32(jb, 128);
+	jit_emit(jb, 4, 0x48, 0x83, 0xc2, 0x04);	// add   rdx, 4
+	jit_emit(jb, 3, 0x48, 0xff, 0xc9);		// dec   rcx
+	jit_jcc(jb, JIT_CC_NZ, loop);			// jnz   loop
+
+	jit_patch_rel32(jb, done, jit_offset(jb));
+	jit_emit(jb, 1, 0xc3);				// ret
+
+	return (bitmask_fun)jit_end(jb);
+}
+
+//---------------------------------------------------------------------------
+// PEXT
+
+typedef struct {
+	int      runs;
+	uint8_t  shift[32];
+	uint32_t mask[32];	// the run, already at its position in the result
+} pext_plan;
+
+
+void pext_plan_build(pext_plan* plan, uint32_t mask) {
+	int position = 0;	// the next bit of the result
+
+	plan->runs = 0;
+	while (mask) {
+		const int lo  = __builtin_ctz(mask);
+		const uint32_t ones = ~(mask >> lo);	// mask >> lo has ones at the bottom
+		const int len = (ones == 0) ? 32 : __builtin_ctz(ones);
+		const uint32_t run = (len == 32) ? 0xffffffff : ((uint32_t)1 << len) - 1;
+
+		plan->shift[plan->runs] = lo - position;
+		plan->mask[plan->runs]  = run << position;
+		plan->runs += 1;
+
+		position += len;
+		mask &= ~(run << lo);
+	}
+}
+
+
+static inline uint32_t pext_plan_apply(const pext_plan* plan, uint32_t src) {
+	uint32_t result = 0;
+	int i;
+
+	for (i=0; i < plan->runs; i++)
+		result |= (src >> plan->shift[i]) & plan->mask[i];
+
+	return result;
+}
+
+
+void pext_plan_array(const pext_plan* plan, const uint32_t* src, uint32_t* dst, size_t n) {
+	size_t i;
+
+	for (i=0; i < n; i++)
+		dst[i] = pext_plan_apply(plan, src[i]);
+}
+
+
+typedef void (*pext_array_fun)(const uint32_t* src, uint32_t* dst, size_t n);
+
+// System V ABI: src = rdi, dst = rsi, n = rdx
+pext_array_fun jit_pext_array(jit_buffer* jb, uint32_t mask) {
+	pext_plan plan;
+	size_t loop, done;
+	int i;
+
+	pext_plan_build(&plan, mask);
+
+	jit_begin(jb);
+
+	jit_emit(jb, 3, 0x48, 0x85, 0xd2);		// test  rdx, rdx
+	done = jit_jcc(jb, JIT_CC_Z, 0);		// jz    done
+
+	loop = jit_offset(jb);
+	jit_emit(jb, 2, 0x8b, 0x0f);			// mov   ecx, [rdi]
+	if (plan.runs == 0)
+		jit_emit(jb, 2, 0x31, 0xc0);		// xor   eax, eax
+
+	for (i=0; i < plan.runs; i++) {
+		const uint32_t run = plan.mask[i];
+		const int shift    = plan.shift[i];
+		// the first run goes directly to eax
+		const int r8       = (i > 0);
+
+		if (r8)
+			jit_emit(jb, 3, 0x41, 0x89, 0xc8);	// mov   r8d, ecx
+		else
+			jit_emit(jb, 2, 0x89, 0xc8);	// mov   eax, ecx
+
+		if (shift > 0) {
+			if (r8)
+				jit_emit(jb, 4, 0x41, 0xc1, 0xe8, shift);	// shr   r8d, shift
+			else
+				jit_emit(jb, 3, 0xc1, 0xe8, shift);	// shr   eax, shift
+		}
+
+		// not needed when the run covers all bits left after the shift
+		if (run != (0xffffffff >> shift)) {
+			if (r8)
+				jit_emit(jb, 3, 0x41, 0x81, 0xe0);	// and   r8d, run
+			else
+				jit_emit(jb, 1, 0x25);		// and   eax, run
+			jit_emit32(jb, run);
+		}
+
+		if (r8)
+			jit_emit(jb, 3, 0x44, 0x09, 0xc0);	// or    eax, r8d
+	}
+
+	jit_emit(jb, 2, 0x89, 0x06);			// mov   [rsi], eax
+	jit_emit(jb, 4, 0x48, 0x83, 0xc7, 0x04);	// add   rdi, 4
+	jit_emit(jb, 4, 0x48, 0x83, 0xc6, 0x04);	// add   rsi, 4
+	jit_emit(jb, 3, 0x48, 0xff, 0xca);		// dec   rdx
+	jit_jcc(jb, JIT_CC_NZ, loop);			// jnz   loop
+
+	jit_patch_rel32(jb, done, jit_offset(jb));
+	jit_emit(jb, 1, 0xc3);				// ret
+
+	return (pext_array_fun)jit_end(jb);
+}
@@ -0,0 +1,139 @@
+// Generic kernels vs. kernels generated for a given constant
+
+#include "../common/bench.h"
+#include "../common/cpudispatch.h"
+
+#include "kernels.c"
+#include "../pext_soft_emu/pext.c"
+
+#include <immintrin.h>
+
+#define N 4096
+
+uint32_t input[N];
+uint32_t output[N];
+
+CPU_TARGET_BEGIN("bmi2")
+void pext_bmi2_array(uint32_t mask, const uint32_t* src, uint32_t* dst, size_t n) {
+	size_t i;
+
+	for (i=0; i < n; i++)
+		dst[i] = _pext_u32(src[i], mask);
+}
+CPU_TARGET_END
+
+
+void pext_soft_array(uint32_t mask, const uint32_t* src, uint32_t* dst, size_t n) {
+	size_t i;
+
+	for (i=0; i < n; i++)
+		dst[i] = pext(src[i], mask);
+}
+
+
+void speed_bitmask(jit_buffer* jb, uint32_t key) {
+	const int repeat = 1000;
+	bitmask_fun fun = jit_bitmask(jb, key);
+	char name[64];
+	bench b;
+
+	if (fun == NULL) {
+		fprintf(stderr, "bitmask: buffer too small\n");
+		exit(EXIT_FAILURE);
+	}
+
+	snprintf(name, sizeof(name), "bitmask/generic/%d", N);
+	bench_begin(&b, name, repeat, N);
+	b.bytes = 4;
+	while (bench_next(&b)) {
+		bitmask_generic(input, N, key, output);
+		BENCH_CLOBBER();
+	}
+	bench_report(&b);
+
+	snprintf(name, sizeof(name), "bitmask/jit/%d", N);
+	bench_begin(&b, name, repeat, N);
+	b.bytes = 4;
+	while (bench_next(&b)) {
+		fun(input, N, output);
+		BENCH_CLOBBER();
+	}
+	bench_report(&b);
+}
+
+
+void speed_pext(jit_buffer* jb, uint32_t mask) {
+	const int repeat = 1000;
+	pext_array_fun fun = jit_pext_array(jb, mask);
+	pext_plan plan;
+	char name[64];
+	bench b;
+
+	if (fun == NULL) {
+		fprintf(stderr, "pext: buffer too small\n");
+		exit(EXIT_FAILURE);
+	}
+
+	pext_plan_build(&plan, mask);
+
+	snprintf(name, sizeof(name), "pext-%08x/soft/%d", mask, N);
+	bench_begin(&b, name, repeat/10, N);
+	b.bytes = 4;
+	while (bench_next(&b)) {
+		pext_soft_array(mask, input, output, N);
+		BENCH_CLOBBER();
+	}
+	bench_report(&b);
+
+	snprintf(name, sizeof(name), "pext-%08x/plan/%d", mask, N);
+	bench_begin(&b, name, repeat, N);
+	b.bytes = 4;
+	while (bench_next(&b)) {
+		pext_plan_array(&plan, input, output, N);
+		BENCH_CLOBBER();
+	}
+	bench_report(&b);
+
+	snprintf(name, sizeof(name), "pext-%08x/jit/%d", mask, N);
+	bench_begin(&b, name, repeat, N);
+	b.bytes = 4;
+	while (bench_next(&b)) {
+		fun(input, output, N);
+		BENCH_CLOBBER();
+	}
+	bench_report(&b);
+
+	if (cpu_has(CPU_BMI2)) {
+		snprintf(name, sizeof(name), "pext-%08x/bmi2/%d", mask, N);
+		bench_begin(&b, name, repeat, N);
+		b.bytes = 4;
+		while (bench_next(&b)) {
+			pext_bmi2_array(mask, input, output, N);
+			BENCH_CLOBBER();
+		}
+		bench_report(&b);
+	}
+}
+
+
+int main() {
+	static const uint32_t masks[] = {0x00ff0000, 0x0f0f0f0f, 0x55555555};
+	const uint32_t key = 42;
+	jit_buffer jb;
+	size_t i;
+
+	if (jit_init(&jb, 64*1024)) {
+		perror("jit_init");
+		return EXIT_FAILURE;
+	}
+
+	for (i=0; i < N; i++)
+		input[i] = (rand() % 4 == 0) ? key : (uint32_t)rand();
+
+	speed_bitmask(&jb, key);
+	for (i=0; i < sizeof(masks)/sizeof(masks[0]); i++)
+		speed_pext(&jb, masks[i]);
+
+	jit_free(&jb);
+	return EXIT_SUCCESS;
+}
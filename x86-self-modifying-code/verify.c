@@ -0,0 +1,128 @@
+// Checks generated kernels against generic ones and PEXT emulation from
+// pext_soft_emu; both kinds of buffers (dual mapping, mprotect) are used
+
+// first, jit.h needs _GNU_SOURCE
+#include "kernels.c"
+#include "../pext_soft_emu/pext.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N 1024
+
+uint32_t input[N];
+uint32_t expected[N];
+uint32_t result[N];
+
+
+int verify_bitmask(jit_buffer* jb) {
+	static const uint32_t keys[] = {0, 1, 7, 0x80000000, 0xffffffff};
+	size_t k, n, i;
+
+	for (k=0; k < sizeof(keys)/sizeof(keys[0]); k++) {
+		const uint32_t key = keys[k];
+		bitmask_fun fun = jit_bitmask(jb, key);
+		if (fun == NULL) {
+			puts("bitmask: buffer too small");
+			return 0;
+		}
+
+		// about half of elements match
+		for (i=0; i < N; i++)
+			input[i] = (rand() % 2) ? key : key ^ (1u << (rand() % 32));
+
+		for (n=0; n <= N; n += 32) {
+			memset(expected, 0xaa, sizeof(expected));
+			memset(result, 0xaa, sizeof(result));
+
+			bitmask_generic(input, n, key, expected);
+			fun(input, n, result);
+			if (memcmp(expected, result, sizeof(result)) != 0) {
+				printf("bitmask: key=%08x, n=%lu: wrong result\n", key, (unsigned long)n);
+				return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+
+
+int verify_pext(jit_buffer* jb) {
+	uint32_t masks[1000];
+	pext_plan plan;
+	size_t k, i;
+
+	masks[0] = 0;
+	masks[1] = 0xffffffff;
+	masks[2] = 0x80000000;
+	masks[3] = 0x00000001;
+	masks[4] = 0xff000000;
+	masks[5] = 0x000000ff;
+	masks[6] = 0x55555555;
+	masks[7] = 0xaaaaaaaa;
+	masks[8] = 0x7ffffffe;
+	for (k=9; k < 1000; k++)
+		masks[k] = rand() ^ ((uint32_t)rand() << 16);
+
+	for (i=0; i < N; i++)
+		input[i] = rand() ^ ((uint32_t)rand() << 16);
+
+	for (k=0; k < 1000; k++) {
+		const uint32_t mask = masks[k];
+		pext_array_fun fun;
+
+		// generated functions don't fit: start over
+		if (jb->size - jb->used < 1024)
+			jb->used = 0;
+
+		fun = jit_pext_array(jb, mask);
+		if (fun == NULL) {
+			puts("pext: buffer too small");
+			return 0;
+		}
+
+		for (i=0; i < N; i++)
+			expected[i] = pext(input[i], mask);
+
+		pext_plan_build(&plan, mask);
+		pext_plan_array(&plan, input, result, N);
+		if (memcmp(expected, result, sizeof(result)) != 0) {
+			printf("pext plan: mask=%08x: wrong result\n", mask);
+			return 0;
+		}
+
+		memset(result, 0, sizeof(result));
+		fun(input, result, N);
+		if (memcmp(expected, result, sizeof(result)) != 0) {
+			printf("pext jit: mask=%08x: wrong result\n", mask);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+
+int main() {
+	jit_buffer dual, single;
+	int ok = 1;
+
+	if (jit_init(&dual, 64*1024) || jit_init_single(&single, 64*1024)) {
+		perror("jit_init");
+		return EXIT_FAILURE;
+	}
+
+	printf("memfd dual mapping: %s\n", dual.dual ? "yes" : "no (mprotect)");
+
+	ok &= verify_bitmask(&dual);
+	ok &= verify_pext(&dual);
+	ok &= verify_bitmask(&single);
+	ok &= verify_pext(&single);
+
+	jit_free(&dual);
+	jit_free(&single);
+
+	puts(ok ? "all OK" : "FAILED");
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}